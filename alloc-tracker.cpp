@@ -0,0 +1,196 @@
+#include "alloc-tracker.hpp"
+
+#include <cstdlib>
+#include <new>
+
+namespace ContextEngine {
+
+// Plain thread locals without constructors, so they are safe to touch from
+// operator new at any point, even before main
+static thread_local AllocationZone currentZone = AllocationZone::Other;
+static thread_local AllocationCounts zoneCounts[static_cast<int>(AllocationZone::Count)];
+
+bool isAllocationTrackingEnabled() {
+#ifdef CONTEXT_ENGINE_TRACK_ALLOCATIONS
+    return true;
+#else
+    return false;
+#endif
+}
+
+const char* getAllocationZoneName(AllocationZone zone) {
+    switch (zone) {
+        case AllocationZone::Events: return "events";
+        case AllocationZone::Update: return "update";
+        case AllocationZone::Render: return "render";
+        case AllocationZone::Present: return "present";
+        default: return "other";
+    }
+}
+
+AllocationCounts getThreadAllocations(AllocationZone zone) {
+    if (zone == AllocationZone::Count) {
+        return AllocationCounts();
+    }
+    return zoneCounts[static_cast<int>(zone)];
+}
+
+void resetThreadAllocations() {
+    for (AllocationCounts& counts : zoneCounts) {
+        counts = AllocationCounts();
+    }
+}
+
+AllocationZoneScope::AllocationZoneScope(AllocationZone zone)
+    : previous(currentZone)
+{
+    currentZone = zone;
+}
+
+AllocationZoneScope::~AllocationZoneScope() {
+    currentZone = previous;
+}
+
+#ifdef CONTEXT_ENGINE_TRACK_ALLOCATIONS
+
+static void countAllocation(std::size_t size) {
+    AllocationCounts& counts = zoneCounts[static_cast<int>(currentZone)];
+    counts.allocations++;
+    counts.bytes += size;
+}
+
+static void countFree(void* memory) {
+    if (memory) {
+        zoneCounts[static_cast<int>(currentZone)].frees++;
+    }
+}
+
+static void* allocate(std::size_t size) {
+    countAllocation(size);
+    return std::malloc(size > 0 ? size : 1);
+}
+
+static void* allocateAligned(std::size_t size, std::size_t alignment) {
+    countAllocation(size);
+    if (alignment < sizeof(void*)) {
+        alignment = sizeof(void*);
+    }
+#ifdef _WIN32
+    return _aligned_malloc(size > 0 ? size : 1, alignment);
+#else
+    void* memory = nullptr;
+    if (posix_memalign(&memory, alignment, size > 0 ? size : 1) != 0) {
+        return nullptr;
+    }
+    return memory;
+#endif
+}
+
+static void freeAligned(void* memory) {
+    countFree(memory);
+#ifdef _WIN32
+    _aligned_free(memory);
+#else
+    std::free(memory);
+#endif
+}
+
+#endif // CONTEXT_ENGINE_TRACK_ALLOCATIONS
+
+} // namespace ContextEngine
+
+#ifdef CONTEXT_ENGINE_TRACK_ALLOCATIONS
+
+// Replacements for every global allocation function; they count in the
+// current zone and pass through to malloc
+
+void* operator new(std::size_t size) {
+    void* memory = ContextEngine::allocate(size);
+    if (!memory) {
+        throw std::bad_alloc();
+    }
+    return memory;
+}
+
+void* operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    return ContextEngine::allocate(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    return ContextEngine::allocate(size);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    void* memory = ContextEngine::allocateAligned(size, static_cast<std::size_t>(alignment));
+    if (!memory) {
+        throw std::bad_alloc();
+    }
+    return memory;
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+    return operator new(size, alignment);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return ContextEngine::allocateAligned(size, static_cast<std::size_t>(alignment));
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return ContextEngine::allocateAligned(size, static_cast<std::size_t>(alignment));
+}
+
+void operator delete(void* memory) noexcept {
+    ContextEngine::countFree(memory);
+    std::free(memory);
+}
+
+void operator delete[](void* memory) noexcept {
+    operator delete(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept {
+    operator delete(memory);
+}
+
+void operator delete[](void* memory, std::size_t) noexcept {
+    operator delete(memory);
+}
+
+void operator delete(void* memory, const std::nothrow_t&) noexcept {
+    operator delete(memory);
+}
+
+void operator delete[](void* memory, const std::nothrow_t&) noexcept {
+    operator delete(memory);
+}
+
+void operator delete(void* memory, std::align_val_t) noexcept {
+    ContextEngine::freeAligned(memory);
+}
+
+void operator delete[](void* memory, std::align_val_t) noexcept {
+    ContextEngine::freeAligned(memory);
+}
+
+void operator delete(void* memory, std::size_t, std::align_val_t) noexcept {
+    ContextEngine::freeAligned(memory);
+}
+
+void operator delete[](void* memory, std::size_t, std::align_val_t) noexcept {
+    ContextEngine::freeAligned(memory);
+}
+
+void operator delete(void* memory, std::align_val_t, const std::nothrow_t&) noexcept {
+    ContextEngine::freeAligned(memory);
+}
+
+void operator delete[](void* memory, std::align_val_t, const std::nothrow_t&) noexcept {
+    ContextEngine::freeAligned(memory);
+}
+
+#endif // CONTEXT_ENGINE_TRACK_ALLOCATIONS
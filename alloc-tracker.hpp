@@ -0,0 +1,50 @@
+#pragma once
+
+#include "context-types.hpp"
+
+namespace ContextEngine {
+
+// Phases of a frame that heap allocations are charged to. Engine marks its
+// own phases; everything else, including worker threads, lands in Other.
+enum class AllocationZone {
+    Events,
+    Update,
+    Render,
+    Present,
+    Other,
+    Count
+};
+
+struct AllocationCounts {
+    Uint64 allocations = 0;
+    Uint64 bytes = 0;
+    Uint64 frees = 0;
+};
+
+// True when the build replaces global operator new/delete to count
+// allocations (CMake option CONTEXT_ENGINE_TRACK_ALLOCATIONS). Otherwise
+// every count reads zero.
+bool isAllocationTrackingEnabled();
+
+const char* getAllocationZoneName(AllocationZone zone);
+
+// Counts for the calling thread since its last reset. Counters are thread
+// local, so reading and resetting them never synchronizes.
+AllocationCounts getThreadAllocations(AllocationZone zone);
+void resetThreadAllocations();
+
+// Charges the calling thread's allocations to a zone until it goes out of scope
+class AllocationZoneScope {
+public:
+    explicit AllocationZoneScope(AllocationZone zone);
+    ~AllocationZoneScope();
+
+    // Prevent copying
+    AllocationZoneScope(const AllocationZoneScope&) = delete;
+    AllocationZoneScope& operator=(const AllocationZoneScope&) = delete;
+
+private:
+    AllocationZone previous;
+};
+
+} // namespace ContextEngine
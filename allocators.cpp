@@ -0,0 +1,60 @@
+#include "allocators.hpp"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace ContextEngine {
+
+FrameArena::FrameArena(size_t initialSize)
+    : blockUsed(0)
+    , used(0)
+    , heapAllocations(0)
+{
+    addBlock(std::max<size_t>(initialSize, 1024));
+    heapAllocations = 0;
+}
+
+void* FrameArena::allocate(size_t size, size_t alignment) {
+    Block& block = blocks.back();
+    uintptr_t base = reinterpret_cast<uintptr_t>(block.memory.get());
+    size_t offset = ((base + blockUsed + alignment - 1) & ~(alignment - 1)) - base;
+    if (offset + size > block.size) {
+        // Doesn't fit: start a new block, at least as big as this request
+        addBlock(size + alignment);
+        return allocate(size, alignment);
+    }
+    blockUsed = offset + size;
+    return block.memory.get() + offset;
+}
+
+void FrameArena::reset() {
+    if (blocks.size() > 1) {
+        // The frame overflowed; replace everything with one block that fits it
+        size_t peak = getUsed();
+        blocks.clear();
+        addBlock(peak + peak / 2);
+    }
+    blockUsed = 0;
+    used = 0;
+    heapAllocations = 0;
+}
+
+size_t FrameArena::getCapacity() const {
+    size_t capacity = 0;
+    for (const Block& block : blocks) {
+        capacity += block.size;
+    }
+    return capacity;
+}
+
+void FrameArena::addBlock(size_t minimumSize) {
+    size_t size = blocks.empty() ? minimumSize : std::max(minimumSize, blocks.back().size * 2);
+    if (!blocks.empty()) {
+        used += blockUsed;
+    }
+    blocks.push_back({std::unique_ptr<unsigned char[]>(new unsigned char[size]), size});
+    blockUsed = 0;
+    heapAllocations++;
+}
+
+} // namespace ContextEngine
@@ -0,0 +1,197 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace ContextEngine {
+
+// Bump allocator for data that only lives until the end of the frame.
+// Allocating is a pointer increment; nothing is freed individually and
+// reset() makes the whole arena reusable. When a frame needs more than the
+// current block, extra blocks come from the heap, and the next reset merges
+// them into one block big enough for that peak, so a steady state frame
+// never touches the heap.
+class FrameArena {
+public:
+    explicit FrameArena(size_t initialSize = 64 * 1024);
+
+    // Prevent copying
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    // Uninitialized memory valid until the next reset
+    void* allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+    // Array of count values; only for types that need no destructor
+    template<typename T>
+    T* allocateArray(size_t count) {
+        static_assert(std::is_trivially_destructible<T>::value, "arena memory is never destroyed");
+        return static_cast<T*>(allocate(sizeof(T) * count, alignof(T)));
+    }
+
+    void reset();
+
+    size_t getUsed() const { return used + blockUsed; }
+    size_t getCapacity() const;
+
+    // Heap blocks taken since the last reset; nonzero means the frame allocated
+    size_t getHeapAllocations() const { return heapAllocations; }
+
+private:
+    struct Block {
+        std::unique_ptr<unsigned char[]> memory;
+        size_t size;
+    };
+
+    void addBlock(size_t minimumSize);
+
+    std::vector<Block> blocks; // The last one is being filled
+    size_t blockUsed;
+    size_t used; // Bytes in full blocks before the current one
+    size_t heapAllocations;
+};
+
+// Standard allocator handing out FrameArena memory, so containers built
+// during a frame cost no heap allocations. deallocate does nothing; the
+// container must not outlive the frame.
+template<typename T>
+class ArenaAllocator {
+public:
+    using value_type = T;
+
+    explicit ArenaAllocator(FrameArena& arena) : arena(&arena) {}
+
+    template<typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) : arena(other.getArena()) {}
+
+    T* allocate(size_t count) { return static_cast<T*>(arena->allocate(sizeof(T) * count, alignof(T))); }
+    void deallocate(T*, size_t) {}
+
+    FrameArena* getArena() const { return arena; }
+
+    template<typename U>
+    bool operator==(const ArenaAllocator<U>& other) const { return arena == other.getArena(); }
+    template<typename U>
+    bool operator!=(const ArenaAllocator<U>& other) const { return arena != other.getArena(); }
+
+private:
+    FrameArena* arena;
+};
+
+// Scratch vector for the current frame, e.g. FrameVector<Vector2> points(ArenaAllocator<Vector2>(arena))
+template<typename T>
+using FrameVector = std::vector<T, ArenaAllocator<T>>;
+
+// Fixed size slots for objects that are created and destroyed often.
+// Slots come in chunks that are never freed or moved, so pointers stay
+// valid until destroy() and a freed slot is reused by the next create().
+template<typename T>
+class ObjectPool {
+public:
+    explicit ObjectPool(size_t chunkSize = 64)
+        : chunkSize(chunkSize > 0 ? chunkSize : 1)
+        , freeList(nullptr)
+        , liveCount(0)
+        , heapAllocations(0)
+    {
+    }
+
+    ~ObjectPool() {
+        // Anything still alive is destroyed with the pool
+        for (std::unique_ptr<Slot[]>& chunk : chunks) {
+            for (size_t i = 0; i < chunkSize; i++) {
+                if (chunk[i].alive) {
+                    chunk[i].object()->~T();
+                }
+            }
+        }
+    }
+
+    // Prevent copying
+    ObjectPool(const ObjectPool&) = delete;
+    ObjectPool& operator=(const ObjectPool&) = delete;
+
+    template<typename... Args>
+    T* create(Args&&... args) {
+        if (!freeList) {
+            addChunk();
+        }
+        Slot* slot = freeList;
+        T* object = new (slot->storage) T(std::forward<Args>(args)...);
+        freeList = slot->next;
+        slot->alive = true;
+        liveCount++;
+        return object;
+    }
+
+    void destroy(T* object) {
+        if (!object) {
+            return;
+        }
+        object->~T();
+        Slot* slot = reinterpret_cast<Slot*>(reinterpret_cast<unsigned char*>(object) - offsetof(Slot, storage));
+        slot->alive = false;
+        slot->next = freeList;
+        freeList = slot;
+        liveCount--;
+    }
+
+    // Make room for count live objects up front, e.g. while loading
+    void reserve(size_t count) {
+        while (chunks.size() * chunkSize < count) {
+            addChunk();
+        }
+    }
+
+    size_t getLiveCount() const { return liveCount; }
+    size_t getCapacity() const { return chunks.size() * chunkSize; }
+
+    // Chunks taken from the heap since the last call to resetHeapAllocations
+    size_t getHeapAllocations() const { return heapAllocations; }
+    void resetHeapAllocations() { heapAllocations = 0; }
+
+private:
+    struct Slot {
+        alignas(T) unsigned char storage[sizeof(T)];
+        Slot* next;
+        bool alive;
+
+        T* object() { return std::launder(reinterpret_cast<T*>(storage)); }
+    };
+
+    void addChunk() {
+        std::unique_ptr<Slot[]> chunk(new Slot[chunkSize]);
+        // Thread the new slots onto the free list in address order
+        for (size_t i = 0; i < chunkSize; i++) {
+            chunk[i].next = i + 1 < chunkSize ? &chunk[i + 1] : freeList;
+            chunk[i].alive = false;
+        }
+        freeList = &chunk[0];
+        chunks.push_back(std::move(chunk));
+        heapAllocations++;
+    }
+
+    size_t chunkSize;
+    std::vector<std::unique_ptr<Slot[]>> chunks;
+    Slot* freeList;
+    size_t liveCount;
+    size_t heapAllocations;
+};
+
+// Deleter returning objects to their pool, for std::unique_ptr<T, PoolDeleter<T>>
+template<typename T>
+struct PoolDeleter {
+    ObjectPool<T>* pool = nullptr;
+
+    void operator()(T* object) const {
+        if (pool) {
+            pool->destroy(object);
+        }
+    }
+};
+
+} // namespace ContextEngine
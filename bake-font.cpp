@@ -0,0 +1,70 @@
+#include "font-cache.hpp"
+#include "text-layout.hpp"
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+using namespace ContextEngine;
+
+// Bakes a font cache ahead of time, e.g. before packaging the web build:
+//   bake_font assets/font.ttf 16 assets/font-cache [charset.txt]
+// Without a charset file the default (printable ASCII) is baked, which is
+// what OtherCtx::setFontCache uses unless it is given another charset.
+int main(int argc, char* argv[]) {
+    if (argc < 4) {
+        std::cerr << "Usage: " << argv[0] << " <font.ttf> <point size> <output directory> [charset file]" << std::endl;
+        return 1;
+    }
+
+    std::string fontPath = argv[1];
+    int pointSize = std::atoi(argv[2]);
+    std::string directory = argv[3];
+    if (pointSize <= 0) {
+        std::cerr << "Invalid point size: " << argv[2] << std::endl;
+        return 1;
+    }
+
+    std::vector<Uint32> charset = defaultCharset();
+    if (argc > 4) {
+        std::ifstream file(argv[4], std::ios::binary);
+        if (!file) {
+            std::cerr << "Failed to open charset file " << argv[4] << std::endl;
+            return 1;
+        }
+        std::ostringstream text;
+        text << file.rdbuf();
+        charset = charsetFromText(text.str());
+    }
+
+    if (TTF_Init() == -1) {
+        std::cerr << "SDL_ttf could not initialize! SDL_ttf Error: " << TTF_GetError() << std::endl;
+        return 1;
+    }
+
+    TTF_Font* font = TTF_OpenFont(fontPath.c_str(), pointSize);
+    if (!font) {
+        std::cerr << "Failed to load font " << fontPath << "! SDL_ttf Error: " << TTF_GetError() << std::endl;
+        TTF_Quit();
+        return 1;
+    }
+
+    FontCacheKey key;
+    key.fontHash = hashFontFile(fontPath);
+    key.pointSize = pointSize;
+    key.charsetHash = hashCharset(charset);
+
+    std::string output = directory + "/" + fontCacheFileName(key);
+    bool baked = FontCache::bake(font, key, charset, GlyphAtlas::PAGE_SIZE, output);
+
+    TTF_CloseFont(font);
+    TTF_Quit();
+
+    if (!baked) {
+        std::cerr << "Failed to bake " << output << std::endl;
+        return 1;
+    }
+    std::cout << "Baked " << charset.size() << " glyphs into " << output << std::endl;
+    return 0;
+}
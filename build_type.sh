@@ -54,17 +54,81 @@ fi
 compile "Context Engine" "g++ -c context-engine.cpp -o build/context-engine.o $SDL_CFLAGS -std=c++17 -Wall -Wextra"
 if [ $? -ne 0 ]; then exit 1; fi
 
+compile "Text Layout" "g++ -c text-layout.cpp -o build/text-layout.o $SDL_CFLAGS -std=c++17 -Wall -Wextra"
+if [ $? -ne 0 ]; then exit 1; fi
+
+compile "Text View" "g++ -c text-view.cpp -o build/text-view.o $SDL_CFLAGS -std=c++17 -Wall -Wextra"
+if [ $? -ne 0 ]; then exit 1; fi
+
+compile "SDF Font" "g++ -c sdf-font.cpp -o build/sdf-font.o $SDL_CFLAGS -std=c++17 -Wall -Wextra"
+if [ $? -ne 0 ]; then exit 1; fi
+
+compile "Worker Pool" "g++ -c worker-pool.cpp -o build/worker-pool.o $SDL_CFLAGS -std=c++17 -Wall -Wextra"
+if [ $? -ne 0 ]; then exit 1; fi
+
+compile "Font Cache" "g++ -c font-cache.cpp -o build/font-cache.o $SDL_CFLAGS -std=c++17 -Wall -Wextra"
+if [ $? -ne 0 ]; then exit 1; fi
+
+compile "Geometry Batch" "g++ -c geometry-batch.cpp -o build/geometry-batch.o $SDL_CFLAGS -std=c++17 -Wall -Wextra"
+if [ $? -ne 0 ]; then exit 1; fi
+
+compile "ECS" "g++ -c ecs.cpp -o build/ecs.o $SDL_CFLAGS -std=c++17 -Wall -Wextra"
+if [ $? -ne 0 ]; then exit 1; fi
+
+compile "Spatial Hash" "g++ -c spatial-hash.cpp -o build/spatial-hash.o $SDL_CFLAGS -std=c++17 -Wall -Wextra"
+if [ $? -ne 0 ]; then exit 1; fi
+
+compile "SIMD Math" "g++ -c simd-math.cpp -o build/simd-math.o $SDL_CFLAGS -std=c++17 -Wall -Wextra -ffp-contract=off"
+if [ $? -ne 0 ]; then exit 1; fi
+
+compile "Physics" "g++ -c physics.cpp -o build/physics.o $SDL_CFLAGS -std=c++17 -Wall -Wextra"
+if [ $? -ne 0 ]; then exit 1; fi
+
+compile "Allocators" "g++ -c allocators.cpp -o build/allocators.o $SDL_CFLAGS -std=c++17 -Wall -Wextra"
+if [ $? -ne 0 ]; then exit 1; fi
+
+compile "Allocation Tracker" "g++ -c alloc-tracker.cpp -o build/alloc-tracker.o $SDL_CFLAGS -std=c++17 -Wall -Wextra"
+if [ $? -ne 0 ]; then exit 1; fi
+
+compile "Particles" "g++ -c particles.cpp -o build/particles.o $SDL_CFLAGS -std=c++17 -Wall -Wextra"
+if [ $? -ne 0 ]; then exit 1; fi
+
+compile "Tilemap" "g++ -c tilemap.cpp -o build/tilemap.o $SDL_CFLAGS -std=c++17 -Wall -Wextra"
+if [ $? -ne 0 ]; then exit 1; fi
+
+compile "World Stream" "g++ -c world-stream.cpp -o build/world-stream.o $SDL_CFLAGS -std=c++17 -Wall -Wextra"
+if [ $? -ne 0 ]; then exit 1; fi
+
+compile "Input Record" "g++ -c input-record.cpp -o build/input-record.o $SDL_CFLAGS -std=c++17 -Wall -Wextra"
+if [ $? -ne 0 ]; then exit 1; fi
+
+compile "Input Queue" "g++ -c input-queue.cpp -o build/input-queue.o $SDL_CFLAGS -std=c++17 -Wall -Wextra"
+if [ $? -ne 0 ]; then exit 1; fi
+
+compile "Latency Stats" "g++ -c latency-stats.cpp -o build/latency-stats.o $SDL_CFLAGS -std=c++17 -Wall -Wextra"
+if [ $? -ne 0 ]; then exit 1; fi
+
+compile "Key State" "g++ -c key-state.cpp -o build/key-state.o $SDL_CFLAGS -std=c++17 -Wall -Wextra"
+if [ $? -ne 0 ]; then exit 1; fi
+
+compile "Timer wheel" "g++ -c timer-wheel.cpp -o build/timer-wheel.o $SDL_CFLAGS -std=c++17 -Wall -Wextra"
+if [ $? -ne 0 ]; then exit 1; fi
+
+compile "Coroutine tasks" "g++ -c coroutines.cpp -o build/coroutines.o $SDL_CFLAGS -std=c++17 -Wall -Wextra"
+if [ $? -ne 0 ]; then exit 1; fi
+
 # Compile the typing test game
 compile "Typing Test Game" "g++ -c typing_test.cpp -o build/typing_test.o $SDL_CFLAGS -std=c++17 -Wall -Wextra"
 if [ $? -ne 0 ]; then exit 1; fi
 
 # Link the final executable
-compile "Typing Test Executable" "g++ build/context-engine.o build/typing_test.o -o build/typing_test $SDL_LIBS $SDL_TTF_LIBS -std=c++17"
+compile "Typing Test Executable" "g++ build/context-engine.o build/text-layout.o build/text-view.o build/sdf-font.o build/worker-pool.o build/font-cache.o build/geometry-batch.o build/ecs.o build/spatial-hash.o build/simd-math.o build/physics.o build/allocators.o build/alloc-tracker.o build/particles.o build/tilemap.o build/world-stream.o build/input-record.o build/input-queue.o build/latency-stats.o build/key-state.o build/timer-wheel.o build/coroutines.o build/typing_test.o -o build/typing_test $SDL_LIBS $SDL_TTF_LIBS -pthread -std=c++17"
 if [ $? -ne 0 ]; then exit 1; fi
 
 # Copy assets to the build directory
 echo -e "${YELLOW}Copying assets to build directory...${NC}"
 mkdir -p build/assets
+mkdir -p build/assets/font-cache
 mkdir -p assets
 
 # Copy any existing assets
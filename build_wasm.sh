@@ -58,6 +58,12 @@ mkdir -p ~/.emscripten_cache
 # Set FROZEN_CACHE explicitly in the environment as well
 export FROZEN_CACHE=0
 
+# Bake the default font cache natively (see build.sh) so the browser skips FreeType for it
+if [ -x build/bake_font ]; then
+    mkdir -p assets/font-cache
+    build/bake_font assets/font.ttf 16 assets/font-cache
+fi
+
 # Build to JavaScript instead of HTML to avoid minification issues
 emcc -std=c++17 -O2 \
     -s WASM=1 \
@@ -76,7 +82,7 @@ emcc -std=c++17 -O2 \
     --preload-file assets \
     -I. \
     -o $WEB_DIR/index.js \
-    context-engine.cpp test.cpp
+    context-engine.cpp text-layout.cpp text-view.cpp sdf-font.cpp worker-pool.cpp font-cache.cpp geometry-batch.cpp ecs.cpp spatial-hash.cpp simd-math.cpp physics.cpp allocators.cpp alloc-tracker.cpp particles.cpp tilemap.cpp world-stream.cpp input-record.cpp input-queue.cpp latency-stats.cpp key-state.cpp timer-wheel.cpp coroutines.cpp test.cpp
 
 # Check if build was successful
 if [ $? -eq 0 ]; then
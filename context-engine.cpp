@@ -7,16 +7,46 @@
 #include <SDL2/SDL_mouse.h>
 #endif
 #include <iostream>
+#include <algorithm>
+#include <cstdlib>
+#include <ctime>
 
 namespace ContextEngine {
 
 // Engine implementation
-Engine::Engine(const char* title, int width, int height)
+Engine::Engine(const char* title, int width, int height, bool headless)
     : window(nullptr)
     , renderer(nullptr)
     , ctx(nullptr)
     , currentSceneIndex(-1)
+    , pendingScene(-1)
+    , pendingPush(false)
     , running(false)
+    , fixedTimestep(1.0f / 60.0f)
+    , fixedAccumulator(0.0f)
+    , maxFixedSteps(5)
+    , frameCount(0)
+    , arenaOverflowFrames(0)
+    , allocatingFrames(0)
+    , warmupFrames(60)
+    , frameAllocations()
+    , allocationAssert(false)
+    , allocationFailure(false)
+    , headless(headless)
+    , randomSeed(static_cast<Uint32>(std::time(nullptr)))
+    , replayDeltaTime(0.0f)
+    , eventTime(0)
+    , eventFiltering(true)
+    , subscriptionStamp(0)
+    , idleWaiting(false)
+    , invalidated(false)
+    , eventsThisFrame(0)
+    , wakeTime(0)
+    , idleWaits(0)
+    , simTimers(0)
+    , wallTimers(1ull << 63)
+    , simTime(0.0)
+    , wallStart(SDL_GetPerformanceCounter())
 {
     std::cout << "Initializing Engine..." << std::endl;
     
@@ -24,8 +54,18 @@ Engine::Engine(const char* title, int width, int height)
     input.mouseX = 0;
     input.mouseY = 0;
     input.mouseDown = false;
+    input.mousePressed = false;
     input.mouseReleased = false;
-    input.keys.resize(SDL_NUM_SCANCODES, false);
+    latched.mouseX = 0;
+    latched.mouseY = 0;
+    latched.mouseDown = false;
+    latched.time = 0;
+    pendingLatencies.reserve(256);
+    
+    // Without a display, fall back to SDL's dummy video driver
+    if (headless && !std::getenv("SDL_VIDEODRIVER")) {
+        SDL_SetHint(SDL_HINT_VIDEODRIVER, "dummy");
+    }
     
     // Initialize SDL
     std::cout << "Initializing SDL..." << std::endl;
@@ -53,7 +93,7 @@ Engine::Engine(const char* title, int width, int height)
                              SDL_WINDOWPOS_CENTERED, 
                              SDL_WINDOWPOS_CENTERED, 
                              width, height, 
-                             SDL_WINDOW_SHOWN | SDL_WINDOW_RESIZABLE);
+                             headless ? SDL_WINDOW_HIDDEN : SDL_WINDOW_SHOWN | SDL_WINDOW_RESIZABLE);
 #endif
     if (!window) {
         std::cerr << "Window could not be created! SDL Error: " << SDL_GetError() << std::endl;
@@ -63,7 +103,7 @@ Engine::Engine(const char* title, int width, int height)
     
     // Create renderer
     std::cout << "Creating renderer..." << std::endl;
-    renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
+    renderer = SDL_CreateRenderer(window, -1, headless ? SDL_RENDERER_SOFTWARE : SDL_RENDERER_ACCELERATED);
     if (!renderer) {
         std::cerr << "Renderer could not be created! SDL Error: " << SDL_GetError() << std::endl;
         return;
@@ -77,6 +117,15 @@ Engine::Engine(const char* title, int width, int height)
 }
 
 Engine::~Engine() {
+    // Wait for scenes still preparing before they go away
+    sceneLoader.reset();
+    
+    // Finish the log so its frame count is written
+    recorder.close();
+    
+    // The watch has to go before SDL does
+    inputQueue.stop();
+    
     // Release context (will not destroy renderer since we set ownsRenderer to false)
     ctx.reset();
     
@@ -101,74 +150,442 @@ bool Engine::init() {
         return false;
     }
     
+    // Queue input from here on, from the thread that runs the loop
+    inputQueue.start();
+    
     running = true;
     return true;
 }
 
 void Engine::handleEvents() {
-    // Reset mouse released state at the beginning of frame
+    AllocationZoneScope zone(AllocationZone::Events);
+    
+    // Reset the edges of the last frame
+    eventsThisFrame = 0;
+    input.mousePressed = false;
     input.mouseReleased = false;
+    input.previousKeys = input.keys;
+    input.keysPressed.clear();
+    input.keysReleased.clear();
     
+    // Without the queue (before init) read SDL directly
     SDL_Event event;
-    while (SDL_PollEvent(&event)) {
-        // Handle engine-level events
-        switch (event.type) {
-            case SDL_QUIT:
-                running = false;
-                break;
-                
+    while (!inputQueue.isActive() && SDL_PollEvent(&event)) {
+        InputEvent polled = {event, SDL_GetPerformanceCounter()};
+        handleQueuedEvent(polled);
+    }
+    
+    refreshEventFilter();
+    inputQueue.pump();
+    inputQueue.flushMotion();
+    InputEvent queued;
+    while (inputQueue.pop(queued)) {
+        handleQueuedEvent(queued);
+    }
+    
+    if (replay.isOpen()) {
+        eventTime = SDL_GetPerformanceCounter();
+        if (replay.nextFrame(replayEvents, replayDeltaTime)) {
+            for (const SDL_Event& recorded : replayEvents) {
+                dispatchEvent(recorded);
+                trackLatency(recorded);
+            }
+        } else {
+            finishReplay();
+        }
+    }
+    
+    flushSceneEvents();
+}
+
+void Engine::flushSceneEvents() {
+    if (!sceneEvents.empty() && currentSceneIndex >= 0) {
+        scenes[currentSceneIndex].scene->handleEventBatch(sceneEvents.data(), sceneEvents.size());
+    }
+    sceneEvents.clear();
+}
+
+void Engine::handleQueuedEvent(const InputEvent& queued) {
+    // A replay only listens to live input for quitting
+    if (replay.isOpen()) {
+        if (queued.event.type == SDL_QUIT) {
+            running = false;
+        }
+        return;
+    }
+    
+    eventTime = queued.time;
+    eventsThisFrame++;
+    recorder.record(queued.event);
+    dispatchEvent(queued.event);
+    trackLatency(queued.event);
+}
+
+void Engine::trackLatency(const SDL_Event& event) {
+    InputLatencyKind kind;
+    switch (event.type) {
+        case SDL_KEYDOWN:
+        case SDL_KEYUP:
+        case SDL_TEXTINPUT:
+            kind = InputLatencyKind::Key;
+            break;
+        case SDL_MOUSEBUTTONDOWN:
+        case SDL_MOUSEBUTTONUP:
+        case SDL_MOUSEWHEEL:
+            kind = InputLatencyKind::MouseButton;
+            break;
+        case SDL_MOUSEMOTION:
+            kind = InputLatencyKind::MouseMotion;
+            break;
+        default:
+            return;
+    }
+    pendingLatencies.push_back({kind, eventTime});
+}
+
+void Engine::dispatchEvent(const SDL_Event& event) {
+    // Handle engine-level events
+    switch (event.type) {
+        case SDL_QUIT:
+            running = false;
+            break;
+            
+        case SDL_KEYDOWN:
+            input.keys.set(event.key.keysym.scancode, true);
+            if (!event.key.repeat) {
+                input.keysPressed.set(event.key.keysym.scancode, true);
+            }
+            break;
+            
+        case SDL_KEYUP:
+            input.keys.set(event.key.keysym.scancode, false);
+            input.keysReleased.set(event.key.keysym.scancode, true);
+            break;
+            
+        case SDL_MOUSEMOTION:
+            input.mouseX = event.motion.x;
+            input.mouseY = event.motion.y;
+            break;
+            
+        case SDL_MOUSEBUTTONDOWN:
+            if (event.button.button == SDL_BUTTON_LEFT) {
+                input.mouseDown = true;
+                input.mousePressed = true;
+            }
+            break;
+            
+        case SDL_MOUSEBUTTONUP:
+            if (event.button.button == SDL_BUTTON_LEFT) {
+                input.mouseDown = false;
+                input.mouseReleased = true;
+            }
+            break;
+    }
+    
+#ifdef CONTEXT_ENGINE_COROUTINES
+    tasks.dispatchEvent(event);
+#endif
+    
+    // Pass events to the current scene if one exists and wants them
+    if (currentSceneIndex >= 0 && scenes[currentSceneIndex].scene->wantsEvent(event.type)) {
+        Scene* scene = scenes[currentSceneIndex].scene.get();
+        if (scene->batchesEvents()) {
+            sceneEvents.push_back(event);
+        } else {
+            scene->handleEvent(event);
+        }
+    }
+}
+
+void Engine::setEventFiltering(bool enable) {
+    eventFiltering = enable;
+    subscriptionStamp = ~static_cast<Uint64>(0); // Rebuild on the next frame
+}
+
+void Engine::refreshEventFilter() {
+    // Revisions only grow, so any subscription change or scene added
+    // changes the stamp. A scene built or done preparing may still be at
+    // revision 0, so those reset the stamp themselves.
+    Uint64 stamp = static_cast<Uint64>(scenes.size()) << 32;
+    bool everything = !eventFiltering;
+    for (const SceneSlot& slot : scenes) {
+        // Scenes preparing on the loader are left alone until they are done
+        if (slot.scene && slot.state != SceneState::Preparing) {
+            stamp += slot.scene->getSubscriptionRevision();
+            everything = everything || !slot.scene->filtersEventTypes();
+        }
+    }
+#ifdef CONTEXT_ENGINE_COROUTINES
+    stamp += tasks.getEventRevision();
+#endif
+    if (stamp == subscriptionStamp) {
+        return;
+    }
+    subscriptionStamp = stamp;
+    
+    for (Uint32 type = InputQueue::FIRST_FILTERED_TYPE; type <= InputQueue::LAST_FILTERED_TYPE; type++) {
+        bool wanted = everything;
+        switch (type) {
+            // The engine's own input state
             case SDL_KEYDOWN:
-                input.keys[event.key.keysym.scancode] = true;
-                break;
-                
             case SDL_KEYUP:
-                input.keys[event.key.keysym.scancode] = false;
-                break;
-                
             case SDL_MOUSEMOTION:
-                input.mouseX = event.motion.x;
-                input.mouseY = event.motion.y;
+            case SDL_MOUSEBUTTONDOWN:
+            case SDL_MOUSEBUTTONUP:
+                wanted = true;
+                break;
+        }
+        for (size_t i = 0; i < scenes.size() && !wanted; i++) {
+            const SceneSlot& slot = scenes[i];
+            wanted = slot.scene && slot.state != SceneState::Preparing && slot.scene->wantsEvent(type);
+        }
+#ifdef CONTEXT_ENGINE_COROUTINES
+        wanted = wanted || tasks.waitsForEventType(type);
+#endif
+        inputQueue.setTypeBlocked(type, !wanted);
+    }
+}
+
+void Engine::update(float deltaTime) {
+    AllocationZoneScope zone(AllocationZone::Update);
+    
+    // A replayed frame advances by exactly what was recorded
+    if (replay.isOpen()) {
+        deltaTime = replayDeltaTime;
+    }
+    
+    // Run the timers that came due
+    simTime += deltaTime;
+    simTimers.advance(static_cast<Uint64>(simTime * 1000.0));
+    wallTimers.advance(getWallTick());
+    
+#ifdef CONTEXT_ENGINE_COROUTINES
+    tasks.update(deltaTime);
+#endif
+    
+    // Show a scene that finished preparing in the background
+    finishPreparing();
+    
+    // After finishPreparing, which logs the scenes that became prepared
+    recorder.endFrame(deltaTime);
+    
+    if (currentSceneIndex < 0) {
+        return;
+    }
+    
+    // Run the simulation in fixed steps, independent of the frame rate
+    fixedAccumulator += deltaTime;
+    int steps = 0;
+    while (fixedAccumulator >= fixedTimestep && steps < maxFixedSteps) {
+        scenes[currentSceneIndex].scene->fixedUpdate(fixedTimestep, this);
+        fixedAccumulator -= fixedTimestep;
+        steps++;
+    }
+    if (steps == maxFixedSteps && fixedAccumulator >= fixedTimestep) {
+        // Too far behind, drop the backlog instead of catching up forever
+        fixedAccumulator = 0.0f;
+    }
+    
+    // Scenes under the top run at their own pace, or not at all. The stack
+    // is indexed each time since an update may push or pop scenes, and
+    // slots are looked up again after every hook since one may add scenes
+    // and move them.
+    for (size_t i = 0; i + 1 < sceneStack.size(); i++) {
+        int index = sceneStack[i];
+        Scene* scene = scenes[index].scene.get();
+        switch (scene->getBackgroundUpdate()) {
+            case BackgroundUpdate::Freeze:
                 break;
                 
-            case SDL_MOUSEBUTTONDOWN:
-                if (event.button.button == SDL_BUTTON_LEFT) {
-                    input.mouseDown = true;
+            case BackgroundUpdate::Reduced: {
+                SceneSlot& slot = scenes[index];
+                slot.backgroundTime += deltaTime;
+                slot.backgroundFrames++;
+                if (slot.backgroundTime < 1.0f / scene->getBackgroundRate()) {
+                    break;
+                }
+                float elapsed = slot.backgroundTime;
+                int frames = slot.backgroundFrames;
+                float fixed = slot.backgroundFixed + elapsed;
+                slot.backgroundTime = 0.0f;
+                slot.backgroundFrames = 0;
+                
+                // The saved-up fixed steps in one go, capped per frame saved
+                // up as the top scene's are
+                int backgroundSteps = 0;
+                int maxSteps = maxFixedSteps * frames;
+                while (fixed >= fixedTimestep && backgroundSteps < maxSteps) {
+                    scene->fixedUpdate(fixedTimestep, this);
+                    fixed -= fixedTimestep;
+                    backgroundSteps++;
+                }
+                if (backgroundSteps == maxSteps && fixed >= fixedTimestep) {
+                    fixed = 0.0f;
                 }
+                scenes[index].backgroundFixed = fixed;
+                scene->update(elapsed, this);
                 break;
+            }
                 
-            case SDL_MOUSEBUTTONUP:
-                if (event.button.button == SDL_BUTTON_LEFT) {
-                    input.mouseDown = false;
-                    input.mouseReleased = true;
+            case BackgroundUpdate::Full:
+                for (int step = 0; step < steps; step++) {
+                    scene->fixedUpdate(fixedTimestep, this);
                 }
+                scene->update(deltaTime, this);
                 break;
         }
-        
-        // Pass events to the current scene if one exists
-        if (currentSceneIndex >= 0 && currentSceneIndex < static_cast<int>(scenes.size())) {
-            scenes[currentSceneIndex]->handleEvent(event);
-        }
+    }
+    
+    // Update the current scene
+    if (currentSceneIndex >= 0) {
+        scenes[currentSceneIndex].scene->update(deltaTime, this);
     }
 }
 
-void Engine::update(float deltaTime) {
-    // Update the current scene if one exists
-    if (currentSceneIndex >= 0 && currentSceneIndex < static_cast<int>(scenes.size())) {
-        scenes[currentSceneIndex]->update(deltaTime, this);
+void Engine::setFixedTimestep(float seconds, int maxSteps) {
+    if (seconds > 0.0f) {
+        fixedTimestep = seconds;
     }
+    maxFixedSteps = std::max(1, maxSteps);
+    fixedAccumulator = 0.0f;
 }
 
 void Engine::render() {
+    AllocationZoneScope zone(AllocationZone::Render);
+    
     // Clear screen
     ctx->clear(Color(0, 0, 0));
     
-    // Render the current scene if one exists
-    if (currentSceneIndex >= 0 && currentSceneIndex < static_cast<int>(scenes.size())) {
-        scenes[currentSceneIndex]->render(ctx.get());
+    // Upload glyphs rasterized in the background since the last frame
+    ctx->processTextUploads();
+    
+    // Sample the newest input for cursors and the like
+    latchInput();
+    
+    // Render the current scene, over the scenes under it while it is an overlay
+    size_t first = sceneStack.size();
+    while (first > 0) {
+        first--;
+        if (!scenes[sceneStack[first]].scene->isOverlay()) {
+            break;
+        }
     }
+    for (size_t i = first; i < sceneStack.size(); i++) {
+        scenes[sceneStack[i]].scene->render(ctx.get());
+    }
+    
+    // Timestamp input that came in while the frame was built
+    pumpInput();
     
     // Present the rendered content
+    AllocationZoneScope presentZone(AllocationZone::Present);
     ctx->present();
+    
+    // Everything handled this frame is on screen now
+    Uint64 presented = SDL_GetPerformanceCounter();
+    Uint64 frequency = SDL_GetPerformanceFrequency();
+    for (const PendingLatency& pending : pendingLatencies) {
+        Uint64 elapsed = presented > pending.time ? presented - pending.time : 0;
+        inputLatency[static_cast<int>(pending.kind)].add(elapsed * 1000000 / frequency);
+    }
+    pendingLatencies.clear();
+}
+
+void Engine::latchInput() {
+    if (replay.isOpen()) {
+        latched.mouseX = input.mouseX;
+        latched.mouseY = input.mouseY;
+        latched.mouseDown = input.mouseDown;
+        latched.keys = input.keys;
+    } else {
+        // Pumping updates SDL's mouse and key state; the events themselves
+        // stay queued for the next frame
+        pumpInput();
+        Uint32 buttons = SDL_GetMouseState(&latched.mouseX, &latched.mouseY);
+        latched.mouseDown = (buttons & SDL_BUTTON(SDL_BUTTON_LEFT)) != 0;
+        int keyCount = 0;
+        const Uint8* keyboard = SDL_GetKeyboardState(&keyCount);
+        latched.keys = KeySnapshot::fromKeyboardState(keyboard, keyCount);
+    }
+    latched.time = SDL_GetPerformanceCounter();
+}
+
+void Engine::resetInputLatency() {
+    for (LatencyHistogram& histogram : inputLatency) {
+        histogram.reset();
+    }
+}
+
+void Engine::logInputLatency() const {
+    for (int kind = 0; kind < static_cast<int>(InputLatencyKind::Count); kind++) {
+        const LatencyHistogram& histogram = inputLatency[kind];
+        if (histogram.getCount() == 0) {
+            continue;
+        }
+        SDL_Log("Input latency (%s, %llu events): mean %.3f ms, p50 %.3f ms, p95 %.3f ms, p99 %.3f ms, max %.3f ms",
+                getInputLatencyKindName(static_cast<InputLatencyKind>(kind)),
+                static_cast<unsigned long long>(histogram.getCount()), histogram.getMean(),
+                histogram.getPercentile(0.5), histogram.getPercentile(0.95), histogram.getPercentile(0.99),
+                histogram.getMax());
+    }
+}
+
+void Engine::endFrame() {
+    // The first frames size the arena, anything after that is a regression
+    bool warm = frameCount >= warmupFrames;
+    FrameArena& arena = ctx->getFrameArena();
+    if (warm && arena.getHeapAllocations() > 0) {
+        arenaOverflowFrames++;
+#ifndef NDEBUG
+        SDL_Log("Frame %llu outgrew the frame arena (%zu bytes used)",
+                static_cast<unsigned long long>(frameCount), arena.getUsed());
+#endif
+    }
+    arena.reset();
+    
+    // Collect this frame's allocations from the main thread's counters
+    Uint64 total = 0;
+    for (int zone = 0; zone < static_cast<int>(AllocationZone::Count); zone++) {
+        frameAllocations[zone] = getThreadAllocations(static_cast<AllocationZone>(zone));
+        total += frameAllocations[zone].allocations;
+    }
+    resetThreadAllocations();
+    if (warm && total > 0) {
+        allocatingFrames++;
+    }
+    
+    if (allocationAssert && warm && total > 0 && !allocationFailure) {
+        SDL_Log("Frame %llu allocated after warm-up:", static_cast<unsigned long long>(frameCount));
+        for (int zone = 0; zone < static_cast<int>(AllocationZone::Count); zone++) {
+            const AllocationCounts& counts = frameAllocations[zone];
+            if (counts.allocations > 0) {
+                SDL_Log("  %s: %llu allocations, %llu bytes",
+                        getAllocationZoneName(static_cast<AllocationZone>(zone)),
+                        static_cast<unsigned long long>(counts.allocations),
+                        static_cast<unsigned long long>(counts.bytes));
+            }
+        }
+        allocationFailure = true;
+        running = false;
+    }
+    
+    frameCount++;
+}
+
+AllocationCounts Engine::getFrameAllocations(AllocationZone zone) const {
+    if (zone == AllocationZone::Count) {
+        return AllocationCounts();
+    }
+    return frameAllocations[static_cast<int>(zone)];
+}
+
+void Engine::setAllocationAssert(bool enable, int warmupFrameCount) {
+    if (enable && !isAllocationTrackingEnabled()) {
+        SDL_Log("Allocation tracking is not built in, configure with -DCONTEXT_ENGINE_TRACK_ALLOCATIONS=ON");
+    }
+    allocationAssert = enable;
+    allocationFailure = false;
+    warmupFrames = static_cast<Uint64>(std::max(0, warmupFrameCount));
 }
 
 void Engine::run() {
@@ -185,6 +602,8 @@ void Engine::run() {
         float deltaTime = (currentTime - previousTime) / 1000.0f;
         previousTime = currentTime;
         
+        Uint64 frameStart = SDL_GetPerformanceCounter();
+        
         // Process events
         handleEvents();
         
@@ -193,14 +612,212 @@ void Engine::run() {
         
         // Render
         render();
+        endFrame();
         
-        // Cap the frame rate at ~60 FPS
-        SDL_Delay(16);
+        // Time the work of each replayed frame, without the frame cap
+        if (replay.isOpen()) {
+            Uint64 elapsed = SDL_GetPerformanceCounter() - frameStart;
+            replayFrameTimes.push_back(static_cast<float>(elapsed * 1000.0 / SDL_GetPerformanceFrequency()));
+        }
+        
+        // Cap the frame rate at ~60 FPS, or sleep until there is something
+        // to do; replays and headless runs go flat out
+        if (!headless && !replay.isOpen() && running) {
+            if (idleWaiting && !needsFrame()) {
+                // Sleeping past the wake-up isn't game time, or the next
+                // frame would get the whole idle stretch as its deltaTime
+                previousTime += waitForWork();
+            } else {
+                SDL_Delay(16);
+            }
+        }
+        invalidated = false;
     }
+    
+    // Quitting in the middle of a replay still reports what ran
+    if (replay.isOpen()) {
+        finishReplay();
+    }
+}
+
+bool Engine::needsFrame() const {
+    if (invalidated || eventsThisFrame > 0 || ctx->hasPendingText()) {
+        return true;
+    }
+    // Pumped events are taken out of SDL's queue, so waiting on it would
+    // sleep through them
+    if (inputQueue.hasPending()) {
+        return true;
+    }
+#ifdef CONTEXT_ENGINE_COROUTINES
+    if (tasks.needsUpdate()) {
+        return true;
+    }
+#endif
+    Uint64 wake = getNextWakeTime();
+    if (wake != 0 && SDL_GetPerformanceCounter() >= wake) {
+        return true;
+    }
+    if (pendingScene >= 0) {
+        return true;
+    }
+    for (size_t i = 0; i < sceneStack.size(); i++) {
+        const Scene* scene = scenes[sceneStack[i]].scene.get();
+        bool runs = i + 1 == sceneStack.size() || scene->getBackgroundUpdate() != BackgroundUpdate::Freeze;
+        if (runs && scene->isAnimating()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+Uint32 Engine::waitForWork() {
+    // Block until an event is queued (it stays queued for handleEvents) or
+    // the next wake-up is due
+    int timeout = -1;
+    Uint64 wake = getNextWakeTime();
+    if (wake != 0) {
+        Uint64 now = SDL_GetPerformanceCounter();
+        Uint64 remaining = wake > now ? wake - now : 0;
+        Uint64 milliseconds = (remaining * 1000 + SDL_GetPerformanceFrequency() - 1) / SDL_GetPerformanceFrequency();
+        timeout = static_cast<int>(std::min<Uint64>(milliseconds, 0x7FFFFFFF));
+    }
+    idleWaits++;
+    Uint32 start = SDL_GetTicks();
+    SDL_WaitEventTimeout(nullptr, timeout);
+    Uint32 slept = SDL_GetTicks() - start;
+    
+    if (wakeTime != 0 && SDL_GetPerformanceCounter() >= wakeTime) {
+        wakeTime = 0;
+    }
+    
+    // Timers and tasks still get the time up to the wake-up they asked for
+    if (timeout < 0) {
+        return slept;
+    }
+    return slept - std::min(slept, static_cast<Uint32>(timeout));
+}
+
+Uint64 Engine::getNextWakeTime() const {
+    Uint64 wake = wakeTime;
+    Uint64 frequency = SDL_GetPerformanceFrequency();
+    
+    // Sim time catches up with the wait on the next update
+    Uint64 simTick = simTimers.getNextExpiry();
+    if (simTick != TimerWheel::NO_TICK) {
+        double milliseconds = std::max(0.0, simTick - simTime * 1000.0);
+        Uint64 time = SDL_GetPerformanceCounter() + static_cast<Uint64>(std::ceil(milliseconds * frequency / 1000.0));
+        wake = wake == 0 ? time : std::min(wake, time);
+    }
+    Uint64 wallTick = wallTimers.getNextExpiry();
+    if (wallTick != TimerWheel::NO_TICK) {
+        Uint64 time = wallStart + (wallTick * frequency + 999) / 1000;
+        wake = wake == 0 ? time : std::min(wake, time);
+    }
+#ifdef CONTEXT_ENGINE_COROUTINES
+    double taskWait = tasks.getTimeToNextWake();
+    if (taskWait >= 0.0) {
+        Uint64 time = SDL_GetPerformanceCounter() + static_cast<Uint64>(std::ceil(taskWait * frequency));
+        wake = wake == 0 ? time : std::min(wake, time);
+    }
+#endif
+    return wake;
+}
+
+Uint64 Engine::getWallTick() const {
+    return (SDL_GetPerformanceCounter() - wallStart) * 1000 / SDL_GetPerformanceFrequency();
+}
+
+// Whole milliseconds, rounded up so a timer never runs early
+static Uint64 toTicks(float seconds) {
+    return static_cast<Uint64>(std::ceil(std::max(0.0f, seconds) * 1000.0f));
+}
+
+TimerId Engine::scheduleTimer(float seconds, std::function<void()> callback, TimerClock clock) {
+    if (clock == TimerClock::Sim) {
+        return simTimers.schedule(toTicks(seconds), 0, std::move(callback));
+    }
+    // Count from now rather than from the last update
+    Uint64 behind = getWallTick() - wallTimers.getTick();
+    return wallTimers.schedule(toTicks(seconds) + behind, 0, std::move(callback));
+}
+
+TimerId Engine::scheduleRepeating(float interval, std::function<void()> callback, TimerClock clock) {
+    Uint64 ticks = std::max<Uint64>(toTicks(interval), 1);
+    if (clock == TimerClock::Sim) {
+        return simTimers.schedule(ticks, ticks, std::move(callback));
+    }
+    Uint64 behind = getWallTick() - wallTimers.getTick();
+    return wallTimers.schedule(ticks + behind, ticks, std::move(callback));
+}
+
+bool Engine::cancelTimer(TimerId id) {
+    return simTimers.owns(id) ? simTimers.cancel(id) : wallTimers.cancel(id);
+}
+
+bool Engine::isTimerScheduled(TimerId id) const {
+    return simTimers.owns(id) ? simTimers.isScheduled(id) : wallTimers.isScheduled(id);
+}
+
+void Engine::wakeAfter(float seconds) {
+    Uint64 delay = static_cast<Uint64>(std::max(0.0f, seconds) * SDL_GetPerformanceFrequency());
+    Uint64 time = SDL_GetPerformanceCounter() + delay;
+    if (wakeTime == 0 || time < wakeTime) {
+        wakeTime = time;
+    }
+}
+
+bool Engine::startRecording(const std::string& path) {
+    if (replay.isOpen()) {
+        SDL_Log("Can't record input while replaying!");
+        return false;
+    }
+    return recorder.open(path, randomSeed);
+}
+
+void Engine::stopRecording() {
+    recorder.close();
+}
+
+bool Engine::startReplay(const std::string& path) {
+    recorder.close();
+    if (!replay.open(path)) {
+        return false;
+    }
+    randomSeed = replay.getSeed();
+    replayFrameTimes.clear();
+    replayFrameTimes.reserve(replay.getFrameCount());
+    return true;
+}
+
+void Engine::finishReplay() {
+    Uint32 frames = replay.getFrame();
+    replay.close();
+    running = false;
+    
+    if (replayFrameTimes.empty()) {
+        SDL_Log("Replay finished after %u frames", frames);
+        return;
+    }
+    
+    std::vector<float> sorted = replayFrameTimes;
+    std::sort(sorted.begin(), sorted.end());
+    double total = 0.0;
+    for (float time : sorted) {
+        total += time;
+    }
+    auto percentile = [&sorted](double p) {
+        return sorted[std::min(sorted.size() - 1, static_cast<size_t>(p * sorted.size()))];
+    };
+    SDL_Log("Replay finished after %u frames: mean %.3f ms, p50 %.3f ms, p95 %.3f ms, p99 %.3f ms, max %.3f ms",
+            frames, total / sorted.size(), percentile(0.5), percentile(0.95), percentile(0.99), sorted.back());
+    logInputLatency();
 }
 
 void Engine::addScene(std::unique_ptr<Scene> scene) {
-    scenes.push_back(std::move(scene));
+    SceneSlot slot;
+    slot.scene = std::move(scene);
+    scenes.push_back(std::move(slot));
     
     // If this is the first scene, make it the current scene
     if (scenes.size() == 1) {
@@ -208,19 +825,164 @@ void Engine::addScene(std::unique_ptr<Scene> scene) {
     }
 }
 
+int Engine::addSceneFactory(std::function<std::unique_ptr<Scene>()> factory) {
+    SceneSlot slot;
+    slot.factory = std::move(factory);
+    scenes.push_back(std::move(slot));
+    
+    int index = static_cast<int>(scenes.size()) - 1;
+    if (index == 0) {
+        switchScene(0);
+    }
+    return index;
+}
+
+Scene* Engine::constructScene(int index) {
+    SceneSlot& slot = scenes[index];
+    if (!slot.scene && slot.factory) {
+        slot.scene = slot.factory();
+        subscriptionStamp = ~static_cast<Uint64>(0); // Its subscriptions may not move the stamp
+    }
+    return slot.scene.get();
+}
+
+void Engine::preloadScene(int index) {
+    if (index < 0 || index >= static_cast<int>(scenes.size()) || scenes[index].state != SceneState::Unprepared) {
+        return;
+    }
+    Scene* scene = constructScene(index);
+    if (!scene) {
+        SDL_Log("Scene %d has no scene to preload", index);
+        return;
+    }
+    
+    if (!sceneLoader) {
+        sceneLoader = std::make_unique<WorkerPool>(1);
+    }
+    scenes[index].state = SceneState::Preparing;
+    sceneLoader->submit([this, scene, index] {
+        scene->prepare();
+        preparedScenes.push(int(index));
+    });
+}
+
+bool Engine::isScenePrepared(int index) const {
+    return index >= 0 && index < static_cast<int>(scenes.size()) && scenes[index].state == SceneState::Prepared;
+}
+
+Scene* Engine::getScene(int index) const {
+    if (index < 0 || index >= static_cast<int>(scenes.size())) {
+        return nullptr;
+    }
+    return scenes[index].scene.get();
+}
+
+void Engine::finishPreparing() {
+    int index;
+    while (preparedScenes.pop(index)) {
+        scenes[index].prepareDone = true;
+        if (!replay.isOpen()) {
+            scenes[index].state = SceneState::Prepared;
+            subscriptionStamp = ~static_cast<Uint64>(0);
+            recorder.recordScenePrepared(index);
+        }
+    }
+    
+    // A replay takes scenes as prepared on the frames the log says they
+    // were, so isScenePrepared and pending switches match the recording.
+    // Only a loader slower than the recorded one is waited for.
+    if (replay.isOpen()) {
+        for (int done : replay.getPreparedScenes()) {
+            if (done < 0 || done >= static_cast<int>(scenes.size()) || scenes[done].state != SceneState::Preparing) {
+                continue;
+            }
+            while (!scenes[done].prepareDone) {
+                SDL_Delay(1);
+                while (preparedScenes.pop(index)) {
+                    scenes[index].prepareDone = true;
+                }
+            }
+            scenes[done].state = SceneState::Prepared;
+            subscriptionStamp = ~static_cast<Uint64>(0);
+        }
+    }
+    
+    if (pendingScene >= 0 && scenes[pendingScene].state == SceneState::Prepared) {
+        int scene = pendingScene;
+        pendingScene = -1;
+        activateScene(scene, pendingPush);
+    }
+}
+
 void Engine::switchScene(int index) {
+    activateScene(index, false);
+}
+
+void Engine::pushScene(int index) {
+    activateScene(index, true);
+}
+
+void Engine::activateScene(int index, bool push) {
     if (index < 0 || index >= static_cast<int>(scenes.size())) {
         return;
     }
+    if (std::find(sceneStack.begin(), sceneStack.end(), index) != sceneStack.end() && index != currentSceneIndex) {
+        SDL_Log("Scene %d is already in the scene stack", index);
+        return;
+    }
+    if (index == currentSceneIndex && push) {
+        return;
+    }
+    
+    Scene* scene = constructScene(index);
+    if (!scene) {
+        SDL_Log("Scene %d could not be constructed", index);
+        return;
+    }
+    
+    SceneSlot& slot = scenes[index];
+    if (slot.state == SceneState::Preparing) {
+        // Keep the current scene running until the loader is done
+        pendingScene = index;
+        pendingPush = push;
+        return;
+    }
+    if (slot.state == SceneState::Unprepared) {
+        scene->prepare();
+        slot.state = SceneState::Prepared;
+        subscriptionStamp = ~static_cast<Uint64>(0);
+    }
     
-    // Exit current scene if needed
-    if (currentSceneIndex >= 0 && currentSceneIndex < static_cast<int>(scenes.size())) {
-        scenes[currentSceneIndex]->onExit();
+    // A direct switch overrides one still waiting
+    pendingScene = -1;
+    
+    if (push && currentSceneIndex >= 0) {
+        SceneSlot& paused = scenes[currentSceneIndex];
+        paused.backgroundTime = 0.0f;
+        paused.backgroundFrames = 0;
+        paused.backgroundFixed = 0.0f;
+        paused.scene->onPause();
+    } else if (currentSceneIndex >= 0) {
+        // Exit current scene if needed
+        scenes[currentSceneIndex].scene->onExit();
+        sceneStack.pop_back();
     }
     
     // Set and load the new scene
+    sceneStack.push_back(index);
+    slot.backgroundTime = 0.0f;
     currentSceneIndex = index;
-    scenes[currentSceneIndex]->onLoad();
+    scene->onLoad();
+}
+
+void Engine::popScene() {
+    if (sceneStack.size() < 2) {
+        return;
+    }
+    scenes[currentSceneIndex].scene->onExit();
+    sceneStack.pop_back();
+    currentSceneIndex = sceneStack.back();
+    scenes[currentSceneIndex].scene->onResume();
 }
 
 int Engine::getCurrentSceneIndex() const {
@@ -228,10 +990,24 @@ int Engine::getCurrentSceneIndex() const {
 }
 
 bool Engine::isKeyPressed(int keyCode) const {
-    if (keyCode < 0 || keyCode >= static_cast<int>(input.keys.size())) {
-        return false;
+    return input.keys.test(keyCode);
+}
+
+bool Engine::wasKeyPressed(int keyCode) const {
+    return input.keysPressed.test(keyCode) || (input.keys.test(keyCode) && !input.previousKeys.test(keyCode));
+}
+
+bool Engine::wasKeyReleased(int keyCode) const {
+    return input.keysReleased.test(keyCode) || (input.previousKeys.test(keyCode) && !input.keys.test(keyCode));
+}
+
+void Engine::syncKeys() {
+    if (replay.isOpen()) {
+        return;
     }
-    return input.keys[keyCode];
+    int keyCount = 0;
+    const Uint8* keyboard = SDL_GetKeyboardState(&keyCount);
+    input.keys = KeySnapshot::fromKeyboardState(keyboard, keyCount);
 }
 
 int Engine::getMouseX() const {
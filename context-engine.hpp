@@ -1,20 +1,37 @@
 #pragma once
 
-// For WebAssembly compatibility
-#ifdef __EMSCRIPTEN__
-#include <emscripten.h>
-#include <SDL.h>
-#include <SDL_ttf.h>
-#else
-#include <SDL2/SDL.h>
-#include <SDL2/SDL_ttf.h>
-#endif
+#include "context-types.hpp"
+#include "text-layout.hpp"
+#include "text-view.hpp"
+#include "sdf-font.hpp"
+#include "worker-pool.hpp"
+#include "font-cache.hpp"
+#include "geometry-batch.hpp"
+#include "ecs.hpp"
+#include "spatial-hash.hpp"
+#include "simd-math.hpp"
+#include "physics.hpp"
+#include "allocators.hpp"
+#include "alloc-tracker.hpp"
+#include "particles.hpp"
+#include "tilemap.hpp"
+#include "world-stream.hpp"
+#include "input-record.hpp"
+#include "input-queue.hpp"
+#include "latency-stats.hpp"
+#include "key-state.hpp"
+#include "timer-wheel.hpp"
+#include "coroutines.hpp"
 
+#include <algorithm>
 #include <string>
+#include <string_view>
 #include <functional>
 #include <vector>
 #include <memory>
+#include <list>
 #include <unordered_map>
+#include <cmath>
 
 namespace ContextEngine {
 
@@ -22,86 +39,196 @@ namespace ContextEngine {
 class Scene;
 class OtherCtx;
 
-// Color structure for easier color handling
-struct Color {
-    Uint8 r, g, b, a;
-    
-    Color() : r(255), g(255), b(255), a(255) {}
-    Color(Uint8 red, Uint8 green, Uint8 blue, Uint8 alpha = 255) 
-        : r(red), g(green), b(blue), a(alpha) {}
-        
-    SDL_Color toSDLColor() const {
-        return {r, g, b, a};
-    }
+// What a scene does while another one is on top of it in the scene stack.
+// Only the scene's own hooks are paused or slowed: engine timers and
+// coroutine tasks it started keep running, so a frozen scene should cancel
+// them in onPause. Background scenes read the same live key and mouse state
+// as the top scene, and should ignore it if the top scene owns the input.
+enum class BackgroundUpdate {
+    Freeze,  // Nothing
+    Reduced, // fixedUpdate() and update() at a lower rate, for the time saved up since the last one
+    Full     // fixedUpdate() and update() every frame as usual
 };
 
-// Rectangle structure
-struct Rect {
-    float x, y, w, h;
+// OtherCtx class for rendering
+class OtherCtx {
+private:
+    SDL_Renderer* renderer;
+    bool ownsRenderer;
+    TTF_Font* defaultFont;
+    std::unordered_map<std::string, TTF_Font*> fonts;
+    std::unordered_map<std::string, std::string> fontPaths; // Store font paths
+    std::unordered_map<std::string, int> fontSizes;
+    std::unordered_map<std::string, std::unique_ptr<GlyphAtlas>> glyphAtlases; // Created on first use
+    std::unordered_map<std::string, std::unique_ptr<SdfFont>> sdfFonts; // Created on first use
     
-    Rect() : x(0), y(0), w(0), h(0) {}
-    Rect(float x, float y, float w, float h) : x(x), y(y), w(w), h(h) {}
+    // Scratch buffers reused by drawTextLayout
+    std::vector<SDL_Vertex> textVertices;
+    std::vector<int> textIndices;
     
-    SDL_FRect toSDLFRect() const {
-        return {x, y, w, h};
-    }
+    // Legacy drawText: fonts opened per scaled size, and rendered strings in
+    // white so one texture serves every color through color mod
+    struct CachedText {
+        std::string key; // Font path, size and string
+        SDL_Texture* texture;
+        int width;
+        int height;
+    };
+    static const size_t TEXT_CACHE_CAPACITY = 256;
+    std::unordered_map<std::string, TTF_Font*> sizedFonts;
+    std::list<CachedText> cachedTexts; // Most recently drawn first
+    std::unordered_map<std::string_view, std::list<CachedText>::iterator> cachedTextIndex; // Views of the keys in the list
+    std::string textKey; // Scratch for lookups, keeps its capacity between draws
     
-    bool contains(float px, float py) const {
-        return px >= x && px <= x + w && py >= y && py <= y + h;
-    }
-};
-
-// Vector2 structure for 2D positions and movements
-struct Vector2 {
-    float x, y;
+    // Camera properties
+    Vector2 cameraPos;
+    float cameraZoom;
+    bool useCamera;
     
-    Vector2() : x(0), y(0) {}
-    Vector2(float x, float y) : x(x), y(y) {}
+    // Route drawText through distance field fonts
+    bool sdfText;
     
-    Vector2 operator+(const Vector2& other) const {
-        return Vector2(x + other.x, y + other.y);
-    }
+    // Background glyph rasterization, uploads are spread over frames
+    std::unique_ptr<WorkerPool> textWorkers;
+    size_t textUploadBudget;
+    
+    // Baked glyph atlases on disk, empty directory when disabled
+    std::string fontCacheDirectory;
+    std::vector<Uint32> fontCacheCharset;
     
-    Vector2 operator-(const Vector2& other) const {
-        return Vector2(x - other.x, y - other.y);
+    // Scratch memory for the current frame, reset by Engine after present
+    FrameArena frameArena;
+    
+    // Fill an atlas from the font cache, baking the cache first if it is missing
+    bool loadFontCache(const std::string& fontName, GlyphAtlas& atlas) {
+        if (fontCacheDirectory.empty()) {
+            return false;
+        }
+        
+        FontCacheKey key;
+        key.fontHash = hashFontFile(fontPaths[fontName]);
+        key.pointSize = fontSizes[fontName];
+        key.charsetHash = hashCharset(fontCacheCharset);
+        if (key.fontHash == 0) {
+            return false;
+        }
+        
+        std::string path = fontCacheDirectory + "/" + fontCacheFileName(key);
+        FontCache cache;
+        if (!cache.open(path, key, GlyphAtlas::PAGE_SIZE)) {
+            // First run: pay for the charset once so later launches start warm
+            if (!FontCache::bake(atlas.getFont(), key, fontCacheCharset, GlyphAtlas::PAGE_SIZE, path) ||
+                !cache.open(path, key, GlyphAtlas::PAGE_SIZE)) {
+                return false;
+            }
+        }
+        return atlas.loadCache(cache);
     }
     
-    Vector2 operator*(float scalar) const {
-        return Vector2(x * scalar, y * scalar);
+    // A font file opened at one pixel size, kept for later drawText calls
+    TTF_Font* getSizedFont(const std::string& path, int size) {
+        std::string key = path + '\n' + std::to_string(size);
+        auto it = sizedFonts.find(key);
+        if (it != sizedFonts.end()) {
+            return it->second;
+        }
+        
+        TTF_Font* font = TTF_OpenFont(path.c_str(), size);
+        if (!font) {
+            SDL_Log("Failed to create sized font! SDL_ttf Error: %s\n", TTF_GetError());
+            return nullptr;
+        }
+        sizedFonts.emplace(std::move(key), font);
+        return font;
     }
     
-    Vector2& operator+=(const Vector2& other) {
-        x += other.x;
-        y += other.y;
-        return *this;
+    // The white texture for a string, rendered on the first request
+    const CachedText* getCachedText(const std::string& path, int size, const std::string& text) {
+        // Built in place, so drawing a cached string allocates nothing
+        textKey.assign(path);
+        textKey += '\n';
+        textKey += std::to_string(size);
+        textKey += '\n';
+        textKey += text;
+        auto it = cachedTextIndex.find(textKey);
+        if (it != cachedTextIndex.end()) {
+            cachedTexts.splice(cachedTexts.begin(), cachedTexts, it->second);
+            return &*it->second;
+        }
+        
+        TTF_Font* font = getSizedFont(path, size);
+        if (!font) {
+            return nullptr;
+        }
+        
+        SDL_Surface* surface = TTF_RenderText_Blended(font, text.c_str(), SDL_Color{255, 255, 255, 255});
+        if (!surface) {
+            SDL_Log("Failed to render text surface! SDL_ttf Error: %s\n", TTF_GetError());
+            return nullptr;
+        }
+        
+        SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer, surface);
+        SDL_FreeSurface(surface);
+        if (!texture) {
+            SDL_Log("Failed to create texture from text surface! SDL Error: %s\n", SDL_GetError());
+            return nullptr;
+        }
+        
+        // Strings that change every frame would grow this forever, so drop
+        // the least recently drawn one once the cache is full
+        if (cachedTexts.size() >= TEXT_CACHE_CAPACITY) {
+            CachedText& oldest = cachedTexts.back();
+            cachedTextIndex.erase(oldest.key);
+            SDL_DestroyTexture(oldest.texture);
+            cachedTexts.pop_back();
+        }
+        
+        CachedText cached;
+        cached.key = textKey;
+        cached.texture = texture;
+        SDL_QueryTexture(texture, nullptr, nullptr, &cached.width, &cached.height);
+        cachedTexts.push_front(std::move(cached));
+        cachedTextIndex.emplace(cachedTexts.front().key, cachedTexts.begin());
+        return &cachedTexts.front();
     }
     
-    Vector2& operator-=(const Vector2& other) {
-        x -= other.x;
-        y -= other.y;
-        return *this;
+    // Release every cached legacy text texture and sized font
+    void clearTextCache() {
+        cachedTextIndex.clear();
+        for (CachedText& cached : cachedTexts) {
+            SDL_DestroyTexture(cached.texture);
+        }
+        cachedTexts.clear();
+        for (auto& [key, font] : sizedFonts) {
+            TTF_CloseFont(font);
+        }
+        sizedFonts.clear();
     }
-};
-
-// OtherCtx class for rendering
-class OtherCtx {
-private:
-    SDL_Renderer* renderer;
-    bool ownsRenderer;
-    TTF_Font* defaultFont;
-    std::unordered_map<std::string, TTF_Font*> fonts;
-    std::unordered_map<std::string, std::string> fontPaths; // Store font paths
     
-    // Camera properties
-    Vector2 cameraPos;
-    float cameraZoom;
-    bool useCamera;
+    // Submit textVertices as quads sampling one texture
+    void submitTextBatch(SDL_Texture* texture) {
+        if (textVertices.empty()) {
+            return;
+        }
+        
+        // Two triangles per quad, the index pattern is shared across frames
+        size_t quadCount = textVertices.size() / 4;
+        while (textIndices.size() < quadCount * 6) {
+            int base = static_cast<int>(textIndices.size() / 6) * 4;
+            textIndices.insert(textIndices.end(), {base, base + 1, base + 2, base + 2, base + 1, base + 3});
+        }
+        
+        SDL_RenderGeometry(renderer, texture,
+                           textVertices.data(), static_cast<int>(textVertices.size()),
+                           textIndices.data(), static_cast<int>(quadCount * 6));
+    }
 
 public:
     // Constructor with SDL_Renderer
     OtherCtx(SDL_Renderer* renderer, bool takeOwnership = false) 
         : renderer(renderer), ownsRenderer(takeOwnership), defaultFont(nullptr),
-          cameraPos(0, 0), cameraZoom(1.0f), useCamera(true) {
+          cameraPos(0, 0), cameraZoom(1.0f), useCamera(true), sdfText(false),
+          textUploadBudget(256 * 1024) {
         // Initialize TTF
         if (TTF_Init() == -1) {
             SDL_Log("SDL_ttf could not initialize! SDL_ttf Error: %s\n", TTF_GetError());
@@ -118,6 +245,14 @@ public:
         
     // Destructor
     ~OtherCtx() {
+        // Stop the workers first so no job is left holding a font
+        setAsyncText(false);
+        
+        // Atlases own textures, so release them while the renderer is alive
+        glyphAtlases.clear();
+        sdfFonts.clear();
+        clearTextCache();
+        
         // Clean up fonts
         for (auto& [name, font] : fonts) {
             if (font) {
@@ -148,6 +283,7 @@ public:
     
     OtherCtx& operator=(OtherCtx&& other) noexcept {
         if (this != &other) {
+            clearTextCache();
             if (ownsRenderer && renderer) {
                 SDL_DestroyRenderer(renderer);
             }
@@ -166,6 +302,9 @@ public:
         return renderer;
     }
     
+    // Bump allocated scratch memory that stays valid until the end of the frame
+    FrameArena& getFrameArena() { return frameArena; }
+    
     // Clear the screen with a color
     void clear(const Color& color = Color(0, 0, 0, 255)) {
         SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
@@ -247,9 +386,35 @@ public:
             return false;
         }
         
+        // Replace a font previously loaded under this name
+        auto existing = fonts.find(name);
+        if (existing != fonts.end() && existing->second) {
+            if (defaultFont == existing->second) {
+                defaultFont = font;
+            }
+            TTF_CloseFont(existing->second);
+        }
+        
+        // A distance field font only depends on the file, not the size
+        auto sdf = fontPaths.find(name);
+        if (sdf != fontPaths.end() && sdf->second != path) {
+            sdfFonts.erase(name);
+        }
+        
         // Store the font and its path
         fonts[name] = font;
         fontPaths[name] = path;
+        fontSizes[name] = size;
+        
+        // Keep any existing atlas, it drops its cached glyphs and layouts rebuild
+        auto atlas = glyphAtlases.find(name);
+        if (atlas != glyphAtlases.end()) {
+            atlas->second->setFont(font);
+            loadFontCache(name, *atlas->second);
+            if (textWorkers) {
+                atlas->second->enableAsync(textWorkers.get(), path, size);
+            }
+        }
         
         // Set as default if we don't have one
         if (!defaultFont) {
@@ -259,6 +424,294 @@ public:
         return true;
     }
     
+    // Get the glyph cache for a loaded font, creating it on first use
+    GlyphAtlas* getGlyphAtlas(const std::string& fontName = "default") {
+        auto atlas = glyphAtlases.find(fontName);
+        if (atlas != glyphAtlases.end()) {
+            return atlas->second.get();
+        }
+        
+        auto font = fonts.find(fontName);
+        if (font == fonts.end() || !font->second) {
+            return nullptr;
+        }
+        
+        auto inserted = glyphAtlases.emplace(fontName, std::make_unique<GlyphAtlas>(renderer, font->second));
+        loadFontCache(fontName, *inserted.first->second);
+        if (textWorkers) {
+            inserted.first->second->enableAsync(textWorkers.get(), fontPaths[fontName], fontSizes[fontName]);
+        }
+        return inserted.first->second.get();
+    }
+    
+    // Get the distance field version of a loaded font, creating it on first use
+    SdfFont* getSdfFont(const std::string& fontName = "default") {
+        auto sdf = sdfFonts.find(fontName);
+        if (sdf != sdfFonts.end()) {
+            return sdf->second->isLoaded() ? sdf->second.get() : nullptr;
+        }
+        
+        auto path = fontPaths.find(fontName);
+        if (path == fontPaths.end()) {
+            return nullptr;
+        }
+        
+        auto inserted = sdfFonts.emplace(fontName, std::make_unique<SdfFont>(renderer, path->second));
+        if (textWorkers) {
+            inserted.first->second->enableAsync(textWorkers.get());
+        }
+        return inserted.first->second->isLoaded() ? inserted.first->second.get() : nullptr;
+    }
+    
+    // Draw every drawText call from distance fields instead of reopening the font per size
+    void setSdfText(bool enable) { sdfText = enable; }
+    bool isSdfTextEnabled() const { return sdfText; }
+    
+    // Draw text at a pixel height from the font's distance field, scaled by the camera
+    void drawTextSdf(const std::string& text, float x, float y, const Color& color,
+                     const std::string& fontName, float pixelHeight) {
+        SdfFont* sdf = getSdfFont(fontName);
+        if (!sdf) {
+            SDL_Log("Font '%s' not found!", fontName.c_str());
+            return;
+        }
+        
+        float screenScale = pixelHeight / sdf->getBaseHeight() * (useCamera ? cameraZoom : 1.0f);
+        Vector2 pos = transformPoint(x, y);
+        
+        int pageCount = sdf->prepare(text, screenScale);
+        for (int page = 0; page < pageCount; page++) {
+            textVertices.clear();
+            sdf->appendQuads(text, pos.x, pos.y, screenScale, color.toSDLColor(), page, textVertices);
+            submitTextBatch(sdf->getPageTexture(page));
+        }
+    }
+    
+    // Load glyph atlases from baked cache files in a directory (see bake-font.cpp),
+    // writing the cache on first use when it is missing. The charset is part of
+    // the cache key, so it has to match the one the cache was baked with.
+    void setFontCache(const std::string& directory, const std::vector<Uint32>& charset = defaultCharset()) {
+        fontCacheDirectory = directory;
+        fontCacheCharset = charset;
+        for (auto& [name, atlas] : glyphAtlases) {
+            loadFontCache(name, *atlas);
+        }
+    }
+    
+    // Rasterize new glyphs on worker threads instead of stalling the frame;
+    // text shows placeholders until its glyphs have been uploaded
+    void setAsyncText(bool enable) {
+        if (enable == (textWorkers != nullptr)) {
+            return;
+        }
+        
+        if (enable) {
+            textWorkers = std::make_unique<WorkerPool>();
+            for (auto& [name, atlas] : glyphAtlases) {
+                atlas->enableAsync(textWorkers.get(), fontPaths[name], fontSizes[name]);
+            }
+            for (auto& [name, sdf] : sdfFonts) {
+                sdf->enableAsync(textWorkers.get());
+            }
+        } else {
+            for (auto& [name, atlas] : glyphAtlases) {
+                atlas->disableAsync();
+            }
+            for (auto& [name, sdf] : sdfFonts) {
+                sdf->disableAsync();
+            }
+            textWorkers.reset();
+        }
+    }
+    bool isAsyncTextEnabled() const { return textWorkers != nullptr; }
+    
+    // Bytes of glyph pixels uploaded per frame at most
+    void setTextUploadBudget(size_t bytes) { textUploadBudget = bytes; }
+    
+    // Whether glyphs are still being built in the background, so frames are
+    // needed to show them
+    bool hasPendingText() const {
+        for (const auto& [name, atlas] : glyphAtlases) {
+            if (atlas->getPendingCount() > 0) {
+                return true;
+            }
+        }
+        for (const auto& [name, sdf] : sdfFonts) {
+            if (sdf->getPendingCount() > 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+    
+    // Upload glyphs finished by the workers, called once per frame by the engine
+    void processTextUploads() {
+        if (!textWorkers) {
+            return;
+        }
+        
+        size_t remaining = textUploadBudget;
+        for (auto& [name, atlas] : glyphAtlases) {
+            size_t used = atlas->processUploads(remaining);
+            remaining = used < remaining ? remaining - used : 0;
+        }
+        for (auto& [name, sdf] : sdfFonts) {
+            size_t used = sdf->processUploads(remaining);
+            remaining = used < remaining ? remaining - used : 0;
+        }
+    }
+    
+    // Measure text without rendering it, using cached glyph metrics
+    Vector2 measureText(const std::string& text, const std::string& fontName = "default", float textSize = 1.0f) {
+        GlyphAtlas* atlas = getGlyphAtlas(fontName);
+        if (!atlas) {
+            SDL_Log("Font '%s' not found!", fontName.c_str());
+            return Vector2(0, 0);
+        }
+        
+        return ContextEngine::measureText(*atlas, text) * textSize;
+    }
+    
+    // Draw a laid out text block, batching glyphs per atlas page
+    void drawTextLayout(const TextLayout& layout, float x, float y, const Color& color) {
+        GlyphAtlas* atlas = layout.getFont();
+        if (!atlas) {
+            SDL_Log("Text layout has no font!");
+            return;
+        }
+        
+        const std::vector<PositionedGlyph>& glyphs = layout.getGlyphs();
+        const float scale = useCamera ? cameraZoom : 1.0f;
+        const float invPage = 1.0f / GlyphAtlas::PAGE_SIZE;
+        const SDL_Color vertexColor = color.toSDLColor();
+        
+        // Rasterize anything new first so the page count is final
+        for (const PositionedGlyph& glyph : glyphs) {
+            atlas->getGlyph(glyph.codepoint);
+        }
+        
+        for (int page = 0; page < atlas->getPageCount(); page++) {
+            textVertices.clear();
+            
+            for (const PositionedGlyph& glyph : glyphs) {
+                const GlyphInfo& info = atlas->getGlyph(glyph.codepoint);
+                if (info.page != page) {
+                    continue;
+                }
+                
+                Vector2 pos = useCamera ? transformPoint(x + glyph.x, y + glyph.y) : Vector2(x + glyph.x, y + glyph.y);
+                float w = info.src.w * scale;
+                float h = info.src.h * scale;
+                float u0 = info.src.x * invPage;
+                float v0 = info.src.y * invPage;
+                float u1 = (info.src.x + info.src.w) * invPage;
+                float v1 = (info.src.y + info.src.h) * invPage;
+                
+                textVertices.push_back({SDL_FPoint{pos.x, pos.y}, vertexColor, SDL_FPoint{u0, v0}});
+                textVertices.push_back({SDL_FPoint{pos.x + w, pos.y}, vertexColor, SDL_FPoint{u1, v0}});
+                textVertices.push_back({SDL_FPoint{pos.x, pos.y + h}, vertexColor, SDL_FPoint{u0, v1}});
+                textVertices.push_back({SDL_FPoint{pos.x + w, pos.y + h}, vertexColor, SDL_FPoint{u1, v1}});
+            }
+            
+            submitTextBatch(atlas->getPageTexture(page));
+        }
+    }
+    
+    // Draw an editable text buffer; lines reuse their cached glyph quads
+    void drawEditableText(EditableText& text, float x, float y) {
+        GlyphAtlas* atlas = text.getFont();
+        if (!atlas) {
+            SDL_Log("Editable text has no font!");
+            return;
+        }
+        
+        const float lineHeight = text.getLineHeight();
+        const size_t lineCount = text.getLines().size();
+        
+        // Build missing quads first so the page count is final
+        for (size_t i = 0; i < lineCount; i++) {
+            text.getLineQuads(i);
+        }
+        
+        for (int page = 0; page < atlas->getPageCount(); page++) {
+            textVertices.clear();
+            
+            for (size_t i = 0; i < lineCount; i++) {
+                const EditableLine& line = text.getLineQuads(i);
+                float lineY = y + i * lineHeight;
+                
+                for (size_t quad = 0; quad < line.quadPages.size(); quad++) {
+                    if (line.quadPages[quad] != page) {
+                        continue;
+                    }
+                    for (size_t corner = 0; corner < 4; corner++) {
+                        SDL_Vertex vertex = line.quads[quad * 4 + corner];
+                        Vector2 pos = transformPoint(x + vertex.position.x, lineY + vertex.position.y);
+                        vertex.position = SDL_FPoint{pos.x, pos.y};
+                        textVertices.push_back(vertex);
+                    }
+                }
+            }
+            
+            submitTextBatch(atlas->getPageTexture(page));
+        }
+    }
+    
+    // Draw the visible part of a text view, clipped to its bounds
+    void drawTextView(TextView& view, const Color& color) {
+        GlyphAtlas* atlas = view.getFont();
+        if (!atlas) {
+            SDL_Log("Text view has no font!");
+            return;
+        }
+        
+        const Rect& bounds = view.getBounds();
+        const float lineHeight = view.getLineHeight();
+        const size_t first = view.getFirstVisibleLine();
+        const size_t count = view.getVisibleLineCount();
+        const float top = bounds.y - view.getScroll();
+        const SDL_Color vertexColor = color.toSDLColor();
+        
+        // Lay out any lines that scrolled into view before batching
+        for (size_t line = first; line < first + count; line++) {
+            view.getLineQuads(line);
+        }
+        
+        Vector2 clipMin = transformPoint(bounds.x, bounds.y);
+        Vector2 clipMax = transformPoint(bounds.x + bounds.w, bounds.y + bounds.h);
+        SDL_Rect clip = {
+            static_cast<int>(clipMin.x), static_cast<int>(clipMin.y),
+            static_cast<int>(std::ceil(clipMax.x - clipMin.x)), static_cast<int>(std::ceil(clipMax.y - clipMin.y))
+        };
+        SDL_RenderSetClipRect(renderer, &clip);
+        
+        for (int page = 0; page < atlas->getPageCount(); page++) {
+            textVertices.clear();
+            
+            for (size_t line = first; line < first + count; line++) {
+                const TextViewLine& cached = view.getLineQuads(line);
+                float lineY = top + line * lineHeight;
+                
+                for (size_t quad = 0; quad < cached.quadPages.size(); quad++) {
+                    if (cached.quadPages[quad] != page) {
+                        continue;
+                    }
+                    for (size_t corner = 0; corner < 4; corner++) {
+                        SDL_Vertex vertex = cached.quads[quad * 4 + corner];
+                        Vector2 pos = transformPoint(bounds.x + vertex.position.x, lineY + vertex.position.y);
+                        vertex.position = SDL_FPoint{pos.x, pos.y};
+                        vertex.color = vertexColor;
+                        textVertices.push_back(vertex);
+                    }
+                }
+            }
+            
+            submitTextBatch(atlas->getPageTexture(page));
+        }
+        
+        SDL_RenderSetClipRect(renderer, nullptr);
+    }
+    
     // Draw text using the default font
     void drawText(const std::string& text, float x, float y, const Color& color, float textSize = 1.0f) {
         if (!defaultFont) {
@@ -290,48 +743,42 @@ public:
         // Get the original font size
         int originalSize = TTF_FontHeight(font);
         
-        // Find the font name and path
-        std::string fontPath;
+        // Find the font name and path, pointing into the maps instead of copying
+        const std::string* fontName = nullptr;
+        const std::string* fontPath = nullptr;
         for (const auto& [name, f] : fonts) {
             if (f == font) {
-                fontPath = fontPaths[name];
+                auto path = fontPaths.find(name);
+                if (path != fontPaths.end()) {
+                    fontName = &name;
+                    fontPath = &path->second;
+                }
                 break;
             }
         }
         
-        if (fontPath.empty()) {
+        if (!fontPath || fontPath->empty()) {
             SDL_Log("Could not find font path for resizing!");
             return;
         }
         
-        // Create a new font with the desired size
-        TTF_Font* sizedFont = TTF_OpenFont(fontPath.c_str(), static_cast<int>(originalSize * textSize));
-        if (!sizedFont) {
-            SDL_Log("Failed to create sized font! SDL_ttf Error: %s\n", TTF_GetError());
+        if (sdfText) {
+            drawTextSdf(text, x, y, color, *fontName, originalSize * textSize);
             return;
         }
         
-        // Render the text to a surface
-        SDL_Surface* surface = TTF_RenderText_Blended(sizedFont, text.c_str(), color.toSDLColor());
-        TTF_CloseFont(sizedFont); // Clean up the temporary font
-        
-        if (!surface) {
-            SDL_Log("Failed to render text surface! SDL_ttf Error: %s\n", TTF_GetError());
-            return;
-        }
-        
-        // Create a texture from the surface
-        SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer, surface);
-        SDL_FreeSurface(surface);
-        
-        if (!texture) {
-            SDL_Log("Failed to create texture from text surface! SDL Error: %s\n", SDL_GetError());
+        // Opening the font and rasterizing the string only happen the first
+        // time this text is drawn at this size
+        const CachedText* cached = getCachedText(*fontPath, static_cast<int>(originalSize * textSize), text);
+        if (!cached) {
             return;
         }
-        
-        // Set up the destination rectangle
-        int textWidth, textHeight;
-        SDL_QueryTexture(texture, nullptr, nullptr, &textWidth, &textHeight);
+        SDL_Texture* texture = cached->texture;
+        int textWidth = cached->width;
+        int textHeight = cached->height;
+        SDL_Color tint = color.toSDLColor();
+        SDL_SetTextureColorMod(texture, tint.r, tint.g, tint.b);
+        SDL_SetTextureAlphaMod(texture, tint.a);
         
         // Apply camera transformation if enabled
         float renderX = x;
@@ -351,9 +798,6 @@ public:
         
         // Draw the texture
         SDL_RenderCopyF(renderer, texture, nullptr, &destRect);
-        
-        // Clean up
-        SDL_DestroyTexture(texture);
     }
 
     // Camera control methods
@@ -364,13 +808,37 @@ public:
     float getCameraZoom() const { return cameraZoom; }
     bool isCameraEnabled() const { return useCamera; }
 
-    // Transform coordinates based on camera
+    // Transform coordinates based on camera, matching transformPoints exactly
     Vector2 transformPoint(float x, float y) const {
         if (!useCamera) return Vector2(x, y);
-        return Vector2(
-            (x - cameraPos.x) * cameraZoom,
-            (y - cameraPos.y) * cameraZoom
-        );
+        return cameraTransformPoint(Vector2(x, y), cameraPos, cameraZoom);
+    }
+
+    // transformPoint for a whole array at once, using SIMD where available
+    void transformPoints(const Vector2* in, Vector2* out, size_t count) const {
+        if (!useCamera) {
+            if (in != out) {
+                std::copy(in, in + count, out);
+            }
+            return;
+        }
+        cameraTransformPoints(in, out, count, cameraPos, cameraZoom);
+    }
+
+    // Inverse of transformPoint, e.g. to pick objects under the mouse
+    Vector2 screenToWorld(float x, float y) const {
+        if (!useCamera) return Vector2(x, y);
+        return Vector2(x / cameraZoom + cameraPos.x, y / cameraZoom + cameraPos.y);
+    }
+
+    // World area currently on screen, for culling with SpatialHash::queryRect
+    Rect getViewRect() const {
+        int width = 0;
+        int height = 0;
+        SDL_GetRendererOutputSize(renderer, &width, &height);
+        Vector2 topLeft = screenToWorld(0, 0);
+        Vector2 bottomRight = screenToWorld(static_cast<float>(width), static_cast<float>(height));
+        return Rect(topLeft.x, topLeft.y, bottomRight.x - topLeft.x, bottomRight.y - topLeft.y);
     }
 
     // Draw a triangle
@@ -625,6 +1093,11 @@ public:
     void drawRoundedRectLines(float x, float y, float width, float height, float radius, const Color& color) {
         drawRoundedRect(x, y, width, height, radius, color, false);
     }
+
+    // Draw a prepared batch of screen space triangles in one call
+    void drawBatch(const GeometryBatch& batch, SDL_Texture* texture = nullptr) {
+        batch.draw(renderer, texture);
+    }
 };
 
 // Engine class to manage the game window, renderer, and scenes
@@ -633,20 +1106,138 @@ private:
     SDL_Window* window;
     SDL_Renderer* renderer;
     std::unique_ptr<OtherCtx> ctx;
-    std::vector<std::unique_ptr<Scene>> scenes;
-    int currentSceneIndex;
+    int currentSceneIndex; // Top of the scene stack
+    
+    // Scenes in the order they were added; factory scenes are constructed
+    // when first preloaded or shown
+    enum class SceneState {
+        Unprepared,
+        Preparing, // prepare() is running on the scene loader
+        Prepared
+    };
+    struct SceneSlot {
+        std::unique_ptr<Scene> scene;
+        std::function<std::unique_ptr<Scene>()> factory;
+        SceneState state = SceneState::Unprepared;
+        float backgroundTime = 0.0f;   // Saved up for a Reduced update
+        int backgroundFrames = 0;      // Frames in backgroundTime
+        float backgroundFixed = 0.0f;  // Fixed step leftover of Reduced updates
+        bool prepareDone = false;      // prepare() returned on the loader
+    };
+    std::vector<SceneSlot> scenes;
+    std::vector<int> sceneStack; // Bottom first
+    
+    // A switch or push waiting for its scene to finish preparing
+    int pendingScene;
+    bool pendingPush;
+    
+    std::unique_ptr<WorkerPool> sceneLoader; // Started by the first preloadScene
+    CompletionQueue<int> preparedScenes;
+    
+    Scene* constructScene(int index);
+    void activateScene(int index, bool push);
+    void finishPreparing();
     bool running;
     
+    // Fixed timestep for Scene::fixedUpdate
+    float fixedTimestep;
+    float fixedAccumulator;
+    int maxFixedSteps;
+    
+    // Frames past warm-up that outgrew the frame arena, and that made any
+    // heap allocation at all (the latter needs allocation tracking)
+    Uint64 frameCount;
+    Uint64 arenaOverflowFrames;
+    Uint64 allocatingFrames;
+    Uint64 warmupFrames;
+    
+    // Heap allocations of the last frame per phase, when tracking is built in
+    AllocationCounts frameAllocations[static_cast<int>(AllocationZone::Count)];
+    bool allocationAssert;
+    bool allocationFailure;
+    
+    // Input recording and replay
+    bool headless;
+    Uint32 randomSeed;
+    InputRecorder recorder;
+    InputReplay replay;
+    std::vector<SDL_Event> replayEvents;
+    float replayDeltaTime;
+    std::vector<float> replayFrameTimes; // Milliseconds of work per replayed frame
+    
+    // Engine handling of one event, then the current scene's
+    void handleQueuedEvent(const InputEvent& queued);
+    void dispatchEvent(const SDL_Event& event);
+    void trackLatency(const SDL_Event& event);
+    void refreshEventFilter();
+    void finishReplay();
+    
+    // Events for a scene that takes them in one batch per frame
+    std::vector<SDL_Event> sceneEvents;
+    void flushSceneEvents();
+    
+    // Events as they arrive, drained by handleEvents
+    InputQueue inputQueue;
+    Uint64 eventTime;
+    bool eventFiltering;
+    Uint64 subscriptionStamp; // Scene subscriptions the filter was built from
+    
+    // Arrival times of the events handled this frame, charged at present
+    struct PendingLatency {
+        InputLatencyKind kind;
+        Uint64 time;
+    };
+    std::vector<PendingLatency> pendingLatencies;
+    LatencyHistogram inputLatency[static_cast<int>(InputLatencyKind::Count)];
+    
+    // Input sampled by latchInput
+    struct {
+        int mouseX, mouseY;
+        bool mouseDown;
+        KeySnapshot keys;
+        Uint64 time;
+    } latched;
+    
+    // Idle waiting in run()
+    bool idleWaiting;
+    bool invalidated;
+    int eventsThisFrame;
+    Uint64 wakeTime; // Performance counter of the next requested wake-up, 0 for none
+    Uint64 idleWaits;
+    
+    bool needsFrame() const;
+    Uint32 waitForWork(); // Returns the milliseconds slept past the wake-up
+    Uint64 getNextWakeTime() const; // Performance counter, 0 for none
+    
+    // Scheduled callbacks in millisecond ticks
+    TimerWheel simTimers;
+    TimerWheel wallTimers;
+    double simTime;   // Seconds
+    Uint64 wallStart; // Performance counter at wall tick 0
+    Uint64 getWallTick() const;
+    
+#ifdef CONTEXT_ENGINE_COROUTINES
+    // Scripted tasks, resumed in update()
+    TaskScheduler tasks;
+#endif
+    
     // Input state
     struct {
         int mouseX, mouseY;
         bool mouseDown;
-        bool mouseReleased;
-        std::vector<bool> keys;
+        bool mousePressed;  // This frame
+        bool mouseReleased; // This frame
+        KeySnapshot keys;
+        KeySnapshot previousKeys; // At the start of the frame
+        KeySnapshot keysPressed;  // Events this frame, without key repeat
+        KeySnapshot keysReleased; // Events this frame
     } input;
 
 public:
-    Engine(const char* title, int width, int height);
+    // A headless engine renders in software to a hidden window (on SDL's
+    // dummy video driver unless SDL_VIDEODRIVER says otherwise) and run()
+    // doesn't cap the frame rate, for replaying logs on machines without a display
+    Engine(const char* title, int width, int height, bool headless = false);
     ~Engine();
     
     // Prevent copying
@@ -660,11 +1251,37 @@ public:
     void handleEvents();
     void update(float deltaTime);
     void render();
+    void endFrame(); // Checks and resets the frame arena
     void run();
     
-    // Scene management
+    // Scene management. Scenes are numbered in the order they are added,
+    // and the first one added is shown right away.
     void addScene(std::unique_ptr<Scene> scene);
+    
+    // Add a scene that is only constructed when it is first preloaded or
+    // shown; returns its index
+    int addSceneFactory(std::function<std::unique_ptr<Scene>()> factory);
+    
+    // Replace the top of the scene stack
     void switchScene(int index);
+    
+    // Show a scene over the current one, which keeps its state and runs in
+    // the background as its BackgroundUpdate says
+    void pushScene(int index);
+    
+    // Drop the top scene and resume the one below it; the last scene stays
+    void popScene();
+    
+    // Start the scene's prepare() on a worker thread. Switching to or
+    // pushing a scene that is still preparing takes effect on the first
+    // update after it is done, and the current scene keeps running until
+    // then. Scenes that were never preloaded prepare on the spot.
+    void preloadScene(int index);
+    bool isScenePrepared(int index) const;
+    
+    Scene* getScene(int index) const; // Null until constructed
+    int getSceneCount() const { return static_cast<int>(scenes.size()); }
+    int getSceneStackDepth() const { return static_cast<int>(sceneStack.size()); }
     int getCurrentSceneIndex() const;
     
     // Input methods
@@ -674,12 +1291,155 @@ public:
     bool isMouseDown() const;
     bool isMouseReleased() const;
     
+    // Edges since the last handleEvents, taken from every queued event in
+    // order, so a press and release in the same frame report both
+    bool wasKeyPressed(int keyCode) const;
+    bool wasKeyReleased(int keyCode) const;
+    bool wasMousePressed() const { return input.mousePressed; }
+    
+    // Whole key sets, one bit per scancode. Pressed and released are this
+    // frame's edges, from the events seen and from how the snapshot changed
+    // since the last frame; held keys were down in both frames.
+    const KeySnapshot& getKeys() const { return input.keys; }
+    const KeySnapshot& getPreviousKeys() const { return input.previousKeys; }
+    KeySnapshot getPressedKeys() const { return input.keysPressed | input.keys.without(input.previousKeys); }
+    KeySnapshot getReleasedKeys() const { return input.keysReleased | input.previousKeys.without(input.keys); }
+    KeySnapshot getHeldKeys() const { return input.keys & input.previousKeys; }
+    
+    // Any of a set of keys, e.g. KeySnapshot::of({SDL_SCANCODE_W, SDL_SCANCODE_UP})
+    bool isAnyKeyPressed(const KeySnapshot& mask) const { return input.keys.any(mask); }
+    bool wasAnyKeyPressed(const KeySnapshot& mask) const { return getPressedKeys().any(mask); }
+    
+    // Take the key state straight from SDL_GetKeyboardState instead of the
+    // events, e.g. after events were dropped; the edges pick up any change.
+    // Does nothing while replaying.
+    void syncKeys();
+    
+    // Performance counter when the event being handled reached SDL; valid
+    // inside Scene::handleEvent
+    Uint64 getEventTime() const { return eventTime; }
+    
+    // Collect waiting OS input mid-frame so it is timestamped on arrival.
+    // render() does this before presenting.
+    void pumpInput() { inputQueue.pump(); }
+    Uint64 getDroppedInputCount() const { return inputQueue.getDroppedCount(); }
+    
+    // Drop input event types that no scene subscribed to (see
+    // Scene::subscribeEvent) in an SDL event filter, and merge runs of mouse
+    // motion into one event per frame with the summed relative motion. Both
+    // are on by default.
+    void setEventFiltering(bool enable);
+    void setMotionCoalescing(bool enable) { inputQueue.setMotionCoalescing(enable); }
+    Uint64 getFilteredEventCount() const { return inputQueue.getFilteredCount(); }
+    Uint64 getCoalescedEventCount() const { return inputQueue.getCoalescedCount(); }
+    
+    // Late latching: sample the newest mouse and key state just before
+    // drawing latency critical things like cursors and crosshairs, ahead of
+    // the events that will update the regular state next frame. render()
+    // latches before the scene draws; call again to sample even later.
+    // Replays latch the regular state so they stay deterministic.
+    void latchInput();
+    int getLatchedMouseX() const { return latched.mouseX; }
+    int getLatchedMouseY() const { return latched.mouseY; }
+    bool isLatchedMouseDown() const { return latched.mouseDown; }
+    bool isLatchedKeyDown(int keyCode) const { return latched.keys.test(keyCode); }
+    const KeySnapshot& getLatchedKeys() const { return latched.keys; }
+    Uint64 getLatchTime() const { return latched.time; }
+    
+    // Time from an input event reaching SDL to the present of the first
+    // frame that handled it, per kind of input, since the last reset
+    const LatencyHistogram& getInputLatency(InputLatencyKind kind) const {
+        return inputLatency[static_cast<int>(kind)];
+    }
+    void resetInputLatency();
+    void logInputLatency() const;
+    
     // Access to context
     OtherCtx* getContext() const;
     
     // Get current window size
     Vector2 getWindowSize() const;
     
+    // Fixed timestep (default 1/60 s). update() runs fixedUpdate as many
+    // times as fit in the elapsed time, at most maxSteps per frame so a long
+    // stall doesn't spiral; the leftover carries to the next frame.
+    void setFixedTimestep(float seconds, int maxSteps = 5);
+    float getFixedTimestep() const { return fixedTimestep; }
+    
+    // How far between the last two fixed steps this frame is (0..1), for
+    // interpolating what is drawn
+    float getFixedAlpha() const { return fixedAccumulator / fixedTimestep; }
+    
+    // Frames past warm-up whose scratch memory didn't fit the frame arena
+    // and went to the heap; a steady state should keep this at zero
+    Uint64 getArenaOverflowFrameCount() const { return arenaOverflowFrames; }
+    
+    // Frames past warm-up that called the heap anywhere on the main thread.
+    // Needs a build with CONTEXT_ENGINE_TRACK_ALLOCATIONS; otherwise zero.
+    Uint64 getAllocatingFrameCount() const { return allocatingFrames; }
+    
+    // Heap allocations the last frame made in one phase. Needs a build with
+    // CONTEXT_ENGINE_TRACK_ALLOCATIONS; otherwise always zero.
+    AllocationCounts getFrameAllocations(AllocationZone zone) const;
+    
+    // Test mode: once warm-up is over, the first frame that allocates is
+    // logged with its per phase counts and stops the engine, and
+    // hasAllocationFailure() reports it
+    void setAllocationAssert(bool enable, int warmupFrameCount = 60);
+    bool hasAllocationFailure() const { return allocationFailure; }
+    
+    // Seed for anything a scene randomizes. Recorded in input logs and
+    // restored by startReplay, so replays see the same random choices.
+    Uint32 getRandomSeed() const { return randomSeed; }
+    
+    // Log every event and each frame's deltaTime to a file until stopped
+    bool startRecording(const std::string& path);
+    void stopRecording();
+    bool isRecording() const { return recorder.isOpen(); }
+    
+    // Feed a log back in frame by frame instead of live input, with the
+    // recorded deltaTimes. Only quitting is taken from live input. When the
+    // log runs out the frame time summary is logged and the engine stops.
+    // Start before adding scenes that use getRandomSeed().
+    bool startReplay(const std::string& path);
+    bool isReplaying() const { return replay.isOpen(); }
+    const std::vector<float>& getReplayFrameTimes() const { return replayFrameTimes; }
+    
+    // Idle policy for run(): after a frame where nothing happened (no input,
+    // no invalidate(), the scene isn't animating and no text is still
+    // loading) the loop blocks in SDL_WaitEventTimeout until input arrives or
+    // the next wake-up is due, instead of drawing the same frame again. It
+    // wakes on the first input event and runs at full rate while anything is
+    // happening. Off by default.
+    void setIdleWaiting(bool enable) { idleWaiting = enable; }
+    bool isIdleWaiting() const { return idleWaiting; }
+    
+    // Run at least one more frame
+    void invalidate() { invalidated = true; }
+    
+    // Make sure a frame runs once this many seconds have passed, e.g. for a
+    // blinking cursor; the earliest request wins
+    void wakeAfter(float seconds);
+    
+    // Times the loop blocked waiting for work
+    Uint64 getIdleWaitCount() const { return idleWaits; }
+    
+    // Run a callback once after a delay in seconds, or every interval seconds
+    // until cancelled. Due timers run at the start of update(), before the
+    // scene, and an idle waiting loop wakes up for the next one.
+    TimerId scheduleTimer(float seconds, std::function<void()> callback, TimerClock clock = TimerClock::Sim);
+    TimerId scheduleRepeating(float interval, std::function<void()> callback, TimerClock clock = TimerClock::Sim);
+    bool cancelTimer(TimerId id); // False if it already fired or was cancelled
+    bool isTimerScheduled(TimerId id) const;
+    double getSimTime() const { return simTime; }
+    
+#ifdef CONTEXT_ENGINE_COROUTINES
+    // Coroutine tasks for scene scripting, resumed in update() after the
+    // timers and before the scene. Their waitSeconds count sim time and
+    // waitForEvent sees every event the engine handles.
+    TaskScheduler& getTasks() { return tasks; }
+#endif
+    
     // Stop the engine
     void quit();
 };
@@ -693,8 +1453,98 @@ public:
     virtual void onLoad() {}
     virtual void onExit() {}
     virtual void handleEvent(const SDL_Event& event) {}
+    virtual void fixedUpdate(float /*fixedDeltaTime*/, Engine* /*engine*/) {} // Physics and other simulation
     virtual void update(float deltaTime, Engine* engine) {}
     virtual void render(OtherCtx* ctx) {}
+    
+    // Whether the scene changes on its own, without input. Returning false
+    // lets an idle waiting engine sleep until input or a wake-up.
+    virtual bool isAnimating() const { return true; }
+    
+    // Work done before the scene is first shown, such as loading and
+    // decoding its assets. Engine::preloadScene runs it on a worker thread,
+    // so it may only fill in the scene's own data: no renderer, engine or
+    // subscribeEvent calls.
+    virtual void prepare() {}
+    
+    // Called when another scene is pushed over this one, and when this one
+    // is back on top
+    virtual void onPause() {}
+    virtual void onResume() {}
+    
+    // Whether the scenes under this one in the stack still draw beneath it,
+    // e.g. for a pause menu
+    virtual bool isOverlay() const { return false; }
+    
+    // How this scene runs while another one is on top; frozen by default
+    void setBackgroundUpdate(BackgroundUpdate mode, float rate = 10.0f) {
+        backgroundUpdate = mode;
+        backgroundRate = rate > 0.0f ? rate : 10.0f;
+    }
+    BackgroundUpdate getBackgroundUpdate() const { return backgroundUpdate; }
+    float getBackgroundRate() const { return backgroundRate; } // Updates per second when Reduced
+    
+    // Event types handleEvent gets. A scene that never subscribes gets every
+    // event; once it does, only the types it asked for. Input types that no
+    // scene (nor the engine) wants are dropped before SDL queues them.
+    void subscribeEvent(Uint32 type) {
+        auto at = std::lower_bound(eventTypes.begin(), eventTypes.end(), type);
+        if (at == eventTypes.end() || *at != type) {
+            eventTypes.insert(at, type);
+        }
+        filtersEvents = true;
+        subscriptionRevision++;
+    }
+    
+    void unsubscribeEvent(Uint32 type) {
+        auto at = std::lower_bound(eventTypes.begin(), eventTypes.end(), type);
+        if (at != eventTypes.end() && *at == type) {
+            eventTypes.erase(at);
+        }
+        subscriptionRevision++;
+    }
+    
+    bool wantsEvent(Uint32 type) const {
+        return !filtersEvents || std::binary_search(eventTypes.begin(), eventTypes.end(), type);
+    }
+    
+    // Stop getting any events until the next subscribeEvent
+    void unsubscribeAllEvents() {
+        eventTypes.clear();
+        filtersEvents = true;
+        subscriptionRevision++;
+    }
+
+    // Go back to getting every event
+    void subscribeAllEvents() {
+        eventTypes.clear();
+        filtersEvents = false;
+        subscriptionRevision++;
+    }
+
+    bool filtersEventTypes() const { return filtersEvents; }
+    Uint32 getSubscriptionRevision() const { return subscriptionRevision; }
+    
+    // With batching on, the engine saves up the events this scene wants and
+    // hands them to handleEventBatch once per frame, in order, after its own
+    // input state has seen all of them, instead of calling handleEvent for
+    // each one
+    virtual void handleEventBatch(const SDL_Event* events, size_t count) {
+        for (size_t i = 0; i < count; i++) {
+            handleEvent(events[i]);
+        }
+    }
+    void setBatchedEvents(bool enable) { batchedEvents = enable; }
+    bool batchesEvents() const { return batchedEvents; }
+    
+private:
+    BackgroundUpdate backgroundUpdate = BackgroundUpdate::Freeze;
+    float backgroundRate = 10.0f;
+    
+    std::vector<Uint32> eventTypes; // Sorted
+    bool filtersEvents = false;
+    bool batchedEvents = false;
+    Uint32 subscriptionRevision = 0;
 };
 
 } // namespace ContextEngine
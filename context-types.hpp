@@ -0,0 +1,76 @@
+#pragma once
+
+// For WebAssembly compatibility
+#ifdef __EMSCRIPTEN__
+#include <emscripten.h>
+#include <SDL.h>
+#include <SDL_ttf.h>
+#else
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+#endif
+
+namespace ContextEngine {
+
+// Color structure for easier color handling
+struct Color {
+    Uint8 r, g, b, a;
+    
+    Color() : r(255), g(255), b(255), a(255) {}
+    Color(Uint8 red, Uint8 green, Uint8 blue, Uint8 alpha = 255) 
+        : r(red), g(green), b(blue), a(alpha) {}
+        
+    SDL_Color toSDLColor() const {
+        return {r, g, b, a};
+    }
+};
+
+// Rectangle structure
+struct Rect {
+    float x, y, w, h;
+    
+    Rect() : x(0), y(0), w(0), h(0) {}
+    Rect(float x, float y, float w, float h) : x(x), y(y), w(w), h(h) {}
+    
+    SDL_FRect toSDLFRect() const {
+        return {x, y, w, h};
+    }
+    
+    bool contains(float px, float py) const {
+        return px >= x && px <= x + w && py >= y && py <= y + h;
+    }
+};
+
+// Vector2 structure for 2D positions and movements
+struct Vector2 {
+    float x, y;
+    
+    Vector2() : x(0), y(0) {}
+    Vector2(float x, float y) : x(x), y(y) {}
+    
+    Vector2 operator+(const Vector2& other) const {
+        return Vector2(x + other.x, y + other.y);
+    }
+    
+    Vector2 operator-(const Vector2& other) const {
+        return Vector2(x - other.x, y - other.y);
+    }
+    
+    Vector2 operator*(float scalar) const {
+        return Vector2(x * scalar, y * scalar);
+    }
+    
+    Vector2& operator+=(const Vector2& other) {
+        x += other.x;
+        y += other.y;
+        return *this;
+    }
+    
+    Vector2& operator-=(const Vector2& other) {
+        x -= other.x;
+        y -= other.y;
+        return *this;
+    }
+};
+
+} // namespace ContextEngine
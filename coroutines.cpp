@@ -0,0 +1,264 @@
+#include "coroutines.hpp"
+
+#ifdef CONTEXT_ENGINE_COROUTINES
+
+#include <algorithm>
+#include <cmath>
+
+namespace ContextEngine {
+
+static const size_t FRAME_CLASS_SIZE = 64;
+static const size_t FRAME_CLASSES = 32;     // Up to 2 KB; larger frames use the heap directly
+static const size_t FRAMES_PER_CHUNK = 32;
+
+// Chunks are kept for the life of the process, so frames can still be
+// released by schedulers destroyed during static destruction
+static void* freeFrames[FRAME_CLASSES];
+static size_t frameChunks = 0;
+
+void* TaskFramePool::allocate(size_t size) {
+    size_t index = (size + FRAME_CLASS_SIZE - 1) / FRAME_CLASS_SIZE - 1;
+    if (index >= FRAME_CLASSES) {
+        return ::operator new(size);
+    }
+
+    if (!freeFrames[index]) {
+        // Thread a new chunk onto the free list in address order
+        size_t frameSize = (index + 1) * FRAME_CLASS_SIZE;
+        unsigned char* chunk = static_cast<unsigned char*>(::operator new(frameSize * FRAMES_PER_CHUNK));
+        frameChunks++;
+        for (size_t i = FRAMES_PER_CHUNK; i-- > 0;) {
+            void* frame = chunk + i * frameSize;
+            *static_cast<void**>(frame) = freeFrames[index];
+            freeFrames[index] = frame;
+        }
+    }
+
+    void* frame = freeFrames[index];
+    freeFrames[index] = *static_cast<void**>(frame);
+    return frame;
+}
+
+void TaskFramePool::release(void* frame, size_t size) {
+    size_t index = (size + FRAME_CLASS_SIZE - 1) / FRAME_CLASS_SIZE - 1;
+    if (index >= FRAME_CLASSES) {
+        ::operator delete(frame);
+        return;
+    }
+    *static_cast<void**>(frame) = freeFrames[index];
+    freeFrames[index] = frame;
+}
+
+size_t TaskFramePool::getHeapAllocations() {
+    return frameChunks;
+}
+
+Task& Task::operator=(Task&& other) noexcept {
+    if (this != &other) {
+        if (handle) {
+            handle.destroy();
+        }
+        handle = std::exchange(other.handle, nullptr);
+    }
+    return *this;
+}
+
+Task::~Task() {
+    if (handle) {
+        handle.destroy();
+    }
+}
+
+TaskScheduler::TaskScheduler()
+    : running(0)
+    , eventRevision(0)
+    , time(0.0)
+{
+}
+
+TaskScheduler::~TaskScheduler() {
+    for (Slot& slot : slots) {
+        if (slot.handle) {
+            slot.handle.destroy();
+        }
+    }
+}
+
+TaskId TaskScheduler::start(Task task) {
+    Task::Handle handle = std::exchange(task.handle, nullptr);
+    if (!handle) {
+        return 0;
+    }
+
+    Uint32 slot;
+    if (!freeSlots.empty()) {
+        slot = freeSlots.back();
+        freeSlots.pop_back();
+    } else {
+        slot = static_cast<Uint32>(slots.size());
+        slots.emplace_back();
+    }
+    slots[slot].handle = handle;
+    handle.promise().scheduler = this;
+    handle.promise().slot = slot;
+    running++;
+
+    // Slot + 1 so no task has id 0
+    TaskId id = (static_cast<Uint64>(slots[slot].generation) << 32) | (slot + 1);
+    resume(slot);
+    return id;
+}
+
+bool TaskScheduler::cancel(TaskId id) {
+    Uint32 slot = static_cast<Uint32>(id & 0xFFFFFFFF) - 1;
+    if (!isRunning(id)) {
+        return false;
+    }
+    if (slots[slot].resuming) {
+        // Destroying a coroutine that is running would pull its frame out
+        // from under it
+        slots[slot].cancelled = true;
+    } else {
+        finish(slot);
+    }
+    return true;
+}
+
+bool TaskScheduler::isRunning(TaskId id) const {
+    Uint32 slot = static_cast<Uint32>(id & 0xFFFFFFFF) - 1;
+    Uint32 generation = static_cast<Uint32>(id >> 32);
+    return id != 0 && slot < slots.size() && slots[slot].handle && slots[slot].generation == generation &&
+           !slots[slot].cancelled;
+}
+
+bool TaskScheduler::isCurrent(const Waiter& waiter) const {
+    return slots[waiter.slot].handle && slots[waiter.slot].generation == waiter.generation;
+}
+
+void TaskScheduler::resume(Uint32 slot) {
+    // Copied out: the task may start others and grow slots
+    Task::Handle handle = slots[slot].handle;
+    slots[slot].timer = 0;
+    slots[slot].resuming = true;
+    handle.resume();
+    slots[slot].resuming = false;
+
+    if (handle.done() || slots[slot].cancelled) {
+        finish(slot);
+    }
+}
+
+void TaskScheduler::finish(Uint32 slot) {
+    Slot& entry = slots[slot];
+    entry.handle.destroy();
+    entry.handle = nullptr;
+    if (entry.timer) {
+        timers.cancel(entry.timer);
+        entry.timer = 0;
+    }
+
+    // Any waits still listed for it no longer match
+    entry.generation++;
+    entry.cancelled = false;
+    freeSlots.push_back(slot);
+    running--;
+}
+
+void TaskScheduler::update(float deltaTime) {
+    time += deltaTime;
+    timers.advance(static_cast<Uint64>(time * 1000.0));
+
+    woken.insert(woken.end(), nextFrame.begin(), nextFrame.end());
+    nextFrame.clear();
+
+    size_t kept = 0;
+    for (const ReadyWaiter& entry : readyWaiters) {
+        if (!isCurrent(entry.waiter)) {
+            continue;
+        }
+        if (entry.ready(entry.awaiter)) {
+            woken.push_back(entry.waiter);
+        } else {
+            readyWaiters[kept++] = entry;
+        }
+    }
+    readyWaiters.resize(kept);
+
+    // Tasks woken while these run wait for the next update
+    resuming.swap(woken);
+    for (const Waiter& waiter : resuming) {
+        if (isCurrent(waiter)) {
+            resume(waiter.slot);
+        }
+    }
+    resuming.clear();
+
+    // Cancelled tasks leave their event waits behind until an event of that
+    // type comes, which may be never; types nobody waits for stop passing
+    // the engine's event filter
+    for (auto it = eventWaiters.begin(); it != eventWaiters.end();) {
+        std::vector<EventWaiter>& waiters = it->second;
+        waiters.erase(std::remove_if(waiters.begin(), waiters.end(),
+                                     [this](const EventWaiter& entry) { return !isCurrent(entry.waiter); }),
+                      waiters.end());
+        if (waiters.empty()) {
+            it = eventWaiters.erase(it);
+            eventRevision++;
+        } else {
+            ++it;
+        }
+    }
+}
+
+void TaskScheduler::dispatchEvent(const SDL_Event& event) {
+    auto found = eventWaiters.find(event.type);
+    if (found == eventWaiters.end()) {
+        return;
+    }
+    for (const EventWaiter& entry : found->second) {
+        if (isCurrent(entry.waiter)) {
+            *entry.out = event;
+            woken.push_back(entry.waiter);
+        }
+    }
+    found->second.clear();
+}
+
+double TaskScheduler::getTimeToNextWake() const {
+    Uint64 tick = timers.getNextExpiry();
+    if (tick == TimerWheel::NO_TICK) {
+        return -1.0;
+    }
+    return std::max(0.0, tick / 1000.0 - time);
+}
+
+void TaskScheduler::waitFrame(Uint32 slot) {
+    nextFrame.push_back(waiterFor(slot));
+}
+
+void TaskScheduler::waitTime(Uint32 slot, float seconds) {
+    Uint64 ticks = static_cast<Uint64>(std::ceil(std::max(0.0f, seconds) * 1000.0f));
+    Waiter waiter = waiterFor(slot);
+    slots[slot].timer = timers.schedule(ticks, 0, [this, waiter] {
+        if (isCurrent(waiter)) {
+            slots[waiter.slot].timer = 0;
+            woken.push_back(waiter);
+        }
+    });
+}
+
+void TaskScheduler::waitEvent(Uint32 slot, Uint32 type, SDL_Event* out) {
+    auto inserted = eventWaiters.try_emplace(type);
+    if (inserted.second) {
+        eventRevision++;
+    }
+    inserted.first->second.push_back(EventWaiter{waiterFor(slot), out});
+}
+
+void TaskScheduler::waitReady(Uint32 slot, bool (*ready)(void*), void* awaiter) {
+    readyWaiters.push_back(ReadyWaiter{waiterFor(slot), ready, awaiter});
+}
+
+} // namespace ContextEngine
+
+#endif // CONTEXT_ENGINE_COROUTINES
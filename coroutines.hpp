@@ -0,0 +1,233 @@
+#pragma once
+
+// C++20 coroutine tasks for scene scripting. Opt-in: configure with
+// -DCONTEXT_ENGINE_COROUTINES=ON, which builds the engine as C++20.
+#ifdef CONTEXT_ENGINE_COROUTINES
+
+#ifndef __cpp_impl_coroutine
+#error "CONTEXT_ENGINE_COROUTINES needs a compiler in C++20 mode"
+#endif
+
+#include "context-types.hpp"
+#include "timer-wheel.hpp"
+
+#include <chrono>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <future>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace ContextEngine {
+
+class TaskScheduler;
+
+// Handle to a running task, 0 for none
+using TaskId = Uint64;
+
+// Coroutine frames in size classes of 64 bytes, reused through free lists
+// instead of going back to the heap, so starting and finishing tasks in a
+// steady state allocates nothing. Main thread only.
+class TaskFramePool {
+public:
+    static void* allocate(size_t size);
+    static void release(void* frame, size_t size);
+
+    // Chunks taken from the heap so far
+    static size_t getHeapAllocations();
+};
+
+// Coroutine returned by a script, e.g.
+//
+//     Task flash(Player& player) {
+//         for (int i = 0; i < 3; i++) {
+//             player.visible = !player.visible;
+//             co_await waitSeconds(0.2f);
+//         }
+//     }
+//     engine.getTasks().start(flash(player));
+//
+// Nothing runs until it is started on a TaskScheduler, which then owns it.
+class Task {
+public:
+    struct promise_type {
+        TaskScheduler* scheduler = nullptr;
+        Uint32 slot = 0;
+
+        static void* operator new(size_t size) { return TaskFramePool::allocate(size); }
+        static void operator delete(void* frame, size_t size) { TaskFramePool::release(frame, size); }
+
+        Task get_return_object() { return Task(std::coroutine_handle<promise_type>::from_promise(*this)); }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; } // The scheduler destroys the frame
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); } // Scripts must not throw
+    };
+
+    using Handle = std::coroutine_handle<promise_type>;
+
+    Task(Task&& other) noexcept : handle(std::exchange(other.handle, nullptr)) {}
+    Task& operator=(Task&& other) noexcept;
+    ~Task(); // Destroys a task that was never started
+
+    // Prevent copying
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+
+private:
+    friend class TaskScheduler;
+    explicit Task(Handle handle) : handle(handle) {}
+
+    Handle handle;
+};
+
+// Runs tasks on the main thread. A suspended task is one record in the list
+// for what it waits on (a frame, a timer wheel slot, an event type or a
+// polled future), so thousands of them cost nothing until they wake up.
+// Woken tasks run inside update(), in the order they woke.
+class TaskScheduler {
+public:
+    TaskScheduler();
+    ~TaskScheduler(); // Destroys the tasks still running
+
+    // Prevent copying
+    TaskScheduler(const TaskScheduler&) = delete;
+    TaskScheduler& operator=(const TaskScheduler&) = delete;
+
+    // Run the task up to its first co_await, then resume it from update()
+    TaskId start(Task task);
+
+    // Destroy a task where it is suspended; false if it already finished
+    bool cancel(TaskId id);
+    bool isRunning(TaskId id) const;
+    size_t getRunningCount() const { return running; }
+
+    // Advance task time and resume every task whose wait is over
+    void update(float deltaTime);
+
+    // Hand an event to the tasks waiting for its type; they resume in the
+    // next update()
+    void dispatchEvent(const SDL_Event& event);
+
+    // Event types a task is waiting for, kept for the engine's event
+    // filter; the revision changes when a type is added or dropped
+    bool waitsForEventType(Uint32 type) const { return eventWaiters.count(type) != 0; }
+    Uint64 getEventRevision() const { return eventRevision; }
+
+    double getTime() const { return time; }
+
+    // Whether a task needs the next update regardless of time: it waits for
+    // a frame or a future, or an event already woke it
+    bool needsUpdate() const { return !woken.empty() || !nextFrame.empty() || !readyWaiters.empty(); }
+
+    // Seconds of task time until the next waitSeconds ends, negative for none
+    double getTimeToNextWake() const;
+
+    // Used by the awaitables
+    void waitFrame(Uint32 slot);
+    void waitTime(Uint32 slot, float seconds);
+    void waitEvent(Uint32 slot, Uint32 type, SDL_Event* out);
+    void waitReady(Uint32 slot, bool (*ready)(void*), void* awaiter);
+
+private:
+    // A task to resume, unless it was cancelled since (generation changed)
+    struct Waiter {
+        Uint32 slot;
+        Uint32 generation;
+    };
+
+    struct EventWaiter {
+        Waiter waiter;
+        SDL_Event* out;
+    };
+
+    struct ReadyWaiter {
+        Waiter waiter;
+        bool (*ready)(void*);
+        void* awaiter;
+    };
+
+    struct Slot {
+        Task::Handle handle;
+        Uint32 generation = 0;
+        TimerId timer = 0;      // Pending waitSeconds
+        bool resuming = false;  // Running right now, further up the stack
+        bool cancelled = false; // Destroyed once it suspends again
+    };
+
+    Waiter waiterFor(Uint32 slot) const { return Waiter{slot, slots[slot].generation}; }
+    bool isCurrent(const Waiter& waiter) const;
+    void resume(Uint32 slot);
+    void finish(Uint32 slot);
+
+    std::vector<Slot> slots;
+    std::vector<Uint32> freeSlots;
+    size_t running;
+
+    std::vector<Waiter> woken;     // Resumed in the next update
+    std::vector<Waiter> resuming;  // Being resumed by update
+    std::vector<Waiter> nextFrame;
+    std::unordered_map<Uint32, std::vector<EventWaiter>> eventWaiters;
+    std::vector<ReadyWaiter> readyWaiters;
+    Uint64 eventRevision;
+
+    TimerWheel timers; // Milliseconds of task time
+    double time;       // Seconds, the sum of update deltaTimes
+};
+
+// co_await nextFrame(): resume in the next update
+struct NextFrameAwaiter {
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(Task::Handle handle) { handle.promise().scheduler->waitFrame(handle.promise().slot); }
+    void await_resume() const noexcept {}
+};
+
+inline NextFrameAwaiter nextFrame() { return {}; }
+
+// co_await waitSeconds(s): resume once s seconds of task time have passed
+struct SecondsAwaiter {
+    float seconds;
+
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(Task::Handle handle) { handle.promise().scheduler->waitTime(handle.promise().slot, seconds); }
+    void await_resume() const noexcept {}
+};
+
+inline SecondsAwaiter waitSeconds(float seconds) { return {seconds}; }
+
+// SDL_Event event = co_await waitForEvent(SDL_KEYDOWN): resume with the
+// next event of a type
+struct EventAwaiter {
+    Uint32 type;
+    SDL_Event event;
+
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(Task::Handle handle) { handle.promise().scheduler->waitEvent(handle.promise().slot, type, &event); }
+    SDL_Event await_resume() const noexcept { return event; }
+};
+
+inline EventAwaiter waitForEvent(Uint32 type) { return {type, SDL_Event()}; }
+
+// T value = co_await waitFor(std::move(future)): resume once a future, e.g.
+// an asset loading on a WorkerPool, has its value. Polled once per update.
+template <typename T>
+struct FutureAwaiter {
+    std::future<T> future;
+
+    static bool isReady(void* awaiter) {
+        return static_cast<FutureAwaiter*>(awaiter)->future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+    }
+
+    bool await_ready() { return isReady(this); }
+    void await_suspend(Task::Handle handle) { handle.promise().scheduler->waitReady(handle.promise().slot, &isReady, this); }
+    T await_resume() { return future.get(); }
+};
+
+template <typename T>
+FutureAwaiter<T> waitFor(std::future<T> future) { return {std::move(future)}; }
+
+} // namespace ContextEngine
+
+#endif // CONTEXT_ENGINE_COROUTINES
@@ -0,0 +1,187 @@
+#include "ecs.hpp"
+#include "context-engine.hpp"
+#include "simd-math.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace ContextEngine {
+
+Registry::Registry()
+    : aliveCount(0)
+{
+}
+
+Entity Registry::create() {
+    if (!freeSlots.empty()) {
+        Uint32 index = freeSlots.back();
+        freeSlots.pop_back();
+        aliveCount++;
+        return slots[index];
+    }
+
+    // The last index is reserved so no handle ever equals NullEntity
+    if (slots.size() >= ENTITY_INDEX_MASK) {
+        SDL_Log("Entity limit of %u reached!", ENTITY_INDEX_MASK);
+        return NullEntity;
+    }
+
+    Entity entity = static_cast<Entity>(slots.size());
+    slots.push_back(entity);
+    aliveCount++;
+    return entity;
+}
+
+void Registry::destroy(Entity entity) {
+    if (!valid(entity)) {
+        return;
+    }
+
+    for (auto& pool : pools) {
+        if (pool) {
+            pool->remove(entity);
+        }
+    }
+
+    // Bump the version so old handles stop matching, then recycle the slot
+    Uint32 index = entityIndex(entity);
+    Uint32 version = (entityVersion(entity) + 1) & (0xFFFFFFFFu >> ENTITY_INDEX_BITS);
+    slots[index] = (version << ENTITY_INDEX_BITS) | index;
+    freeSlots.push_back(index);
+    aliveCount--;
+}
+
+// Free slots already hold the handle their next entity will get, which was
+// never handed out, so comparing the handle is enough
+bool Registry::valid(Entity entity) const {
+    Uint32 index = entityIndex(entity);
+    return entity != NullEntity && index < slots.size() && slots[index] == entity;
+}
+
+void Registry::clear() {
+    for (auto& pool : pools) {
+        pool.reset();
+    }
+
+    // Keep the slots and bump every live one so handles from before stay stale
+    std::vector<bool> free(slots.size(), false);
+    for (Uint32 index : freeSlots) {
+        free[index] = true;
+    }
+    for (Uint32 index = 0; index < slots.size(); index++) {
+        if (!free[index]) {
+            Uint32 version = (entityVersion(slots[index]) + 1) & (0xFFFFFFFFu >> ENTITY_INDEX_BITS);
+            slots[index] = (version << ENTITY_INDEX_BITS) | index;
+            freeSlots.push_back(index);
+        }
+    }
+    aliveCount = 0;
+}
+
+void renderShapes(Registry& registry, OtherCtx& ctx, GeometryBatch& batch) {
+    batch.clear();
+
+    const bool camera = ctx.isCameraEnabled();
+    const Vector2 cameraPos = camera ? ctx.getCameraPosition() : Vector2(0, 0);
+    const float zoom = camera ? ctx.getCameraZoom() : 1.0f;
+
+    int outputWidth = 0;
+    int outputHeight = 0;
+    SDL_GetRendererOutputSize(ctx.getRenderer(), &outputWidth, &outputHeight);
+
+    // Outline scratch for circles and rounded corners comes from the frame arena
+    FrameArena& arena = ctx.getFrameArena();
+
+    registry.view<Transform, Shape, Color>().each([&](Entity, Transform& transform, Shape& shape, Color& color) {
+        const float halfWidth = shape.size.x * 0.5f * transform.scale.x;
+        const float halfHeight = shape.size.y * 0.5f * transform.scale.y;
+        const Vector2 center((transform.position.x - cameraPos.x) * zoom,
+                             (transform.position.y - cameraPos.y) * zoom);
+
+        // Cull against a bounding circle so rotation never matters
+        float extent = std::sqrt(halfWidth * halfWidth + halfHeight * halfHeight) * zoom;
+        if (outputWidth > 0 && (center.x + extent < 0 || center.x - extent > outputWidth ||
+                                center.y + extent < 0 || center.y - extent > outputHeight)) {
+            return;
+        }
+
+        const SDL_Color vertexColor = color.toSDLColor();
+        const bool rotated = transform.rotation != 0.0f;
+        const float cosR = rotated ? std::cos(transform.rotation) : 1.0f;
+        const float sinR = rotated ? std::sin(transform.rotation) : 0.0f;
+        auto place = [&](float x, float y) {
+            return Vector2(center.x + (x * cosR - y * sinR) * zoom,
+                           center.y + (x * sinR + y * cosR) * zoom);
+        };
+
+        // Outlines with many points go through the batch transform instead
+        Affine2 toScreen;
+        toScreen.a = cosR * zoom;
+        toScreen.b = sinR * zoom;
+        toScreen.c = -sinR * zoom;
+        toScreen.d = cosR * zoom;
+        toScreen.tx = center.x;
+        toScreen.ty = center.y;
+
+        switch (shape.kind) {
+            case ShapeKind::Rect:
+                if (!rotated) {
+                    batch.addRect(center.x - halfWidth * zoom, center.y - halfHeight * zoom,
+                                  2 * halfWidth * zoom, 2 * halfHeight * zoom, vertexColor);
+                } else {
+                    batch.addQuad(place(-halfWidth, -halfHeight), place(halfWidth, -halfHeight),
+                                  place(halfWidth, halfHeight), place(-halfWidth, halfHeight), vertexColor);
+                }
+                break;
+
+            case ShapeKind::Triangle:
+                batch.addTriangle(place(0, -halfHeight), place(halfWidth, halfHeight),
+                                  place(-halfWidth, halfHeight), vertexColor);
+                break;
+
+            case ShapeKind::Circle: {
+                int segments = circleSegments(std::max(halfWidth, halfHeight) * zoom);
+                Vector2* outline = arena.allocateArray<Vector2>(segments);
+                for (int i = 0; i < segments; i++) {
+                    float angle = 2.0f * static_cast<float>(M_PI) * i / segments;
+                    outline[i] = Vector2(std::cos(angle) * halfWidth, std::sin(angle) * halfHeight);
+                }
+                transformPoints(outline, outline, segments, toScreen);
+                batch.addConvexPolygon(outline, segments, vertexColor);
+                break;
+            }
+
+            case ShapeKind::RoundedRect: {
+                float scale = std::min(std::fabs(transform.scale.x), std::fabs(transform.scale.y));
+                float radius = std::min({shape.cornerRadius * scale, std::fabs(halfWidth), std::fabs(halfHeight)});
+                int steps = std::max(2, circleSegments(radius * zoom) / 4);
+
+                // Corner centers clockwise from the top left, each sweeping a quarter turn
+                const Vector2 corners[4] = {
+                    Vector2(-halfWidth + radius, -halfHeight + radius),
+                    Vector2(halfWidth - radius, -halfHeight + radius),
+                    Vector2(halfWidth - radius, halfHeight - radius),
+                    Vector2(-halfWidth + radius, halfHeight - radius)
+                };
+                int count = 4 * (steps + 1);
+                Vector2* outline = arena.allocateArray<Vector2>(count);
+                int point = 0;
+                for (int corner = 0; corner < 4; corner++) {
+                    float start = static_cast<float>(M_PI) * (1.0f + 0.5f * corner);
+                    for (int i = 0; i <= steps; i++) {
+                        float angle = start + 0.5f * static_cast<float>(M_PI) * i / steps;
+                        outline[point++] = Vector2(corners[corner].x + std::cos(angle) * radius,
+                                                   corners[corner].y + std::sin(angle) * radius);
+                    }
+                }
+                transformPoints(outline, outline, count, toScreen);
+                batch.addConvexPolygon(outline, count, vertexColor);
+                break;
+            }
+        }
+    });
+
+    ctx.drawBatch(batch);
+}
+
+} // namespace ContextEngine
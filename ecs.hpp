@@ -0,0 +1,290 @@
+#pragma once
+
+#include "context-types.hpp"
+#include "geometry-batch.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace ContextEngine {
+
+class OtherCtx;
+
+// Entity handle: the low 20 bits index a slot, the high 12 bits count how
+// often the slot was reused so stale handles are detected
+using Entity = Uint32;
+const Entity NullEntity = 0xFFFFFFFF;
+
+const Uint32 ENTITY_INDEX_BITS = 20;
+const Uint32 ENTITY_INDEX_MASK = (1u << ENTITY_INDEX_BITS) - 1;
+
+inline Uint32 entityIndex(Entity entity) { return entity & ENTITY_INDEX_MASK; }
+inline Uint32 entityVersion(Entity entity) { return entity >> ENTITY_INDEX_BITS; }
+
+// Small dense id per component type, assigned on first use
+inline size_t nextComponentTypeId() {
+    static size_t counter = 0;
+    return counter++;
+}
+
+template <typename T>
+size_t componentTypeId() {
+    static const size_t id = nextComponentTypeId();
+    return id;
+}
+
+// Sparse set of entities. The sparse side maps an entity index to its slot in
+// the dense array and is allocated in pages, so high indices cost no memory
+// until they are used.
+class ComponentPoolBase {
+public:
+    static constexpr Uint32 INVALID = 0xFFFFFFFF;
+    static constexpr Uint32 PAGE_BITS = 12;
+    static constexpr Uint32 PAGE_SIZE = 1u << PAGE_BITS;
+
+    virtual ~ComponentPoolBase() = default;
+    virtual void remove(Entity entity) = 0;
+
+    // Dense slot of an entity, INVALID when it has no component here
+    Uint32 indexOf(Entity entity) const {
+        Uint32 index = entityIndex(entity);
+        Uint32 page = index >> PAGE_BITS;
+        if (page >= sparse.size() || !sparse[page]) {
+            return INVALID;
+        }
+        Uint32 slot = sparse[page][index & (PAGE_SIZE - 1)];
+        return slot != INVALID && entities[slot] == entity ? slot : INVALID;
+    }
+
+    bool contains(Entity entity) const { return indexOf(entity) != INVALID; }
+    size_t size() const { return entities.size(); }
+    const Entity* entityData() const { return entities.data(); }
+
+protected:
+    void setSlot(Entity entity, Uint32 slot) {
+        Uint32 index = entityIndex(entity);
+        Uint32 page = index >> PAGE_BITS;
+        if (page >= sparse.size()) {
+            sparse.resize(page + 1);
+        }
+        if (!sparse[page]) {
+            sparse[page].reset(new Uint32[PAGE_SIZE]);
+            std::fill(sparse[page].get(), sparse[page].get() + PAGE_SIZE, INVALID);
+        }
+        sparse[page][index & (PAGE_SIZE - 1)] = slot;
+    }
+
+    std::vector<std::unique_ptr<Uint32[]>> sparse;
+    std::vector<Entity> entities; // Dense, parallel to the component array
+};
+
+// One component type stored contiguously. Every component type lives in its
+// own dense array, so a system touching positions only streams positions.
+//
+// This is structure-of-arrays at component granularity: each pool is one
+// column. Fields inside a component are not split into further columns, so
+// views and get() can hand out plain T& and the dense array of a small
+// component (e.g. a Vector2 velocity) is already the span the simd-math
+// kernels take. Data that is iterated apart belongs in separate components.
+template <typename T>
+class ComponentPool : public ComponentPoolBase {
+public:
+    template <typename... Args>
+    T& emplace(Entity entity, Args&&... args) {
+        Uint32 slot = indexOf(entity);
+        if (slot != INVALID) {
+            components[slot] = T{std::forward<Args>(args)...};
+            return components[slot];
+        }
+
+        setSlot(entity, static_cast<Uint32>(entities.size()));
+        entities.push_back(entity);
+        components.push_back(T{std::forward<Args>(args)...});
+        return components.back();
+    }
+
+    // Swap the last component into the hole so the array stays packed
+    void remove(Entity entity) override {
+        Uint32 slot = indexOf(entity);
+        if (slot == INVALID) {
+            return;
+        }
+
+        Uint32 last = static_cast<Uint32>(entities.size()) - 1;
+        if (slot != last) {
+            entities[slot] = entities[last];
+            components[slot] = std::move(components[last]);
+            setSlot(entities[slot], slot);
+        }
+        setSlot(entity, INVALID);
+        entities.pop_back();
+        components.pop_back();
+    }
+
+    T* find(Entity entity) {
+        Uint32 slot = indexOf(entity);
+        return slot != INVALID ? &components[slot] : nullptr;
+    }
+
+    T& get(Entity entity) { return components[indexOf(entity)]; }
+
+    // Raw dense arrays for tight loops; entityData()[i] owns data()[i]
+    T* data() { return components.data(); }
+    const T* data() const { return components.data(); }
+
+private:
+    std::vector<T> components;
+};
+
+// Entities that have every component in Ts. Iteration is driven by the
+// smallest pool and probes the others, so no archetype tables are needed.
+// Components may be modified inside each(), but not added or removed.
+template <typename... Ts>
+class View {
+public:
+    explicit View(ComponentPool<Ts>&... pools)
+        : pools(&pools...)
+    {
+    }
+
+    template <typename Func>
+    void each(Func func) {
+        if constexpr (sizeof...(Ts) == 1) {
+            // A single pool is one linear pass over packed arrays
+            auto* pool = std::get<0>(pools);
+            const Entity* entities = pool->entityData();
+            auto* components = pool->data();
+            size_t count = pool->size();
+            for (size_t i = 0; i < count; i++) {
+                func(entities[i], components[i]);
+            }
+        } else {
+            const ComponentPoolBase* driver = smallest();
+            const Entity* entities = driver->entityData();
+            size_t count = driver->size();
+            for (size_t i = 0; i < count; i++) {
+                Entity entity = entities[i];
+                std::tuple<Ts*...> found(std::get<ComponentPool<Ts>*>(pools)->find(entity)...);
+                if ((std::get<Ts*>(found) && ...)) {
+                    func(entity, *std::get<Ts*>(found)...);
+                }
+            }
+        }
+    }
+
+    // Upper bound on the number of entities visited
+    size_t sizeHint() const { return smallest()->size(); }
+
+private:
+    const ComponentPoolBase* smallest() const {
+        const ComponentPoolBase* result = std::get<0>(pools);
+        ((result = std::get<ComponentPool<Ts>*>(pools)->size() < result->size()
+                       ? std::get<ComponentPool<Ts>*>(pools) : result), ...);
+        return result;
+    }
+
+    std::tuple<ComponentPool<Ts>*...> pools;
+};
+
+// Owns entities and their component pools
+class Registry {
+public:
+    Registry();
+
+    // Prevent copying
+    Registry(const Registry&) = delete;
+    Registry& operator=(const Registry&) = delete;
+
+    Entity create();
+    void destroy(Entity entity); // Removes every component of the entity
+    bool valid(Entity entity) const;
+    size_t size() const { return aliveCount; }
+    void clear();
+
+    template <typename T, typename... Args>
+    T& emplace(Entity entity, Args&&... args) {
+        return storage<T>().emplace(entity, std::forward<Args>(args)...);
+    }
+
+    template <typename T>
+    void remove(Entity entity) {
+        storage<T>().remove(entity);
+    }
+
+    template <typename T>
+    bool has(Entity entity) {
+        return storage<T>().contains(entity);
+    }
+
+    // The entity must have the component, use tryGet otherwise
+    template <typename T>
+    T& get(Entity entity) {
+        return storage<T>().get(entity);
+    }
+
+    template <typename T>
+    T* tryGet(Entity entity) {
+        return storage<T>().find(entity);
+    }
+
+    template <typename T>
+    ComponentPool<T>& storage() {
+        size_t id = componentTypeId<T>();
+        if (id >= pools.size()) {
+            pools.resize(id + 1);
+        }
+        if (!pools[id]) {
+            pools[id].reset(new ComponentPool<T>());
+        }
+        return static_cast<ComponentPool<T>&>(*pools[id]);
+    }
+
+    template <typename... Ts>
+    View<Ts...> view() {
+        return View<Ts...>(storage<Ts>()...);
+    }
+
+private:
+    std::vector<Entity> slots;     // Current handle of every slot, alive or free
+    std::vector<Uint32> freeSlots;
+    std::vector<std::unique_ptr<ComponentPoolBase>> pools;
+    size_t aliveCount;
+};
+
+// Built-in components drawn by renderShapes
+
+// Center position, rotation in radians and scale of an entity
+struct Transform {
+    Vector2 position;
+    float rotation = 0.0f;
+    Vector2 scale = Vector2(1.0f, 1.0f);
+};
+
+enum class ShapeKind {
+    Rect,
+    RoundedRect,
+    Circle,
+    Triangle // Pointing up
+};
+
+// Geometry centered on the transform position
+struct Shape {
+    ShapeKind kind = ShapeKind::Rect;
+    Vector2 size;
+    float cornerRadius = 0.0f;
+
+    static Shape rect(float width, float height) { return {ShapeKind::Rect, Vector2(width, height), 0.0f}; }
+    static Shape roundedRect(float width, float height, float radius) { return {ShapeKind::RoundedRect, Vector2(width, height), radius}; }
+    static Shape circle(float radius) { return {ShapeKind::Circle, Vector2(radius * 2, radius * 2), 0.0f}; }
+    static Shape triangle(float width, float height) { return {ShapeKind::Triangle, Vector2(width, height), 0.0f}; }
+};
+
+// Draw every entity with Transform, Shape and Color in one batched call,
+// applying the context camera and skipping entities off screen
+void renderShapes(Registry& registry, OtherCtx& ctx, GeometryBatch& batch);
+
+} // namespace ContextEngine
@@ -0,0 +1,303 @@
+#include "font-cache.hpp"
+#include "text-layout.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define CONTEXT_ENGINE_HAS_MMAP 1
+#endif
+
+namespace ContextEngine {
+
+static const Uint64 FNV_OFFSET = 14695981039346656037ULL;
+static const Uint64 FNV_PRIME = 1099511628211ULL;
+
+static Uint64 fnv1a(Uint64 hash, const Uint8* data, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+        hash ^= data[i];
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+Uint64 hashFontFile(const std::string& path) {
+    MappedFile file;
+    if (!file.open(path)) {
+        return 0;
+    }
+    return fnv1a(FNV_OFFSET, file.data(), file.size());
+}
+
+Uint64 hashCharset(const std::vector<Uint32>& charset) {
+    Uint64 hash = FNV_OFFSET;
+    for (Uint32 codepoint : charset) {
+        hash = fnv1a(hash, reinterpret_cast<const Uint8*>(&codepoint), sizeof(codepoint));
+    }
+    return hash;
+}
+
+std::vector<Uint32> defaultCharset() {
+    std::vector<Uint32> charset;
+    for (Uint32 codepoint = 32; codepoint < 127; codepoint++) {
+        charset.push_back(codepoint);
+    }
+    return charset;
+}
+
+std::vector<Uint32> charsetFromText(const std::string& text) {
+    std::vector<Uint32> charset;
+    size_t offset = 0;
+    while (offset < text.size()) {
+        Uint32 codepoint = decodeUtf8(text, offset);
+        if (codepoint != '\n' && codepoint != '\r') {
+            charset.push_back(codepoint);
+        }
+    }
+    std::sort(charset.begin(), charset.end());
+    charset.erase(std::unique(charset.begin(), charset.end()), charset.end());
+    return charset;
+}
+
+std::string fontCacheFileName(const FontCacheKey& key) {
+    char name[64];
+    std::snprintf(name, sizeof(name), "%016llx-%d-%08llx.fontcache",
+                  static_cast<unsigned long long>(key.fontHash), key.pointSize,
+                  static_cast<unsigned long long>(key.charsetHash & 0xFFFFFFFFULL));
+    return name;
+}
+
+// MappedFile implementation
+MappedFile::MappedFile()
+    : bytes(nullptr)
+    , length(0)
+    , mapped(false)
+{
+}
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+bool MappedFile::open(const std::string& path) {
+    close();
+
+#ifdef CONTEXT_ENGINE_HAS_MMAP
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd >= 0) {
+        struct stat info;
+        if (fstat(fd, &info) == 0 && info.st_size > 0) {
+            void* address = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if (address != MAP_FAILED) {
+                bytes = static_cast<const Uint8*>(address);
+                length = static_cast<size_t>(info.st_size);
+                mapped = true;
+            }
+        }
+        ::close(fd);
+        if (mapped) {
+            return true;
+        }
+    }
+#endif
+
+    // No mmap (or it failed), read the whole file instead
+    std::ifstream stream(path, std::ios::binary | std::ios::ate);
+    if (!stream) {
+        return false;
+    }
+    std::streamsize size = stream.tellg();
+    if (size <= 0) {
+        return false;
+    }
+    fallback.resize(static_cast<size_t>(size));
+    stream.seekg(0);
+    if (!stream.read(reinterpret_cast<char*>(fallback.data()), size)) {
+        fallback.clear();
+        return false;
+    }
+    bytes = fallback.data();
+    length = fallback.size();
+    return true;
+}
+
+void MappedFile::close() {
+#ifdef CONTEXT_ENGINE_HAS_MMAP
+    if (mapped) {
+        munmap(const_cast<Uint8*>(bytes), length);
+    }
+#endif
+    bytes = nullptr;
+    length = 0;
+    mapped = false;
+    fallback.clear();
+    fallback.shrink_to_fit();
+}
+
+// FontCache implementation
+bool FontCache::open(const std::string& path, const FontCacheKey& key, int pageSize) {
+    close();
+    if (!file.open(path)) {
+        return false;
+    }
+
+    if (file.size() < sizeof(FontCacheHeader)) {
+        close();
+        return false;
+    }
+    const FontCacheHeader* candidate = reinterpret_cast<const FontCacheHeader*>(file.data());
+    if (candidate->magic != MAGIC || candidate->version != VERSION ||
+        candidate->fontHash != key.fontHash || candidate->charsetHash != key.charsetHash ||
+        candidate->pointSize != key.pointSize || candidate->pageSize != pageSize || pageSize <= 0) {
+        close();
+        return false;
+    }
+
+    // Every table has to fit inside the file. Counts are checked against the
+    // bytes left before they are multiplied, so a corrupt count cannot wrap
+    // size_t (32 bits on wasm32) past the check.
+    size_t offset = sizeof(FontCacheHeader);
+    size_t pageBytes = static_cast<size_t>(pageSize) * pageSize * sizeof(Uint32);
+    bool fits = candidate->glyphCount <= (file.size() - offset) / sizeof(FontCacheGlyph);
+    if (fits) {
+        offset += candidate->glyphCount * sizeof(FontCacheGlyph);
+        fits = candidate->kerningCount <= (file.size() - offset) / sizeof(FontCacheKerning);
+    }
+    if (fits) {
+        offset += candidate->kerningCount * sizeof(FontCacheKerning);
+        fits = candidate->pixelOffset >= offset && candidate->pixelOffset % 16 == 0 &&
+               candidate->pixelOffset <= file.size() &&
+               candidate->pageCount <= (file.size() - candidate->pixelOffset) / pageBytes;
+    }
+    if (!fits) {
+        SDL_Log("Font cache %s is truncated, ignoring it", path.c_str());
+        close();
+        return false;
+    }
+
+    header = candidate;
+    return true;
+}
+
+const FontCacheGlyph* FontCache::getGlyphs() const {
+    return reinterpret_cast<const FontCacheGlyph*>(file.data() + sizeof(FontCacheHeader));
+}
+
+const FontCacheKerning* FontCache::getKerning() const {
+    return reinterpret_cast<const FontCacheKerning*>(
+        file.data() + sizeof(FontCacheHeader) + header->glyphCount * sizeof(FontCacheGlyph));
+}
+
+const Uint32* FontCache::getPagePixels(int page) const {
+    size_t pageBytes = static_cast<size_t>(header->pageSize) * header->pageSize * sizeof(Uint32);
+    return reinterpret_cast<const Uint32*>(file.data() + header->pixelOffset + page * pageBytes);
+}
+
+bool FontCache::bake(TTF_Font* font, const FontCacheKey& key, const std::vector<Uint32>& charset,
+                     int pageSize, const std::string& path) {
+    if (!font) {
+        return false;
+    }
+
+    // Pack exactly the way GlyphAtlas would
+    ShelfPacker packer(pageSize);
+    std::vector<std::vector<Uint32>> pages;
+    std::vector<FontCacheGlyph> glyphs;
+    GlyphBitmap bitmap;
+    for (Uint32 codepoint : charset) {
+        FontCacheGlyph glyph = {codepoint, 0.0f, -1, 0, 0, 0, 0};
+        int minx, maxx, miny, maxy, advance;
+        if (TTF_GlyphMetrics32(font, codepoint, &minx, &maxx, &miny, &maxy, &advance) == 0) {
+            glyph.advance = static_cast<float>(advance);
+        }
+
+        bool blank = codepoint == ' ' || codepoint == '\t' || codepoint == '\n' || codepoint == '\r';
+        int page;
+        SDL_Rect rect;
+        if (!blank && rasterizeGlyph(font, codepoint, bitmap) && bitmap.width > 0 && bitmap.height > 0 &&
+            packer.pack(bitmap.width, bitmap.height, page, rect)) {
+            if (page >= static_cast<int>(pages.size())) {
+                pages.emplace_back(static_cast<size_t>(pageSize) * pageSize, 0);
+            }
+            for (int y = 0; y < rect.h; y++) {
+                std::memcpy(&pages[page][static_cast<size_t>(rect.y + y) * pageSize + rect.x],
+                            &bitmap.pixels[static_cast<size_t>(y) * bitmap.width], rect.w * sizeof(Uint32));
+            }
+            glyph.page = page;
+            glyph.x = rect.x;
+            glyph.y = rect.y;
+            glyph.w = rect.w;
+            glyph.h = rect.h;
+        }
+        glyphs.push_back(glyph);
+    }
+
+    std::vector<FontCacheKerning> kerning;
+    bool kerningEnabled = TTF_GetFontKerning(font) != 0;
+    if (kerningEnabled) {
+        for (Uint32 left : charset) {
+            for (Uint32 right : charset) {
+                int amount = TTF_GetFontKerningSizeGlyphs32(font, left, right);
+                if (amount != 0) {
+                    kerning.push_back({left, right, static_cast<float>(amount)});
+                }
+            }
+        }
+    }
+
+    FontCacheHeader header = {};
+    header.magic = MAGIC;
+    header.version = VERSION;
+    header.fontHash = key.fontHash;
+    header.charsetHash = key.charsetHash;
+    header.pointSize = key.pointSize;
+    header.pageSize = pageSize;
+    header.glyphCount = static_cast<Uint32>(glyphs.size());
+    header.kerningCount = static_cast<Uint32>(kerning.size());
+    header.pageCount = static_cast<Uint32>(pages.size());
+    size_t tables = sizeof(header) + glyphs.size() * sizeof(FontCacheGlyph) + kerning.size() * sizeof(FontCacheKerning);
+    header.pixelOffset = static_cast<Uint32>((tables + 15) & ~static_cast<size_t>(15));
+    header.lineHeight = static_cast<float>(TTF_FontLineSkip(font));
+    header.fontHeight = static_cast<float>(TTF_FontHeight(font));
+    header.kerningEnabled = kerningEnabled ? 1 : 0;
+
+    // Write next to the target and rename, so a crash never leaves half a cache
+    std::string temporary = path + ".tmp";
+    {
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            SDL_Log("Failed to write font cache %s!", temporary.c_str());
+            return false;
+        }
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(glyphs.data()), glyphs.size() * sizeof(FontCacheGlyph));
+        out.write(reinterpret_cast<const char*>(kerning.data()), kerning.size() * sizeof(FontCacheKerning));
+        std::vector<char> padding(header.pixelOffset - tables, 0);
+        out.write(padding.data(), padding.size());
+        for (const std::vector<Uint32>& page : pages) {
+            out.write(reinterpret_cast<const char*>(page.data()), page.size() * sizeof(Uint32));
+        }
+        if (!out) {
+            SDL_Log("Failed to write font cache %s!", temporary.c_str());
+            std::remove(temporary.c_str());
+            return false;
+        }
+    }
+
+    // Rename only replaces an existing file on POSIX, remove it first elsewhere
+    if (std::rename(temporary.c_str(), path.c_str()) != 0 &&
+        (std::remove(path.c_str()), std::rename(temporary.c_str(), path.c_str()) != 0)) {
+        SDL_Log("Failed to move font cache into place at %s!", path.c_str());
+        std::remove(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+} // namespace ContextEngine
@@ -0,0 +1,111 @@
+#pragma once
+
+#include "context-types.hpp"
+
+#include <string>
+#include <vector>
+
+namespace ContextEngine {
+
+// Identifies a baked atlas: the font file contents, point size and charset
+struct FontCacheKey {
+    Uint64 fontHash = 0;
+    int pointSize = 0;
+    Uint64 charsetHash = 0;
+};
+
+// FNV-1a over the font file, 0 if it can't be read
+Uint64 hashFontFile(const std::string& path);
+Uint64 hashCharset(const std::vector<Uint32>& charset);
+
+// Printable ASCII, what most UI text needs
+std::vector<Uint32> defaultCharset();
+
+// Every distinct code point of a UTF-8 string, sorted
+std::vector<Uint32> charsetFromText(const std::string& text);
+
+// File name for a key, so caches for several fonts share one directory
+std::string fontCacheFileName(const FontCacheKey& key);
+
+// Read-only view of a whole file, memory mapped where the platform allows it
+class MappedFile {
+public:
+    MappedFile();
+    ~MappedFile();
+
+    // Prevent copying
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+
+    bool isOpen() const { return bytes != nullptr; }
+    const Uint8* data() const { return bytes; }
+    size_t size() const { return length; }
+
+private:
+    const Uint8* bytes;
+    size_t length;
+    bool mapped;
+    std::vector<Uint8> fallback; // File contents when mmap is not available
+};
+
+// On-disk layout, in host byte order. A file from another platform fails the
+// magic check and is simply baked again.
+struct FontCacheHeader {
+    Uint32 magic;
+    Uint32 version;
+    Uint64 fontHash;
+    Uint64 charsetHash;
+    Sint32 pointSize;
+    Sint32 pageSize;
+    Uint32 glyphCount;
+    Uint32 kerningCount;
+    Uint32 pageCount;
+    Uint32 pixelOffset;   // Start of the page pixels, 16 byte aligned
+    float lineHeight;
+    float fontHeight;
+    Uint32 kerningEnabled;
+};
+
+struct FontCacheGlyph {
+    Uint32 codepoint;
+    float advance;
+    Sint32 page;          // -1 for blank glyphs
+    Sint32 x, y, w, h;
+};
+
+// Only pairs with a non-zero adjustment are stored
+struct FontCacheKerning {
+    Uint32 left;
+    Uint32 right;
+    float kerning;
+};
+
+// A baked glyph atlas: metrics, kerning pairs and ARGB8888 page pixels that
+// upload to textures without going through FreeType
+class FontCache {
+public:
+    static const Uint32 MAGIC = 0x41464543; // "CEFA"
+    static const Uint32 VERSION = 1;
+
+    // Map a cache file and check it matches the key and atlas page size
+    bool open(const std::string& path, const FontCacheKey& key, int pageSize);
+    void close() { file.close(); header = nullptr; }
+
+    // Rasterize the charset with an open font and write a cache file
+    static bool bake(TTF_Font* font, const FontCacheKey& key, const std::vector<Uint32>& charset,
+                     int pageSize, const std::string& path);
+
+    const FontCacheHeader& getHeader() const { return *header; }
+    const FontCacheGlyph* getGlyphs() const;
+    const FontCacheKerning* getKerning() const;
+    const Uint32* getPagePixels(int page) const;
+
+private:
+    MappedFile file;
+    const FontCacheHeader* header = nullptr;
+};
+
+} // namespace ContextEngine
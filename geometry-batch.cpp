@@ -0,0 +1,126 @@
+#include "geometry-batch.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace ContextEngine {
+
+void GeometryBatch::clear() {
+    vertices.clear();
+    indices.clear();
+}
+
+void GeometryBatch::reserve(size_t vertexCount, size_t indexCount) {
+    vertices.reserve(vertexCount);
+    indices.reserve(indexCount);
+}
+
+int GeometryBatch::pushVertex(float x, float y, SDL_Color color, float u, float v) {
+    vertices.push_back({SDL_FPoint{x, y}, color, SDL_FPoint{u, v}});
+    return static_cast<int>(vertices.size()) - 1;
+}
+
+void GeometryBatch::addTriangle(const Vector2& a, const Vector2& b, const Vector2& c, SDL_Color color) {
+    int first = pushVertex(a.x, a.y, color);
+    pushVertex(b.x, b.y, color);
+    pushVertex(c.x, c.y, color);
+    indices.insert(indices.end(), {first, first + 1, first + 2});
+}
+
+SDL_Vertex* GeometryBatch::appendQuad() {
+    // Grow once and write in place; quads are most of what gets batched
+    int first = static_cast<int>(vertices.size());
+    vertices.resize(vertices.size() + 4);
+    size_t index = indices.size();
+    indices.resize(index + 6);
+    int* out = &indices[index];
+    out[0] = first;
+    out[1] = first + 1;
+    out[2] = first + 2;
+    out[3] = first;
+    out[4] = first + 2;
+    out[5] = first + 3;
+    return &vertices[first];
+}
+
+void GeometryBatch::addQuad(const Vector2& a, const Vector2& b, const Vector2& c, const Vector2& d, SDL_Color color) {
+    SDL_Vertex* vertex = appendQuad();
+    vertex[0] = {SDL_FPoint{a.x, a.y}, color, SDL_FPoint{0, 0}};
+    vertex[1] = {SDL_FPoint{b.x, b.y}, color, SDL_FPoint{0, 0}};
+    vertex[2] = {SDL_FPoint{c.x, c.y}, color, SDL_FPoint{0, 0}};
+    vertex[3] = {SDL_FPoint{d.x, d.y}, color, SDL_FPoint{0, 0}};
+}
+
+void GeometryBatch::addRect(float x, float y, float width, float height, SDL_Color color) {
+    addTexturedRect(x, y, width, height, 0, 0, 0, 0, color);
+}
+
+void GeometryBatch::addConvexPolygon(const Vector2* points, int count, SDL_Color color) {
+    if (count < 3) {
+        return;
+    }
+
+    int first = static_cast<int>(vertices.size());
+    for (int i = 0; i < count; i++) {
+        pushVertex(points[i].x, points[i].y, color);
+    }
+    for (int i = 1; i < count - 1; i++) {
+        indices.insert(indices.end(), {first, first + i, first + i + 1});
+    }
+}
+
+void GeometryBatch::addTexturedRect(float x, float y, float width, float height,
+                                    float u0, float v0, float u1, float v1, SDL_Color color) {
+    SDL_Vertex* vertex = appendQuad();
+    vertex[0] = {SDL_FPoint{x, y}, color, SDL_FPoint{u0, v0}};
+    vertex[1] = {SDL_FPoint{x + width, y}, color, SDL_FPoint{u1, v0}};
+    vertex[2] = {SDL_FPoint{x + width, y + height}, color, SDL_FPoint{u1, v1}};
+    vertex[3] = {SDL_FPoint{x, y + height}, color, SDL_FPoint{u0, v1}};
+}
+
+void GeometryBatch::addQuads(const SDL_Vertex* corners, size_t quadCount, const Vector2& offset, float scale) {
+    if (quadCount == 0) {
+        return;
+    }
+
+    size_t firstVertex = vertices.size();
+    size_t firstIndex = indices.size();
+    vertices.resize(firstVertex + quadCount * 4);
+    indices.resize(firstIndex + quadCount * 6);
+
+    SDL_Vertex* vertex = &vertices[firstVertex];
+    for (size_t i = 0; i < quadCount * 4; i++) {
+        vertex[i] = corners[i];
+        vertex[i].position.x = offset.x + corners[i].position.x * scale;
+        vertex[i].position.y = offset.y + corners[i].position.y * scale;
+    }
+    int* out = &indices[firstIndex];
+    for (size_t quad = 0; quad < quadCount; quad++) {
+        int first = static_cast<int>(firstVertex + quad * 4);
+        out[0] = first;
+        out[1] = first + 1;
+        out[2] = first + 2;
+        out[3] = first;
+        out[4] = first + 2;
+        out[5] = first + 3;
+        out += 6;
+    }
+}
+
+void GeometryBatch::draw(SDL_Renderer* renderer, SDL_Texture* texture) const {
+    if (vertices.empty()) {
+        return;
+    }
+
+    SDL_RenderGeometry(renderer, texture,
+                       vertices.data(), static_cast<int>(vertices.size()),
+                       indices.data(), static_cast<int>(indices.size()));
+}
+
+int circleSegments(float radius) {
+    // Keep each edge around 4 pixels long
+    int segments = static_cast<int>(std::ceil(2.0f * 3.14159265f * radius / 4.0f));
+    return std::max(8, std::min(segments, 64));
+}
+
+} // namespace ContextEngine
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "context-types.hpp"
+
+#include <vector>
+
+namespace ContextEngine {
+
+// Collects triangles in screen space and draws them with a single
+// SDL_RenderGeometry call. Buffers keep their capacity between frames.
+class GeometryBatch {
+public:
+    void clear();
+    bool empty() const { return vertices.empty(); }
+    void reserve(size_t vertexCount, size_t indexCount); // Avoid regrowing while filling a large batch
+
+    void addTriangle(const Vector2& a, const Vector2& b, const Vector2& c, SDL_Color color);
+    void addQuad(const Vector2& a, const Vector2& b, const Vector2& c, const Vector2& d, SDL_Color color); // Corners in winding order
+    void addRect(float x, float y, float width, float height, SDL_Color color);
+
+    // Fan of a convex outline, e.g. a circle or rounded rectangle already transformed
+    void addConvexPolygon(const Vector2* points, int count, SDL_Color color);
+
+    // Axis aligned quad sampling a region of the batch texture (UVs in 0..1)
+    void addTexturedRect(float x, float y, float width, float height,
+                         float u0, float v0, float u1, float v1, SDL_Color color);
+
+    // Prebuilt quads as groups of four corners, e.g. a cached mesh, placed at
+    // offset + position * scale
+    void addQuads(const SDL_Vertex* corners, size_t quadCount, const Vector2& offset, float scale);
+
+    // Draw everything with an optional texture; the batch is left intact
+    void draw(SDL_Renderer* renderer, SDL_Texture* texture = nullptr) const;
+
+    size_t getVertexCount() const { return vertices.size(); }
+    size_t getIndexCount() const { return indices.size(); }
+
+private:
+    int pushVertex(float x, float y, SDL_Color color, float u = 0.0f, float v = 0.0f);
+    SDL_Vertex* appendQuad(); // Four new vertices with their two triangles already indexed
+
+    std::vector<SDL_Vertex> vertices;
+    std::vector<int> indices;
+};
+
+// Segments for a circle of a given on-screen radius, fine enough to look round
+int circleSegments(float radius);
+
+} // namespace ContextEngine
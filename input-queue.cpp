@@ -0,0 +1,137 @@
+#include "input-queue.hpp"
+
+namespace ContextEngine {
+
+InputQueue::InputQueue(size_t capacity)
+    : ring(capacity)
+    , dropped(0)
+    , active(false)
+    , filtered(0)
+    , previousFilter(nullptr)
+    , previousFilterData(nullptr)
+    , hasMotion(false)
+    , coalesceMotion(true)
+    , coalesced(0)
+{
+    for (std::atomic<Uint32>& word : blocked) {
+        word.store(0, std::memory_order_relaxed);
+    }
+}
+
+InputQueue::~InputQueue() {
+    stop();
+}
+
+void InputQueue::start() {
+    if (active) {
+        return;
+    }
+    producer = std::this_thread::get_id();
+    if (!SDL_GetEventFilter(&previousFilter, &previousFilterData)) {
+        previousFilter = nullptr;
+        previousFilterData = nullptr;
+    }
+    SDL_SetEventFilter(&InputQueue::filter, this);
+    SDL_AddEventWatch(&InputQueue::watch, this);
+    active = true;
+}
+
+void InputQueue::stop() {
+    if (!active) {
+        return;
+    }
+    SDL_DelEventWatch(&InputQueue::watch, this);
+    SDL_SetEventFilter(previousFilter, previousFilterData);
+    flushMotion();
+    active = false;
+}
+
+void InputQueue::setTypeBlocked(Uint32 type, bool block) {
+    if (type < FIRST_FILTERED_TYPE || type > LAST_FILTERED_TYPE) {
+        return;
+    }
+    Uint32 index = type - FIRST_FILTERED_TYPE;
+    Uint32 bit = 1u << (index & 31);
+    if (block) {
+        blocked[index >> 5].fetch_or(bit, std::memory_order_relaxed);
+    } else {
+        blocked[index >> 5].fetch_and(~bit, std::memory_order_relaxed);
+    }
+}
+
+bool InputQueue::isTypeBlocked(Uint32 type) const {
+    if (type < FIRST_FILTERED_TYPE || type > LAST_FILTERED_TYPE) {
+        return false;
+    }
+    Uint32 index = type - FIRST_FILTERED_TYPE;
+    return (blocked[index >> 5].load(std::memory_order_relaxed) >> (index & 31)) & 1;
+}
+
+int SDLCALL InputQueue::filter(void* userdata, SDL_Event* event) {
+    InputQueue* queue = static_cast<InputQueue*>(userdata);
+    if (queue->isTypeBlocked(event->type)) {
+        queue->filtered.fetch_add(1, std::memory_order_relaxed);
+        return 0;
+    }
+    return queue->previousFilter ? queue->previousFilter(queue->previousFilterData, event) : 1;
+}
+
+int SDLCALL InputQueue::watch(void* userdata, SDL_Event* event) {
+    InputQueue* queue = static_cast<InputQueue*>(userdata);
+    InputEvent queued = {*event, SDL_GetPerformanceCounter()};
+    if (std::this_thread::get_id() != queue->producer) {
+        queue->foreign.push(std::move(queued));
+        return 0;
+    }
+
+    if (event->type == SDL_MOUSEMOTION && queue->coalesceMotion) {
+        SDL_MouseMotionEvent& held = queue->motion.event.motion;
+        if (queue->hasMotion && held.windowID == event->motion.windowID &&
+            held.which == event->motion.which && held.state == event->motion.state) {
+            // Newest position, summed motion, arrival of the first
+            held.timestamp = event->motion.timestamp;
+            held.x = event->motion.x;
+            held.y = event->motion.y;
+            held.xrel += event->motion.xrel;
+            held.yrel += event->motion.yrel;
+            queue->coalesced.fetch_add(1, std::memory_order_relaxed);
+            return 0;
+        }
+        queue->flushMotion();
+        queue->motion = queued;
+        queue->hasMotion = true;
+        return 0;
+    }
+
+    queue->flushMotion();
+    queue->publish(queued);
+    return 0;
+}
+
+void InputQueue::publish(const InputEvent& queued) {
+    if (!ring.push(queued)) {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+
+void InputQueue::pump() {
+    if (!active) {
+        return;
+    }
+    SDL_PumpEvents();
+    SDL_FlushEvents(SDL_FIRSTEVENT, SDL_LASTEVENT);
+}
+
+void InputQueue::flushMotion() {
+    if (hasMotion) {
+        publish(motion);
+        hasMotion = false;
+    }
+}
+
+bool InputQueue::pop(InputEvent& event) {
+    return ring.pop(event) || foreign.pop(event);
+}
+
+} // namespace ContextEngine
@@ -0,0 +1,169 @@
+#pragma once
+
+#include "context-types.hpp"
+#include "worker-pool.hpp"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace ContextEngine {
+
+// Bounded single producer, single consumer ring. push and pop never lock or
+// allocate; each side only writes its own index and keeps a cached copy of
+// the other's, so the indices' cache lines are touched only when needed.
+template <typename T>
+class SpscQueue {
+public:
+    // Capacity is rounded up to a power of two
+    explicit SpscQueue(size_t capacity)
+        : head(0)
+        , tail(0)
+        , cachedHead(0)
+        , cachedTail(0)
+    {
+        size_t size = 2;
+        while (size < capacity) {
+            size *= 2;
+        }
+        items.resize(size);
+        mask = size - 1;
+    }
+
+    // Prevent copying
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    // Producer only; false when full
+    bool push(const T& item) {
+        size_t at = tail.load(std::memory_order_relaxed);
+        if (at - cachedHead > mask) {
+            cachedHead = head.load(std::memory_order_acquire);
+            if (at - cachedHead > mask) {
+                return false;
+            }
+        }
+        items[at & mask] = item;
+        tail.store(at + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer only; false when empty
+    bool pop(T& item) {
+        size_t at = head.load(std::memory_order_relaxed);
+        if (at == cachedTail) {
+            cachedTail = tail.load(std::memory_order_acquire);
+            if (at == cachedTail) {
+                return false;
+            }
+        }
+        item = items[at & mask];
+        head.store(at + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Exact only when called from one of the two sides with the other idle
+    size_t size() const { return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire); }
+    size_t capacity() const { return mask + 1; }
+
+private:
+    std::vector<T> items;
+    size_t mask;
+
+    alignas(64) std::atomic<size_t> head; // Next to pop, written by the consumer
+    alignas(64) std::atomic<size_t> tail; // Next to push, written by the producer
+    alignas(64) size_t cachedHead;        // Producer's last look at head
+    alignas(64) size_t cachedTail;        // Consumer's last look at tail
+};
+
+// An SDL event and the performance counter when it reached SDL's queue
+struct InputEvent {
+    SDL_Event event;
+    Uint64 time;
+};
+
+// Takes every event as SDL queues it, through an event watch, and keeps it
+// with a high resolution timestamp until the frame drains it, in arrival
+// order. The thread that calls start() is the producer: it is the one that
+// pumps SDL. Events pushed from other threads go through a locked side
+// queue and are drained after the ring.
+//
+// An SDL event filter in front of the watch drops blocked event types
+// before SDL queues them, and runs of mouse motion are merged into one
+// event carrying the summed relative motion.
+class InputQueue {
+public:
+    // Input, device and drop events can be blocked; window, render and user
+    // events always pass, since SDL itself relies on some of them
+    static const Uint32 FIRST_FILTERED_TYPE = SDL_KEYDOWN;
+    static const Uint32 LAST_FILTERED_TYPE = 0x12FF;
+
+    explicit InputQueue(size_t capacity = 1024);
+    ~InputQueue(); // Removes the watch
+
+    // Prevent copying
+    InputQueue(const InputQueue&) = delete;
+    InputQueue& operator=(const InputQueue&) = delete;
+
+    // Install and remove the event watch; SDL must be initialized
+    void start();
+    void stop();
+    bool isActive() const { return active; }
+
+    // Collect what the OS has for us now, so it is timestamped on arrival
+    // rather than at the next drain. Producer thread only. SDL's own queue is
+    // emptied, since every event in it is already in the ring.
+    void pump();
+
+    // Release motion held back for merging, so the next drain sees it.
+    // Producer thread, before draining; pumping alone keeps merging.
+    void flushMotion();
+
+    // Next event in arrival order, consumer side
+    bool pop(InputEvent& event);
+
+    // Whether a drain would return anything, counting motion held back for
+    // merging. Producer thread; SDL's queue may be empty while this is true.
+    bool hasPending() const { return hasMotion || ring.size() > 0 || foreign.size() > 0; }
+
+    // Drop an event type in the filter (only types in the filtered range)
+    void setTypeBlocked(Uint32 type, bool blocked);
+    bool isTypeBlocked(Uint32 type) const;
+
+    // Merge consecutive mouse motion with the same buttons held (default on)
+    void setMotionCoalescing(bool enable) { coalesceMotion = enable; }
+
+    // Events lost because the ring was full
+    Uint64 getDroppedCount() const { return dropped.load(std::memory_order_relaxed); }
+
+    // Events blocked by the filter, and motion events merged into another
+    Uint64 getFilteredCount() const { return filtered.load(std::memory_order_relaxed); }
+    Uint64 getCoalescedCount() const { return coalesced.load(std::memory_order_relaxed); }
+
+private:
+    static const int BLOCKED_WORDS = (LAST_FILTERED_TYPE - FIRST_FILTERED_TYPE + 1) / 32;
+
+    static int SDLCALL filter(void* userdata, SDL_Event* event);
+    static int SDLCALL watch(void* userdata, SDL_Event* event);
+    void publish(const InputEvent& queued);
+
+    SpscQueue<InputEvent> ring;
+    CompletionQueue<InputEvent> foreign; // Events pushed from other threads
+    std::thread::id producer;
+    std::atomic<Uint64> dropped;
+    bool active;
+
+    // Read by the filter on whichever thread pushes an event
+    std::atomic<Uint32> blocked[BLOCKED_WORDS];
+    std::atomic<Uint64> filtered;
+    SDL_EventFilter previousFilter; // The application's filter, still called
+    void* previousFilterData;
+
+    // Motion held back in case the next event extends it, producer only
+    InputEvent motion;
+    bool hasMotion;
+    bool coalesceMotion;
+    std::atomic<Uint64> coalesced;
+};
+
+} // namespace ContextEngine
@@ -0,0 +1,274 @@
+#include "input-record.hpp"
+
+#include <cstddef>
+#include <cstring>
+
+namespace ContextEngine {
+
+InputRecorder::InputRecorder()
+    : frameEvents(0)
+    , frameCount(0)
+    , startTime(0)
+{
+}
+
+InputRecorder::~InputRecorder() {
+    close();
+}
+
+bool InputRecorder::open(const std::string& path, Uint32 seed) {
+    close();
+
+    out.open(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        SDL_Log("Failed to open input log %s!", path.c_str());
+        return false;
+    }
+
+    InputLogHeader header = {MAGIC, VERSION, seed, 0};
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    frame.clear();
+    framePrepared.clear();
+    frameEvents = 0;
+    frameCount = 0;
+    startTime = SDL_GetTicks();
+    return true;
+}
+
+void InputRecorder::close() {
+    if (!out.is_open()) {
+        return;
+    }
+
+    // Events after the last update belong to no frame and are dropped
+    out.seekp(offsetof(InputLogHeader, frameCount));
+    out.write(reinterpret_cast<const char*>(&frameCount), sizeof(frameCount));
+    out.close();
+}
+
+template <typename T>
+void InputRecorder::put(const T& value) {
+    size_t at = frame.size();
+    frame.resize(at + sizeof(T));
+    std::memcpy(frame.data() + at, &value, sizeof(T));
+}
+
+void InputRecorder::record(const SDL_Event& event) {
+    if (!out.is_open()) {
+        return;
+    }
+
+    switch (event.type) {
+        case SDL_QUIT:
+        case SDL_WINDOWEVENT:
+        case SDL_KEYDOWN:
+        case SDL_KEYUP:
+        case SDL_TEXTINPUT:
+        case SDL_MOUSEMOTION:
+        case SDL_MOUSEBUTTONDOWN:
+        case SDL_MOUSEBUTTONUP:
+        case SDL_MOUSEWHEEL:
+            break;
+        default:
+            return;
+    }
+
+    put(event.type);
+    put(event.common.timestamp - startTime);
+    switch (event.type) {
+        case SDL_WINDOWEVENT:
+            put(event.window.event);
+            put(event.window.data1);
+            put(event.window.data2);
+            break;
+
+        case SDL_KEYDOWN:
+        case SDL_KEYUP:
+            put(static_cast<Uint16>(event.key.keysym.scancode));
+            put(static_cast<Sint32>(event.key.keysym.sym));
+            put(event.key.keysym.mod);
+            put(event.key.state);
+            put(event.key.repeat);
+            break;
+
+        case SDL_TEXTINPUT: {
+            Uint8 length = static_cast<Uint8>(strnlen(event.text.text, sizeof(event.text.text) - 1));
+            put(length);
+            size_t at = frame.size();
+            frame.resize(at + length);
+            std::memcpy(frame.data() + at, event.text.text, length);
+            break;
+        }
+
+        case SDL_MOUSEMOTION:
+            put(event.motion.state);
+            put(event.motion.x);
+            put(event.motion.y);
+            put(event.motion.xrel);
+            put(event.motion.yrel);
+            break;
+
+        case SDL_MOUSEBUTTONDOWN:
+        case SDL_MOUSEBUTTONUP:
+            put(event.button.button);
+            put(event.button.state);
+            put(event.button.clicks);
+            put(event.button.x);
+            put(event.button.y);
+            break;
+
+        case SDL_MOUSEWHEEL:
+            put(event.wheel.x);
+            put(event.wheel.y);
+            put(event.wheel.direction);
+            break;
+    }
+    frameEvents++;
+}
+
+void InputRecorder::recordScenePrepared(int index) {
+    if (out.is_open()) {
+        framePrepared.push_back(index);
+    }
+}
+
+void InputRecorder::endFrame(float deltaTime) {
+    if (!out.is_open()) {
+        return;
+    }
+
+    InputLogFrame header = {deltaTime, frameEvents, static_cast<Uint32>(framePrepared.size())};
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(frame.data()), static_cast<std::streamsize>(frame.size()));
+    out.write(reinterpret_cast<const char*>(framePrepared.data()),
+              static_cast<std::streamsize>(framePrepared.size() * sizeof(Sint32)));
+    frame.clear();
+    framePrepared.clear();
+    frameEvents = 0;
+    frameCount++;
+}
+
+InputReplay::InputReplay()
+    : offset(0)
+    , seed(0)
+    , frameCount(0)
+    , frame(0)
+{
+}
+
+bool InputReplay::open(const std::string& path) {
+    close();
+    if (!file.open(path)) {
+        SDL_Log("Failed to open input log %s!", path.c_str());
+        return false;
+    }
+
+    InputLogHeader header;
+    if (!get(header) || header.magic != InputRecorder::MAGIC || header.version != InputRecorder::VERSION) {
+        SDL_Log("Input log %s is invalid!", path.c_str());
+        close();
+        return false;
+    }
+    seed = header.seed;
+    frameCount = header.frameCount;
+    return true;
+}
+
+void InputReplay::close() {
+    file.close();
+    prepared.clear();
+    offset = 0;
+    seed = 0;
+    frameCount = 0;
+    frame = 0;
+}
+
+template <typename T>
+bool InputReplay::get(T& value) {
+    if (file.size() - offset < sizeof(T)) {
+        return false;
+    }
+    std::memcpy(&value, file.data() + offset, sizeof(T));
+    offset += sizeof(T);
+    return true;
+}
+
+bool InputReplay::nextFrame(std::vector<SDL_Event>& events, float& deltaTime) {
+    events.clear();
+    prepared.clear();
+    InputLogFrame header;
+    if (!file.isOpen() || frame >= frameCount || !get(header)) {
+        return false;
+    }
+
+    for (Uint32 i = 0; i < header.eventCount; i++) {
+        SDL_Event event;
+        std::memset(&event, 0, sizeof(event));
+        bool complete = get(event.type) && get(event.common.timestamp);
+        switch (event.type) {
+            case SDL_WINDOWEVENT:
+                complete = complete && get(event.window.event) && get(event.window.data1) && get(event.window.data2);
+                break;
+
+            case SDL_KEYDOWN:
+            case SDL_KEYUP: {
+                Uint16 scancode = 0;
+                Sint32 sym = 0;
+                complete = complete && get(scancode) && get(sym) && get(event.key.keysym.mod) &&
+                           get(event.key.state) && get(event.key.repeat);
+                event.key.keysym.scancode = static_cast<SDL_Scancode>(scancode);
+                event.key.keysym.sym = static_cast<SDL_Keycode>(sym);
+                break;
+            }
+
+            case SDL_TEXTINPUT: {
+                Uint8 length = 0;
+                complete = complete && get(length) && length < sizeof(event.text.text) &&
+                           file.size() - offset >= length;
+                if (complete) {
+                    std::memcpy(event.text.text, file.data() + offset, length);
+                    offset += length;
+                }
+                break;
+            }
+
+            case SDL_MOUSEMOTION:
+                complete = complete && get(event.motion.state) && get(event.motion.x) && get(event.motion.y) &&
+                           get(event.motion.xrel) && get(event.motion.yrel);
+                break;
+
+            case SDL_MOUSEBUTTONDOWN:
+            case SDL_MOUSEBUTTONUP:
+                complete = complete && get(event.button.button) && get(event.button.state) &&
+                           get(event.button.clicks) && get(event.button.x) && get(event.button.y);
+                break;
+
+            case SDL_MOUSEWHEEL:
+                complete = complete && get(event.wheel.x) && get(event.wheel.y) && get(event.wheel.direction);
+                break;
+        }
+        if (!complete) {
+            SDL_Log("Input log is truncated at frame %u!", frame);
+            events.clear();
+            return false;
+        }
+        events.push_back(event);
+    }
+
+    for (Uint32 i = 0; i < header.preparedCount; i++) {
+        Sint32 index = 0;
+        if (!get(index)) {
+            SDL_Log("Input log is truncated at frame %u!", frame);
+            events.clear();
+            prepared.clear();
+            return false;
+        }
+        prepared.push_back(index);
+    }
+
+    deltaTime = header.deltaTime;
+    frame++;
+    return true;
+}
+
+} // namespace ContextEngine
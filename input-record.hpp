@@ -0,0 +1,108 @@
+#pragma once
+
+#include "context-types.hpp"
+#include "font-cache.hpp"
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace ContextEngine {
+
+// Input log layout, in host byte order: this header, then for every frame
+// an InputLogFrame followed by its events and the Sint32 indices of the
+// scenes that finished preparing on it. Each event is its type, its
+// timestamp in milliseconds since recording started, and only the fields
+// the engine and scenes read for that type.
+struct InputLogHeader {
+    Uint32 magic;
+    Uint32 version;
+    Uint32 seed;       // Engine::getRandomSeed() while recording
+    Uint32 frameCount; // Filled in when the recording is closed
+};
+
+struct InputLogFrame {
+    float deltaTime;
+    Uint32 eventCount;
+    Uint32 preparedCount;
+};
+
+// Writes the events of every frame and the deltaTime it was updated with.
+// Event types the engine never reads (joysticks, drops, user events...) are
+// left out.
+class InputRecorder {
+public:
+    static const Uint32 MAGIC = 0x52494543; // "CEIR"
+    static const Uint32 VERSION = 2;
+
+    InputRecorder();
+    ~InputRecorder(); // Closes the log
+
+    // Prevent copying
+    InputRecorder(const InputRecorder&) = delete;
+    InputRecorder& operator=(const InputRecorder&) = delete;
+
+    bool open(const std::string& path, Uint32 seed);
+    void close();
+    bool isOpen() const { return out.is_open(); }
+
+    // Add an event to the current frame
+    void record(const SDL_Event& event);
+
+    // Note that a preloaded scene finished preparing on the current frame,
+    // which depends on the loader thread and not on input
+    void recordScenePrepared(int index);
+
+    // Write the current frame with the deltaTime it was updated with
+    void endFrame(float deltaTime);
+
+    Uint32 getFrameCount() const { return frameCount; }
+
+private:
+    template <typename T>
+    void put(const T& value);
+
+    std::ofstream out;
+    std::vector<Uint8> frame; // Encoded events of the current frame
+    std::vector<Sint32> framePrepared;
+    Uint32 frameEvents;
+    Uint32 frameCount;
+    Uint32 startTime;
+};
+
+// Reads a log back one frame at a time
+class InputReplay {
+public:
+    InputReplay();
+
+    // Prevent copying
+    InputReplay(const InputReplay&) = delete;
+    InputReplay& operator=(const InputReplay&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+    bool isOpen() const { return file.isOpen(); }
+
+    Uint32 getSeed() const { return seed; }
+    Uint32 getFrameCount() const { return frameCount; }
+    Uint32 getFrame() const { return frame; } // Frames read so far
+
+    // Events and deltaTime of the next frame; false once the log is over
+    bool nextFrame(std::vector<SDL_Event>& events, float& deltaTime);
+
+    // Scenes that finished preparing on the frame nextFrame last read
+    const std::vector<int>& getPreparedScenes() const { return prepared; }
+
+private:
+    template <typename T>
+    bool get(T& value);
+
+    MappedFile file;
+    std::vector<int> prepared;
+    size_t offset;
+    Uint32 seed;
+    Uint32 frameCount;
+    Uint32 frame;
+};
+
+} // namespace ContextEngine
@@ -0,0 +1,41 @@
+#include "key-state.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace ContextEngine {
+
+KeySnapshot KeySnapshot::fromKeyboardState(const Uint8* state, int count) {
+    KeySnapshot snapshot;
+    if (!state) {
+        return snapshot;
+    }
+    count = std::max(0, std::min(count, KEY_COUNT));
+
+    // Eight 0/1 bytes at a time: the multiply gathers the low bit of each
+    // byte into the top byte, in order
+    for (int key = 0; key + 8 <= count; key += 8) {
+        Uint64 bytes;
+        std::memcpy(&bytes, state + key, sizeof(bytes));
+        bytes = SDL_SwapLE64(bytes) & 0x0101010101010101ULL;
+        Uint64 bits = (bytes * 0x0102040810204080ULL) >> 56;
+        snapshot.words[key >> 6] |= bits << (key & 63);
+    }
+    for (int key = count & ~7; key < count; key++) {
+        snapshot.set(key, state[key] != 0);
+    }
+    return snapshot;
+}
+
+int KeySnapshot::count() const {
+    int total = 0;
+    for (Uint64 word : words) {
+        while (word) {
+            word &= word - 1;
+            total++;
+        }
+    }
+    return total;
+}
+
+} // namespace ContextEngine
@@ -0,0 +1,115 @@
+#pragma once
+
+#include "context-types.hpp"
+
+#include <initializer_list>
+
+namespace ContextEngine {
+
+// One bit per scancode, SDL_NUM_SCANCODES (512) bits in eight words. Set
+// operations work a word at a time, and a snapshot is 64 trivially copyable
+// bytes, cheap to keep per frame for rollback or replay. Also used as a
+// mask of keys, e.g. KeySnapshot::of({SDL_SCANCODE_W, SDL_SCANCODE_UP}).
+struct KeySnapshot {
+    static constexpr int KEY_COUNT = 512;
+    static constexpr int WORD_COUNT = KEY_COUNT / 64;
+
+    Uint64 words[WORD_COUNT] = {};
+
+    static KeySnapshot of(std::initializer_list<int> scancodes) {
+        KeySnapshot mask;
+        for (int scancode : scancodes) {
+            mask.set(scancode, true);
+        }
+        return mask;
+    }
+
+    // Pack SDL_GetKeyboardState's array of 0/1 bytes
+    static KeySnapshot fromKeyboardState(const Uint8* state, int count = SDL_NUM_SCANCODES);
+
+    bool test(int scancode) const {
+        if (static_cast<unsigned>(scancode) >= static_cast<unsigned>(KEY_COUNT)) {
+            return false;
+        }
+        return (words[scancode >> 6] >> (scancode & 63)) & 1;
+    }
+
+    void set(int scancode, bool down) {
+        if (static_cast<unsigned>(scancode) >= static_cast<unsigned>(KEY_COUNT)) {
+            return;
+        }
+        Uint64 bit = static_cast<Uint64>(1) << (scancode & 63);
+        words[scancode >> 6] = down ? words[scancode >> 6] | bit : words[scancode >> 6] & ~bit;
+    }
+
+    void clear() {
+        for (Uint64& word : words) {
+            word = 0;
+        }
+    }
+
+    // Whether any, or all, of the keys in a mask are in this set
+    bool any(const KeySnapshot& mask) const {
+        Uint64 found = 0;
+        for (int i = 0; i < WORD_COUNT; i++) {
+            found |= words[i] & mask.words[i];
+        }
+        return found != 0;
+    }
+
+    bool all(const KeySnapshot& mask) const {
+        Uint64 missing = 0;
+        for (int i = 0; i < WORD_COUNT; i++) {
+            missing |= mask.words[i] & ~words[i];
+        }
+        return missing == 0;
+    }
+
+    bool empty() const {
+        Uint64 found = 0;
+        for (Uint64 word : words) {
+            found |= word;
+        }
+        return found == 0;
+    }
+
+    int count() const;
+
+    // Keys in this set and not in another
+    KeySnapshot without(const KeySnapshot& other) const {
+        KeySnapshot result;
+        for (int i = 0; i < WORD_COUNT; i++) {
+            result.words[i] = words[i] & ~other.words[i];
+        }
+        return result;
+    }
+
+    KeySnapshot operator&(const KeySnapshot& other) const {
+        KeySnapshot result;
+        for (int i = 0; i < WORD_COUNT; i++) {
+            result.words[i] = words[i] & other.words[i];
+        }
+        return result;
+    }
+
+    KeySnapshot operator|(const KeySnapshot& other) const {
+        KeySnapshot result;
+        for (int i = 0; i < WORD_COUNT; i++) {
+            result.words[i] = words[i] | other.words[i];
+        }
+        return result;
+    }
+
+    KeySnapshot operator^(const KeySnapshot& other) const {
+        KeySnapshot result;
+        for (int i = 0; i < WORD_COUNT; i++) {
+            result.words[i] = words[i] ^ other.words[i];
+        }
+        return result;
+    }
+
+    bool operator==(const KeySnapshot& other) const { return (*this ^ other).empty(); }
+    bool operator!=(const KeySnapshot& other) const { return !(*this == other); }
+};
+
+} // namespace ContextEngine
@@ -0,0 +1,84 @@
+#include "latency-stats.hpp"
+
+#include <algorithm>
+
+namespace ContextEngine {
+
+// Values below 32 get a bucket each, above that every power of two is split
+// into 16 buckets
+static const int LINEAR_BUCKETS = 32;
+static const int SUB_BUCKETS = 16;
+static const int BUCKET_COUNT = LINEAR_BUCKETS + (64 - 5) * SUB_BUCKETS;
+
+LatencyHistogram::LatencyHistogram()
+    : buckets(BUCKET_COUNT, 0)
+    , count(0)
+    , total(0)
+    , max(0)
+{
+}
+
+int LatencyHistogram::bucketFor(Uint64 microseconds) {
+    if (microseconds < LINEAR_BUCKETS) {
+        return static_cast<int>(microseconds);
+    }
+    int exponent = 63;
+    while (!(microseconds >> exponent)) {
+        exponent--;
+    }
+    int sub = static_cast<int>((microseconds >> (exponent - 4)) & (SUB_BUCKETS - 1));
+    return LINEAR_BUCKETS + (exponent - 5) * SUB_BUCKETS + sub;
+}
+
+Uint64 LatencyHistogram::bucketLimit(int bucket) {
+    if (bucket < LINEAR_BUCKETS) {
+        return static_cast<Uint64>(bucket);
+    }
+    int exponent = (bucket - LINEAR_BUCKETS) / SUB_BUCKETS + 5;
+    Uint64 sub = static_cast<Uint64>((bucket - LINEAR_BUCKETS) % SUB_BUCKETS);
+    return ((SUB_BUCKETS + sub + 1) << (exponent - 4)) - 1;
+}
+
+void LatencyHistogram::add(Uint64 microseconds) {
+    buckets[bucketFor(microseconds)]++;
+    count++;
+    total += microseconds;
+    max = std::max(max, microseconds);
+}
+
+void LatencyHistogram::reset() {
+    std::fill(buckets.begin(), buckets.end(), 0);
+    count = 0;
+    total = 0;
+    max = 0;
+}
+
+double LatencyHistogram::getMean() const {
+    return count > 0 ? total / 1000.0 / count : 0.0;
+}
+
+double LatencyHistogram::getPercentile(double p) const {
+    if (count == 0) {
+        return 0.0;
+    }
+    Uint64 rank = static_cast<Uint64>(std::max(0.0, std::min(p, 1.0)) * (count - 1)) + 1;
+    Uint64 seen = 0;
+    for (int bucket = 0; bucket < BUCKET_COUNT; bucket++) {
+        seen += buckets[bucket];
+        if (seen >= rank) {
+            return std::min(bucketLimit(bucket), max) / 1000.0;
+        }
+    }
+    return max / 1000.0;
+}
+
+const char* getInputLatencyKindName(InputLatencyKind kind) {
+    switch (kind) {
+        case InputLatencyKind::Key: return "key";
+        case InputLatencyKind::MouseButton: return "mouse button";
+        case InputLatencyKind::MouseMotion: return "mouse motion";
+        default: return "other";
+    }
+}
+
+} // namespace ContextEngine
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "context-types.hpp"
+
+#include <vector>
+
+namespace ContextEngine {
+
+// Histogram of durations with buckets about 6% wide from 1 microsecond up
+// to hours, so percentiles cost nothing to record and stay accurate without
+// keeping every sample.
+class LatencyHistogram {
+public:
+    LatencyHistogram();
+
+    void add(Uint64 microseconds);
+    void reset();
+
+    Uint64 getCount() const { return count; }
+    double getMean() const;                      // Milliseconds
+    double getMax() const { return max / 1000.0; } // Milliseconds
+
+    // Upper edge of the bucket holding the p-th fraction (0..1) of samples,
+    // in milliseconds; 0 with no samples
+    double getPercentile(double p) const;
+
+private:
+    static int bucketFor(Uint64 microseconds);
+    static Uint64 bucketLimit(int bucket);
+
+    std::vector<Uint32> buckets;
+    Uint64 count;
+    Uint64 total;
+    Uint64 max;
+};
+
+// Kinds of input whose event-to-present latency is tracked separately
+enum class InputLatencyKind {
+    Key,         // Key presses, releases and text input
+    MouseButton, // Buttons and wheel
+    MouseMotion,
+    Count
+};
+
+const char* getInputLatencyKindName(InputLatencyKind kind);
+
+} // namespace ContextEngine
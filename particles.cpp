@@ -0,0 +1,189 @@
+#include "particles.hpp"
+#include "context-engine.hpp"
+#include "simd-math.hpp"
+
+namespace ContextEngine {
+
+ParticleSystem::ParticleSystem(size_t capacity, Uint32 seed)
+    : capacity(capacity)
+    , count(0)
+    , rngState(seed != 0 ? seed : 1)
+    , positions(capacity)
+    , velocities(capacity)
+    , ages(capacity)
+    , inverseLifetimes(capacity)
+    , owners(capacity)
+    , gravity(0.0f, 0.0f)
+    , drag(0.0f)
+    , sprite(ParticleSprite::Quad)
+    , pointSize(2.0f)
+    , texture(nullptr)
+{
+}
+
+int ParticleSystem::addEmitter(const EmitterSettings& settings) {
+    emitters.push_back({settings, 0.0f, 0.0f, true});
+    return static_cast<int>(emitters.size()) - 1;
+}
+
+void ParticleSystem::setEmitting(int emitter, bool emitting) {
+    Emitter& target = emitters[emitter];
+    if (emitting && !target.emitting) {
+        // Restart the cycle, e.g. for a one shot effect
+        target.time = 0.0f;
+        target.pending = 0.0f;
+    }
+    target.emitting = emitting;
+}
+
+void ParticleSystem::burst(int emitter, int spawnCount) {
+    spawn(emitter, spawnCount);
+}
+
+void ParticleSystem::setSprite(ParticleSprite spriteKind, float pointPixels) {
+    sprite = spriteKind;
+    pointSize = pointPixels;
+}
+
+void ParticleSystem::clear() {
+    count = 0;
+    for (Emitter& emitter : emitters) {
+        emitter.time = 0.0f;
+        emitter.pending = 0.0f;
+    }
+}
+
+float ParticleSystem::random() {
+    // xorshift32; fast, and the same seed replays the same effect
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return (rngState >> 8) * (1.0f / 16777216.0f);
+}
+
+void ParticleSystem::spawn(int emitter, int spawnCount) {
+    const EmitterSettings& settings = emitters[emitter].settings;
+    // Past capacity new particles are dropped rather than replacing old ones
+    size_t room = capacity - count;
+    size_t spawning = std::min(static_cast<size_t>(std::max(spawnCount, 0)), room);
+
+    for (size_t i = 0; i < spawning; i++) {
+        size_t index = count++;
+        Vector2 offset(0.0f, 0.0f);
+        if (settings.spawnRadius > 0.0f) {
+            // Square root keeps the points evenly spread over the disc
+            float radius = settings.spawnRadius * std::sqrt(random());
+            float angle = random(0.0f, 6.2831853f);
+            offset = Vector2(std::cos(angle) * radius, std::sin(angle) * radius);
+        }
+        float angle = settings.direction + random(-0.5f, 0.5f) * settings.spread;
+        float speed = random(settings.minSpeed, settings.maxSpeed);
+        float lifetime = std::max(random(settings.minLifetime, settings.maxLifetime), 0.001f);
+
+        positions[index] = settings.position + offset;
+        velocities[index] = Vector2(std::cos(angle) * speed, std::sin(angle) * speed);
+        ages[index] = 0.0f;
+        inverseLifetimes[index] = 1.0f / lifetime;
+        owners[index] = static_cast<Uint16>(emitter);
+    }
+}
+
+void ParticleSystem::kill(size_t index) {
+    size_t last = --count;
+    positions[index] = positions[last];
+    velocities[index] = velocities[last];
+    ages[index] = ages[last];
+    inverseLifetimes[index] = inverseLifetimes[last];
+    owners[index] = owners[last];
+}
+
+void ParticleSystem::update(float deltaTime) {
+    if (deltaTime <= 0.0f) {
+        return;
+    }
+
+    // Emit, carrying fractions over so low rates still spawn on time
+    for (size_t i = 0; i < emitters.size(); i++) {
+        Emitter& emitter = emitters[i];
+        if (!emitter.emitting) {
+            continue;
+        }
+        const EmitterSettings& settings = emitter.settings;
+        float cycle = settings.duration > 0.0f ? emitter.time / settings.duration : 0.0f;
+        emitter.pending += settings.rate * settings.rateCurve.evaluate(cycle) * deltaTime;
+        int spawnCount = static_cast<int>(emitter.pending);
+        emitter.pending -= spawnCount;
+        spawn(static_cast<int>(i), spawnCount);
+
+        emitter.time += deltaTime;
+        if (settings.duration > 0.0f && emitter.time >= settings.duration) {
+            if (settings.looping) {
+                emitter.time = std::fmod(emitter.time, settings.duration);
+            } else {
+                emitter.emitting = false;
+                emitter.time = 0.0f;
+                emitter.pending = 0.0f;
+            }
+        }
+    }
+
+    // Age, and compact the dead out of the live range
+    size_t index = 0;
+    while (index < count) {
+        ages[index] += deltaTime;
+        if (ages[index] * inverseLifetimes[index] >= 1.0f) {
+            kill(index);
+        } else {
+            index++;
+        }
+    }
+
+    // Forces, then positions through the batch kernel
+    const Vector2 gravityStep = gravity * deltaTime;
+    const float damping = std::max(0.0f, 1.0f - drag * deltaTime);
+    Vector2* velocity = velocities.data();
+    for (size_t i = 0; i < count; i++) {
+        velocity[i].x = (velocity[i].x + gravityStep.x) * damping;
+        velocity[i].y = (velocity[i].y + gravityStep.y) * damping;
+    }
+    integratePositions(positions.data(), velocities.data(), count, deltaTime);
+}
+
+void ParticleSystem::render(OtherCtx& ctx) {
+    batch.clear();
+    if (count == 0) {
+        return;
+    }
+
+    // Camera transform for every particle at once, into frame scratch memory
+    Vector2* screen = ctx.getFrameArena().allocateArray<Vector2>(count);
+    ctx.transformPoints(positions.data(), screen, count);
+    const float zoom = ctx.isCameraEnabled() ? ctx.getCameraZoom() : 1.0f;
+
+    int outputWidth = 0;
+    int outputHeight = 0;
+    SDL_GetRendererOutputSize(ctx.getRenderer(), &outputWidth, &outputHeight);
+
+    batch.reserve(count * 4, count * 6);
+    for (size_t i = 0; i < count; i++) {
+        const EmitterSettings& settings = emitters[owners[i]].settings;
+        float life = ages[i] * inverseLifetimes[i];
+        float half = (sprite == ParticleSprite::Point ? pointSize : settings.size.evaluate(life) * zoom) * 0.5f;
+        const Vector2& center = screen[i];
+        if (outputWidth > 0 && (center.x + half < 0 || center.x - half > outputWidth ||
+                                center.y + half < 0 || center.y - half > outputHeight)) {
+            continue;
+        }
+
+        SDL_Color color = settings.color.evaluate(life).toSDLColor();
+        if (texture && sprite == ParticleSprite::Quad) {
+            batch.addTexturedRect(center.x - half, center.y - half, half * 2, half * 2, 0, 0, 1, 1, color);
+        } else {
+            batch.addRect(center.x - half, center.y - half, half * 2, half * 2, color);
+        }
+    }
+
+    ctx.drawBatch(batch, sprite == ParticleSprite::Quad ? texture : nullptr);
+}
+
+} // namespace ContextEngine
@@ -0,0 +1,185 @@
+#pragma once
+
+#include "context-types.hpp"
+#include "geometry-batch.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+namespace ContextEngine {
+
+class OtherCtx;
+
+inline float lerpValue(float a, float b, float t) {
+    return a + (b - a) * t;
+}
+
+inline Color lerpValue(const Color& a, const Color& b, float t) {
+    auto channel = [t](Uint8 from, Uint8 to) {
+        return static_cast<Uint8>(std::lround(from + (to - from) * t));
+    };
+    return Color(channel(a.r, b.r), channel(a.g, b.g), channel(a.b, b.b), channel(a.a, b.a));
+}
+
+// Piecewise linear curve over 0..1, e.g. a particle's size over its life.
+// Keys are baked into a lookup table, so evaluating is one index per call.
+template<typename T>
+class Curve {
+public:
+    static constexpr int TABLE_SIZE = 64;
+
+    Curve() : Curve(T()) {}
+    Curve(const T& constant) { setConstant(constant); }
+    Curve(const T& start, const T& end) {
+        keys = {{0.0f, start}, {1.0f, end}};
+        bake();
+    }
+
+    void setConstant(const T& value) {
+        keys = {{0.0f, value}};
+        bake();
+    }
+
+    // Value at time 0..1; keys may be added in any order
+    void addKey(float time, const T& value) {
+        time = std::max(0.0f, std::min(time, 1.0f));
+        auto at = std::upper_bound(keys.begin(), keys.end(), time,
+            [](float value, const std::pair<float, T>& key) { return value < key.first; });
+        keys.insert(at, {time, value});
+        bake();
+    }
+
+    T evaluate(float time) const {
+        int index = static_cast<int>(time * (TABLE_SIZE - 1) + 0.5f);
+        return table[std::max(0, std::min(index, TABLE_SIZE - 1))];
+    }
+
+private:
+    // Exact value at a time from the keys, used to fill the table
+    T sample(float time) const {
+        if (time <= keys.front().first) {
+            return keys.front().second;
+        }
+        for (size_t i = 1; i < keys.size(); i++) {
+            if (time <= keys[i].first) {
+                const std::pair<float, T>& from = keys[i - 1];
+                const std::pair<float, T>& to = keys[i];
+                float span = to.first - from.first;
+                return lerpValue(from.second, to.second, span > 0.0f ? (time - from.first) / span : 1.0f);
+            }
+        }
+        return keys.back().second;
+    }
+
+    void bake() {
+        for (int i = 0; i < TABLE_SIZE; i++) {
+            table[i] = sample(static_cast<float>(i) / (TABLE_SIZE - 1));
+        }
+    }
+
+    std::vector<std::pair<float, T>> keys;
+    T table[TABLE_SIZE];
+};
+
+enum class ParticleSprite {
+    Quad, // Square of the curve's size in world units, textured when a texture is set
+    Point // Fixed size square in pixels that ignores zoom, the cheapest to draw
+};
+
+// Where and how an emitter spawns particles. Curves over "life" take a
+// particle's age divided by its lifetime; rateCurve takes the time within
+// the current emission cycle divided by duration.
+struct EmitterSettings {
+    Vector2 position;
+    float rate = 100.0f;     // Particles per second, scaled by rateCurve
+    float duration = 1.0f;   // Seconds in one emission cycle
+    bool looping = true;     // Otherwise stops after one cycle
+    Curve<float> rateCurve = Curve<float>(1.0f);
+
+    float minLifetime = 1.0f;
+    float maxLifetime = 1.0f;
+    float minSpeed = 50.0f;
+    float maxSpeed = 100.0f;
+    float direction = -1.5707964f; // Radians, 0 points along +x; default is up
+    float spread = 3.1415927f;     // Full cone angle around direction
+    float spawnRadius = 0.0f;      // Particles start anywhere within this circle
+
+    Curve<float> size = Curve<float>(4.0f);
+    Curve<Color> color = Curve<Color>(Color(255, 255, 255));
+};
+
+// A fixed capacity pool of particles stored as separate arrays (positions,
+// velocities, ages...) so update runs through the SIMD integration kernel.
+// Dead particles are swapped with the last live one, so the live range stays
+// packed and spawning never allocates. Everything is drawn through one
+// GeometryBatch in a single call.
+class ParticleSystem {
+public:
+    explicit ParticleSystem(size_t capacity = 10000, Uint32 seed = 1);
+
+    // Prevent copying
+    ParticleSystem(const ParticleSystem&) = delete;
+    ParticleSystem& operator=(const ParticleSystem&) = delete;
+
+    int addEmitter(const EmitterSettings& settings);
+    EmitterSettings& getEmitter(int emitter) { return emitters[emitter].settings; }
+    void setEmitterPosition(int emitter, const Vector2& position) { emitters[emitter].settings.position = position; }
+    void setEmitting(int emitter, bool emitting);
+    bool isEmitting(int emitter) const { return emitters[emitter].emitting; }
+
+    // Spawn count particles at once, on top of the emission rate
+    void burst(int emitter, int count);
+
+    // Applied to every particle, in world units per second
+    void setGravity(const Vector2& acceleration) { gravity = acceleration; }
+    void setDrag(float perSecond) { drag = perSecond; } // Share of velocity lost per second
+
+    void setSprite(ParticleSprite spriteKind, float pointPixels = 2.0f);
+    void setTexture(SDL_Texture* spriteTexture) { texture = spriteTexture; }
+
+    void update(float deltaTime);
+    void clear();
+
+    // Cull, transform by the camera and draw every live particle in one call
+    void render(OtherCtx& ctx);
+
+    size_t getCount() const { return count; }
+    size_t getCapacity() const { return capacity; }
+    const GeometryBatch& getBatch() const { return batch; }
+
+private:
+    struct Emitter {
+        EmitterSettings settings;
+        float time;    // Within the current cycle
+        float pending; // Fractional particles carried to the next update
+        bool emitting;
+    };
+
+    void spawn(int emitter, int spawnCount);
+    void kill(size_t index);
+    float random(); // 0..1
+    float random(float min, float max) { return min + (max - min) * random(); }
+
+    size_t capacity;
+    size_t count;
+    Uint32 rngState;
+
+    std::vector<Vector2> positions;
+    std::vector<Vector2> velocities;
+    std::vector<float> ages;
+    std::vector<float> inverseLifetimes;
+    std::vector<Uint16> owners; // Emitter each particle came from
+
+    std::vector<Emitter> emitters;
+    Vector2 gravity;
+    float drag;
+
+    ParticleSprite sprite;
+    float pointSize;
+    SDL_Texture* texture;
+    GeometryBatch batch;
+};
+
+} // namespace ContextEngine
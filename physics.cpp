@@ -0,0 +1,519 @@
+#include "physics.hpp"
+#include "simd-math.hpp"
+#include "worker-pool.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace ContextEngine {
+
+static float dot(const Vector2& a, const Vector2& b) {
+    return a.x * b.x + a.y * b.y;
+}
+
+static Uint64 pairKey(int a, int b) {
+    return (static_cast<Uint64>(static_cast<Uint32>(a)) << 32) | static_cast<Uint32>(b);
+}
+
+// Moving point against a box around center; t is the fraction of motion.
+// Starting inside counts as no hit, overlaps are left to the narrowphase.
+static bool sweepPointBox(const Vector2& origin, const Vector2& motion, const Vector2& center,
+                          const Vector2& half, float& time, Vector2& normal) {
+    float enter = -1.0f;
+    float exit = 1.0f;
+    int enterAxis = -1;
+    const float start[2] = {origin.x - center.x, origin.y - center.y};
+    const float step[2] = {motion.x, motion.y};
+    const float extent[2] = {half.x, half.y};
+    for (int axis = 0; axis < 2; axis++) {
+        if (step[axis] == 0.0f) {
+            if (start[axis] <= -extent[axis] || start[axis] >= extent[axis]) {
+                return false;
+            }
+            continue;
+        }
+        float near = (-extent[axis] - start[axis]) / step[axis];
+        float far = (extent[axis] - start[axis]) / step[axis];
+        if (near > far) {
+            std::swap(near, far);
+        }
+        if (near > enter) {
+            enter = near;
+            enterAxis = axis;
+        }
+        exit = std::min(exit, far);
+    }
+    if (enterAxis < 0 || enter < 0.0f || enter > exit || enter > 1.0f) {
+        return false;
+    }
+
+    time = enter;
+    normal = enterAxis == 0 ? Vector2(step[0] > 0 ? -1.0f : 1.0f, 0.0f)
+                            : Vector2(0.0f, step[1] > 0 ? -1.0f : 1.0f);
+    return true;
+}
+
+static bool sweepPointCircle(const Vector2& origin, const Vector2& motion, const Vector2& center,
+                             float radius, float& time, Vector2& normal) {
+    Vector2 offset = origin - center;
+    float a = dot(motion, motion);
+    float b = 2.0f * dot(offset, motion);
+    float c = dot(offset, offset) - radius * radius;
+    if (a == 0.0f || c <= 0.0f) {
+        return false; // Not moving, or already overlapping
+    }
+    float discriminant = b * b - 4.0f * a * c;
+    if (discriminant < 0.0f) {
+        return false;
+    }
+    float t = (-b - std::sqrt(discriminant)) / (2.0f * a);
+    if (t < 0.0f || t > 1.0f) {
+        return false;
+    }
+
+    time = t;
+    Vector2 contact = offset + motion * t;
+    float length = std::sqrt(dot(contact, contact));
+    normal = length > 0.0f ? contact * (1.0f / length) : Vector2(0.0f, -1.0f);
+    return true;
+}
+
+// Moving circle center against a box grown by the radius with rounded
+// corners: two crossed boxes and four corner circles, earliest hit wins
+static bool sweepPointRoundedBox(const Vector2& origin, const Vector2& motion, const Vector2& center,
+                                 const Vector2& half, float radius, float& time, Vector2& normal) {
+    bool found = false;
+    float t;
+    Vector2 n;
+    auto take = [&](bool hit) {
+        if (hit && (!found || t < time)) {
+            time = t;
+            normal = n;
+            found = true;
+        }
+    };
+    take(sweepPointBox(origin, motion, center, Vector2(half.x + radius, half.y), t, n));
+    take(sweepPointBox(origin, motion, center, Vector2(half.x, half.y + radius), t, n));
+    for (int corner = 0; corner < 4; corner++) {
+        Vector2 point(center.x + (corner & 1 ? half.x : -half.x), center.y + (corner & 2 ? half.y : -half.y));
+        take(sweepPointCircle(origin, motion, point, radius, t, n));
+    }
+    return found;
+}
+
+PhysicsWorld::PhysicsWorld(const PhysicsSettings& settings)
+    : settings(settings)
+    , workers(nullptr)
+    , bodyCount(0)
+    , broadphase(settings.broadphaseCellSize)
+{
+}
+
+int PhysicsWorld::createBody(const BodyDef& def) {
+    int id;
+    if (!freeBodies.empty()) {
+        id = freeBodies.back();
+        freeBodies.pop_back();
+    } else {
+        id = static_cast<int>(bodies.size());
+        bodies.push_back(Body());
+        positions.push_back(Vector2());
+        velocities.push_back(Vector2());
+        previousPositions.push_back(Vector2());
+    }
+
+    Body& body = bodies[id];
+    body.type = def.type;
+    body.shape = def.shape;
+    body.halfExtents = def.halfExtents;
+    body.radius = def.radius;
+    body.inverseMass = def.type == BodyType::Dynamic && def.mass > 0.0f ? 1.0f / def.mass : 0.0f;
+    body.restitution = def.restitution;
+    body.friction = def.friction;
+    body.bullet = def.bullet;
+    body.alive = true;
+    body.userData = def.userData;
+    positions[id] = def.position;
+    previousPositions[id] = def.position;
+    velocities[id] = def.type == BodyType::Static ? Vector2() : def.velocity;
+    body.proxy = broadphase.insert(getBounds(id), static_cast<Uint32>(id));
+    bodyCount++;
+    return id;
+}
+
+void PhysicsWorld::destroyBody(int id) {
+    if (!isValid(id)) {
+        return;
+    }
+    broadphase.remove(bodies[id].proxy);
+    // A body created in this slot must not inherit the old contact impulses
+    warmImpulses.erase(std::remove_if(warmImpulses.begin(), warmImpulses.end(),
+        [id](const WarmImpulse& warm) {
+            return static_cast<int>(warm.key >> 32) == id || static_cast<int>(warm.key & 0xffffffffu) == id;
+        }), warmImpulses.end());
+    bodies[id].alive = false;
+    velocities[id] = Vector2();
+    freeBodies.push_back(id);
+    bodyCount--;
+}
+
+bool PhysicsWorld::isValid(int id) const {
+    return id >= 0 && id < static_cast<int>(bodies.size()) && bodies[id].alive;
+}
+
+void PhysicsWorld::setPosition(int id, const Vector2& position) {
+    positions[id] = position;
+    previousPositions[id] = position;
+    broadphase.move(bodies[id].proxy, getBounds(id));
+}
+
+Vector2 PhysicsWorld::halfSize(int id) const {
+    const Body& body = bodies[id];
+    return body.shape == BodyShape::Circle ? Vector2(body.radius, body.radius) : body.halfExtents;
+}
+
+Rect PhysicsWorld::getBounds(int id) const {
+    Vector2 half = halfSize(id);
+    return Rect(positions[id].x - half.x, positions[id].y - half.y, half.x * 2, half.y * 2);
+}
+
+void PhysicsWorld::forRange(size_t count, size_t grain, const std::function<void(size_t, size_t)>& body) {
+    if (workers) {
+        workers->parallelFor(count, grain, body);
+    } else if (count > 0) {
+        body(0, count);
+    }
+}
+
+void PhysicsWorld::step(float deltaTime) {
+    if (deltaTime <= 0.0f) {
+        return;
+    }
+
+    // Integrate
+    previousPositions = positions;
+    Vector2 gravityStep = settings.gravity * deltaTime;
+    for (size_t i = 0; i < bodies.size(); i++) {
+        if (bodies[i].alive && bodies[i].type == BodyType::Dynamic) {
+            velocities[i] += gravityStep;
+        }
+    }
+    integratePositions(positions.data(), velocities.data(), positions.size(), deltaTime);
+
+    // Continuous detection for bodies that could tunnel this step
+    sweepFastBodies(deltaTime);
+
+    // Broadphase: refresh every moving proxy, then collect overlapping pairs
+    for (size_t i = 0; i < bodies.size(); i++) {
+        if (bodies[i].alive && bodies[i].type != BodyType::Static) {
+            broadphase.move(bodies[i].proxy, getBounds(static_cast<int>(i)));
+        }
+    }
+    pairs.clear();
+    broadphase.queryPairs(pairs);
+
+    // Narrowphase and solver
+    findContacts();
+    solveVelocities();
+    solvePositions();
+}
+
+// Earliest time a body moving by motion from start touches other, which sits
+// at its position from the start of the step
+bool PhysicsWorld::sweep(int id, const Vector2& start, const Vector2& motion, int other, Sweep& hit) const {
+    const Body& body = bodies[id];
+    const Body& target = bodies[other];
+    const Vector2& targetStart = previousPositions[other];
+
+    if (body.shape == BodyShape::Aabb && target.shape == BodyShape::Aabb) {
+        Vector2 half = body.halfExtents + target.halfExtents;
+        return sweepPointBox(start, motion, targetStart, half, hit.time, hit.normal);
+    }
+    if (body.shape == BodyShape::Circle && target.shape == BodyShape::Circle) {
+        return sweepPointCircle(start, motion, targetStart, body.radius + target.radius, hit.time, hit.normal);
+    }
+    if (body.shape == BodyShape::Circle) {
+        return sweepPointRoundedBox(start, motion, targetStart, target.halfExtents, body.radius, hit.time, hit.normal);
+    }
+
+    // Box against circle: sweep the circle backwards against the box instead
+    if (!sweepPointRoundedBox(targetStart, motion * -1.0f, start, body.halfExtents, target.radius, hit.time, hit.normal)) {
+        return false;
+    }
+    hit.normal = hit.normal * -1.0f;
+    return true;
+}
+
+void PhysicsWorld::sweepFastBodies(float deltaTime) {
+    fastBodies.clear();
+    for (size_t i = 0; i < bodies.size(); i++) {
+        const Body& body = bodies[i];
+        if (!body.alive || body.type != BodyType::Dynamic) {
+            continue;
+        }
+        // Moving more than half its smallest extent could skip a thin wall
+        Vector2 half = halfSize(static_cast<int>(i));
+        float limit = 0.5f * std::min(half.x, half.y);
+        Vector2 motion = velocities[i] * deltaTime;
+        if (body.bullet || dot(motion, motion) > limit * limit) {
+            fastBodies.push_back(static_cast<int>(i));
+        }
+    }
+    if (fastBodies.empty()) {
+        return;
+    }
+
+    // Broadphase queries aren't thread safe, so gather the candidates here
+    // and run only the sweep math in parallel
+    sweepCandidates.resize(fastBodies.size());
+    for (size_t k = 0; k < fastBodies.size(); k++) {
+        int id = fastBodies[k];
+        Rect from = getBounds(id);
+        Vector2 half = halfSize(id);
+        Rect swept(std::min(from.x, previousPositions[id].x - half.x), std::min(from.y, previousPositions[id].y - half.y), 0, 0);
+        swept.w = std::max(from.x + from.w, previousPositions[id].x + half.x) - swept.x;
+        swept.h = std::max(from.y + from.h, previousPositions[id].y + half.y) - swept.y;
+        sweepCandidates[k].clear();
+        broadphase.queryRect(swept, sweepCandidates[k]);
+    }
+
+    sweepResults.assign(fastBodies.size(), Sweep{1.0f, Vector2()});
+    sweepHits.assign(fastBodies.size(), 0);
+    forRange(fastBodies.size(), 64, [&](size_t begin, size_t end) {
+        for (size_t k = begin; k < end; k++) {
+            int id = fastBodies[k];
+            const Body& body = bodies[id];
+            Vector2 start = previousPositions[id];
+            Vector2 ownMotion = positions[id] - start;
+            for (Uint32 candidate : sweepCandidates[k]) {
+                int other = static_cast<int>(candidate);
+                const Body& target = bodies[other];
+                // Bullets also stop at dynamic bodies, others only at walls
+                if (other == id || (target.type == BodyType::Dynamic && !body.bullet)) {
+                    continue;
+                }
+                Vector2 motion = ownMotion - (positions[other] - previousPositions[other]);
+                Sweep hit;
+                if (sweep(id, start, motion, other, hit) && hit.time < sweepResults[k].time) {
+                    sweepResults[k] = hit;
+                    sweepHits[k] = 1;
+                }
+            }
+        }
+    });
+
+    // Stop at the time of impact and bounce; the rest of the step is dropped
+    for (size_t k = 0; k < fastBodies.size(); k++) {
+        if (!sweepHits[k]) {
+            continue;
+        }
+        int id = fastBodies[k];
+        const Sweep& hit = sweepResults[k];
+        Vector2 start = previousPositions[id];
+        positions[id] = start + (positions[id] - start) * hit.time + hit.normal * settings.penetrationSlop;
+        float normalSpeed = dot(velocities[id], hit.normal);
+        if (normalSpeed < 0.0f) {
+            velocities[id] -= hit.normal * (normalSpeed * (1.0f + bodies[id].restitution));
+        }
+    }
+}
+
+// Contact between two bodies at their current positions, normal from a to b
+bool PhysicsWorld::collide(int a, int b, Contact& contact) const {
+    const Body& first = bodies[a];
+    const Body& second = bodies[b];
+    Vector2 delta = positions[b] - positions[a];
+    contact.a = a;
+    contact.b = b;
+
+    if (first.shape == BodyShape::Aabb && second.shape == BodyShape::Aabb) {
+        float overlapX = first.halfExtents.x + second.halfExtents.x - std::fabs(delta.x);
+        float overlapY = first.halfExtents.y + second.halfExtents.y - std::fabs(delta.y);
+        if (overlapX <= 0.0f || overlapY <= 0.0f) {
+            return false;
+        }
+        if (overlapX < overlapY) {
+            contact.normal = Vector2(delta.x < 0 ? -1.0f : 1.0f, 0.0f);
+            contact.penetration = overlapX;
+        } else {
+            contact.normal = Vector2(0.0f, delta.y < 0 ? -1.0f : 1.0f);
+            contact.penetration = overlapY;
+        }
+        return true;
+    }
+
+    if (first.shape == BodyShape::Circle && second.shape == BodyShape::Circle) {
+        float radii = first.radius + second.radius;
+        float distanceSquared = dot(delta, delta);
+        if (distanceSquared >= radii * radii) {
+            return false;
+        }
+        float distance = std::sqrt(distanceSquared);
+        contact.normal = distance > 0.0f ? delta * (1.0f / distance) : Vector2(0.0f, 1.0f);
+        contact.penetration = radii - distance;
+        return true;
+    }
+
+    // Box against circle, worked out with the box first and flipped if needed
+    bool flipped = first.shape == BodyShape::Circle;
+    const Body& box = flipped ? second : first;
+    const Body& circle = flipped ? first : second;
+    Vector2 offset = flipped ? delta * -1.0f : delta; // Box center to circle center
+    Vector2 closest(std::max(-box.halfExtents.x, std::min(offset.x, box.halfExtents.x)),
+                    std::max(-box.halfExtents.y, std::min(offset.y, box.halfExtents.y)));
+    Vector2 normal;
+    float penetration;
+    if (closest.x == offset.x && closest.y == offset.y) {
+        // Center inside the box: push out through the nearest face
+        float faceX = box.halfExtents.x - std::fabs(offset.x);
+        float faceY = box.halfExtents.y - std::fabs(offset.y);
+        if (faceX < faceY) {
+            normal = Vector2(offset.x < 0 ? -1.0f : 1.0f, 0.0f);
+            penetration = faceX + circle.radius;
+        } else {
+            normal = Vector2(0.0f, offset.y < 0 ? -1.0f : 1.0f);
+            penetration = faceY + circle.radius;
+        }
+    } else {
+        Vector2 toCircle = offset - closest;
+        float distanceSquared = dot(toCircle, toCircle);
+        if (distanceSquared >= circle.radius * circle.radius) {
+            return false;
+        }
+        float distance = std::sqrt(distanceSquared);
+        normal = toCircle * (1.0f / distance);
+        penetration = circle.radius - distance;
+    }
+    contact.normal = flipped ? normal * -1.0f : normal;
+    contact.penetration = penetration;
+    return true;
+}
+
+void PhysicsWorld::findContacts() {
+    // Chunks write to their own lists, joined in order so results don't
+    // depend on thread timing
+    const size_t grain = 256;
+    size_t chunkCount = (pairs.size() + grain - 1) / grain;
+    if (contactChunks.size() < chunkCount) {
+        contactChunks.resize(chunkCount);
+    }
+    forRange(pairs.size(), grain, [&](size_t begin, size_t end) {
+        std::vector<Contact>& out = contactChunks[begin / grain];
+        out.clear();
+        for (size_t i = begin; i < end; i++) {
+            int a = static_cast<int>(pairs[i].first);
+            int b = static_cast<int>(pairs[i].second);
+            if (bodies[a].inverseMass == 0.0f && bodies[b].inverseMass == 0.0f) {
+                continue;
+            }
+            Contact contact;
+            if (collide(a, b, contact)) {
+                out.push_back(contact);
+            }
+        }
+    });
+
+    contacts.clear();
+    for (size_t chunk = 0; chunk < chunkCount; chunk++) {
+        contacts.insert(contacts.end(), contactChunks[chunk].begin(), contactChunks[chunk].end());
+    }
+}
+
+// Sequential impulses. Each contact accumulates its impulse over the
+// iterations and only the total is clamped, so a later iteration can take
+// back part of an earlier push. Contacts that persist start from last step's
+// impulses (warm starting), which is what lets stacks come to rest.
+void PhysicsWorld::solveVelocities() {
+    impulses.assign(contacts.size(), ContactImpulse{0.0f, 0.0f, 0.0f});
+    for (size_t i = 0; i < contacts.size(); i++) {
+        const Contact& contact = contacts[i];
+        const Body& a = bodies[contact.a];
+        const Body& b = bodies[contact.b];
+        float restitution = std::max(a.restitution, b.restitution);
+        float normalSpeed = dot(velocities[contact.b] - velocities[contact.a], contact.normal);
+        // Slow contacts don't bounce, otherwise resting bodies would jitter
+        if (normalSpeed < -1.0f) {
+            impulses[i].bounce = -restitution * normalSpeed;
+        }
+
+        Uint64 key = pairKey(contact.a, contact.b);
+        auto previous = std::lower_bound(warmImpulses.begin(), warmImpulses.end(), key,
+            [](const WarmImpulse& warm, Uint64 value) { return warm.key < value; });
+        if (previous == warmImpulses.end() || previous->key != key || dot(previous->normal, contact.normal) < 0.99f) {
+            continue;
+        }
+        impulses[i].normal = previous->normalImpulse;
+        impulses[i].tangent = previous->tangentImpulse;
+        Vector2 tangent(-contact.normal.y, contact.normal.x);
+        Vector2 impulse = contact.normal * impulses[i].normal + tangent * impulses[i].tangent;
+        velocities[contact.a] -= impulse * a.inverseMass;
+        velocities[contact.b] += impulse * b.inverseMass;
+    }
+
+    for (int iteration = 0; iteration < settings.velocityIterations; iteration++) {
+        for (size_t i = 0; i < contacts.size(); i++) {
+            const Contact& contact = contacts[i];
+            ContactImpulse& accumulated = impulses[i];
+            const Body& a = bodies[contact.a];
+            const Body& b = bodies[contact.b];
+            float inverseMassSum = a.inverseMass + b.inverseMass;
+
+            Vector2 relative = velocities[contact.b] - velocities[contact.a];
+            float normalSpeed = dot(relative, contact.normal);
+            float impulse = (accumulated.bounce - normalSpeed) / inverseMassSum;
+            float total = std::max(accumulated.normal + impulse, 0.0f);
+            impulse = total - accumulated.normal;
+            accumulated.normal = total;
+            velocities[contact.a] -= contact.normal * (impulse * a.inverseMass);
+            velocities[contact.b] += contact.normal * (impulse * b.inverseMass);
+
+            // Coulomb friction along the surface, bounded by the normal impulse
+            relative = velocities[contact.b] - velocities[contact.a];
+            Vector2 tangent(-contact.normal.y, contact.normal.x);
+            float friction = std::sqrt(a.friction * b.friction);
+            float tangentImpulse = -dot(relative, tangent) / inverseMassSum;
+            float limit = accumulated.normal * friction;
+            float tangentTotal = std::max(-limit, std::min(accumulated.tangent + tangentImpulse, limit));
+            tangentImpulse = tangentTotal - accumulated.tangent;
+            accumulated.tangent = tangentTotal;
+            velocities[contact.a] -= tangent * (tangentImpulse * a.inverseMass);
+            velocities[contact.b] += tangent * (tangentImpulse * b.inverseMass);
+        }
+    }
+
+    warmImpulses.clear();
+    for (size_t i = 0; i < contacts.size(); i++) {
+        const Contact& contact = contacts[i];
+        warmImpulses.push_back({pairKey(contact.a, contact.b), contact.normal, impulses[i].normal, impulses[i].tangent});
+    }
+    std::sort(warmImpulses.begin(), warmImpulses.end(),
+        [](const WarmImpulse& first, const WarmImpulse& second) { return first.key < second.key; });
+}
+
+// Push overlapping bodies apart, measuring the overlap again every iteration
+void PhysicsWorld::solvePositions() {
+    for (int iteration = 0; iteration < settings.positionIterations; iteration++) {
+        for (const Contact& original : contacts) {
+            Contact contact;
+            if (!collide(original.a, original.b, contact)) {
+                continue;
+            }
+            float correction = std::max(contact.penetration - settings.penetrationSlop, 0.0f) * settings.positionCorrection;
+            if (correction <= 0.0f) {
+                continue;
+            }
+            const Body& a = bodies[contact.a];
+            const Body& b = bodies[contact.b];
+            Vector2 push = contact.normal * (correction / (a.inverseMass + b.inverseMass));
+            positions[contact.a] -= push * a.inverseMass;
+            positions[contact.b] += push * b.inverseMass;
+        }
+    }
+
+    for (const Contact& contact : contacts) {
+        broadphase.move(bodies[contact.a].proxy, getBounds(contact.a));
+        broadphase.move(bodies[contact.b].proxy, getBounds(contact.b));
+    }
+}
+
+} // namespace ContextEngine
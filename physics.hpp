@@ -0,0 +1,162 @@
+#pragma once
+
+#include "context-types.hpp"
+#include "spatial-hash.hpp"
+
+#include <functional>
+#include <vector>
+
+namespace ContextEngine {
+
+class WorkerPool;
+
+enum class BodyType {
+    Static,    // Never moves
+    Kinematic, // Moved by its velocity or setPosition, pushes dynamic bodies
+    Dynamic    // Moved by gravity, velocity and contacts
+};
+
+enum class BodyShape {
+    Aabb,
+    Circle
+};
+
+// Everything needed to create a body. Positions are centers.
+struct BodyDef {
+    BodyType type = BodyType::Dynamic;
+    BodyShape shape = BodyShape::Aabb;
+    Vector2 position;
+    Vector2 velocity;
+    Vector2 halfExtents = Vector2(0.5f, 0.5f); // Aabb only
+    float radius = 0.5f;                       // Circle only
+    float mass = 1.0f;                         // Dynamic only
+    float restitution = 0.0f;                  // 0 stops dead, 1 bounces fully
+    float friction = 0.2f;
+    bool bullet = false;                       // Always use continuous detection
+    Uint32 userData = 0;
+};
+
+// A touching pair from the last step; normal points from a to b
+struct Contact {
+    int a;
+    int b;
+    Vector2 normal;
+    float penetration;
+};
+
+struct PhysicsSettings {
+    Vector2 gravity = Vector2(0.0f, 0.0f);
+    int velocityIterations = 8;
+    int positionIterations = 3;
+    float penetrationSlop = 0.01f;    // Overlap left alone to avoid jitter
+    float positionCorrection = 0.8f;  // Share of the overlap removed per iteration
+    float broadphaseCellSize = 64.0f;
+};
+
+// Rigid AABB and circle bodies without rotation. step() runs:
+// integrate, continuous sweeps for fast bodies, broadphase pairs from a
+// SpatialHash, narrowphase contacts, then the iterative solver.
+// Call step from Scene::fixedUpdate so it always sees the same time step.
+class PhysicsWorld {
+public:
+    explicit PhysicsWorld(const PhysicsSettings& settings = PhysicsSettings());
+
+    // Prevent copying
+    PhysicsWorld(const PhysicsWorld&) = delete;
+    PhysicsWorld& operator=(const PhysicsWorld&) = delete;
+
+    int createBody(const BodyDef& def);
+    void destroyBody(int body);
+    bool isValid(int body) const;
+    size_t getBodyCount() const { return bodyCount; }
+
+    PhysicsSettings& getSettings() { return settings; }
+
+    // Optional; the sweep and narrowphase stages are split across the pool
+    void setWorkerPool(WorkerPool* pool) { workers = pool; }
+
+    void step(float deltaTime);
+
+    Vector2 getPosition(int body) const { return positions[body]; }
+    void setPosition(int body, const Vector2& position); // Teleports without sweeping
+    Vector2 getVelocity(int body) const { return velocities[body]; }
+    void setVelocity(int body, const Vector2& velocity) { velocities[body] = velocity; }
+    Rect getBounds(int body) const;
+    Uint32 getUserData(int body) const { return bodies[body].userData; }
+    BodyType getType(int body) const { return bodies[body].type; }
+
+    const std::vector<Contact>& getContacts() const { return contacts; }
+
+    // Bodies whose bounds overlap an area, e.g. for picking
+    void queryRect(const Rect& area, std::vector<Uint32>& bodyIds) const { broadphase.queryRect(area, bodyIds); }
+
+private:
+    struct Body {
+        BodyType type;
+        BodyShape shape;
+        Vector2 halfExtents;
+        float radius;
+        float inverseMass;
+        float restitution;
+        float friction;
+        bool bullet;
+        bool alive;
+        Uint32 userData;
+        int proxy;
+    };
+
+    // Solver state per contact
+    struct ContactImpulse {
+        float normal;
+        float tangent;
+        float bounce; // Separating speed restitution asks for
+    };
+
+    // Impulses a contact ended the last step with, keyed by body pair
+    struct WarmImpulse {
+        Uint64 key;
+        Vector2 normal;
+        float normalImpulse;
+        float tangentImpulse;
+    };
+
+    // A sweep hit: fraction of this step's motion and the surface normal
+    struct Sweep {
+        float time;
+        Vector2 normal;
+    };
+
+    Vector2 halfSize(int body) const;
+    bool collide(int a, int b, Contact& contact) const;
+    bool sweep(int body, const Vector2& start, const Vector2& motion, int other, Sweep& hit) const;
+    void sweepFastBodies(float deltaTime);
+    void findContacts();
+    void solveVelocities();
+    void solvePositions();
+    void forRange(size_t count, size_t grain, const std::function<void(size_t, size_t)>& body);
+
+    PhysicsSettings settings;
+    WorkerPool* workers;
+
+    // Positions and velocities are dense arrays so integration runs through
+    // the SIMD batch kernels; dead slots hold zero velocity
+    std::vector<Vector2> positions;
+    std::vector<Vector2> velocities;
+    std::vector<Vector2> previousPositions;
+    std::vector<Body> bodies;
+    std::vector<int> freeBodies;
+    size_t bodyCount;
+
+    SpatialHash broadphase;
+    std::vector<std::pair<Uint32, Uint32>> pairs;
+    std::vector<std::vector<Contact>> contactChunks;
+    std::vector<Contact> contacts;
+    std::vector<ContactImpulse> impulses;
+    std::vector<WarmImpulse> warmImpulses; // Sorted by key
+    std::vector<int> fastBodies;
+    std::vector<std::vector<Uint32>> sweepCandidates;
+    std::vector<Sweep> sweepResults;
+    std::vector<Uint8> sweepHits;
+};
+
+} // namespace ContextEngine
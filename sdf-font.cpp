@@ -0,0 +1,615 @@
+#include "sdf-font.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+namespace ContextEngine {
+
+static bool isBlank(Uint32 codepoint) {
+    return codepoint == ' ' || codepoint == '\t' || codepoint == '\n' || codepoint == '\r';
+}
+
+SdfFont::SdfFont(SDL_Renderer* renderer, const std::string& path)
+    : renderer(renderer)
+    , path(path)
+    , font(nullptr)
+    , baseHeight(0)
+    , baseLineSkip(0)
+    , kerningEnabled(false)
+    , fieldPacker(FIELD_PAGE_SIZE)
+    , current(nullptr)
+    , useCounter(0)
+    , bucketCounter(0)
+    , rasterizeCount(0)
+    , thresholdCount(0)
+    , workers(nullptr)
+    , pendingCount(0)
+{
+    font = TTF_OpenFont(path.c_str(), BASE_SIZE);
+    if (!font) {
+        SDL_Log("Failed to load SDF font %s! SDL_ttf Error: %s\n", path.c_str(), TTF_GetError());
+        return;
+    }
+
+    baseHeight = static_cast<float>(TTF_FontHeight(font));
+    baseLineSkip = static_cast<float>(TTF_FontLineSkip(font));
+    kerningEnabled = TTF_GetFontKerning(font) != 0;
+}
+
+SdfFont::~SdfFont() {
+    // Jobs still running write into this font, wait for them
+    retireFontSource(std::move(asyncSource), retiredSources);
+    releaseFontSources(retiredSources, true);
+
+    for (auto& bucket : buckets) {
+        destroyBucket(*bucket);
+    }
+    buckets.clear();
+
+    if (font) {
+        TTF_CloseFont(font);
+    }
+}
+
+float SdfFont::getLineHeight(float height) const {
+    return baseHeight > 0 ? baseLineSkip * height / baseHeight : 0.0f;
+}
+
+Vector2 SdfFont::measureText(const std::string& text, float height) {
+    if (!font || text.empty()) {
+        return Vector2(0, 0);
+    }
+
+    float scale = height / baseHeight;
+    float width = 0;
+    float lineWidth = 0;
+    int lineCount = 1;
+    Uint32 previous = 0;
+    size_t offset = 0;
+    while (offset < text.size()) {
+        Uint32 codepoint = decodeUtf8(text, offset);
+        if (codepoint == '\n') {
+            width = std::max(width, lineWidth);
+            lineWidth = 0;
+            lineCount++;
+            previous = 0;
+            continue;
+        }
+        if (previous) {
+            lineWidth += getKerning(previous, codepoint);
+        }
+        lineWidth += field(codepoint).advance;
+        previous = codepoint;
+    }
+    width = std::max(width, lineWidth);
+
+    return Vector2(width * scale, lineCount * baseLineSkip * scale);
+}
+
+float SdfFont::getKerning(Uint32 left, Uint32 right) {
+    if (!kerningEnabled) {
+        return 0.0f;
+    }
+
+    Uint64 key = (static_cast<Uint64>(left) << 32) | right;
+    auto it = kerningPairs.find(key);
+    if (it != kerningPairs.end()) {
+        return it->second;
+    }
+
+    float kerning = static_cast<float>(TTF_GetFontKerningSizeGlyphs32(font, left, right));
+    kerningPairs.emplace(key, kerning);
+    return kerning;
+}
+
+bool SdfFont::enableAsync(WorkerPool* pool) {
+    disableAsync();
+
+    // Without worker threads there is nothing to gain
+    if (!font || !pool || pool->getThreadCount() == 0) {
+        return false;
+    }
+
+    std::unique_ptr<AsyncFontSource> source(new AsyncFontSource(path, BASE_SIZE));
+    if (!source->font) {
+        return false;
+    }
+    workers = pool;
+    asyncSource = std::move(source);
+    return true;
+}
+
+void SdfFont::disableAsync() {
+    if (!asyncSource) {
+        return;
+    }
+    retireFontSource(std::move(asyncSource), retiredSources);
+    workers = nullptr;
+
+    // Whatever was still pending gets built synchronously on next use
+    for (auto& [codepoint, glyph] : glyphs) {
+        if (glyph.pending) {
+            glyph = SdfGlyph();
+        }
+    }
+    for (auto& bucket : buckets) {
+        for (auto& [codepoint, coverage] : bucket->glyphs) {
+            if (coverage.pending) {
+                coverage = SdfCoverageGlyph();
+            }
+        }
+        bucket->pending = 0;
+    }
+    pendingCount = 0;
+}
+
+SdfGlyph& SdfFont::field(Uint32 codepoint) {
+    SdfGlyph& glyph = glyphs[codepoint];
+    if (glyph.loaded || !font) {
+        return glyph;
+    }
+    glyph.loaded = true;
+
+    int minx, maxx, miny, maxy, advance;
+    if (TTF_GlyphMetrics32(font, codepoint, &minx, &maxx, &miny, &maxy, &advance) == 0) {
+        glyph.advance = static_cast<float>(advance);
+    }
+
+    // Whitespace has nothing to draw
+    if (isBlank(codepoint)) {
+        return glyph;
+    }
+
+    if (asyncSource) {
+        glyph.pending = true;
+        pendingCount++;
+
+        std::shared_ptr<AsyncFontSource> source = asyncSource->acquire();
+        CompletionQueue<SdfFieldBitmap>* queue = &finished;
+        workers->submit([source, queue, codepoint] {
+            if (source->cancelled) {
+                return;
+            }
+
+            SdfFieldBitmap bitmap;
+            std::unique_lock<std::mutex> lock(source->fontMutex);
+            bool built = buildField(source->font, codepoint, bitmap);
+            lock.unlock();
+            if (!built) {
+                bitmap = SdfFieldBitmap();
+                bitmap.codepoint = codepoint;
+            }
+            queue->push(std::move(bitmap));
+        });
+        return glyph;
+    }
+
+    SdfFieldBitmap bitmap;
+    if (buildField(font, codepoint, bitmap)) {
+        storeField(bitmap, glyph);
+    }
+    return glyph;
+}
+
+size_t SdfFont::processUploads(size_t budgetBytes) {
+    releaseFontSources(retiredSources, false);
+
+    size_t uploaded = 0;
+    SdfFieldBitmap bitmap;
+    while ((uploaded == 0 || uploaded < budgetBytes) && finished.pop(bitmap)) {
+        auto it = glyphs.find(bitmap.codepoint);
+        if (it == glyphs.end() || !it->second.pending) {
+            continue;
+        }
+        it->second.pending = false;
+        pendingCount--;
+
+        storeField(bitmap, it->second);
+        uploaded += bitmap.values.size();
+    }
+
+    SdfCoverageBitmap coverageBitmap;
+    while ((uploaded == 0 || uploaded < budgetBytes) && finishedCoverage.pop(coverageBitmap)) {
+        // The bucket may have been evicted since
+        auto bucket = std::find_if(buckets.begin(), buckets.end(),
+            [&](const std::unique_ptr<Bucket>& candidate) { return candidate->id == coverageBitmap.bucket; });
+        if (bucket == buckets.end()) {
+            continue;
+        }
+        auto it = (*bucket)->glyphs.find(coverageBitmap.codepoint);
+        if (it == (*bucket)->glyphs.end() || !it->second.pending) {
+            continue;
+        }
+        it->second.pending = false;
+        it->second.resolved = true;
+        (*bucket)->pending--;
+        pendingCount--;
+
+        storeCoverage(**bucket, it->second, coverageBitmap.width, coverageBitmap.height, coverageBitmap.pixels.data());
+        uploaded += coverageBitmap.pixels.size() * sizeof(Uint32);
+    }
+    return uploaded;
+}
+
+bool SdfFont::buildField(TTF_Font* font, Uint32 codepoint, SdfFieldBitmap& bitmap) {
+    bitmap.codepoint = codepoint;
+
+    SDL_Surface* surface = TTF_RenderGlyph32_Blended(font, codepoint, SDL_Color{255, 255, 255, 255});
+    if (!surface) {
+        SDL_Log("Failed to rasterize glyph U+%04X! SDL_ttf Error: %s\n", codepoint, TTF_GetError());
+        return false;
+    }
+    SDL_Surface* converted = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_ARGB8888, 0);
+    SDL_FreeSurface(surface);
+    if (!converted) {
+        SDL_Log("Failed to convert glyph surface! SDL Error: %s\n", SDL_GetError());
+        return false;
+    }
+
+    const int width = converted->w;
+    const int height = converted->h;
+    bitmap.width = width + 2 * SPREAD;
+    bitmap.height = height + 2 * SPREAD;
+    bitmap.values.assign(static_cast<size_t>(bitmap.width) * bitmap.height, 0);
+
+    // Inside test on the glyph coverage, in field coordinates
+    auto inside = [&](int x, int y) {
+        x -= SPREAD;
+        y -= SPREAD;
+        if (x < 0 || y < 0 || x >= width || y >= height) {
+            return false;
+        }
+        const Uint32* row = reinterpret_cast<const Uint32*>(static_cast<const Uint8*>(converted->pixels) + y * converted->pitch);
+        return (row[x] >> 24) >= 128;
+    };
+
+    // Brute force search for the nearest pixel on the other side of the edge,
+    // bounded by the spread; this runs once per glyph
+    const int radius = SPREAD + 1;
+    for (int y = 0; y < bitmap.height; y++) {
+        for (int x = 0; x < bitmap.width; x++) {
+            bool in = inside(x, y);
+            int best = radius * radius;
+            for (int dy = -radius; dy <= radius; dy++) {
+                for (int dx = -radius; dx <= radius; dx++) {
+                    int distance = dx * dx + dy * dy;
+                    if (distance < best && inside(x + dx, y + dy) != in) {
+                        best = distance;
+                    }
+                }
+            }
+
+            float distance = std::sqrt(static_cast<float>(best)) - 0.5f;
+            float signedDistance = in ? distance : -distance;
+            float value = 128.0f + signedDistance * 127.0f / SPREAD;
+            bitmap.values[static_cast<size_t>(y) * bitmap.width + x] =
+                static_cast<Uint8>(std::max(0.0f, std::min(255.0f, value)));
+        }
+    }
+    SDL_FreeSurface(converted);
+    return true;
+}
+
+void SdfFont::storeField(const SdfFieldBitmap& bitmap, SdfGlyph& glyph) {
+    if (bitmap.width <= 0 || bitmap.height <= 0) {
+        return;
+    }
+    rasterizeCount++;
+
+    int page;
+    SDL_Rect rect;
+    if (!fieldPacker.pack(bitmap.width, bitmap.height, page, rect)) {
+        SDL_Log("Glyph field of %dx%d does not fit in a %d field page!", bitmap.width, bitmap.height, FIELD_PAGE_SIZE);
+        return;
+    }
+    if (page >= static_cast<int>(fieldPages.size())) {
+        fieldPages.emplace_back(FIELD_PAGE_SIZE * FIELD_PAGE_SIZE, 0);
+    }
+
+    std::vector<Uint8>& pixels = fieldPages[page];
+    for (int y = 0; y < bitmap.height; y++) {
+        std::copy(bitmap.values.begin() + static_cast<size_t>(y) * bitmap.width,
+                  bitmap.values.begin() + static_cast<size_t>(y + 1) * bitmap.width,
+                  pixels.begin() + (rect.y + y) * FIELD_PAGE_SIZE + rect.x);
+    }
+
+    glyph.page = page;
+    glyph.src = rect;
+}
+
+// Bilinear sample of a field region, clamped to its edges
+static float sampleField(const Uint8* field, int stride, int width, int height, float x, float y) {
+    x = std::max(0.0f, std::min(x, static_cast<float>(width - 1)));
+    y = std::max(0.0f, std::min(y, static_cast<float>(height - 1)));
+    int x0 = static_cast<int>(x);
+    int y0 = static_cast<int>(y);
+    int x1 = std::min(x0 + 1, width - 1);
+    int y1 = std::min(y0 + 1, height - 1);
+    float fx = x - x0;
+    float fy = y - y0;
+
+    auto at = [&](int px, int py) {
+        return static_cast<float>(field[py * stride + px]);
+    };
+    float top = at(x0, y0) + (at(x1, y0) - at(x0, y0)) * fx;
+    float bottom = at(x0, y1) + (at(x1, y1) - at(x0, y1)) * fx;
+    return top + (bottom - top) * fy;
+}
+
+// The same threshold a distance field shader applies, with the edge one
+// output pixel wide at this scale
+static void thresholdField(const Uint8* field, int stride, int fieldWidth, int fieldHeight,
+                           float scale, int width, int height, Uint32* out) {
+    const float distanceScale = SdfFont::SPREAD / 127.0f * scale;
+    for (int y = 0; y < height; y++) {
+        float fieldY = (y + 0.5f) / scale - 0.5f;
+        for (int x = 0; x < width; x++) {
+            float fieldX = (x + 0.5f) / scale - 0.5f;
+            float distance = (sampleField(field, stride, fieldWidth, fieldHeight, fieldX, fieldY) - 128.0f) * distanceScale;
+            float alpha = std::max(0.0f, std::min(1.0f, distance + 0.5f));
+            out[y * width + x] = (static_cast<Uint32>(alpha * 255.0f + 0.5f) << 24) | 0x00FFFFFF;
+        }
+    }
+}
+
+SdfFont::Bucket& SdfFont::selectBucket(float screenScale) {
+    // Round up to the next quarter octave so coverage is only ever scaled down
+    int step = static_cast<int>(std::ceil(std::log2(std::max(screenScale, 0.125f)) * 4.0f));
+    step = std::min(step, 8);
+
+    for (auto& bucket : buckets) {
+        if (bucket->step == step) {
+            bucket->lastUsed = ++useCounter;
+            current = bucket.get();
+            return *bucket;
+        }
+    }
+
+    // Evict the least recently used bucket
+    if (static_cast<int>(buckets.size()) >= MAX_BUCKETS) {
+        auto oldest = std::min_element(buckets.begin(), buckets.end(),
+            [](const std::unique_ptr<Bucket>& a, const std::unique_ptr<Bucket>& b) {
+                return a->lastUsed < b->lastUsed;
+            });
+        destroyBucket(**oldest);
+        buckets.erase(oldest);
+    }
+
+    buckets.push_back(std::unique_ptr<Bucket>(new Bucket{
+        step, std::pow(2.0f, step / 4.0f), ++bucketCounter, ++useCounter, 0, {}, {}, ShelfPacker(COVERAGE_PAGE_SIZE)
+    }));
+    current = buckets.back().get();
+    return *current;
+}
+
+void SdfFont::destroyBucket(Bucket& bucket) {
+    for (SDL_Texture* page : bucket.pages) {
+        SDL_DestroyTexture(page);
+    }
+    bucket.pages.clear();
+    bucket.glyphs.clear();
+    pendingCount -= bucket.pending;
+    bucket.pending = 0;
+    if (current == &bucket) {
+        current = nullptr;
+    }
+}
+
+const SdfCoverageGlyph& SdfFont::resolve(Bucket& bucket, Uint32 codepoint) {
+    SdfCoverageGlyph& coverage = bucket.glyphs[codepoint];
+    if (coverage.resolved || coverage.pending) {
+        return coverage;
+    }
+
+    // Left out until its field has been built
+    const SdfGlyph& glyph = field(codepoint);
+    if (glyph.pending) {
+        return coverage;
+    }
+    if (glyph.page < 0) {
+        coverage.resolved = true;
+        return coverage;
+    }
+
+    int width = std::max(1, static_cast<int>(std::ceil(glyph.src.w * bucket.scale)));
+    int height = std::max(1, static_cast<int>(std::ceil(glyph.src.h * bucket.scale)));
+    thresholdCount++;
+
+    if (asyncSource) {
+        coverage.pending = true;
+        bucket.pending++;
+        pendingCount++;
+
+        // The job gets its own copy of the field; the pages keep growing
+        std::vector<Uint8> values(static_cast<size_t>(glyph.src.w) * glyph.src.h);
+        const std::vector<Uint8>& pixels = fieldPages[glyph.page];
+        for (int y = 0; y < glyph.src.h; y++) {
+            std::copy(pixels.begin() + (glyph.src.y + y) * FIELD_PAGE_SIZE + glyph.src.x,
+                      pixels.begin() + (glyph.src.y + y) * FIELD_PAGE_SIZE + glyph.src.x + glyph.src.w,
+                      values.begin() + static_cast<size_t>(y) * glyph.src.w);
+        }
+
+        std::shared_ptr<AsyncFontSource> source = asyncSource->acquire();
+        CompletionQueue<SdfCoverageBitmap>* queue = &finishedCoverage;
+        Uint32 id = bucket.id;
+        float scale = bucket.scale;
+        int fieldWidth = glyph.src.w;
+        int fieldHeight = glyph.src.h;
+        workers->submit([source, queue, id, codepoint, scale, width, height, fieldWidth, fieldHeight,
+                         values = std::move(values)] {
+            if (source->cancelled) {
+                return;
+            }
+
+            SdfCoverageBitmap bitmap;
+            bitmap.bucket = id;
+            bitmap.codepoint = codepoint;
+            bitmap.width = width;
+            bitmap.height = height;
+            bitmap.pixels.resize(static_cast<size_t>(width) * height);
+            thresholdField(values.data(), fieldWidth, fieldWidth, fieldHeight, scale, width, height, bitmap.pixels.data());
+            queue->push(std::move(bitmap));
+        });
+        return coverage;
+    }
+
+    coverage.resolved = true;
+    coverageScratch.resize(static_cast<size_t>(width) * height);
+    const Uint8* values = fieldPages[glyph.page].data() + glyph.src.y * FIELD_PAGE_SIZE + glyph.src.x;
+    thresholdField(values, FIELD_PAGE_SIZE, glyph.src.w, glyph.src.h, bucket.scale, width, height, coverageScratch.data());
+    storeCoverage(bucket, coverage, width, height, coverageScratch.data());
+    return coverage;
+}
+
+void SdfFont::storeCoverage(Bucket& bucket, SdfCoverageGlyph& coverage, int width, int height, const Uint32* pixels) {
+    int page;
+    SDL_Rect rect;
+    if (!bucket.packer.pack(width, height, page, rect)) {
+        SDL_Log("Glyph of %dx%d does not fit in a %d coverage page!", width, height, COVERAGE_PAGE_SIZE);
+        return;
+    }
+    if (page >= static_cast<int>(bucket.pages.size())) {
+        SDL_Texture* texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888,
+                                                 SDL_TEXTUREACCESS_STATIC, COVERAGE_PAGE_SIZE, COVERAGE_PAGE_SIZE);
+        if (!texture) {
+            SDL_Log("Failed to create SDF coverage page! SDL Error: %s\n", SDL_GetError());
+            // Open the page again next time instead of packing into one that does not exist
+            bucket.packer.skipPages(static_cast<int>(bucket.pages.size()));
+            return;
+        }
+        SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+        SDL_SetTextureScaleMode(texture, SDL_ScaleModeLinear);
+        bucket.pages.push_back(texture);
+    }
+
+    // Pages start out undefined instead of cleared, so each glyph is uploaded
+    // with a transparent border over the packer's padding; linear filtering
+    // never reaches further than that
+    const int pageSize = COVERAGE_PAGE_SIZE;
+    SDL_Rect border;
+    border.x = std::max(0, rect.x - 1);
+    border.y = std::max(0, rect.y - 1);
+    border.w = std::min(pageSize, rect.x + width + 1) - border.x;
+    border.h = std::min(pageSize, rect.y + height + 1) - border.y;
+    uploadScratch.assign(static_cast<size_t>(border.w) * border.h, 0x00FFFFFF);
+    for (int y = 0; y < height; y++) {
+        std::copy(pixels + static_cast<size_t>(y) * width, pixels + static_cast<size_t>(y + 1) * width,
+                  uploadScratch.begin() + (rect.y - border.y + y) * border.w + (rect.x - border.x));
+    }
+    SDL_UpdateTexture(bucket.pages[page], &border, uploadScratch.data(), border.w * sizeof(Uint32));
+
+    coverage.page = page;
+    coverage.src = rect;
+}
+
+bool SdfFont::hasCoverage(const Bucket& bucket, const std::string& text) const {
+    size_t offset = 0;
+    while (offset < text.size()) {
+        Uint32 codepoint = decodeUtf8(text, offset);
+        auto it = bucket.glyphs.find(codepoint);
+        if (it != bucket.glyphs.end() ? !it->second.resolved : !isBlank(codepoint)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+SdfFont::Bucket* SdfFont::findFallback(const Bucket& target, const std::string& text) {
+    // The nearest size that has every glyph, larger ones first since they
+    // only get scaled down
+    Bucket* best = nullptr;
+    int bestDistance = 0;
+    for (auto& bucket : buckets) {
+        if (bucket.get() == &target || !hasCoverage(*bucket, text)) {
+            continue;
+        }
+        int distance = std::abs(bucket->step - target.step) * 2 + (bucket->step < target.step ? 1 : 0);
+        if (!best || distance < bestDistance) {
+            best = bucket.get();
+            bestDistance = distance;
+        }
+    }
+    return best;
+}
+
+int SdfFont::prepare(const std::string& text, float screenScale) {
+    if (!font) {
+        return 0;
+    }
+
+    Bucket& bucket = selectBucket(screenScale);
+    bool complete = true;
+    size_t offset = 0;
+    while (offset < text.size()) {
+        if (!resolve(bucket, decodeUtf8(text, offset)).resolved) {
+            complete = false;
+        }
+    }
+
+    // Draw from another size until the workers have finished this one
+    if (!complete) {
+        Bucket* fallback = findFallback(bucket, text);
+        if (fallback) {
+            fallback->lastUsed = ++useCounter;
+            current = fallback;
+        }
+    }
+    return static_cast<int>(current->pages.size());
+}
+
+SDL_Texture* SdfFont::getPageTexture(int page) const {
+    if (!current || page < 0 || page >= static_cast<int>(current->pages.size())) {
+        return nullptr;
+    }
+    return current->pages[page];
+}
+
+void SdfFont::appendQuads(const std::string& text, float x, float y, float screenScale,
+                          SDL_Color color, int page, std::vector<SDL_Vertex>& vertices) {
+    if (!current) {
+        return;
+    }
+
+    const float invPage = 1.0f / COVERAGE_PAGE_SIZE;
+    float penX = 0;
+    float lineY = 0;
+    Uint32 previous = 0;
+    size_t offset = 0;
+    while (offset < text.size()) {
+        Uint32 codepoint = decodeUtf8(text, offset);
+        if (codepoint == '\n') {
+            penX = 0;
+            lineY += baseLineSkip;
+            previous = 0;
+            continue;
+        }
+        if (previous) {
+            penX += getKerning(previous, codepoint);
+        }
+
+        const SdfGlyph& glyph = field(codepoint);
+        const SdfCoverageGlyph& coverage = resolve(*current, codepoint);
+        if (coverage.page == page) {
+            // Field regions are padded by the spread on every side
+            float x0 = x + (penX - SPREAD) * screenScale;
+            float y0 = y + (lineY - SPREAD) * screenScale;
+            float x1 = x0 + glyph.src.w * screenScale;
+            float y1 = y0 + glyph.src.h * screenScale;
+            float u0 = coverage.src.x * invPage;
+            float v0 = coverage.src.y * invPage;
+            float u1 = (coverage.src.x + coverage.src.w) * invPage;
+            float v1 = (coverage.src.y + coverage.src.h) * invPage;
+
+            vertices.push_back({SDL_FPoint{x0, y0}, color, SDL_FPoint{u0, v0}});
+            vertices.push_back({SDL_FPoint{x1, y0}, color, SDL_FPoint{u1, v0}});
+            vertices.push_back({SDL_FPoint{x0, y1}, color, SDL_FPoint{u0, v1}});
+            vertices.push_back({SDL_FPoint{x1, y1}, color, SDL_FPoint{u1, v1}});
+        }
+
+        penX += glyph.advance;
+        previous = codepoint;
+    }
+}
+
+} // namespace ContextEngine
@@ -0,0 +1,161 @@
+#pragma once
+
+#include "context-types.hpp"
+#include "text-layout.hpp"
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+
+namespace ContextEngine {
+
+// Distance field of one glyph inside the field atlas
+struct SdfGlyph {
+    float advance = 0.0f;        // In base pixels
+    int page = -1;               // Field atlas page, -1 for blank glyphs
+    SDL_Rect src = {0, 0, 0, 0}; // Field region, padded by SPREAD on every side
+    bool loaded = false;
+    bool pending = false;        // Field is still being built by a worker
+};
+
+// A distance field built in CPU memory, ready to be packed
+struct SdfFieldBitmap {
+    Uint32 codepoint = 0;
+    int width = 0;
+    int height = 0;
+    std::vector<Uint8> values; // 128 on the edge, SPREAD pixels per 127 steps
+};
+
+// Coverage bitmap resolved from a distance field for one size bucket
+struct SdfCoverageGlyph {
+    int page = -1;
+    SDL_Rect src = {0, 0, 0, 0};
+    bool resolved = false;
+    bool pending = false;        // Being thresholded by a worker
+};
+
+// Coverage thresholded by a worker, ready to be packed into a bucket
+struct SdfCoverageBitmap {
+    Uint32 bucket = 0;           // Id of the bucket it was made for
+    Uint32 codepoint = 0;
+    int width = 0;
+    int height = 0;
+    std::vector<Uint32> pixels;
+};
+
+// Signed distance field font. Each glyph is rasterized once at BASE_SIZE and
+// turned into a distance field; every text size and camera zoom is then drawn
+// from that one field atlas, with no font reopened at another size.
+//
+// SDL_Renderer has no programmable fragment stage, so the edge threshold a
+// shader would apply per pixel runs on the CPU instead: once per glyph and
+// quarter-octave size bucket, into a small coverage atlas that is scaled the
+// rest of the way with linear filtering. With async text the threshold runs
+// on the workers, and text whose glyphs are not ready in the new bucket keeps
+// drawing from the nearest bucket that has them, so zooming never waits.
+class SdfFont {
+public:
+    static const int BASE_SIZE = 48;          // Point size the fields are built from
+    static const int SPREAD = 6;              // Distance range in base pixels
+    static const int FIELD_PAGE_SIZE = 512;
+    static const int COVERAGE_PAGE_SIZE = 1024;
+    static const int MAX_BUCKETS = 8;         // Size buckets kept resident, over an octave of zoom plus the HUD
+
+    SdfFont(SDL_Renderer* renderer, const std::string& path);
+    ~SdfFont();
+
+    // Prevent copying
+    SdfFont(const SdfFont&) = delete;
+    SdfFont& operator=(const SdfFont&) = delete;
+
+    bool isLoaded() const { return font != nullptr; }
+
+    // Font height at BASE_SIZE in pixels; text heights are relative to it
+    float getBaseHeight() const { return baseHeight; }
+    float getLineHeight(float height) const;
+    Vector2 measureText(const std::string& text, float height);
+
+    // Resolve the glyphs of text for a screen scale (relative to the base size)
+    // and return the number of coverage pages to draw
+    int prepare(const std::string& text, float screenScale);
+
+    // Append the quads of text that live on one coverage page of the last prepared bucket
+    void appendQuads(const std::string& text, float x, float y, float screenScale,
+                     SDL_Color color, int page, std::vector<SDL_Vertex>& vertices);
+    SDL_Texture* getPageTexture(int page) const;
+
+    // Build new fields on a worker pool from a second copy of the font file.
+    // Glyphs are left out of the text until processUploads has packed them.
+    bool enableAsync(WorkerPool* pool);
+    void disableAsync();
+    bool isAsync() const { return asyncSource != nullptr; }
+
+    // Pack finished fields until about budgetBytes have been copied, always at
+    // least one. Returns the bytes packed.
+    size_t processUploads(size_t budgetBytes);
+    int getPendingCount() const { return pendingCount; }
+
+    // Rasterize a glyph and build its field; safe from any thread that owns the font
+    static bool buildField(TTF_Font* font, Uint32 codepoint, SdfFieldBitmap& bitmap);
+
+    // Number of glyphs rasterized by FreeType so far
+    Uint32 getRasterizeCount() const { return rasterizeCount; }
+
+    // Number of glyph coverages thresholded so far, over all buckets
+    Uint32 getThresholdCount() const { return thresholdCount; }
+    int getBucketCount() const { return static_cast<int>(buckets.size()); }
+
+private:
+    struct Bucket {
+        int step;       // Quarter octaves from the base size
+        float scale;
+        Uint32 id;
+        Uint32 lastUsed;
+        int pending;    // Coverages queued on the workers
+        std::unordered_map<Uint32, SdfCoverageGlyph> glyphs;
+        std::vector<SDL_Texture*> pages;
+        ShelfPacker packer;
+    };
+
+    SdfGlyph& field(Uint32 codepoint);
+    void storeField(const SdfFieldBitmap& bitmap, SdfGlyph& glyph);
+    float getKerning(Uint32 left, Uint32 right);
+    Bucket& selectBucket(float screenScale);
+    const SdfCoverageGlyph& resolve(Bucket& bucket, Uint32 codepoint);
+    void storeCoverage(Bucket& bucket, SdfCoverageGlyph& coverage, int width, int height, const Uint32* pixels);
+    bool hasCoverage(const Bucket& bucket, const std::string& text) const;
+    Bucket* findFallback(const Bucket& target, const std::string& text);
+    void destroyBucket(Bucket& bucket);
+
+    SDL_Renderer* renderer;
+    std::string path;
+    TTF_Font* font;
+    float baseHeight;
+    float baseLineSkip;
+    bool kerningEnabled;
+
+    std::unordered_map<Uint32, SdfGlyph> glyphs;
+    std::unordered_map<Uint64, float> kerningPairs;
+    std::vector<std::vector<Uint8>> fieldPages;
+    ShelfPacker fieldPacker;
+
+    std::vector<std::unique_ptr<Bucket>> buckets;
+    Bucket* current;
+    Uint32 useCounter;
+    Uint32 bucketCounter;
+    std::vector<Uint32> coverageScratch;
+    std::vector<Uint32> uploadScratch;
+    Uint32 rasterizeCount;
+    Uint32 thresholdCount;
+
+    // Background field builds
+    WorkerPool* workers;
+    std::unique_ptr<AsyncFontSource> asyncSource;
+    std::vector<std::unique_ptr<AsyncFontSource>> retiredSources;
+    CompletionQueue<SdfFieldBitmap> finished;
+    CompletionQueue<SdfCoverageBitmap> finishedCoverage;
+    int pendingCount; // Fields and coverages
+};
+
+} // namespace ContextEngine
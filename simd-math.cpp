@@ -0,0 +1,571 @@
+#include "simd-math.hpp"
+
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define CONTEXT_ENGINE_SSE2 1
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define CONTEXT_ENGINE_AVX2 1
+#define CONTEXT_ENGINE_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define CONTEXT_ENGINE_NEON 1
+#elif defined(__wasm_simd128__)
+#include <wasm_simd128.h>
+#define CONTEXT_ENGINE_WASM_SIMD 1
+#endif
+
+namespace ContextEngine {
+
+// The kernels load points and rects straight from memory as packed floats
+static_assert(sizeof(Vector2) == 2 * sizeof(float), "Vector2 must be two packed floats");
+static_assert(sizeof(Rect) == 4 * sizeof(float), "Rect must be four packed floats");
+
+// Scalar kernels, the reference every other level has to match. The SIMD
+// versions use them for the elements left over after the last full vector.
+
+static void transformScalar(const Vector2* in, Vector2* out, size_t count, const Affine2& m) {
+    for (size_t i = 0; i < count; i++) {
+        float x = in[i].x;
+        float y = in[i].y;
+        out[i].x = m.a * x + m.c * y + m.tx;
+        out[i].y = m.b * x + m.d * y + m.ty;
+    }
+}
+
+static void cameraScalar(const Vector2* in, Vector2* out, size_t count, const Vector2& cameraPos, float zoom) {
+    for (size_t i = 0; i < count; i++) {
+        out[i].x = (in[i].x - cameraPos.x) * zoom;
+        out[i].y = (in[i].y - cameraPos.y) * zoom;
+    }
+}
+
+static void integrateScalar(Vector2* positions, const Vector2* velocities, size_t count, float deltaTime) {
+    for (size_t i = 0; i < count; i++) {
+        positions[i].x = positions[i].x + velocities[i].x * deltaTime;
+        positions[i].y = positions[i].y + velocities[i].y * deltaTime;
+    }
+}
+
+static void containsScalar(const Rect& rect, const Vector2* points, size_t count, Uint8* results) {
+    for (size_t i = 0; i < count; i++) {
+        results[i] = rect.contains(points[i].x, points[i].y) ? 1 : 0;
+    }
+}
+
+static void overlapScalar(const Rect* rects, size_t count, const Rect& query, Uint8* results) {
+    float queryRight = query.x + query.w;
+    float queryBottom = query.y + query.h;
+    for (size_t i = 0; i < count; i++) {
+        const Rect& rect = rects[i];
+        results[i] = rect.x <= queryRight && query.x <= rect.x + rect.w &&
+                     rect.y <= queryBottom && query.y <= rect.y + rect.h ? 1 : 0;
+    }
+}
+
+// Points are stored interleaved (x0 y0 x1 y1 ...). Element-wise kernels work
+// on that directly; the affine transform splits x and y into separate vectors
+// first so every lane computes a*x + c*y + tx in the scalar order.
+
+#ifdef CONTEXT_ENGINE_SSE2
+static void transformSse2(const Vector2* in, Vector2* out, size_t count, const Affine2& m) {
+    const __m128 a = _mm_set1_ps(m.a);
+    const __m128 b = _mm_set1_ps(m.b);
+    const __m128 c = _mm_set1_ps(m.c);
+    const __m128 d = _mm_set1_ps(m.d);
+    const __m128 tx = _mm_set1_ps(m.tx);
+    const __m128 ty = _mm_set1_ps(m.ty);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 first = _mm_loadu_ps(&in[i].x);
+        __m128 second = _mm_loadu_ps(&in[i + 2].x);
+        __m128 x = _mm_shuffle_ps(first, second, _MM_SHUFFLE(2, 0, 2, 0));
+        __m128 y = _mm_shuffle_ps(first, second, _MM_SHUFFLE(3, 1, 3, 1));
+        __m128 resultX = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a, x), _mm_mul_ps(c, y)), tx);
+        __m128 resultY = _mm_add_ps(_mm_add_ps(_mm_mul_ps(b, x), _mm_mul_ps(d, y)), ty);
+        _mm_storeu_ps(&out[i].x, _mm_unpacklo_ps(resultX, resultY));
+        _mm_storeu_ps(&out[i + 2].x, _mm_unpackhi_ps(resultX, resultY));
+    }
+    transformScalar(in + i, out + i, count - i, m);
+}
+
+static void cameraSse2(const Vector2* in, Vector2* out, size_t count, const Vector2& cameraPos, float zoom) {
+    const __m128 camera = _mm_setr_ps(cameraPos.x, cameraPos.y, cameraPos.x, cameraPos.y);
+    const __m128 scale = _mm_set1_ps(zoom);
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        __m128 v = _mm_loadu_ps(&in[i].x);
+        _mm_storeu_ps(&out[i].x, _mm_mul_ps(_mm_sub_ps(v, camera), scale));
+    }
+    cameraScalar(in + i, out + i, count - i, cameraPos, zoom);
+}
+
+static void integrateSse2(Vector2* positions, const Vector2* velocities, size_t count, float deltaTime) {
+    const __m128 dt = _mm_set1_ps(deltaTime);
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        __m128 p = _mm_loadu_ps(&positions[i].x);
+        __m128 v = _mm_loadu_ps(&velocities[i].x);
+        _mm_storeu_ps(&positions[i].x, _mm_add_ps(p, _mm_mul_ps(v, dt)));
+    }
+    integrateScalar(positions + i, velocities + i, count - i, deltaTime);
+}
+
+static void containsSse2(const Rect& rect, const Vector2* points, size_t count, Uint8* results) {
+    float right = rect.x + rect.w;
+    float bottom = rect.y + rect.h;
+    const __m128 low = _mm_setr_ps(rect.x, rect.y, rect.x, rect.y);
+    const __m128 high = _mm_setr_ps(right, bottom, right, bottom);
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        __m128 v = _mm_loadu_ps(&points[i].x);
+        int bits = _mm_movemask_ps(_mm_and_ps(_mm_cmpge_ps(v, low), _mm_cmple_ps(v, high)));
+        results[i] = (bits & 3) == 3 ? 1 : 0;
+        results[i + 1] = (bits & 12) == 12 ? 1 : 0;
+    }
+    containsScalar(rect, points + i, count - i, results + i);
+}
+
+// Four rects per step, transposed so each vector holds one field of all four
+static void overlapSse2(const Rect* rects, size_t count, const Rect& query, Uint8* results) {
+    const __m128 queryX = _mm_set1_ps(query.x);
+    const __m128 queryY = _mm_set1_ps(query.y);
+    const __m128 queryRight = _mm_set1_ps(query.x + query.w);
+    const __m128 queryBottom = _mm_set1_ps(query.y + query.h);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 x = _mm_loadu_ps(&rects[i].x);
+        __m128 y = _mm_loadu_ps(&rects[i + 1].x);
+        __m128 w = _mm_loadu_ps(&rects[i + 2].x);
+        __m128 h = _mm_loadu_ps(&rects[i + 3].x);
+        _MM_TRANSPOSE4_PS(x, y, w, h);
+        __m128 hit = _mm_and_ps(_mm_and_ps(_mm_cmple_ps(x, queryRight), _mm_cmple_ps(queryX, _mm_add_ps(x, w))),
+                                _mm_and_ps(_mm_cmple_ps(y, queryBottom), _mm_cmple_ps(queryY, _mm_add_ps(y, h))));
+        int bits = _mm_movemask_ps(hit);
+        for (int lane = 0; lane < 4; lane++) {
+            results[i + lane] = (bits >> lane) & 1;
+        }
+    }
+    overlapScalar(rects + i, count - i, query, results + i);
+}
+#endif
+
+#ifdef CONTEXT_ENGINE_AVX2
+CONTEXT_ENGINE_TARGET_AVX2
+static void transformAvx2(const Vector2* in, Vector2* out, size_t count, const Affine2& m) {
+    const __m256 a = _mm256_set1_ps(m.a);
+    const __m256 b = _mm256_set1_ps(m.b);
+    const __m256 c = _mm256_set1_ps(m.c);
+    const __m256 d = _mm256_set1_ps(m.d);
+    const __m256 tx = _mm256_set1_ps(m.tx);
+    const __m256 ty = _mm256_set1_ps(m.ty);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        // Shuffles stay within 128 bit halves, so the points come out of
+        // unpack in the order they went in
+        __m256 first = _mm256_loadu_ps(&in[i].x);
+        __m256 second = _mm256_loadu_ps(&in[i + 4].x);
+        __m256 x = _mm256_shuffle_ps(first, second, _MM_SHUFFLE(2, 0, 2, 0));
+        __m256 y = _mm256_shuffle_ps(first, second, _MM_SHUFFLE(3, 1, 3, 1));
+        __m256 resultX = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(a, x), _mm256_mul_ps(c, y)), tx);
+        __m256 resultY = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(b, x), _mm256_mul_ps(d, y)), ty);
+        _mm256_storeu_ps(&out[i].x, _mm256_unpacklo_ps(resultX, resultY));
+        _mm256_storeu_ps(&out[i + 4].x, _mm256_unpackhi_ps(resultX, resultY));
+    }
+    transformSse2(in + i, out + i, count - i, m);
+}
+
+CONTEXT_ENGINE_TARGET_AVX2
+static void cameraAvx2(const Vector2* in, Vector2* out, size_t count, const Vector2& cameraPos, float zoom) {
+    const __m256 camera = _mm256_setr_ps(cameraPos.x, cameraPos.y, cameraPos.x, cameraPos.y,
+                                         cameraPos.x, cameraPos.y, cameraPos.x, cameraPos.y);
+    const __m256 scale = _mm256_set1_ps(zoom);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m256 v = _mm256_loadu_ps(&in[i].x);
+        _mm256_storeu_ps(&out[i].x, _mm256_mul_ps(_mm256_sub_ps(v, camera), scale));
+    }
+    cameraSse2(in + i, out + i, count - i, cameraPos, zoom);
+}
+
+CONTEXT_ENGINE_TARGET_AVX2
+static void integrateAvx2(Vector2* positions, const Vector2* velocities, size_t count, float deltaTime) {
+    const __m256 dt = _mm256_set1_ps(deltaTime);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m256 p = _mm256_loadu_ps(&positions[i].x);
+        __m256 v = _mm256_loadu_ps(&velocities[i].x);
+        _mm256_storeu_ps(&positions[i].x, _mm256_add_ps(p, _mm256_mul_ps(v, dt)));
+    }
+    integrateSse2(positions + i, velocities + i, count - i, deltaTime);
+}
+
+CONTEXT_ENGINE_TARGET_AVX2
+static void containsAvx2(const Rect& rect, const Vector2* points, size_t count, Uint8* results) {
+    float right = rect.x + rect.w;
+    float bottom = rect.y + rect.h;
+    const __m256 low = _mm256_setr_ps(rect.x, rect.y, rect.x, rect.y, rect.x, rect.y, rect.x, rect.y);
+    const __m256 high = _mm256_setr_ps(right, bottom, right, bottom, right, bottom, right, bottom);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m256 v = _mm256_loadu_ps(&points[i].x);
+        __m256 inside = _mm256_and_ps(_mm256_cmp_ps(v, low, _CMP_GE_OQ), _mm256_cmp_ps(v, high, _CMP_LE_OQ));
+        int bits = _mm256_movemask_ps(inside);
+        for (int point = 0; point < 4; point++) {
+            results[i + point] = ((bits >> (point * 2)) & 3) == 3 ? 1 : 0;
+        }
+    }
+    containsSse2(rect, points + i, count - i, results + i);
+}
+#endif
+
+#ifdef CONTEXT_ENGINE_NEON
+// vld2q/vst2q split and rejoin x and y for free
+static void transformNeon(const Vector2* in, Vector2* out, size_t count, const Affine2& m) {
+    const float32x4_t a = vdupq_n_f32(m.a);
+    const float32x4_t b = vdupq_n_f32(m.b);
+    const float32x4_t c = vdupq_n_f32(m.c);
+    const float32x4_t d = vdupq_n_f32(m.d);
+    const float32x4_t tx = vdupq_n_f32(m.tx);
+    const float32x4_t ty = vdupq_n_f32(m.ty);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        float32x4x2_t points = vld2q_f32(&in[i].x);
+        float32x4x2_t result;
+        result.val[0] = vaddq_f32(vaddq_f32(vmulq_f32(a, points.val[0]), vmulq_f32(c, points.val[1])), tx);
+        result.val[1] = vaddq_f32(vaddq_f32(vmulq_f32(b, points.val[0]), vmulq_f32(d, points.val[1])), ty);
+        vst2q_f32(&out[i].x, result);
+    }
+    transformScalar(in + i, out + i, count - i, m);
+}
+
+static void cameraNeon(const Vector2* in, Vector2* out, size_t count, const Vector2& cameraPos, float zoom) {
+    const float cameraValues[4] = {cameraPos.x, cameraPos.y, cameraPos.x, cameraPos.y};
+    const float32x4_t camera = vld1q_f32(cameraValues);
+    const float32x4_t scale = vdupq_n_f32(zoom);
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        float32x4_t v = vld1q_f32(&in[i].x);
+        vst1q_f32(&out[i].x, vmulq_f32(vsubq_f32(v, camera), scale));
+    }
+    cameraScalar(in + i, out + i, count - i, cameraPos, zoom);
+}
+
+static void integrateNeon(Vector2* positions, const Vector2* velocities, size_t count, float deltaTime) {
+    const float32x4_t dt = vdupq_n_f32(deltaTime);
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        float32x4_t p = vld1q_f32(&positions[i].x);
+        float32x4_t v = vld1q_f32(&velocities[i].x);
+        vst1q_f32(&positions[i].x, vaddq_f32(p, vmulq_f32(v, dt)));
+    }
+    integrateScalar(positions + i, velocities + i, count - i, deltaTime);
+}
+
+static void containsNeon(const Rect& rect, const Vector2* points, size_t count, Uint8* results) {
+    float right = rect.x + rect.w;
+    float bottom = rect.y + rect.h;
+    const float lowValues[4] = {rect.x, rect.y, rect.x, rect.y};
+    const float highValues[4] = {right, bottom, right, bottom};
+    const float32x4_t low = vld1q_f32(lowValues);
+    const float32x4_t high = vld1q_f32(highValues);
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        float32x4_t v = vld1q_f32(&points[i].x);
+        uint32x4_t inside = vandq_u32(vcgeq_f32(v, low), vcleq_f32(v, high));
+        results[i] = vgetq_lane_u32(inside, 0) && vgetq_lane_u32(inside, 1) ? 1 : 0;
+        results[i + 1] = vgetq_lane_u32(inside, 2) && vgetq_lane_u32(inside, 3) ? 1 : 0;
+    }
+    containsScalar(rect, points + i, count - i, results + i);
+}
+
+// vld4q deinterleaves four rects into one vector per field
+static void overlapNeon(const Rect* rects, size_t count, const Rect& query, Uint8* results) {
+    const float32x4_t queryX = vdupq_n_f32(query.x);
+    const float32x4_t queryY = vdupq_n_f32(query.y);
+    const float32x4_t queryRight = vdupq_n_f32(query.x + query.w);
+    const float32x4_t queryBottom = vdupq_n_f32(query.y + query.h);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        float32x4x4_t fields = vld4q_f32(&rects[i].x);
+        uint32x4_t hit = vandq_u32(
+            vandq_u32(vcleq_f32(fields.val[0], queryRight), vcleq_f32(queryX, vaddq_f32(fields.val[0], fields.val[2]))),
+            vandq_u32(vcleq_f32(fields.val[1], queryBottom), vcleq_f32(queryY, vaddq_f32(fields.val[1], fields.val[3]))));
+        results[i] = vgetq_lane_u32(hit, 0) ? 1 : 0;
+        results[i + 1] = vgetq_lane_u32(hit, 1) ? 1 : 0;
+        results[i + 2] = vgetq_lane_u32(hit, 2) ? 1 : 0;
+        results[i + 3] = vgetq_lane_u32(hit, 3) ? 1 : 0;
+    }
+    overlapScalar(rects + i, count - i, query, results + i);
+}
+#endif
+
+#ifdef CONTEXT_ENGINE_WASM_SIMD
+static void transformWasm(const Vector2* in, Vector2* out, size_t count, const Affine2& m) {
+    const v128_t a = wasm_f32x4_splat(m.a);
+    const v128_t b = wasm_f32x4_splat(m.b);
+    const v128_t c = wasm_f32x4_splat(m.c);
+    const v128_t d = wasm_f32x4_splat(m.d);
+    const v128_t tx = wasm_f32x4_splat(m.tx);
+    const v128_t ty = wasm_f32x4_splat(m.ty);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        v128_t first = wasm_v128_load(&in[i].x);
+        v128_t second = wasm_v128_load(&in[i + 2].x);
+        v128_t x = wasm_i32x4_shuffle(first, second, 0, 2, 4, 6);
+        v128_t y = wasm_i32x4_shuffle(first, second, 1, 3, 5, 7);
+        v128_t resultX = wasm_f32x4_add(wasm_f32x4_add(wasm_f32x4_mul(a, x), wasm_f32x4_mul(c, y)), tx);
+        v128_t resultY = wasm_f32x4_add(wasm_f32x4_add(wasm_f32x4_mul(b, x), wasm_f32x4_mul(d, y)), ty);
+        wasm_v128_store(&out[i].x, wasm_i32x4_shuffle(resultX, resultY, 0, 4, 1, 5));
+        wasm_v128_store(&out[i + 2].x, wasm_i32x4_shuffle(resultX, resultY, 2, 6, 3, 7));
+    }
+    transformScalar(in + i, out + i, count - i, m);
+}
+
+static void cameraWasm(const Vector2* in, Vector2* out, size_t count, const Vector2& cameraPos, float zoom) {
+    const v128_t camera = wasm_f32x4_make(cameraPos.x, cameraPos.y, cameraPos.x, cameraPos.y);
+    const v128_t scale = wasm_f32x4_splat(zoom);
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        v128_t v = wasm_v128_load(&in[i].x);
+        wasm_v128_store(&out[i].x, wasm_f32x4_mul(wasm_f32x4_sub(v, camera), scale));
+    }
+    cameraScalar(in + i, out + i, count - i, cameraPos, zoom);
+}
+
+static void integrateWasm(Vector2* positions, const Vector2* velocities, size_t count, float deltaTime) {
+    const v128_t dt = wasm_f32x4_splat(deltaTime);
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        v128_t p = wasm_v128_load(&positions[i].x);
+        v128_t v = wasm_v128_load(&velocities[i].x);
+        wasm_v128_store(&positions[i].x, wasm_f32x4_add(p, wasm_f32x4_mul(v, dt)));
+    }
+    integrateScalar(positions + i, velocities + i, count - i, deltaTime);
+}
+
+static void containsWasm(const Rect& rect, const Vector2* points, size_t count, Uint8* results) {
+    float right = rect.x + rect.w;
+    float bottom = rect.y + rect.h;
+    const v128_t low = wasm_f32x4_make(rect.x, rect.y, rect.x, rect.y);
+    const v128_t high = wasm_f32x4_make(right, bottom, right, bottom);
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        v128_t v = wasm_v128_load(&points[i].x);
+        int bits = wasm_i32x4_bitmask(wasm_v128_and(wasm_f32x4_ge(v, low), wasm_f32x4_le(v, high)));
+        results[i] = (bits & 3) == 3 ? 1 : 0;
+        results[i + 1] = (bits & 12) == 12 ? 1 : 0;
+    }
+    containsScalar(rect, points + i, count - i, results + i);
+}
+
+static void overlapWasm(const Rect* rects, size_t count, const Rect& query, Uint8* results) {
+    const v128_t queryX = wasm_f32x4_splat(query.x);
+    const v128_t queryY = wasm_f32x4_splat(query.y);
+    const v128_t queryRight = wasm_f32x4_splat(query.x + query.w);
+    const v128_t queryBottom = wasm_f32x4_splat(query.y + query.h);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        v128_t r0 = wasm_v128_load(&rects[i].x);
+        v128_t r1 = wasm_v128_load(&rects[i + 1].x);
+        v128_t r2 = wasm_v128_load(&rects[i + 2].x);
+        v128_t r3 = wasm_v128_load(&rects[i + 3].x);
+
+        // Transpose into x, y, w and h vectors
+        v128_t xy01 = wasm_i32x4_shuffle(r0, r1, 0, 4, 1, 5);
+        v128_t xy23 = wasm_i32x4_shuffle(r2, r3, 0, 4, 1, 5);
+        v128_t wh01 = wasm_i32x4_shuffle(r0, r1, 2, 6, 3, 7);
+        v128_t wh23 = wasm_i32x4_shuffle(r2, r3, 2, 6, 3, 7);
+        v128_t x = wasm_i32x4_shuffle(xy01, xy23, 0, 1, 4, 5);
+        v128_t y = wasm_i32x4_shuffle(xy01, xy23, 2, 3, 6, 7);
+        v128_t w = wasm_i32x4_shuffle(wh01, wh23, 0, 1, 4, 5);
+        v128_t h = wasm_i32x4_shuffle(wh01, wh23, 2, 3, 6, 7);
+
+        v128_t hit = wasm_v128_and(
+            wasm_v128_and(wasm_f32x4_le(x, queryRight), wasm_f32x4_le(queryX, wasm_f32x4_add(x, w))),
+            wasm_v128_and(wasm_f32x4_le(y, queryBottom), wasm_f32x4_le(queryY, wasm_f32x4_add(y, h))));
+        int bits = wasm_i32x4_bitmask(hit);
+        for (int lane = 0; lane < 4; lane++) {
+            results[i + lane] = (bits >> lane) & 1;
+        }
+    }
+    overlapScalar(rects + i, count - i, query, results + i);
+}
+#endif
+
+// Level selection
+static bool isSupported(SimdLevel level) {
+    switch (level) {
+        case SimdLevel::Scalar:
+            return true;
+#ifdef CONTEXT_ENGINE_SSE2
+        case SimdLevel::Sse2:
+            return true;
+#endif
+#ifdef CONTEXT_ENGINE_AVX2
+        case SimdLevel::Avx2:
+            return __builtin_cpu_supports("avx2");
+#endif
+#ifdef CONTEXT_ENGINE_NEON
+        case SimdLevel::Neon:
+            return true;
+#endif
+#ifdef CONTEXT_ENGINE_WASM_SIMD
+        case SimdLevel::Wasm:
+            return true;
+#endif
+        default:
+            return false;
+    }
+}
+
+static SimdLevel bestLevel() {
+    const SimdLevel preferred[] = {SimdLevel::Avx2, SimdLevel::Sse2, SimdLevel::Neon, SimdLevel::Wasm};
+    for (SimdLevel level : preferred) {
+        if (isSupported(level)) {
+            return level;
+        }
+    }
+    return SimdLevel::Scalar;
+}
+
+static SimdLevel activeLevel = bestLevel();
+
+SimdLevel getSimdLevel() {
+    return activeLevel;
+}
+
+const char* getSimdLevelName(SimdLevel level) {
+    switch (level) {
+        case SimdLevel::Sse2: return "SSE2";
+        case SimdLevel::Avx2: return "AVX2";
+        case SimdLevel::Neon: return "NEON";
+        case SimdLevel::Wasm: return "WASM SIMD";
+        default: return "Scalar";
+    }
+}
+
+void setSimdLevel(SimdLevel level) {
+    activeLevel = isSupported(level) ? level : bestLevel();
+}
+
+Affine2 Affine2::fromTransform(const Vector2& position, float rotation, const Vector2& scale) {
+    float cosR = std::cos(rotation);
+    float sinR = std::sin(rotation);
+    Affine2 matrix;
+    matrix.a = cosR * scale.x;
+    matrix.b = sinR * scale.x;
+    matrix.c = -sinR * scale.y;
+    matrix.d = cosR * scale.y;
+    matrix.tx = position.x;
+    matrix.ty = position.y;
+    return matrix;
+}
+
+// Public entry points dispatch on the active level
+
+Vector2 transformPoint(const Vector2& point, const Affine2& matrix) {
+    Vector2 result;
+    transformScalar(&point, &result, 1, matrix);
+    return result;
+}
+
+Vector2 cameraTransformPoint(const Vector2& point, const Vector2& cameraPos, float zoom) {
+    Vector2 result;
+    cameraScalar(&point, &result, 1, cameraPos, zoom);
+    return result;
+}
+
+void transformPoints(const Vector2* in, Vector2* out, size_t count, const Affine2& matrix) {
+    switch (activeLevel) {
+#ifdef CONTEXT_ENGINE_AVX2
+        case SimdLevel::Avx2: transformAvx2(in, out, count, matrix); return;
+#endif
+#ifdef CONTEXT_ENGINE_SSE2
+        case SimdLevel::Sse2: transformSse2(in, out, count, matrix); return;
+#endif
+#ifdef CONTEXT_ENGINE_NEON
+        case SimdLevel::Neon: transformNeon(in, out, count, matrix); return;
+#endif
+#ifdef CONTEXT_ENGINE_WASM_SIMD
+        case SimdLevel::Wasm: transformWasm(in, out, count, matrix); return;
+#endif
+        default: transformScalar(in, out, count, matrix); return;
+    }
+}
+
+void cameraTransformPoints(const Vector2* in, Vector2* out, size_t count, const Vector2& cameraPos, float zoom) {
+    switch (activeLevel) {
+#ifdef CONTEXT_ENGINE_AVX2
+        case SimdLevel::Avx2: cameraAvx2(in, out, count, cameraPos, zoom); return;
+#endif
+#ifdef CONTEXT_ENGINE_SSE2
+        case SimdLevel::Sse2: cameraSse2(in, out, count, cameraPos, zoom); return;
+#endif
+#ifdef CONTEXT_ENGINE_NEON
+        case SimdLevel::Neon: cameraNeon(in, out, count, cameraPos, zoom); return;
+#endif
+#ifdef CONTEXT_ENGINE_WASM_SIMD
+        case SimdLevel::Wasm: cameraWasm(in, out, count, cameraPos, zoom); return;
+#endif
+        default: cameraScalar(in, out, count, cameraPos, zoom); return;
+    }
+}
+
+void integratePositions(Vector2* positions, const Vector2* velocities, size_t count, float deltaTime) {
+    switch (activeLevel) {
+#ifdef CONTEXT_ENGINE_AVX2
+        case SimdLevel::Avx2: integrateAvx2(positions, velocities, count, deltaTime); return;
+#endif
+#ifdef CONTEXT_ENGINE_SSE2
+        case SimdLevel::Sse2: integrateSse2(positions, velocities, count, deltaTime); return;
+#endif
+#ifdef CONTEXT_ENGINE_NEON
+        case SimdLevel::Neon: integrateNeon(positions, velocities, count, deltaTime); return;
+#endif
+#ifdef CONTEXT_ENGINE_WASM_SIMD
+        case SimdLevel::Wasm: integrateWasm(positions, velocities, count, deltaTime); return;
+#endif
+        default: integrateScalar(positions, velocities, count, deltaTime); return;
+    }
+}
+
+void containsPoints(const Rect& rect, const Vector2* points, size_t count, Uint8* results) {
+    switch (activeLevel) {
+#ifdef CONTEXT_ENGINE_AVX2
+        case SimdLevel::Avx2: containsAvx2(rect, points, count, results); return;
+#endif
+#ifdef CONTEXT_ENGINE_SSE2
+        case SimdLevel::Sse2: containsSse2(rect, points, count, results); return;
+#endif
+#ifdef CONTEXT_ENGINE_NEON
+        case SimdLevel::Neon: containsNeon(rect, points, count, results); return;
+#endif
+#ifdef CONTEXT_ENGINE_WASM_SIMD
+        case SimdLevel::Wasm: containsWasm(rect, points, count, results); return;
+#endif
+        default: containsScalar(rect, points, count, results); return;
+    }
+}
+
+// Rects are already four floats wide, so AVX2 uses the SSE2 kernel
+void overlapRects(const Rect* rects, size_t count, const Rect& query, Uint8* results) {
+    switch (activeLevel) {
+#ifdef CONTEXT_ENGINE_SSE2
+        case SimdLevel::Avx2:
+        case SimdLevel::Sse2: overlapSse2(rects, count, query, results); return;
+#endif
+#ifdef CONTEXT_ENGINE_NEON
+        case SimdLevel::Neon: overlapNeon(rects, count, query, results); return;
+#endif
+#ifdef CONTEXT_ENGINE_WASM_SIMD
+        case SimdLevel::Wasm: overlapWasm(rects, count, query, results); return;
+#endif
+        default: overlapScalar(rects, count, query, results); return;
+    }
+}
+
+} // namespace ContextEngine
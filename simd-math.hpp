@@ -0,0 +1,61 @@
+#pragma once
+
+#include "context-types.hpp"
+
+#include <cstddef>
+
+namespace ContextEngine {
+
+// Instruction sets the batch kernels can use. The best one available is
+// picked at startup; AVX2 is detected at runtime on x86.
+enum class SimdLevel {
+    Scalar,
+    Sse2,
+    Avx2,
+    Neon,
+    Wasm
+};
+
+SimdLevel getSimdLevel();
+const char* getSimdLevelName(SimdLevel level);
+
+// Force a level, e.g. Scalar to compare against. A level the CPU or build
+// doesn't support falls back to the best one that is.
+void setSimdLevel(SimdLevel level);
+
+// 2D affine matrix: x' = a*x + c*y + tx, y' = b*x + d*y + ty
+struct Affine2 {
+    float a = 1.0f, b = 0.0f;
+    float c = 0.0f, d = 1.0f;
+    float tx = 0.0f, ty = 0.0f;
+
+    // Scale, then rotate (radians), then translate
+    static Affine2 fromTransform(const Vector2& position, float rotation, const Vector2& scale);
+};
+
+// Batch kernels over arrays of Vector2/Rect. Every level produces results
+// bit for bit identical to the scalar path (simd-math.cpp is compiled without
+// floating point contraction); only the sign and payload of NaN results are
+// unspecified, as for any compiled float code. Input and output may be the
+// same array.
+
+void transformPoints(const Vector2* in, Vector2* out, size_t count, const Affine2& matrix);
+
+// Same math as OtherCtx::transformPoint: (p - cameraPos) * zoom
+void cameraTransformPoints(const Vector2* in, Vector2* out, size_t count, const Vector2& cameraPos, float zoom);
+
+// One point through the scalar kernels. Out of line on purpose, so callers
+// compiled with contraction on still get the batch results bit for bit.
+Vector2 transformPoint(const Vector2& point, const Affine2& matrix);
+Vector2 cameraTransformPoint(const Vector2& point, const Vector2& cameraPos, float zoom);
+
+// positions[i] += velocities[i] * deltaTime
+void integratePositions(Vector2* positions, const Vector2* velocities, size_t count, float deltaTime);
+
+// results[i] = 1 when rect.contains(points[i]), else 0
+void containsPoints(const Rect& rect, const Vector2* points, size_t count, Uint8* results);
+
+// results[i] = 1 when rects[i] overlaps query (touching edges count), else 0
+void overlapRects(const Rect* rects, size_t count, const Rect& query, Uint8* results);
+
+} // namespace ContextEngine
@@ -0,0 +1,383 @@
+#include "spatial-hash.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace ContextEngine {
+
+static bool overlaps(const Rect& a, const Rect& b) {
+    return a.x <= b.x + b.w && b.x <= a.x + a.w && a.y <= b.y + b.h && b.y <= a.y + a.h;
+}
+
+static bool insideRange(int x, int y, int minX, int minY, int maxX, int maxY) {
+    return x >= minX && x <= maxX && y >= minY && y <= maxY;
+}
+
+// Slab test; distance is 0 when the ray starts inside the box
+static bool rayHitsBox(const Vector2& origin, const Vector2& direction, const Rect& box, float maxDistance, float& distance) {
+    float enter = 0.0f;
+    float exit = maxDistance;
+    const float start[2] = {origin.x, origin.y};
+    const float step[2] = {direction.x, direction.y};
+    const float low[2] = {box.x, box.y};
+    const float high[2] = {box.x + box.w, box.y + box.h};
+    for (int axis = 0; axis < 2; axis++) {
+        if (step[axis] == 0.0f) {
+            if (start[axis] < low[axis] || start[axis] > high[axis]) {
+                return false;
+            }
+            continue;
+        }
+        float near = (low[axis] - start[axis]) / step[axis];
+        float far = (high[axis] - start[axis]) / step[axis];
+        if (near > far) {
+            std::swap(near, far);
+        }
+        enter = std::max(enter, near);
+        exit = std::min(exit, far);
+        if (enter > exit) {
+            return false;
+        }
+    }
+    distance = enter;
+    return true;
+}
+
+SpatialHash::SpatialHash(float cellSize)
+    : cellSize(cellSize > 0.0f ? cellSize : 64.0f)
+    , inverseCellSize(1.0f / this->cellSize)
+    , proxyCount(0)
+    , stampCounter(0)
+{
+}
+
+int SpatialHash::cellCoord(float value) const {
+    // Clamp so far away or infinite bounds still map to a valid cell
+    float cell = std::floor(value * inverseCellSize);
+    cell = std::max(-1.0e9f, std::min(cell, 1.0e9f));
+    return static_cast<int>(cell);
+}
+
+SpatialHash::CellRange SpatialHash::rangeOf(const Rect& bounds) const {
+    return {cellCoord(bounds.x), cellCoord(bounds.y), cellCoord(bounds.x + bounds.w), cellCoord(bounds.y + bounds.h)};
+}
+
+void SpatialHash::addToCells(int proxy, const CellRange& range, const CellRange* skip) {
+    for (int y = range.minY; y <= range.maxY; y++) {
+        for (int x = range.minX; x <= range.maxX; x++) {
+            if (skip && insideRange(x, y, skip->minX, skip->minY, skip->maxX, skip->maxY)) {
+                continue;
+            }
+            cells[cellKey(x, y)].push_back(proxy);
+        }
+    }
+}
+
+void SpatialHash::removeFromCells(int proxy, const CellRange& range, const CellRange* skip) {
+    for (int y = range.minY; y <= range.maxY; y++) {
+        for (int x = range.minX; x <= range.maxX; x++) {
+            if (skip && insideRange(x, y, skip->minX, skip->minY, skip->maxX, skip->maxY)) {
+                continue;
+            }
+            auto found = cells.find(cellKey(x, y));
+            if (found == cells.end()) {
+                continue;
+            }
+            std::vector<int>& list = found->second;
+            auto entry = std::find(list.begin(), list.end(), proxy);
+            if (entry != list.end()) {
+                *entry = list.back();
+                list.pop_back();
+            }
+        }
+    }
+}
+
+Uint32 SpatialHash::nextStamp() const {
+    if (++stampCounter == 0) {
+        // Wrapped around, forget every old stamp
+        for (const Proxy& proxy : proxies) {
+            proxy.stamp = 0;
+        }
+        stampCounter = 1;
+    }
+    return stampCounter;
+}
+
+int SpatialHash::insert(const Rect& bounds, Uint32 userData) {
+    int id;
+    if (!freeProxies.empty()) {
+        id = freeProxies.back();
+        freeProxies.pop_back();
+    } else {
+        id = static_cast<int>(proxies.size());
+        proxies.push_back(Proxy());
+    }
+
+    CellRange range = rangeOf(bounds);
+    Proxy& proxy = proxies[id];
+    proxy.bounds = bounds;
+    proxy.userData = userData;
+    proxy.minX = range.minX;
+    proxy.minY = range.minY;
+    proxy.maxX = range.maxX;
+    proxy.maxY = range.maxY;
+    proxy.stamp = 0;
+    proxy.alive = true;
+    addToCells(id, range, nullptr);
+    proxyCount++;
+    return id;
+}
+
+void SpatialHash::move(int id, const Rect& bounds) {
+    if (id < 0 || id >= static_cast<int>(proxies.size()) || !proxies[id].alive) {
+        return;
+    }
+
+    Proxy& proxy = proxies[id];
+    proxy.bounds = bounds;
+    CellRange range = rangeOf(bounds);
+    if (range.minX == proxy.minX && range.minY == proxy.minY &&
+        range.maxX == proxy.maxX && range.maxY == proxy.maxY) {
+        return; // Still in the same cells, the common case
+    }
+
+    // Only touch the cells that were entered or left
+    CellRange old = {proxy.minX, proxy.minY, proxy.maxX, proxy.maxY};
+    removeFromCells(id, old, &range);
+    addToCells(id, range, &old);
+    proxy.minX = range.minX;
+    proxy.minY = range.minY;
+    proxy.maxX = range.maxX;
+    proxy.maxY = range.maxY;
+}
+
+void SpatialHash::remove(int id) {
+    if (id < 0 || id >= static_cast<int>(proxies.size()) || !proxies[id].alive) {
+        return;
+    }
+
+    Proxy& proxy = proxies[id];
+    CellRange range = {proxy.minX, proxy.minY, proxy.maxX, proxy.maxY};
+    removeFromCells(id, range, nullptr);
+    proxy.alive = false;
+    freeProxies.push_back(id);
+    proxyCount--;
+}
+
+void SpatialHash::clear() {
+    cells.clear();
+    proxies.clear();
+    freeProxies.clear();
+    proxyCount = 0;
+}
+
+void SpatialHash::shrink() {
+    for (auto it = cells.begin(); it != cells.end();) {
+        if (it->second.empty()) {
+            it = cells.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void SpatialHash::queryRect(const Rect& area, std::vector<Uint32>& out) const {
+    Uint32 stamp = nextStamp();
+    auto visitCell = [&](const std::vector<int>& list) {
+        for (int id : list) {
+            const Proxy& proxy = proxies[id];
+            if (proxy.stamp != stamp) {
+                proxy.stamp = stamp;
+                if (overlaps(proxy.bounds, area)) {
+                    out.push_back(proxy.userData);
+                }
+            }
+        }
+    };
+
+    CellRange range = rangeOf(area);
+    double rangeCells = (static_cast<double>(range.maxX) - range.minX + 1) * (static_cast<double>(range.maxY) - range.minY + 1);
+    if (rangeCells > static_cast<double>(cells.size())) {
+        // Huge area over a sparse world, e.g. a zoomed out camera: walk the
+        // occupied cells instead of every cell in the area
+        for (const auto& cell : cells) {
+            int x = static_cast<int>(static_cast<Uint32>(cell.first >> 32));
+            int y = static_cast<int>(static_cast<Uint32>(cell.first));
+            if (insideRange(x, y, range.minX, range.minY, range.maxX, range.maxY)) {
+                visitCell(cell.second);
+            }
+        }
+        return;
+    }
+
+    for (int y = range.minY; y <= range.maxY; y++) {
+        for (int x = range.minX; x <= range.maxX; x++) {
+            auto found = cells.find(cellKey(x, y));
+            if (found != cells.end()) {
+                visitCell(found->second);
+            }
+        }
+    }
+}
+
+void SpatialHash::queryPoint(const Vector2& point, std::vector<Uint32>& out) const {
+    // A point sits in one cell, so no object can be seen twice
+    auto found = cells.find(cellKey(cellCoord(point.x), cellCoord(point.y)));
+    if (found == cells.end()) {
+        return;
+    }
+    for (int id : found->second) {
+        if (proxies[id].bounds.contains(point.x, point.y)) {
+            out.push_back(proxies[id].userData);
+        }
+    }
+}
+
+void SpatialHash::queryRadius(const Vector2& center, float radius, std::vector<Uint32>& out) const {
+    Uint32 stamp = nextStamp();
+    CellRange range = rangeOf(Rect(center.x - radius, center.y - radius, radius * 2, radius * 2));
+    float radiusSquared = radius * radius;
+    for (int y = range.minY; y <= range.maxY; y++) {
+        for (int x = range.minX; x <= range.maxX; x++) {
+            auto found = cells.find(cellKey(x, y));
+            if (found == cells.end()) {
+                continue;
+            }
+            for (int id : found->second) {
+                const Proxy& proxy = proxies[id];
+                if (proxy.stamp == stamp) {
+                    continue;
+                }
+                proxy.stamp = stamp;
+
+                // Distance from the center to the closest point of the box
+                float dx = center.x - std::max(proxy.bounds.x, std::min(center.x, proxy.bounds.x + proxy.bounds.w));
+                float dy = center.y - std::max(proxy.bounds.y, std::min(center.y, proxy.bounds.y + proxy.bounds.h));
+                if (dx * dx + dy * dy <= radiusSquared) {
+                    out.push_back(proxy.userData);
+                }
+            }
+        }
+    }
+}
+
+template <typename Visit>
+void SpatialHash::traverseRay(const Vector2& origin, const Vector2& direction, float maxDistance, Visit visit) const {
+    if (!(maxDistance >= 0.0f) || std::isinf(maxDistance)) {
+        return;
+    }
+
+    // Grid traversal (Amanatides and Woo): step into whichever neighbouring
+    // cell the ray reaches first
+    const float infinity = std::numeric_limits<float>::infinity();
+    int x = cellCoord(origin.x);
+    int y = cellCoord(origin.y);
+    int stepX = direction.x > 0.0f ? 1 : (direction.x < 0.0f ? -1 : 0);
+    int stepY = direction.y > 0.0f ? 1 : (direction.y < 0.0f ? -1 : 0);
+    float nextX = stepX != 0 ? ((x + (stepX > 0 ? 1 : 0)) * cellSize - origin.x) / direction.x : infinity;
+    float nextY = stepY != 0 ? ((y + (stepY > 0 ? 1 : 0)) * cellSize - origin.y) / direction.y : infinity;
+    float deltaX = stepX != 0 ? cellSize / std::fabs(direction.x) : infinity;
+    float deltaY = stepY != 0 ? cellSize / std::fabs(direction.y) : infinity;
+
+    while (true) {
+        float cellExit = std::min(nextX, nextY);
+        auto found = cells.find(cellKey(x, y));
+        if (found != cells.end() && !visit(found->second, cellExit)) {
+            return;
+        }
+        if (cellExit > maxDistance) {
+            return;
+        }
+        if (nextX < nextY) {
+            x += stepX;
+            nextX += deltaX;
+        } else {
+            y += stepY;
+            nextY += deltaY;
+        }
+    }
+}
+
+bool SpatialHash::raycast(const Vector2& origin, const Vector2& direction, float maxDistance, RayHit& hit) const {
+    float length = std::sqrt(direction.x * direction.x + direction.y * direction.y);
+    if (length == 0.0f) {
+        return false;
+    }
+    Vector2 unit = direction * (1.0f / length);
+
+    Uint32 stamp = nextStamp();
+    bool found = false;
+    traverseRay(origin, unit, maxDistance, [&](const std::vector<int>& list, float cellExit) {
+        for (int id : list) {
+            const Proxy& proxy = proxies[id];
+            if (proxy.stamp == stamp) {
+                continue;
+            }
+            proxy.stamp = stamp;
+
+            float distance;
+            if (rayHitsBox(origin, unit, proxy.bounds, maxDistance, distance) && (!found || distance < hit.distance)) {
+                hit = {proxy.userData, distance, origin + unit * distance};
+                found = true;
+            }
+        }
+        // Later cells can't hold anything nearer than a hit inside this one
+        return !(found && hit.distance <= cellExit);
+    });
+    return found;
+}
+
+void SpatialHash::raycastAll(const Vector2& origin, const Vector2& direction, float maxDistance, std::vector<RayHit>& out) const {
+    float length = std::sqrt(direction.x * direction.x + direction.y * direction.y);
+    if (length == 0.0f) {
+        return;
+    }
+    Vector2 unit = direction * (1.0f / length);
+
+    Uint32 stamp = nextStamp();
+    size_t first = out.size();
+    traverseRay(origin, unit, maxDistance, [&](const std::vector<int>& list, float) {
+        for (int id : list) {
+            const Proxy& proxy = proxies[id];
+            if (proxy.stamp == stamp) {
+                continue;
+            }
+            proxy.stamp = stamp;
+
+            float distance;
+            if (rayHitsBox(origin, unit, proxy.bounds, maxDistance, distance)) {
+                out.push_back({proxy.userData, distance, origin + unit * distance});
+            }
+        }
+        return true;
+    });
+    std::sort(out.begin() + first, out.end(), [](const RayHit& a, const RayHit& b) {
+        return a.distance < b.distance;
+    });
+}
+
+void SpatialHash::queryPairs(std::vector<std::pair<Uint32, Uint32>>& out) const {
+    for (const auto& cell : cells) {
+        const std::vector<int>& list = cell.second;
+        int x = static_cast<int>(static_cast<Uint32>(cell.first >> 32));
+        int y = static_cast<int>(static_cast<Uint32>(cell.first));
+        for (size_t i = 0; i < list.size(); i++) {
+            const Rect& a = proxies[list[i]].bounds;
+            for (size_t j = i + 1; j < list.size(); j++) {
+                const Rect& b = proxies[list[j]].bounds;
+                if (!overlaps(a, b)) {
+                    continue;
+                }
+                // Two objects can share many cells; only the cell holding the
+                // corner of their overlap reports them
+                if (cellCoord(std::max(a.x, b.x)) == x && cellCoord(std::max(a.y, b.y)) == y) {
+                    out.emplace_back(proxies[list[i]].userData, proxies[list[j]].userData);
+                }
+            }
+        }
+    }
+}
+
+} // namespace ContextEngine
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "context-types.hpp"
+
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace ContextEngine {
+
+// Result of a ray query; distance is along the normalized direction
+struct RayHit {
+    Uint32 userData;
+    float distance;
+    Vector2 point;
+};
+
+// Uniform grid of world-space boxes, hashed so the world can be unbounded.
+// Each object is a proxy listed in every cell its bounds touch. Moving a
+// proxy only rewrites cell lists when it crosses a cell boundary.
+// Queries return the userData given at insert time (an Entity, an index...).
+class SpatialHash {
+public:
+    // Cells should be about the size of a typical object
+    explicit SpatialHash(float cellSize = 64.0f);
+
+    // Prevent copying
+    SpatialHash(const SpatialHash&) = delete;
+    SpatialHash& operator=(const SpatialHash&) = delete;
+
+    // Returns a proxy id used to move or remove the object later
+    int insert(const Rect& bounds, Uint32 userData);
+    void move(int proxy, const Rect& bounds);
+    void remove(int proxy);
+    void clear();
+
+    // Drop cells left empty by moving objects; their lists are kept otherwise
+    // so objects going back and forth don't allocate
+    void shrink();
+
+    const Rect& getBounds(int proxy) const { return proxies[proxy].bounds; }
+    Uint32 getUserData(int proxy) const { return proxies[proxy].userData; }
+    float getCellSize() const { return cellSize; }
+    size_t size() const { return proxyCount; }
+    size_t getCellCount() const { return cells.size(); }
+
+    // Queries append to out and report each object once
+    void queryRect(const Rect& area, std::vector<Uint32>& out) const;
+    void queryPoint(const Vector2& point, std::vector<Uint32>& out) const;
+    void queryRadius(const Vector2& center, float radius, std::vector<Uint32>& out) const;
+
+    // Nearest object hit within maxDistance, which must be finite
+    bool raycast(const Vector2& origin, const Vector2& direction, float maxDistance, RayHit& hit) const;
+    // Every object hit within maxDistance, sorted nearest first
+    void raycastAll(const Vector2& origin, const Vector2& direction, float maxDistance, std::vector<RayHit>& out) const;
+
+    // Every pair of overlapping objects, once each
+    void queryPairs(std::vector<std::pair<Uint32, Uint32>>& out) const;
+
+private:
+    struct Proxy {
+        Rect bounds;
+        Uint32 userData;
+        int minX, minY, maxX, maxY; // Covered cell range, inclusive
+        mutable Uint32 stamp;       // Last query that visited it
+        bool alive;
+    };
+
+    struct CellRange {
+        int minX, minY, maxX, maxY;
+    };
+
+    static Uint64 cellKey(int x, int y) {
+        return (static_cast<Uint64>(static_cast<Uint32>(x)) << 32) | static_cast<Uint32>(y);
+    }
+
+    int cellCoord(float value) const;
+    CellRange rangeOf(const Rect& bounds) const;
+    void addToCells(int proxy, const CellRange& range, const CellRange* skip);
+    void removeFromCells(int proxy, const CellRange& range, const CellRange* skip);
+    Uint32 nextStamp() const;
+
+    // Walk the cells along a ray; stops early when visit returns false
+    template <typename Visit>
+    void traverseRay(const Vector2& origin, const Vector2& direction, float maxDistance, Visit visit) const;
+
+    float cellSize;
+    float inverseCellSize;
+    std::unordered_map<Uint64, std::vector<int>> cells;
+    std::vector<Proxy> proxies;
+    std::vector<int> freeProxies;
+    size_t proxyCount;
+    mutable Uint32 stampCounter;
+};
+
+} // namespace ContextEngine
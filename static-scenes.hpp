@@ -0,0 +1,345 @@
+#pragma once
+
+#include "context-engine.hpp"
+
+#include <functional>
+#include <memory>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+namespace ContextEngine {
+
+// Whether Hook<T> is a valid expression for T
+template <typename T, template <typename> class Hook, typename = void>
+struct HasHook : std::false_type {};
+
+template <typename T, template <typename> class Hook>
+struct HasHook<T, Hook, std::void_t<Hook<T>>> : std::true_type {};
+
+namespace EventRoutes {
+
+// One SDL event type and the member function that takes it
+#define CONTEXT_ENGINE_EVENT_ROUTE(Name, EventType, Method, Field)                                 \
+    struct Name {                                                                                 \
+        static constexpr Uint32 type = EventType;                                                 \
+        template <typename T>                                                                     \
+        using Hook = decltype(std::declval<T&>().Method(std::declval<const SDL_Event&>().Field)); \
+        template <typename T>                                                                     \
+        static void call(T& handler, const SDL_Event& event) { handler.Method(event.Field); }     \
+    };
+
+CONTEXT_ENGINE_EVENT_ROUTE(KeyDown, SDL_KEYDOWN, onKeyDown, key)
+CONTEXT_ENGINE_EVENT_ROUTE(KeyUp, SDL_KEYUP, onKeyUp, key)
+CONTEXT_ENGINE_EVENT_ROUTE(TextInput, SDL_TEXTINPUT, onTextInput, text)
+CONTEXT_ENGINE_EVENT_ROUTE(MouseMotion, SDL_MOUSEMOTION, onMouseMotion, motion)
+CONTEXT_ENGINE_EVENT_ROUTE(MouseButtonDown, SDL_MOUSEBUTTONDOWN, onMouseButtonDown, button)
+CONTEXT_ENGINE_EVENT_ROUTE(MouseButtonUp, SDL_MOUSEBUTTONUP, onMouseButtonUp, button)
+CONTEXT_ENGINE_EVENT_ROUTE(MouseWheel, SDL_MOUSEWHEEL, onMouseWheel, wheel)
+CONTEXT_ENGINE_EVENT_ROUTE(FingerDown, SDL_FINGERDOWN, onFingerDown, tfinger)
+CONTEXT_ENGINE_EVENT_ROUTE(FingerUp, SDL_FINGERUP, onFingerUp, tfinger)
+CONTEXT_ENGINE_EVENT_ROUTE(FingerMotion, SDL_FINGERMOTION, onFingerMotion, tfinger)
+CONTEXT_ENGINE_EVENT_ROUTE(ControllerAxis, SDL_CONTROLLERAXISMOTION, onControllerAxis, caxis)
+CONTEXT_ENGINE_EVENT_ROUTE(ControllerButtonDown, SDL_CONTROLLERBUTTONDOWN, onControllerButtonDown, cbutton)
+CONTEXT_ENGINE_EVENT_ROUTE(ControllerButtonUp, SDL_CONTROLLERBUTTONUP, onControllerButtonUp, cbutton)
+CONTEXT_ENGINE_EVENT_ROUTE(Window, SDL_WINDOWEVENT, onWindowEvent, window)
+CONTEXT_ENGINE_EVENT_ROUTE(User, SDL_USEREVENT, onUserEvent, user)
+
+#undef CONTEXT_ENGINE_EVENT_ROUTE
+
+template <typename T>
+using AnyHook = decltype(std::declval<T&>().onEvent(std::declval<const SDL_Event&>()));
+
+template <typename... Routes>
+struct RouteList {
+    template <typename T>
+    static void route(T& handler, const SDL_Event& event) {
+        (routeOne<Routes>(handler, event), ...);
+    }
+
+    template <typename T>
+    static void subscribe(Scene& scene) {
+        (subscribeOne<Routes, T>(scene), ...);
+    }
+
+private:
+    template <typename Route, typename T>
+    static void routeOne(T& handler, const SDL_Event& event) {
+        if constexpr (HasHook<T, Route::template Hook>::value) {
+            if (event.type == Route::type) {
+                Route::call(handler, event);
+            }
+        }
+    }
+
+    template <typename Route, typename T>
+    static void subscribeOne(Scene& scene) {
+        if constexpr (HasHook<T, Route::template Hook>::value) {
+            scene.subscribeEvent(Route::type);
+        }
+    }
+};
+
+using All = RouteList<KeyDown, KeyUp, TextInput, MouseMotion, MouseButtonDown, MouseButtonUp, MouseWheel, FingerDown,
+                      FingerUp, FingerMotion, ControllerAxis, ControllerButtonDown, ControllerButtonUp, Window, User>;
+
+} // namespace EventRoutes
+
+// Typed event bus. A handler declares the events it wants as plain member
+// functions taking the matching SDL struct, e.g.
+//
+//     void onKeyDown(const SDL_KeyboardEvent& key);
+//     void onMouseMotion(const SDL_MouseMotionEvent& motion);
+//
+// and routeEvent calls them directly, picked at compile time, so event
+// types without one cost nothing. onEvent(const SDL_Event&), if present,
+// gets every event. See EventRoutes for the full list.
+template <typename T>
+inline void routeEvent(T& handler, const SDL_Event& event) {
+    EventRoutes::All::route(handler, event);
+    if constexpr (HasHook<T, EventRoutes::AnyHook>::value) {
+        handler.onEvent(event);
+    }
+}
+
+// Subscribe a scene to exactly the event types T has functions for, so the
+// engine's event filter drops the rest before they are queued
+template <typename T>
+inline void subscribeRoutedEvents(Scene& scene) {
+    if constexpr (HasHook<T, EventRoutes::AnyHook>::value) {
+        scene.subscribeAllEvents();
+    } else {
+        scene.unsubscribeAllEvents();
+        EventRoutes::All::subscribe<T>(scene);
+    }
+}
+
+namespace SceneHooks {
+template <typename T> using OnLoad = decltype(std::declval<T&>().onLoad());
+template <typename T> using OnExit = decltype(std::declval<T&>().onExit());
+template <typename T> using OnPause = decltype(std::declval<T&>().onPause());
+template <typename T> using OnResume = decltype(std::declval<T&>().onResume());
+template <typename T> using Prepare = decltype(std::declval<T&>().prepare());
+template <typename T> using FixedUpdate = decltype(std::declval<T&>().fixedUpdate(0.0f, std::declval<Engine*>()));
+template <typename T> using Update = decltype(std::declval<T&>().update(0.0f, std::declval<Engine*>()));
+template <typename T> using Render = decltype(std::declval<T&>().render(std::declval<OtherCtx*>()));
+template <typename T> using IsAnimating = decltype(std::declval<const T&>().isAnimating());
+template <typename T> using IsOverlay = decltype(std::declval<const T&>().isOverlay());
+} // namespace SceneHooks
+
+// Compile-time scene registry: one engine scene that holds whichever of a
+// fixed set of scene types is showing in a std::variant. The types don't
+// derive from Scene; their hooks are plain member functions with the same
+// names (all optional) plus routeEvent handlers, so every call is a direct,
+// inlinable one. The engine hands over each frame's events in one batch,
+// and only the event types the showing scene handles get past the filter.
+//
+//     StaticScenes<MenuScene, LevelScene>* scenes = ...;
+//     scenes->show<LevelScene>(levelNumber);
+template <typename... Scenes>
+class StaticScenes : public Scene {
+public:
+    StaticScenes() {
+        setBatchedEvents(true);
+        unsubscribeAllEvents();
+    }
+
+    // Replace the showing scene with a new T built from args. Called from
+    // one of the showing scene's own hooks, the switch waits until that hook
+    // returns, since replacing the scene would destroy it mid-call; events
+    // left in the batch then go to the new scene. The last such call wins.
+    template <typename T, typename... Args>
+    void show(Args&&... args) {
+        if (visiting == 0) {
+            replace<T>(std::forward<Args>(args)...);
+            applyPendingShow();
+            return;
+        }
+        auto stored = std::make_shared<std::tuple<std::decay_t<Args>...>>(std::forward<Args>(args)...);
+        pendingShow = [this, stored] {
+            std::apply([this](auto&... values) { replace<T>(std::move(values)...); }, *stored);
+        };
+    }
+
+    // Whether a show from inside a hook is waiting for it to return
+    bool isSwitchPending() const { return static_cast<bool>(pendingShow); }
+
+    // The showing scene if it is a T
+    template <typename T>
+    T* get() { return std::get_if<T>(&active); }
+
+    template <typename T>
+    bool isShowing() const { return std::holds_alternative<T>(active); }
+
+    void onLoad() override {
+        loaded = true;
+        visit([](auto& scene) {
+            if constexpr (HasHook<std::decay_t<decltype(scene)>, SceneHooks::OnLoad>::value) {
+                scene.onLoad();
+            }
+        });
+        applyPendingShow();
+    }
+
+    void onExit() override {
+        visit([](auto& scene) {
+            if constexpr (HasHook<std::decay_t<decltype(scene)>, SceneHooks::OnExit>::value) {
+                scene.onExit();
+            }
+        });
+        loaded = false;
+        applyPendingShow();
+    }
+
+    void onPause() override {
+        visit([](auto& scene) {
+            if constexpr (HasHook<std::decay_t<decltype(scene)>, SceneHooks::OnPause>::value) {
+                scene.onPause();
+            }
+        });
+        applyPendingShow();
+    }
+
+    void onResume() override {
+        visit([](auto& scene) {
+            if constexpr (HasHook<std::decay_t<decltype(scene)>, SceneHooks::OnResume>::value) {
+                scene.onResume();
+            }
+        });
+        applyPendingShow();
+    }
+
+    void handleEvent(const SDL_Event& event) override {
+        handleEventBatch(&event, 1);
+    }
+
+    // One visit per frame, then a direct call per event. A handler that
+    // shows another scene ends the visit, and the rest go to the new one.
+    void handleEventBatch(const SDL_Event* events, size_t count) override {
+        size_t next = 0;
+        while (next < count) {
+            visit([this, events, count, &next](auto& scene) {
+                for (; next < count && !pendingShow; next++) {
+                    routeEvent(scene, events[next]);
+                }
+            });
+            if (!pendingShow) {
+                break;
+            }
+            applyPendingShow();
+        }
+    }
+
+    void fixedUpdate(float fixedDeltaTime, Engine* engine) override {
+        visit([fixedDeltaTime, engine](auto& scene) {
+            if constexpr (HasHook<std::decay_t<decltype(scene)>, SceneHooks::FixedUpdate>::value) {
+                scene.fixedUpdate(fixedDeltaTime, engine);
+            }
+        });
+        applyPendingShow();
+    }
+
+    void update(float deltaTime, Engine* engine) override {
+        visit([deltaTime, engine](auto& scene) {
+            if constexpr (HasHook<std::decay_t<decltype(scene)>, SceneHooks::Update>::value) {
+                scene.update(deltaTime, engine);
+            }
+        });
+        applyPendingShow();
+    }
+
+    void render(OtherCtx* ctx) override {
+        visit([ctx](auto& scene) {
+            if constexpr (HasHook<std::decay_t<decltype(scene)>, SceneHooks::Render>::value) {
+                scene.render(ctx);
+            }
+        });
+        applyPendingShow();
+    }
+
+    bool isAnimating() const override {
+        bool animating = true;
+        visit([&animating](const auto& scene) {
+            if constexpr (HasHook<std::decay_t<decltype(scene)>, SceneHooks::IsAnimating>::value) {
+                animating = scene.isAnimating();
+            }
+        });
+        return animating;
+    }
+
+    bool isOverlay() const override {
+        bool overlay = false;
+        visit([&overlay](const auto& scene) {
+            if constexpr (HasHook<std::decay_t<decltype(scene)>, SceneHooks::IsOverlay>::value) {
+                overlay = scene.isOverlay();
+            }
+        });
+        return overlay;
+    }
+
+private:
+    // Swap in the new scene. Counts as a visit, so hooks it calls that show
+    // yet another scene queue that switch behind this one.
+    template <typename T, typename... Args>
+    void replace(Args&&... args) {
+        visiting++;
+        if (loaded) {
+            std::visit([](auto& scene) {
+                if constexpr (HasHook<std::decay_t<decltype(scene)>, SceneHooks::OnExit>::value) {
+                    scene.onExit();
+                }
+            }, active);
+        }
+        T& scene = active.template emplace<T>(std::forward<Args>(args)...);
+        subscribeRoutedEvents<T>(*this);
+        if constexpr (HasHook<T, SceneHooks::Prepare>::value) {
+            scene.prepare();
+        }
+        if (loaded) {
+            if constexpr (HasHook<T, SceneHooks::OnLoad>::value) {
+                scene.onLoad();
+            }
+        }
+        visiting--;
+    }
+
+    // Run switches shown from inside hooks, once no hook is running
+    void applyPendingShow() {
+        while (visiting == 0 && pendingShow) {
+            std::function<void()> next = std::move(pendingShow);
+            pendingShow = nullptr;
+            next();
+        }
+    }
+
+    // Calls f with the showing scene, if there is one
+    template <typename F>
+    void visit(F&& f) {
+        visiting++;
+        std::visit([&f](auto& scene) {
+            if constexpr (!std::is_same_v<std::decay_t<decltype(scene)>, std::monostate>) {
+                f(scene);
+            }
+        }, active);
+        visiting--;
+    }
+
+    template <typename F>
+    void visit(F&& f) const {
+        std::visit([&f](const auto& scene) {
+            if constexpr (!std::is_same_v<std::decay_t<decltype(scene)>, std::monostate>) {
+                f(scene);
+            }
+        }, active);
+    }
+
+    std::variant<std::monostate, Scenes...> active;
+    bool loaded = false;
+
+    // Hooks of the showing scene running right now, and a show made from one
+    int visiting = 0;
+    std::function<void()> pendingShow;
+};
+
+} // namespace ContextEngine
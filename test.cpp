@@ -21,11 +21,39 @@ class GameScene;
 Engine* g_engine = nullptr;
 #endif
 
+// Index of the pause menu scene, pushed over the game with P
+int g_pauseScene = -1;
+
+// Pause menu drawn over the frozen game until P is pressed again
+class PauseScene : public Scene {
+public:
+    void update(float deltaTime, Engine* engine) override {
+        if (engine->wasKeyPressed(SDL_SCANCODE_P)) {
+            engine->popScene();
+        } else if (engine->isKeyPressed(SDL_SCANCODE_ESCAPE)) {
+            engine->quit();
+        }
+    }
+    
+    void render(OtherCtx* ctx) override {
+        // The game left its camera behind
+        ctx->setCameraPosition(Vector2(0, 0));
+        ctx->setCameraZoom(1.0f);
+        ctx->drawRect(300, 250, 200, 100, Color(20, 20, 30));
+        ctx->drawRectOutline(300, 250, 200, 100, Color(255, 255, 255));
+        ctx->drawText("Paused", 360, 285, Color(255, 255, 255));
+    }
+    
+    bool isOverlay() const override { return true; }
+    bool isAnimating() const override { return false; }
+};
+
 // Example game scene to demonstrate the Context Engine features
 class GameScene : public Scene {
 private:
     // Game state
     Vector2 windowSize;
+    std::string windowSizeLabel; // Rebuilt only on resize so frames don't allocate
     float playerX = 400;
     float playerY = 300;
     float playerSpeed = 200.0f;
@@ -33,14 +61,29 @@ private:
     
     // Objects to draw
     Rect playerRect = Rect(playerX, playerY, 50, 50);
-    std::vector<Rect> blocks;
+    Registry world;
+    std::vector<Entity> blocks;
+    GeometryBatch shapeBatch;
+    SpatialHash blockIndex = SpatialHash(128.0f);
+    std::vector<int> blockProxies;
+    std::vector<Uint32> visibleBlocks;
     
-    // Random block colors
-    std::vector<Color> blockColors;
+    // Collision against the screen edges and the blocks
+    PhysicsWorld physics;
+    int playerBody = -1;
+    std::vector<int> blockBodies;
+    
+    // Checkered floor under the whole world
+    Tilemap floor = Tilemap(63, 63, 32.0f);
+    
+    // Exhaust trail behind the player
+    ParticleSystem trail = ParticleSystem(4000);
+    int trailEmitter = -1;
 
     // Since the render method doesn't have access to the engine, we'll store mouse position in our class
     int lastMouseX = 0;
     int lastMouseY = 0;
+    Engine* engine = nullptr; // For late latched input while rendering
 
     // Camera zoom control
     float cameraZoom = 1.0f;
@@ -53,13 +96,68 @@ public:
         // Create some blocks with random colors
         for (int i = 0; i < 5; i++) {
             float x = 100.0f + i * 120.0f;
-            blocks.push_back(Rect(x, 200, 80, 80));
+            Entity block = world.create();
+            world.emplace<Transform>(block, Vector2(x + 40, 240));
+            world.emplace<Shape>(block, Shape::roundedRect(80, 80, 10));
             
             // Generate a random color
             Uint8 r = rand() % 256;
             Uint8 g = rand() % 256;
             Uint8 b = rand() % 256;
-            blockColors.push_back(Color(r, g, b));
+            world.emplace<Color>(block, r, g, b);
+            blocks.push_back(block);
+            blockProxies.push_back(blockIndex.insert(Rect(x, 200, 80, 80), block));
+            
+            // Blocks are moved by the scene and push the player out of the way
+            BodyDef blockDef;
+            blockDef.type = BodyType::Kinematic;
+            blockDef.position = Vector2(x + 40, 240);
+            blockDef.halfExtents = Vector2(40, 40);
+            blockBodies.push_back(physics.createBody(blockDef));
+        }
+        
+        // Walls just outside the 800x600 play area
+        BodyDef wallDef;
+        wallDef.type = BodyType::Static;
+        wallDef.halfExtents = Vector2(450, 50);
+        wallDef.position = Vector2(400, -50);
+        physics.createBody(wallDef);
+        wallDef.position = Vector2(400, 650);
+        physics.createBody(wallDef);
+        wallDef.halfExtents = Vector2(50, 350);
+        wallDef.position = Vector2(-50, 300);
+        physics.createBody(wallDef);
+        wallDef.position = Vector2(850, 300);
+        physics.createBody(wallDef);
+        
+        BodyDef playerDef;
+        playerDef.position = Vector2(playerX + 25, playerY + 25);
+        playerDef.halfExtents = Vector2(25, 25);
+        playerDef.friction = 0.0f;
+        playerBody = physics.createBody(playerDef);
+        
+        // Sparks that shrink and fade from orange to transparent red
+        EmitterSettings sparks;
+        sparks.rate = 400.0f;
+        sparks.minLifetime = 0.4f;
+        sparks.maxLifetime = 0.9f;
+        sparks.minSpeed = 20.0f;
+        sparks.maxSpeed = 80.0f;
+        sparks.direction = 1.5707964f;
+        sparks.spread = 1.2f;
+        sparks.spawnRadius = 8.0f;
+        sparks.size = Curve<float>(6.0f, 1.0f);
+        sparks.color = Curve<Color>(Color(255, 200, 60), Color(255, 40, 0, 0));
+        trailEmitter = trail.addEmitter(sparks);
+        trail.setGravity(Vector2(0, 60));
+        trail.setDrag(1.5f);
+        
+        floor.setTileColor(1, Color(48, 48, 70));
+        floor.setTileColor(2, Color(54, 54, 78));
+        for (int y = 0; y < floor.getHeight(); y++) {
+            for (int x = 0; x < floor.getWidth(); x++) {
+                floor.setTile(x, y, (x + y) % 2 ? 2 : 1);
+            }
         }
     }
     
@@ -75,41 +173,56 @@ public:
         // Handle additional scene-specific events here
     }
     
-    void update(float deltaTime, Engine* engine) override {
-        // Store mouse position for rendering
-        lastMouseX = engine->getMouseX();
-        lastMouseY = engine->getMouseY();
-        
+    void fixedUpdate(float fixedDeltaTime, Engine* engine) override {
         // Player movement based on arrow keys
+        Vector2 velocity(0, 0);
         if (engine->isKeyPressed(SDL_SCANCODE_LEFT)) {
-            playerX -= playerSpeed * deltaTime;
+            velocity.x -= playerSpeed;
         }
         if (engine->isKeyPressed(SDL_SCANCODE_RIGHT)) {
-            playerX += playerSpeed * deltaTime;
+            velocity.x += playerSpeed;
         }
         if (engine->isKeyPressed(SDL_SCANCODE_UP)) {
-            playerY -= playerSpeed * deltaTime;
+            velocity.y -= playerSpeed;
         }
         if (engine->isKeyPressed(SDL_SCANCODE_DOWN)) {
-            playerY += playerSpeed * deltaTime;
+            velocity.y += playerSpeed;
         }
+        physics.setVelocity(playerBody, velocity);
         
-        // Update player rectangle position
+        // The walls keep the player on screen, the blocks push it around
+        physics.step(fixedDeltaTime);
+        
+        Vector2 center = physics.getPosition(playerBody);
+        playerX = center.x - playerRect.w / 2;
+        playerY = center.y - playerRect.h / 2;
         playerRect.x = playerX;
         playerRect.y = playerY;
         
-        // Keep player within the screen bounds
-        if (playerRect.x < 0) playerRect.x = 0;
-        if (playerRect.y < 0) playerRect.y = 0;
-        if (playerRect.x + playerRect.w > 800) playerRect.x = 800 - playerRect.w;
-        if (playerRect.y + playerRect.h > 600) playerRect.y = 600 - playerRect.h;
+        trail.setEmitterPosition(trailEmitter, Vector2(center.x, center.y + playerRect.h / 2));
+        trail.update(fixedDeltaTime);
+    }
+    
+    void update(float deltaTime, Engine* engine) override {
+        this->engine = engine;
+        
+        // Store mouse position for rendering
+        lastMouseX = engine->getMouseX();
+        lastMouseY = engine->getMouseY();
         
         // Animate blocks (move up and down)
         for (size_t i = 0; i < blocks.size(); i++) {
-            blocks[i].y = 200 + sinf(engine->getMouseX() * 0.01f + i) * 50;
+            Vector2& center = world.get<Transform>(blocks[i]).position;
+            center.y = 240 + sinf(engine->getMouseX() * 0.01f + i) * 50;
+            blockIndex.move(blockProxies[i], Rect(center.x - 40, center.y - 40, 80, 80));
+            physics.setPosition(blockBodies[i], center);
         }
 
-        windowSize = engine->getWindowSize();
+        Vector2 newSize = engine->getWindowSize();
+        if (windowSizeLabel.empty() || newSize.x != windowSize.x || newSize.y != windowSize.y) {
+            windowSize = newSize;
+            windowSizeLabel = std::to_string(windowSize.x) + "x" + std::to_string(windowSize.y);
+        }
 
         // Toggle zoom with Z key
         if (engine->isKeyPressed(SDL_SCANCODE_Z)) {
@@ -127,6 +240,11 @@ public:
             cameraZoom = std::max(cameraZoom - ZOOM_SPEED * deltaTime, targetZoom);
         }
         
+        // Pause with P; the game freezes under the menu
+        if (engine->wasKeyPressed(SDL_SCANCODE_P)) {
+            engine->pushScene(g_pauseScene);
+        }
+        
         // Exit on ESC key
         if (engine->isKeyPressed(SDL_SCANCODE_ESCAPE)) {
             engine->quit();
@@ -141,17 +259,30 @@ public:
         // Draw the background
         ctx->clear(Color(40, 40, 60));
         
+        // Only the floor chunks in view are drawn
+        floor.render(*ctx);
+        
         // Draw a large world boundary
         ctx->drawRectLines(0, 0, 2000, 2000, Color(100, 100, 100));
         
-        // Draw blocks with rounded corners
-        for (size_t i = 0; i < blocks.size(); i++) {
-            // Draw filled rounded rectangle
-            ctx->drawRoundedRect(blocks[i].x, blocks[i].y, blocks[i].w, blocks[i].h, 10, blockColors[i]);
-            // Draw outline with slightly larger radius to prevent gaps
-            ctx->drawRoundedRectLines(blocks[i].x, blocks[i].y, blocks[i].w, blocks[i].h, 10, Color(255, 255, 255));
+        // Draw every block in one batch, then outline the visible ones,
+        // highlighting whichever is under the mouse
+        renderShapes(world, *ctx, shapeBatch);
+        Vector2 worldMouse = ctx->screenToWorld(static_cast<float>(lastMouseX), static_cast<float>(lastMouseY));
+        visibleBlocks.clear();
+        blockIndex.queryPoint(worldMouse, visibleBlocks);
+        Entity hovered = visibleBlocks.empty() ? NullEntity : visibleBlocks.front();
+        visibleBlocks.clear();
+        blockIndex.queryRect(ctx->getViewRect(), visibleBlocks);
+        for (Entity block : visibleBlocks) {
+            Vector2 center = world.get<Transform>(block).position;
+            Color outline = block == hovered ? Color(255, 255, 0) : Color(255, 255, 255);
+            ctx->drawRoundedRectLines(center.x - 40, center.y - 40, 80, 80, 10, outline);
         }
         
+        // The whole trail goes out in one geometry call
+        trail.render(*ctx);
+        
         // Draw player as a triangle
         float centerX = playerRect.x + playerRect.w/2;
         float centerY = playerRect.y + playerRect.h/2;
@@ -173,24 +304,24 @@ public:
         );
         
         // Draw a line from the player to the mouse position
-        // Convert screen mouse coordinates to world coordinates
-        Vector2 cameraPos = ctx->getCameraPosition();
-        float zoom = ctx->getCameraZoom();
-        
-        // Screen to world coordinate conversion:
-        // 1. Divide by zoom to account for scaling
-        // 2. Add camera position to translate to world space
-        float worldMouseX = static_cast<float>(lastMouseX) / zoom + cameraPos.x;
-        float worldMouseY = static_cast<float>(lastMouseY) / zoom + cameraPos.y;
-        
+        // Convert screen mouse coordinates to world coordinates, from the
+        // latched position so the line tracks the cursor without a frame of lag
+        Vector2 latchedMouse = worldMouse;
+        if (engine) {
+            latchedMouse = ctx->screenToWorld(static_cast<float>(engine->getLatchedMouseX()),
+                                              static_cast<float>(engine->getLatchedMouseY()));
+        }
         ctx->drawLine(
             centerX,
             centerY,
-            worldMouseX,
-            worldMouseY,
+            latchedMouse.x,
+            latchedMouse.y,
             Color(255, 255, 0)
         );
         
+        // World space label, stays sharp at every zoom level
+        ctx->drawText("Player", centerX - 24, centerY - size - 30, Color(255, 255, 255));
+        
         // Draw GUI elements (disable camera for these)
         ctx->enableCamera(false);
         
@@ -198,7 +329,7 @@ public:
         ctx->drawRoundedRect(10, 10, 200, 100, 15, Color(0, 0, 0, 200));
         ctx->drawText("Score: 100", 20, 20, Color(255, 255, 255));
         ctx->drawText("Press Z to zoom", 20, 50, Color(255, 255, 255));
-        ctx->drawText(std::to_string(windowSize.x) + "x" + std::to_string(windowSize.y), 20, 80, Color(255, 255, 255));
+        ctx->drawText(windowSizeLabel, 20, 80, Color(255, 255, 255));
         
         // Draw a triangle indicator for zoom level
         float zoomIndicatorX = 20;
@@ -223,16 +354,33 @@ void main_loop() {
         g_engine->handleEvents();
         g_engine->update(1.0f / 60.0f); // Fixed time step for WebAssembly
         g_engine->render();
+        g_engine->endFrame();
     }
 }
 #endif
 
 int main(int argc, char* argv[]) {
-    // Seed the random number generator
-    srand(static_cast<unsigned int>(time(nullptr)));
+    // --record <file> logs this session's input, --replay <file> plays one
+    // back (add --headless to run it without a window)
+    std::string recordPath;
+    std::string replayPath;
+    bool headless = false;
+    bool assertNoAlloc = false;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--record" && i + 1 < argc) {
+            recordPath = argv[++i];
+        } else if (arg == "--replay" && i + 1 < argc) {
+            replayPath = argv[++i];
+        } else if (arg == "--headless") {
+            headless = true;
+        } else if (arg == "--assert-no-alloc") {
+            assertNoAlloc = true;
+        }
+    }
     
     // Create the engine
-    Engine engine("Context Engine Demo", 800, 600);
+    Engine engine("Context Engine Demo", 800, 600, headless);
     
     // Check if SDL was properly initialized
     if (!engine.init()) {
@@ -240,10 +388,37 @@ int main(int argc, char* argv[]) {
         return 1;
     }
     
+    // Glyph atlases start from the baked cache instead of FreeType
+    engine.getContext()->setFontCache("assets/font-cache");
+    
+    // Draw text from distance fields so it scales with the camera without reloading fonts
+    engine.getContext()->setSdfText(true);
+    
+    // Build glyph fields on worker threads so new text never stalls a frame
+    engine.getContext()->setAsyncText(true);
+    
+    // --assert-no-alloc fails the run if a frame allocates after warm-up
+    if (assertNoAlloc) {
+        engine.setAllocationAssert(true);
+    }
+    
+    if (!replayPath.empty() && !engine.startReplay(replayPath)) {
+        return 1;
+    }
+    if (!recordPath.empty() && !engine.startRecording(recordPath)) {
+        return 1;
+    }
+    
+    // Seed the random number generator, from the log when replaying
+    srand(engine.getRandomSeed());
+    
     // Add a scene
     std::unique_ptr<Scene> gameScene = std::make_unique<GameScene>();
     engine.addScene(std::move(gameScene));
     
+    // The pause menu is only built the first time it is shown
+    g_pauseScene = engine.addSceneFactory([] { return std::make_unique<PauseScene>(); });
+    
 #ifdef __EMSCRIPTEN__
     // Store engine pointer for Emscripten main loop
     g_engine = &engine;
@@ -255,7 +430,12 @@ int main(int argc, char* argv[]) {
 #else
     // Start the game loop (native platforms)
     engine.run();
+    
+    // Event to present latency of the session (replays log it with their summary)
+    if (replayPath.empty()) {
+        engine.logInputLatency();
+    }
 #endif
     
-    return 0;
+    return engine.hasAllocationFailure() ? 1 : 0;
 } 
\ No newline at end of file
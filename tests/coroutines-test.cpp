@@ -0,0 +1,137 @@
+#include "coroutines.hpp"
+#include "test-common.hpp"
+
+#include <vector>
+
+using namespace ContextEngine;
+
+namespace {
+
+Task countFrames(int& frames, int count) {
+    for (int i = 0; i < count; i++) {
+        co_await nextFrame();
+        frames++;
+    }
+}
+
+Task sleepThenSet(bool& done, float seconds) {
+    co_await waitSeconds(seconds);
+    done = true;
+}
+
+Task collectKeys(std::vector<Sint32>& keys) {
+    for (;;) {
+        SDL_Event event = co_await waitForEvent(SDL_KEYDOWN);
+        keys.push_back(event.key.keysym.sym);
+    }
+}
+
+Task waitForQuit(bool& quit) {
+    co_await waitForEvent(SDL_QUIT);
+    quit = true;
+}
+
+SDL_Event keyDown(Sint32 key) {
+    SDL_Event event = {};
+    event.type = SDL_KEYDOWN;
+    event.key.keysym.sym = key;
+    return event;
+}
+
+// Frame and time waits resume in the update they are due
+void testFramesAndTime() {
+    TaskScheduler tasks;
+    int frames = 0;
+    bool done = false;
+    TaskId counter = tasks.start(countFrames(frames, 3));
+    tasks.start(sleepThenSet(done, 0.05f));
+    CHECK(tasks.getRunningCount() == 2);
+    CHECK(tasks.needsUpdate());
+
+    tasks.update(0.02f);
+    tasks.update(0.02f);
+    CHECK(frames == 2);
+    CHECK(!done);
+    CHECK(tasks.getTimeToNextWake() > 0.0);
+
+    tasks.update(0.02f);
+    CHECK(frames == 3);
+    CHECK(done);
+    CHECK(!tasks.isRunning(counter));
+    CHECK(tasks.getRunningCount() == 0);
+    CHECK(tasks.getTimeToNextWake() < 0.0);
+}
+
+// Events wake their waiters on the next update, with the event's contents
+void testEvents() {
+    TaskScheduler tasks;
+    std::vector<Sint32> keys;
+    tasks.start(collectKeys(keys));
+    CHECK(tasks.waitsForEventType(SDL_KEYDOWN));
+    Uint64 revision = tasks.getEventRevision();
+
+    tasks.dispatchEvent(keyDown(SDLK_a));
+    CHECK(keys.empty());
+    tasks.update(0.016f);
+    tasks.dispatchEvent(keyDown(SDLK_b));
+    tasks.update(0.016f);
+    CHECK(keys.size() == 2 && keys[0] == SDLK_a && keys[1] == SDLK_b);
+
+    // A task that keeps waiting on the same type doesn't churn the filter
+    CHECK(tasks.waitsForEventType(SDL_KEYDOWN));
+    CHECK(tasks.getEventRevision() == revision);
+}
+
+// Cancelled waiters are pruned even if their event never arrives
+void testCancelledEventWaitsArePruned() {
+    TaskScheduler tasks;
+    bool quit = false;
+    std::vector<Sint32> keys;
+    TaskId quitTask = tasks.start(waitForQuit(quit));
+    TaskId keyTask = tasks.start(collectKeys(keys));
+    CHECK(tasks.waitsForEventType(SDL_QUIT));
+    CHECK(tasks.waitsForEventType(SDL_KEYDOWN));
+
+    CHECK(tasks.cancel(quitTask));
+    CHECK(!tasks.cancel(quitTask));
+    Uint64 revision = tasks.getEventRevision();
+    tasks.update(0.016f);
+    CHECK(!tasks.waitsForEventType(SDL_QUIT));
+    CHECK(tasks.waitsForEventType(SDL_KEYDOWN));
+    CHECK(tasks.getEventRevision() != revision);
+
+    CHECK(tasks.cancel(keyTask));
+    tasks.update(0.016f);
+    CHECK(!tasks.waitsForEventType(SDL_KEYDOWN));
+    CHECK(tasks.getRunningCount() == 0);
+    CHECK(!quit);
+}
+
+// Once the frame pool is warm, starting and finishing tasks takes no chunks
+void testFramesAreReused() {
+    TaskScheduler tasks;
+    int frames = 0;
+    for (int i = 0; i < 64; i++) {
+        tasks.start(countFrames(frames, 1));
+    }
+    tasks.update(0.016f);
+    size_t chunks = TaskFramePool::getHeapAllocations();
+    for (int round = 0; round < 10; round++) {
+        for (int i = 0; i < 64; i++) {
+            tasks.start(countFrames(frames, 1));
+        }
+        tasks.update(0.016f);
+    }
+    CHECK(frames == 64 * 11);
+    CHECK(TaskFramePool::getHeapAllocations() == chunks);
+}
+
+} // namespace
+
+int main() {
+    testFramesAndTime();
+    testEvents();
+    testCancelledEventWaitsArePruned();
+    testFramesAreReused();
+    return TestSupport::finish();
+}
@@ -0,0 +1,128 @@
+#include "ecs.hpp"
+#include "test-common.hpp"
+
+#include <set>
+
+using namespace ContextEngine;
+
+namespace {
+
+struct Position {
+    float x = 0.0f;
+    float y = 0.0f;
+};
+
+struct Velocity {
+    float x = 0.0f;
+    float y = 0.0f;
+};
+
+struct Tag {
+    int value = 0;
+};
+
+// Views visit exactly the entities that have every component
+void testViewIteration() {
+    Registry registry;
+    std::vector<Entity> entities;
+    for (int i = 0; i < 1000; i++) {
+        Entity entity = registry.create();
+        entities.push_back(entity);
+        registry.emplace<Position>(entity, static_cast<float>(i), 0.0f);
+        if (i % 3 == 0) {
+            registry.emplace<Velocity>(entity, 1.0f, 2.0f);
+        }
+    }
+
+    int visited = 0;
+    registry.view<Position>().each([&](Entity, Position&) { visited++; });
+    CHECK(visited == 1000);
+
+    std::set<Entity> seen;
+    registry.view<Position, Velocity>().each([&](Entity entity, Position& position, Velocity& velocity) {
+        CHECK(static_cast<int>(position.x) % 3 == 0);
+        position.x += velocity.x;
+        seen.insert(entity);
+    });
+    CHECK(seen.size() == 334);
+    CHECK(registry.view<Position, Velocity>().sizeHint() == 334);
+
+    // Writes through the view land in the pool
+    CHECK(registry.get<Position>(entities[3]).x == 4.0f);
+    CHECK(registry.get<Position>(entities[4]).x == 4.0f);
+
+    // A type nobody has yields nothing
+    int tagged = 0;
+    registry.view<Position, Tag>().each([&](Entity, Position&, Tag&) { tagged++; });
+    CHECK(tagged == 0);
+}
+
+// Removing swaps the last component into the hole and keeps lookups right
+void testRemoval() {
+    Registry registry;
+    std::vector<Entity> entities;
+    for (int i = 0; i < 100; i++) {
+        Entity entity = registry.create();
+        entities.push_back(entity);
+        registry.emplace<Tag>(entity, i);
+    }
+
+    for (int i = 0; i < 100; i += 2) {
+        registry.remove<Tag>(entities[i]);
+    }
+    registry.remove<Tag>(entities[0]); // Already gone
+
+    ComponentPool<Tag>& pool = registry.storage<Tag>();
+    CHECK(pool.size() == 50);
+    for (int i = 0; i < 100; i++) {
+        Tag* tag = registry.tryGet<Tag>(entities[i]);
+        if (i % 2 == 0) {
+            CHECK(tag == nullptr);
+        } else {
+            CHECK(tag && tag->value == i);
+        }
+    }
+
+    // The dense arrays stay parallel
+    for (size_t i = 0; i < pool.size(); i++) {
+        CHECK(registry.get<Tag>(pool.entityData()[i]).value == pool.data()[i].value);
+    }
+
+    int sum = 0;
+    registry.view<Tag>().each([&](Entity, Tag& tag) { sum += tag.value; });
+    CHECK(sum == 2500); // 1 + 3 + ... + 99
+}
+
+// Destroyed handles go stale even when their slot is reused
+void testDestroyAndReuse() {
+    Registry registry;
+    Entity first = registry.create();
+    registry.emplace<Position>(first, 1.0f, 2.0f);
+    registry.emplace<Tag>(first, 7);
+    registry.destroy(first);
+
+    CHECK(!registry.valid(first));
+    CHECK(registry.size() == 0);
+    CHECK(registry.storage<Position>().size() == 0);
+    CHECK(registry.storage<Tag>().size() == 0);
+
+    Entity second = registry.create();
+    CHECK(entityIndex(second) == entityIndex(first));
+    CHECK(second != first);
+    CHECK(registry.valid(second));
+    CHECK(!registry.has<Position>(second));
+    CHECK(!registry.has<Position>(first));
+
+    registry.clear();
+    CHECK(!registry.valid(second));
+    CHECK(registry.size() == 0);
+}
+
+} // namespace
+
+int main() {
+    testViewIteration();
+    testRemoval();
+    testDestroyAndReuse();
+    return TestSupport::finish();
+}
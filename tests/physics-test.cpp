@@ -0,0 +1,141 @@
+#include "physics.hpp"
+#include "worker-pool.hpp"
+#include "test-common.hpp"
+
+#include <cmath>
+#include <cstring>
+
+using namespace ContextEngine;
+
+namespace {
+
+const float STEP = 1.0f / 60.0f;
+
+int addWall(PhysicsWorld& world, const Vector2& center, const Vector2& halfExtents) {
+    BodyDef wall;
+    wall.type = BodyType::Static;
+    wall.position = center;
+    wall.halfExtents = halfExtents;
+    return world.createBody(wall);
+}
+
+// Bodies moving many times their size per step stop at a thin wall instead
+// of passing through it
+void testFastBodiesDontTunnel() {
+    PhysicsWorld world;
+    addWall(world, Vector2(5.0f, 0.0f), Vector2(0.05f, 10.0f));
+
+    BodyDef circle;
+    circle.shape = BodyShape::Circle;
+    circle.radius = 0.1f;
+    circle.velocity = Vector2(1000.0f, 0.0f); // 16.7 units per step
+    int fast = world.createBody(circle);
+
+    BodyDef box;
+    box.position = Vector2(0.0f, 3.0f);
+    box.halfExtents = Vector2(0.1f, 0.1f);
+    box.velocity = Vector2(600.0f, 0.0f);
+    box.bullet = true;
+    int bullet = world.createBody(box);
+
+    for (int i = 0; i < 30; i++) {
+        world.step(STEP);
+    }
+    CHECK(world.getPosition(fast).x < 5.0f);
+    CHECK(world.getPosition(bullet).x < 5.0f);
+    CHECK(world.getVelocity(fast).x <= 0.0f);
+}
+
+// The time of impact puts the body against the wall on the step it hits
+void testTimeOfImpact() {
+    PhysicsWorld world;
+    addWall(world, Vector2(10.0f, 0.0f), Vector2(0.5f, 5.0f));
+
+    BodyDef box;
+    box.halfExtents = Vector2(0.25f, 0.25f);
+    box.velocity = Vector2(300.0f, 0.0f); // 5 units per step, wall face at 9.5
+    int body = world.createBody(box);
+
+    world.step(STEP);
+    CHECK(std::fabs(world.getPosition(body).x - 5.0f) < 1e-3f);
+    world.step(STEP);
+    float x = world.getPosition(body).x;
+    CHECK(x <= 9.25f + 0.02f && x >= 9.25f - 0.05f);
+}
+
+// A box dropped on the ground comes to rest on it
+void testResting() {
+    PhysicsSettings settings;
+    settings.gravity = Vector2(0.0f, 30.0f);
+    PhysicsWorld world(settings);
+    addWall(world, Vector2(0.0f, 10.0f), Vector2(20.0f, 1.0f)); // Top face at 9
+
+    BodyDef box;
+    box.halfExtents = Vector2(0.5f, 0.5f);
+    int body = world.createBody(box);
+    for (int i = 0; i < 240; i++) {
+        world.step(STEP);
+    }
+    CHECK(std::fabs(world.getPosition(body).y - 8.5f) < 0.05f);
+    CHECK(std::fabs(world.getVelocity(body).y) < 0.5f);
+    CHECK(!world.getContacts().empty());
+}
+
+// A worker pool splits the work without changing the result
+void testWorkersMatchSerial() {
+    WorkerPool pool(3);
+    PhysicsWorld serial;
+    PhysicsWorld parallel;
+    parallel.setWorkerPool(&pool);
+    for (PhysicsWorld* world : {&serial, &parallel}) {
+        addWall(*world, Vector2(0.0f, 40.0f), Vector2(60.0f, 1.0f));
+        for (int i = 0; i < 300; i++) {
+            BodyDef def;
+            def.shape = i % 2 ? BodyShape::Circle : BodyShape::Aabb;
+            def.position = Vector2(static_cast<float>(i % 30) * 1.5f - 22.0f, static_cast<float>(i / 30) * 1.5f);
+            def.velocity = Vector2(static_cast<float>(i % 7) * 40.0f - 120.0f, static_cast<float>(i % 5) * 50.0f);
+            def.restitution = 0.3f;
+            world->createBody(def);
+        }
+        world->getSettings().gravity = Vector2(0.0f, 20.0f);
+    }
+    for (int i = 0; i < 60; i++) {
+        serial.step(STEP);
+        parallel.step(STEP);
+    }
+    bool same = true;
+    for (int body = 0; body < 301; body++) {
+        Vector2 a = serial.getPosition(body);
+        Vector2 b = parallel.getPosition(body);
+        same = same && std::memcmp(&a, &b, sizeof(Vector2)) == 0;
+    }
+    CHECK(same);
+}
+
+// Destroyed body ids are invalid until reused
+void testDestroy() {
+    PhysicsWorld world;
+    BodyDef def;
+    int first = world.createBody(def);
+    int second = world.createBody(def);
+    CHECK(world.getBodyCount() == 2);
+    world.destroyBody(first);
+    CHECK(!world.isValid(first));
+    CHECK(world.isValid(second));
+    CHECK(world.getBodyCount() == 1);
+
+    std::vector<Uint32> found;
+    world.queryRect(Rect(-1.0f, -1.0f, 2.0f, 2.0f), found);
+    CHECK(found.size() == 1 && found[0] == static_cast<Uint32>(second));
+}
+
+} // namespace
+
+int main() {
+    testFastBodiesDontTunnel();
+    testTimeOfImpact();
+    testResting();
+    testWorkersMatchSerial();
+    testDestroy();
+    return TestSupport::finish();
+}
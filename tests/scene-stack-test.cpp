@@ -0,0 +1,271 @@
+#include "context-engine.hpp"
+#include "test-common.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <thread>
+
+using namespace ContextEngine;
+
+namespace {
+
+const float STEP = 1.0f / 64.0f; // Exact in binary, so frame counts come out even
+
+std::string events;
+
+// Appends its lifecycle calls to events; prepare() waits until released
+class TestScene : public Scene {
+public:
+    explicit TestScene(const std::string& name, bool released = true) : name(name), released(released) {}
+
+    void prepare() override {
+        while (!released) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    void onLoad() override { events += name + ".load "; }
+    void onExit() override { events += name + ".exit "; }
+    void onPause() override { events += name + ".pause "; }
+    void onResume() override { events += name + ".resume "; }
+    void fixedUpdate(float, Engine* engine) override {
+        fixedUpdates++;
+        if (onFixedUpdate) {
+            onFixedUpdate(engine);
+        }
+    }
+    void update(float deltaTime, Engine*) override {
+        updates++;
+        lastDeltaTime = deltaTime;
+    }
+    void handleEvent(const SDL_Event& event) override { events += name + ".event" + std::to_string(event.type) + " "; }
+    void render(OtherCtx*) override { events += name + ".render "; }
+    bool isOverlay() const override { return overlay; }
+
+    std::string name;
+    std::atomic<bool> released;
+    bool overlay = false;
+    int fixedUpdates = 0;
+    int updates = 0;
+    float lastDeltaTime = 0.0f;
+    std::function<void(Engine*)> onFixedUpdate;
+};
+
+std::string takeEvents() {
+    std::string taken = events;
+    events.clear();
+    return taken;
+}
+
+// A switch to a scene still preparing waits for it, keeping the current one
+void testPreloadThenSwitch() {
+    Engine engine("test", 100, 100, true);
+    CHECK(engine.init());
+    TestScene* first = new TestScene("a");
+    engine.addScene(std::unique_ptr<Scene>(first));
+    CHECK(takeEvents() == "a.load ");
+
+    TestScene* second = nullptr;
+    int built = 0;
+    int index = engine.addSceneFactory([&] {
+        built++;
+        auto scene = std::make_unique<TestScene>("b", false);
+        second = scene.get();
+        return scene;
+    });
+    CHECK(built == 0 && engine.getScene(index) == nullptr);
+
+    engine.preloadScene(index);
+    CHECK(built == 1 && !engine.isScenePrepared(index));
+    engine.switchScene(index);
+    engine.update(STEP);
+    CHECK(engine.getCurrentSceneIndex() == 0);
+    CHECK(first->updates == 1);
+
+    second->released = true;
+    for (int i = 0; i < 1000 && engine.getCurrentSceneIndex() != index; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        engine.update(STEP);
+    }
+    CHECK(engine.getCurrentSceneIndex() == index);
+    CHECK(engine.isScenePrepared(index));
+    CHECK(takeEvents() == "a.exit b.load ");
+}
+
+// Reduced background scenes get the fixed steps of the time saved up,
+// frozen ones nothing, and overlays draw over what is under them
+void testBackgroundScenes() {
+    Engine engine("test", 100, 100, true);
+    CHECK(engine.init());
+    engine.setFixedTimestep(STEP);
+    TestScene* bottom = new TestScene("a");
+    TestScene* top = new TestScene("b");
+    top->overlay = true;
+    engine.addScene(std::unique_ptr<Scene>(bottom));
+    engine.addScene(std::unique_ptr<Scene>(top));
+    bottom->setBackgroundUpdate(BackgroundUpdate::Reduced, 8.0f);
+    engine.pushScene(1);
+    CHECK(takeEvents() == "a.load a.pause b.load ");
+
+    for (int i = 0; i < 32; i++) {
+        engine.update(STEP);
+    }
+    CHECK(top->fixedUpdates == 32 && top->updates == 32);
+    CHECK(bottom->fixedUpdates == 32);
+    CHECK(bottom->updates == 4);
+    CHECK(bottom->lastDeltaTime == 8 * STEP);
+
+    engine.render();
+    CHECK(takeEvents() == "a.render b.render ");
+
+    bottom->setBackgroundUpdate(BackgroundUpdate::Freeze);
+    engine.update(1.0f);
+    CHECK(bottom->updates == 4 && bottom->fixedUpdates == 32);
+
+    engine.popScene();
+    CHECK(takeEvents() == "b.exit a.resume ");
+    CHECK(engine.getCurrentSceneIndex() == 0);
+}
+
+// A background scene can add scenes from its hooks, moving the slots its
+// own saved-up time is kept in
+void testBackgroundSceneAddsScenes() {
+    Engine engine("test", 100, 100, true);
+    CHECK(engine.init());
+    engine.setFixedTimestep(STEP);
+    TestScene* bottom = new TestScene("a");
+    engine.addScene(std::unique_ptr<Scene>(bottom));
+    engine.addScene(std::make_unique<TestScene>("b"));
+    bottom->setBackgroundUpdate(BackgroundUpdate::Reduced, 8.0f);
+    engine.pushScene(1);
+    int added = 0;
+    bottom->onFixedUpdate = [&added](Engine* engine) {
+        for (int i = 0; i < 16; i++) {
+            engine->addSceneFactory([] { return std::make_unique<TestScene>("c"); });
+            added++;
+        }
+    };
+
+    for (int i = 0; i < 32; i++) {
+        engine.update(STEP);
+    }
+    CHECK(bottom->fixedUpdates == 32 && bottom->updates == 4);
+    CHECK(added == 32 * 16);
+
+    bottom->setBackgroundUpdate(BackgroundUpdate::Full);
+    engine.update(STEP);
+    CHECK(bottom->fixedUpdates == 33 && bottom->updates == 5);
+    CHECK(engine.getCurrentSceneIndex() == 1);
+    takeEvents();
+}
+
+// A scene built later that never subscribed gets the types the scene before
+// it filtered out
+void testNewSceneGetsEveryEvent() {
+    Engine engine("test", 100, 100, true);
+    CHECK(engine.init());
+    TestScene* first = new TestScene("a");
+    first->subscribeEvent(SDL_KEYDOWN);
+    engine.addScene(std::unique_ptr<Scene>(first));
+    int index = engine.addSceneFactory([] { return std::make_unique<TestScene>("b"); });
+    engine.handleEvents();
+
+    SDL_Event wheel = {};
+    wheel.type = SDL_MOUSEWHEEL;
+    SDL_PushEvent(&wheel);
+    engine.handleEvents();
+    CHECK(takeEvents() == "a.load ");
+
+    engine.switchScene(index);
+    engine.handleEvents();
+    SDL_PushEvent(&wheel);
+    engine.handleEvents();
+    CHECK(takeEvents() == "a.exit b.load b.event" + std::to_string(SDL_MOUSEWHEEL) + " ");
+}
+
+// Records a preload and a pending switch; returns the frame the switch
+// happened on, -1 if never
+int recordSwitch(const std::string& path) {
+    Engine engine("test", 100, 100, true);
+    CHECK(engine.init());
+    engine.addScene(std::make_unique<TestScene>("a"));
+    TestScene* second = new TestScene("b", false);
+    engine.addScene(std::unique_ptr<Scene>(second));
+    CHECK(engine.startRecording(path));
+
+    engine.preloadScene(1);
+    engine.switchScene(1);
+    int switched = -1;
+    for (int frame = 0; frame < 40; frame++) {
+        // The switch stays pending rather than blocking the recording
+        if (frame == 3) {
+            CHECK(engine.getCurrentSceneIndex() == 0);
+            second->released = true;
+        }
+        engine.handleEvents();
+        engine.update(STEP);
+        if (switched < 0 && engine.getCurrentSceneIndex() == 1) {
+            switched = frame;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    engine.stopRecording();
+    takeEvents();
+    return switched;
+}
+
+// Replays the log with a loader that finishes after delay; returns the frame
+// the switch happened on, -1 if never
+int replaySwitch(const std::string& path, int delay) {
+    Engine engine("test", 100, 100, true);
+    CHECK(engine.init());
+    engine.addScene(std::make_unique<TestScene>("a"));
+    TestScene* second = new TestScene("b", delay == 0);
+    engine.addScene(std::unique_ptr<Scene>(second));
+    CHECK(engine.startReplay(path));
+
+    engine.preloadScene(1);
+    engine.switchScene(1);
+    std::thread release([second, delay] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(delay));
+        second->released = true;
+    });
+    int switched = -1;
+    for (int frame = 0; frame < 40; frame++) {
+        engine.handleEvents();
+        engine.update(STEP);
+        if (switched < 0 && engine.getCurrentSceneIndex() == 1) {
+            switched = frame;
+        }
+        if (switched < 0) {
+            CHECK(!engine.isScenePrepared(1));
+        }
+    }
+    release.join();
+    takeEvents();
+    return switched;
+}
+
+// The frame a preloaded scene became ready on is in the log, so a replay
+// switches on the same frame whether its loader is faster or slower
+void testRecordedActivation() {
+    std::string path = (std::filesystem::temp_directory_path() / "context-engine-scene-stack-test.log").string();
+    int recorded = recordSwitch(path);
+    CHECK(recorded >= 3);
+    CHECK(replaySwitch(path, 0) == recorded);
+    CHECK(replaySwitch(path, 50) == recorded);
+    std::filesystem::remove(path);
+}
+
+} // namespace
+
+int main() {
+    testPreloadThenSwitch();
+    testBackgroundScenes();
+    testBackgroundSceneAddsScenes();
+    testNewSceneGetsEveryEvent();
+    testRecordedActivation();
+    return TestSupport::finish();
+}
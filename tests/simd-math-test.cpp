@@ -0,0 +1,115 @@
+#include "simd-math.hpp"
+#include "test-common.hpp"
+
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace ContextEngine;
+
+namespace {
+
+// Odd so every kernel also runs its scalar tail
+const size_t COUNT = 1003;
+
+bool sameBits(const void* a, const void* b, size_t bytes) {
+    return std::memcmp(a, b, bytes) == 0;
+}
+
+struct Inputs {
+    std::vector<Vector2> points;
+    std::vector<Vector2> velocities;
+    std::vector<Rect> rects;
+    Affine2 matrix;
+    Vector2 cameraPos;
+    float zoom;
+    Rect query;
+};
+
+Inputs makeInputs() {
+    // Values spread over many magnitudes so rounding differences would show
+    std::mt19937 random(1234);
+    std::uniform_real_distribution<float> coordinate(-5000.0f, 5000.0f);
+    std::uniform_real_distribution<float> small(-3.7f, 3.7f);
+
+    Inputs inputs;
+    for (size_t i = 0; i < COUNT; i++) {
+        inputs.points.push_back(Vector2(coordinate(random), coordinate(random) * 0.001f));
+        inputs.velocities.push_back(Vector2(small(random) * 100.0f, small(random)));
+        inputs.rects.push_back(Rect(coordinate(random), coordinate(random), std::fabs(small(random)) * 400.0f,
+                                    std::fabs(small(random)) * 400.0f));
+    }
+    inputs.matrix = Affine2::fromTransform(Vector2(13.3f, -7.1f), 0.731f, Vector2(1.7f, 0.3f));
+    inputs.cameraPos = Vector2(123.456f, -789.012f);
+    inputs.zoom = 1.37f;
+    inputs.query = Rect(-1000.0f, -1000.0f, 2500.0f, 1800.0f);
+    return inputs;
+}
+
+struct Outputs {
+    std::vector<Vector2> transformed;
+    std::vector<Vector2> camera;
+    std::vector<Vector2> integrated;
+    std::vector<Uint8> contained;
+    std::vector<Uint8> overlapping;
+};
+
+Outputs run(const Inputs& inputs) {
+    Outputs outputs;
+    outputs.transformed.resize(COUNT);
+    outputs.camera.resize(COUNT);
+    outputs.contained.resize(COUNT);
+    outputs.overlapping.resize(COUNT);
+    transformPoints(inputs.points.data(), outputs.transformed.data(), COUNT, inputs.matrix);
+    cameraTransformPoints(inputs.points.data(), outputs.camera.data(), COUNT, inputs.cameraPos, inputs.zoom);
+    outputs.integrated = inputs.points;
+    integratePositions(outputs.integrated.data(), inputs.velocities.data(), COUNT, 1.0f / 60.0f);
+    containsPoints(inputs.query, inputs.points.data(), COUNT, outputs.contained.data());
+    overlapRects(inputs.rects.data(), COUNT, inputs.query, outputs.overlapping.data());
+    return outputs;
+}
+
+// Every level the build and CPU support matches the scalar kernels bit for bit
+void testLevelsMatchScalar() {
+    Inputs inputs = makeInputs();
+    setSimdLevel(SimdLevel::Scalar);
+    CHECK(getSimdLevel() == SimdLevel::Scalar);
+    Outputs reference = run(inputs);
+
+    const SimdLevel levels[] = {SimdLevel::Sse2, SimdLevel::Avx2, SimdLevel::Neon, SimdLevel::Wasm};
+    for (SimdLevel level : levels) {
+        setSimdLevel(level);
+        if (getSimdLevel() != level) {
+            continue; // Not available here
+        }
+        std::printf("checking %s\n", getSimdLevelName(level));
+        Outputs outputs = run(inputs);
+        CHECK(sameBits(outputs.transformed.data(), reference.transformed.data(), COUNT * sizeof(Vector2)));
+        CHECK(sameBits(outputs.camera.data(), reference.camera.data(), COUNT * sizeof(Vector2)));
+        CHECK(sameBits(outputs.integrated.data(), reference.integrated.data(), COUNT * sizeof(Vector2)));
+        CHECK(outputs.contained == reference.contained);
+        CHECK(outputs.overlapping == reference.overlapping);
+    }
+}
+
+// The one-point functions the draw calls use agree with the batch kernels
+void testSinglePointMatchesBatch() {
+    Inputs inputs = makeInputs();
+    setSimdLevel(SimdLevel::Avx2); // Falls back to the best level available
+    Outputs batch = run(inputs);
+    for (size_t i = 0; i < COUNT; i++) {
+        Vector2 transformed = transformPoint(inputs.points[i], inputs.matrix);
+        Vector2 camera = cameraTransformPoint(inputs.points[i], inputs.cameraPos, inputs.zoom);
+        CHECK(sameBits(&transformed, &batch.transformed[i], sizeof(Vector2)));
+        CHECK(sameBits(&camera, &batch.camera[i], sizeof(Vector2)));
+    }
+}
+
+} // namespace
+
+int main() {
+    testLevelsMatchScalar();
+    testSinglePointMatchesBatch();
+    return TestSupport::finish();
+}
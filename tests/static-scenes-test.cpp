@@ -0,0 +1,164 @@
+#include "static-scenes.hpp"
+#include "test-common.hpp"
+
+#include <memory>
+#include <string>
+
+using namespace ContextEngine;
+
+namespace {
+
+std::string events;
+
+struct Menu;
+struct Level;
+struct Everything;
+using Scenes = StaticScenes<Menu, Level, Everything>;
+
+struct Menu {
+    Scenes* owner = nullptr;
+    int* alive = nullptr;
+
+    Menu(Scenes* owner, int* alive) : owner(owner), alive(alive) { (*alive)++; }
+    ~Menu() { (*alive)--; }
+
+    void onKeyDown(const SDL_KeyboardEvent& key); // Shows a Level on enter
+    void onLoad() { events += "menu.load "; }
+    void onExit() { events += "menu.exit "; }
+    bool isAnimating() const { return false; }
+};
+
+struct Level {
+    Scenes* owner = nullptr;
+    int number = 0;
+    std::unique_ptr<int> lives; // Move-only arguments are fine
+
+    Level(Scenes* owner, int number, std::unique_ptr<int> lives)
+        : owner(owner)
+        , number(number)
+        , lives(std::move(lives))
+    {
+    }
+
+    void onKeyDown(const SDL_KeyboardEvent& key) { events += "level.key" + std::to_string(key.keysym.scancode) + " "; }
+    void onMouseMotion(const SDL_MouseMotionEvent&) { events += "level.motion "; }
+    void update(float, Engine*); // Shows the Menu once out of lives
+    void onLoad() { events += "level.load "; }
+    void onExit() { events += "level.exit "; }
+};
+
+struct Everything {
+    void onEvent(const SDL_Event& event) { events += "any" + std::to_string(event.type) + " "; }
+    void onKeyUp(const SDL_KeyboardEvent&) { events += "any.up "; }
+};
+
+// Defined once every scene type is complete, which show needs
+void Menu::onKeyDown(const SDL_KeyboardEvent& key) {
+    events += "menu.key" + std::to_string(key.keysym.scancode) + " ";
+    if (key.keysym.scancode == SDL_SCANCODE_RETURN) {
+        owner->show<Level>(owner, 7, std::make_unique<int>(3));
+        events += "menu.after ";
+    }
+}
+
+void Level::update(float, Engine*) {
+    events += "level.update" + std::to_string(number) + " ";
+    if (--*lives == 0) {
+        static int menus = 0;
+        owner->show<Menu>(owner, &menus);
+        events += "level.after ";
+    }
+}
+
+std::string takeEvents() {
+    std::string taken = events;
+    events.clear();
+    return taken;
+}
+
+SDL_Event keyDown(SDL_Scancode scancode) {
+    SDL_Event event = {};
+    event.type = SDL_KEYDOWN;
+    event.key.keysym.scancode = scancode;
+    return event;
+}
+
+SDL_Event mouseMotion() {
+    SDL_Event event = {};
+    event.type = SDL_MOUSEMOTION;
+    return event;
+}
+
+static_assert(HasHook<Menu, EventRoutes::KeyDown::Hook>::value, "Menu handles key presses");
+static_assert(!HasHook<Menu, EventRoutes::MouseMotion::Hook>::value, "Menu ignores motion");
+
+// Handlers are picked per type and subscriptions follow the showing scene
+void testRoutingAndSubscriptions() {
+    Scenes scenes;
+    int menus = 0;
+    CHECK(scenes.batchesEvents());
+    CHECK(!scenes.wantsEvent(SDL_KEYDOWN));
+
+    scenes.show<Menu>(&scenes, &menus);
+    scenes.onLoad();
+    CHECK(takeEvents() == "menu.load ");
+    CHECK(scenes.wantsEvent(SDL_KEYDOWN) && !scenes.wantsEvent(SDL_MOUSEMOTION));
+    CHECK(!scenes.isAnimating());
+
+    SDL_Event batch[] = {keyDown(SDL_SCANCODE_A), mouseMotion(), keyDown(SDL_SCANCODE_B)};
+    scenes.handleEventBatch(batch, 3);
+    CHECK(takeEvents() == "menu.key4 menu.key5 ");
+
+    scenes.show<Everything>();
+    CHECK(takeEvents() == "menu.exit ");
+    CHECK(menus == 0);
+    CHECK(!scenes.filtersEventTypes());
+    SDL_Event up = {};
+    up.type = SDL_KEYUP;
+    scenes.handleEvent(up);
+    CHECK(takeEvents() == "any.up any769 ");
+}
+
+// A handler that shows another scene finishes before its scene goes away,
+// and the rest of the batch goes to the new scene
+void testShowFromHandler() {
+    Scenes scenes;
+    int menus = 0;
+    scenes.show<Menu>(&scenes, &menus);
+    scenes.onLoad();
+    takeEvents();
+
+    SDL_Event batch[] = {keyDown(SDL_SCANCODE_A), keyDown(SDL_SCANCODE_RETURN), mouseMotion(),
+                         keyDown(SDL_SCANCODE_B)};
+    scenes.handleEventBatch(batch, 4);
+    CHECK(takeEvents() == "menu.key4 menu.key40 menu.after menu.exit level.load level.motion level.key5 ");
+    CHECK(menus == 0);
+    CHECK(!scenes.isSwitchPending());
+    CHECK(scenes.isShowing<Level>());
+    Level* level = scenes.get<Level>();
+    CHECK(level && level->number == 7 && level->lives && *level->lives == 3);
+    CHECK(scenes.wantsEvent(SDL_MOUSEMOTION));
+}
+
+// A show from update waits for update to return
+void testShowFromUpdate() {
+    Scenes scenes;
+    scenes.show<Level>(&scenes, 2, std::make_unique<int>(2));
+    scenes.onLoad();
+    takeEvents();
+
+    scenes.update(0.016f, nullptr);
+    CHECK(takeEvents() == "level.update2 ");
+    scenes.update(0.016f, nullptr);
+    CHECK(takeEvents() == "level.update2 level.after level.exit menu.load ");
+    CHECK(scenes.isShowing<Menu>());
+}
+
+} // namespace
+
+int main() {
+    testRoutingAndSubscriptions();
+    testShowFromHandler();
+    testShowFromUpdate();
+    return TestSupport::finish();
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdio>
+
+// Checks for the behavior tests. A failed CHECK prints where it failed and
+// the test keeps going, so one run reports every failure.
+namespace TestSupport {
+
+inline int& failureCount() {
+    static int count = 0;
+    return count;
+}
+
+// Exit code for main: 0 when every check passed
+inline int finish() {
+    if (failureCount() > 0) {
+        std::printf("%d check(s) failed\n", failureCount());
+        return 1;
+    }
+    return 0;
+}
+
+} // namespace TestSupport
+
+// Variadic so conditions may contain template argument commas
+#define CHECK(...)                                                                      \
+    do {                                                                                \
+        if (!(__VA_ARGS__)) {                                                           \
+            std::printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #__VA_ARGS__); \
+            TestSupport::failureCount()++;                                              \
+        }                                                                               \
+    } while (0)
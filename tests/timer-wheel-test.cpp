@@ -0,0 +1,110 @@
+#include "timer-wheel.hpp"
+#include "test-common.hpp"
+
+#include <algorithm>
+#include <map>
+#include <random>
+#include <vector>
+
+using namespace ContextEngine;
+
+namespace {
+
+// Every timer fires on exactly its tick, in tick order, however far away it
+// was placed and however large the steps time moves in
+void testFiresOnDueTick() {
+    TimerWheel wheel;
+    std::mt19937 random(42);
+    std::uniform_int_distribution<Uint64> nearDelay(1, 5000);
+    std::uniform_int_distribution<Uint64> farDelay(5000, 40000000); // Past the top level too
+
+    std::map<TimerId, Uint64> due;
+    std::vector<Uint64> firedAt;
+    int wrongTick = 0;
+    for (int i = 0; i < 2000; i++) {
+        Uint64 delay = i % 4 == 0 ? farDelay(random) : nearDelay(random);
+        Uint64 when = delay;
+        TimerId id = wheel.schedule(delay, 0, [&wheel, &firedAt, &wrongTick, when] {
+            firedAt.push_back(wheel.getTick());
+            wrongTick += wheel.getTick() != when;
+        });
+        due[id] = when;
+    }
+    CHECK(wheel.getCount() == 2000);
+
+    std::uniform_int_distribution<Uint64> step(1, 100000);
+    while (wheel.getCount() > 0) {
+        // The expiry the idle loop sleeps until is the earliest pending timer
+        Uint64 earliest = TimerWheel::NO_TICK;
+        for (const auto& [id, when] : due) {
+            if (wheel.isScheduled(id)) {
+                earliest = std::min(earliest, when);
+            }
+        }
+        CHECK(wheel.getNextExpiry() == earliest);
+        wheel.advance(wheel.getTick() + step(random));
+    }
+    CHECK(firedAt.size() == 2000);
+    CHECK(wrongTick == 0);
+    CHECK(std::is_sorted(firedAt.begin(), firedAt.end()));
+    CHECK(wheel.getNextExpiry() == TimerWheel::NO_TICK);
+}
+
+// Repeating timers keep their phase and can cancel themselves
+void testRepeatingAndCancel() {
+    TimerWheel wheel;
+    int repeats = 0;
+    TimerId repeating = wheel.schedule(10, 10, [&] { repeats++; });
+    wheel.advance(105);
+    CHECK(repeats == 10);
+    CHECK(wheel.isScheduled(repeating));
+    CHECK(wheel.getNextExpiry() == 110);
+
+    CHECK(wheel.cancel(repeating));
+    CHECK(!wheel.cancel(repeating));
+    CHECK(!wheel.isScheduled(repeating));
+    wheel.advance(1000);
+    CHECK(repeats == 10);
+
+    int selfRuns = 0;
+    TimerId self = 0;
+    self = wheel.schedule(5, 5, [&] {
+        if (++selfRuns == 3) {
+            CHECK(wheel.cancel(self));
+        }
+    });
+    wheel.advance(2000);
+    CHECK(selfRuns == 3);
+    CHECK(wheel.getCount() == 0);
+}
+
+// Ids of fired timers stay dead when their node is reused
+void testStaleIds() {
+    TimerWheel wheel;
+    int runs = 0;
+    TimerId first = wheel.schedule(1, 0, [&] { runs++; });
+    wheel.advance(1);
+    CHECK(runs == 1);
+    CHECK(!wheel.isScheduled(first));
+
+    TimerId second = wheel.schedule(1, 0, [&] { runs++; });
+    CHECK(second != first);
+    CHECK(!wheel.cancel(first));
+    CHECK(wheel.isScheduled(second));
+
+    // Ids from another wheel are never mistaken for this one's
+    TimerWheel tagged(1ull << 63);
+    TimerId other = tagged.schedule(1, 0, [] {});
+    CHECK(!wheel.owns(other));
+    CHECK(!wheel.cancel(other));
+    CHECK(tagged.owns(other));
+}
+
+} // namespace
+
+int main() {
+    testFiresOnDueTick();
+    testRepeatingAndCancel();
+    testStaleIds();
+    return TestSupport::finish();
+}
@@ -0,0 +1,128 @@
+#include "world-stream.hpp"
+#include "test-common.hpp"
+
+#include <chrono>
+#include <filesystem>
+#include <thread>
+#include <vector>
+
+using namespace ContextEngine;
+
+namespace {
+
+const float CHUNK_SIZE = 100.0f;
+const size_t CHUNK_BYTES = 1000;
+
+// A square of chunk files around the origin, every one CHUNK_BYTES long
+std::string makeWorld(int radius) {
+    std::filesystem::path directory = std::filesystem::temp_directory_path() / "context-engine-world-stream-test";
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+    std::vector<Uint8> data(CHUNK_BYTES);
+    for (int y = -radius; y <= radius; y++) {
+        for (int x = -radius; x <= radius; x++) {
+            data[0] = static_cast<Uint8>(x);
+            data[1] = static_cast<Uint8>(y);
+            WorldStream::writeChunk(directory.string(), x, y, data.data(), data.size());
+        }
+    }
+    return directory.string();
+}
+
+Vector2 chunkCenter(int x, int y) {
+    return Vector2((x + 0.5f) * CHUNK_SIZE, (y + 0.5f) * CHUNK_SIZE);
+}
+
+// Run frames with a still camera until the loads have settled
+void settle(WorldStream& stream, const Vector2& camera, int frames = 200) {
+    for (int i = 0; i < frames; i++) {
+        stream.update(camera, Vector2(0.0f, 0.0f));
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+StreamingSettings smallSettings() {
+    StreamingSettings settings;
+    settings.chunkSize = CHUNK_SIZE;
+    settings.loadRadius = 0;
+    settings.prefetchRadius = 2;     // 25 chunks
+    settings.memoryBudget = 5 * CHUNK_BYTES;
+    settings.maxPendingLoads = 4;
+    return settings;
+}
+
+// A prefetch area bigger than the budget fills it once and then stays put
+void testPrefetchDoesNotThrash() {
+    std::string directory = makeWorld(4);
+    WorldStream stream(directory, smallSettings(), 2);
+    int loads = 0;
+    int unloads = 0;
+    stream.setOnLoad([&](const StreamedChunk&) { loads++; });
+    stream.setOnUnload([&](const StreamedChunk&) { unloads++; });
+
+    settle(stream, chunkCenter(0, 0));
+    CHECK(stream.getState(0, 0) == ChunkState::Resident);
+    CHECK(stream.getResidentBytes() <= 5 * CHUNK_BYTES);
+    CHECK(unloads == 0);
+
+    int settledLoads = loads;
+    settle(stream, chunkCenter(0, 0));
+    CHECK(loads == settledLoads);
+    CHECK(unloads == 0);
+    CHECK(stream.getPendingCount() == 0);
+}
+
+// Moving away lets the chunks behind the camera go to make room
+void testMovingEvictsStaleChunks() {
+    std::string directory = makeWorld(4);
+    WorldStream stream(directory, smallSettings(), 2);
+    settle(stream, chunkCenter(-3, 0));
+    CHECK(stream.getState(-3, 0) == ChunkState::Resident);
+
+    settle(stream, chunkCenter(3, 0));
+    CHECK(stream.getState(3, 0) == ChunkState::Resident);
+    CHECK(stream.getState(-3, 0) == ChunkState::Unloaded);
+    CHECK(stream.getResidentBytes() <= 5 * CHUNK_BYTES);
+
+    const StreamedChunk* chunk = stream.getChunk(3, 0);
+    CHECK(chunk && chunk->size == CHUNK_BYTES && chunk->data[0] == 3 && chunk->data[1] == 0);
+}
+
+// Required chunks stay even when they alone exceed the budget
+void testRequiredOverBudget() {
+    std::string directory = makeWorld(3);
+    StreamingSettings settings = smallSettings();
+    settings.loadRadius = 2;
+    WorldStream stream(directory, settings, 2);
+    int unloads = 0;
+    stream.setOnUnload([&](const StreamedChunk&) { unloads++; });
+
+    settle(stream, chunkCenter(0, 0));
+    CHECK(stream.getResidentCount() == 25);
+    CHECK(unloads == 0);
+    CHECK(stream.isAreaReady(Rect(-150.0f, -150.0f, 300.0f, 300.0f)));
+}
+
+// requireArea loads on the calling thread, and missing files are empty world
+void testRequireArea() {
+    std::string directory = makeWorld(1);
+    WorldStream stream(directory, smallSettings(), 1);
+    Rect area(-250.0f, -50.0f, 400.0f, 100.0f); // Chunks -3..1 on row -1..0
+    CHECK(!stream.isAreaReady(area));
+    stream.requireArea(area);
+    CHECK(stream.isAreaReady(area));
+    CHECK(stream.getState(-1, 0) == ChunkState::Resident);
+    CHECK(stream.getState(-3, 0) == ChunkState::Missing);
+    CHECK(stream.getChunk(-3, 0) == nullptr);
+}
+
+} // namespace
+
+int main() {
+    testPrefetchDoesNotThrash();
+    testMovingEvictsStaleChunks();
+    testRequiredOverBudget();
+    testRequireArea();
+    std::filesystem::remove_all(std::filesystem::temp_directory_path() / "context-engine-world-stream-test");
+    return TestSupport::finish();
+}
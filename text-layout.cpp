@@ -0,0 +1,1085 @@
+#include "text-layout.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <thread>
+#include <vector>
+
+namespace ContextEngine {
+
+Uint32 decodeUtf8(const std::string& text, size_t& offset) {
+    const Uint32 replacement = 0xFFFD;
+    unsigned char lead = static_cast<unsigned char>(text[offset++]);
+    if (lead < 0x80) {
+        return lead;
+    }
+
+    int extra;
+    Uint32 codepoint;
+    if ((lead & 0xE0) == 0xC0) {
+        extra = 1;
+        codepoint = lead & 0x1F;
+    } else if ((lead & 0xF0) == 0xE0) {
+        extra = 2;
+        codepoint = lead & 0x0F;
+    } else if ((lead & 0xF8) == 0xF0) {
+        extra = 3;
+        codepoint = lead & 0x07;
+    } else {
+        return replacement;
+    }
+
+    for (int i = 0; i < extra; i++) {
+        if (offset >= text.size()) {
+            return replacement;
+        }
+        unsigned char next = static_cast<unsigned char>(text[offset]);
+        if ((next & 0xC0) != 0x80) {
+            return replacement;
+        }
+        codepoint = (codepoint << 6) | (next & 0x3F);
+        offset++;
+    }
+    return codepoint;
+}
+
+// ShelfPacker implementation
+ShelfPacker::ShelfPacker(int pageSize, int padding)
+    : pageSize(pageSize)
+    , padding(padding)
+    , pageCount(0)
+    , shelfX(0)
+    , shelfY(0)
+    , shelfHeight(0)
+{
+}
+
+void ShelfPacker::reset() {
+    pageCount = 0;
+    shelfX = 0;
+    shelfY = 0;
+    shelfHeight = 0;
+}
+
+void ShelfPacker::skipPages(int count) {
+    pageCount = count;
+    shelfX = 0;
+    shelfY = pageSize; // Full, so the next pack opens a page
+    shelfHeight = 0;
+}
+
+bool ShelfPacker::pack(int width, int height, int& page, SDL_Rect& rect) {
+    if (width + padding > pageSize || height + padding > pageSize) {
+        return false;
+    }
+
+    // Move to the next shelf, or open a new page when this one is full
+    if (pageCount > 0 && shelfX + width + padding > pageSize) {
+        shelfX = 0;
+        shelfY += shelfHeight;
+        shelfHeight = 0;
+    }
+    if (pageCount == 0 || shelfY + height + padding > pageSize) {
+        pageCount++;
+        shelfX = 0;
+        shelfY = 0;
+        shelfHeight = 0;
+    }
+
+    page = pageCount - 1;
+    rect = {shelfX, shelfY, width, height};
+    shelfX += width + padding;
+    shelfHeight = std::max(shelfHeight, height + padding);
+    return true;
+}
+
+// GlyphAtlas implementation
+bool rasterizeGlyph(TTF_Font* font, Uint32 codepoint, GlyphBitmap& bitmap) {
+    bitmap.codepoint = codepoint;
+    bitmap.width = 0;
+    bitmap.height = 0;
+    bitmap.pixels.clear();
+
+    // Render white so the color can be applied per vertex at draw time
+    SDL_Surface* surface = TTF_RenderGlyph32_Blended(font, codepoint, SDL_Color{255, 255, 255, 255});
+    if (!surface) {
+        SDL_Log("Failed to rasterize glyph U+%04X! SDL_ttf Error: %s\n", codepoint, TTF_GetError());
+        return false;
+    }
+
+    SDL_Surface* converted = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_ARGB8888, 0);
+    SDL_FreeSurface(surface);
+    if (!converted) {
+        SDL_Log("Failed to convert glyph surface! SDL Error: %s\n", SDL_GetError());
+        return false;
+    }
+
+    bitmap.width = converted->w;
+    bitmap.height = converted->h;
+    bitmap.pixels.resize(static_cast<size_t>(bitmap.width) * bitmap.height);
+    for (int y = 0; y < bitmap.height; y++) {
+        const Uint32* row = reinterpret_cast<const Uint32*>(static_cast<const Uint8*>(converted->pixels) + y * converted->pitch);
+        std::copy(row, row + bitmap.width, bitmap.pixels.begin() + static_cast<size_t>(y) * bitmap.width);
+    }
+    SDL_FreeSurface(converted);
+    return true;
+}
+
+// AsyncFontSource implementation
+AsyncFontSource::AsyncFontSource(const std::string& path, int pointSize) {
+    font = TTF_OpenFont(path.c_str(), pointSize);
+    if (!font) {
+        SDL_Log("Failed to open font %s for background rasterization! SDL_ttf Error: %s\n", path.c_str(), TTF_GetError());
+    }
+}
+
+AsyncFontSource::~AsyncFontSource() {
+    if (font) {
+        TTF_CloseFont(font);
+    }
+}
+
+std::shared_ptr<AsyncFontSource> AsyncFontSource::acquire() {
+    inFlight++;
+    return std::shared_ptr<AsyncFontSource>(this, [](AsyncFontSource* source) { source->inFlight--; });
+}
+
+void retireFontSource(std::unique_ptr<AsyncFontSource> source, std::vector<std::unique_ptr<AsyncFontSource>>& retired) {
+    if (source) {
+        source->cancelled = true;
+        retired.push_back(std::move(source));
+    }
+}
+
+void releaseFontSources(std::vector<std::unique_ptr<AsyncFontSource>>& retired, bool wait) {
+    if (wait) {
+        for (const auto& source : retired) {
+            while (!source->isIdle()) {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    retired.erase(std::remove_if(retired.begin(), retired.end(),
+        [](const std::unique_ptr<AsyncFontSource>& source) { return source->isIdle(); }),
+        retired.end());
+}
+
+static bool isBlank(Uint32 codepoint) {
+    return codepoint == ' ' || codepoint == '\t' || codepoint == '\n' || codepoint == '\r';
+}
+
+// GlyphAtlas implementation
+GlyphAtlas::GlyphAtlas(SDL_Renderer* renderer, TTF_Font* font)
+    : renderer(renderer)
+    , font(nullptr)
+    , generation(0)
+    , lineHeight(0)
+    , fontHeight(0)
+    , kerningEnabled(false)
+    , packer(PAGE_SIZE)
+    , workers(nullptr)
+    , pendingCount(0)
+    , asyncEpoch(0)
+    , revision(0)
+    , placeholders(true)
+    , placeholderPage(-1)
+    , placeholderRect{0, 0, 0, 0}
+{
+    setFont(font);
+}
+
+GlyphAtlas::~GlyphAtlas() {
+    // Jobs still running write into this atlas, wait for them
+    retireFontSource(std::move(asyncSource), retiredSources);
+    releaseFontSources(retiredSources, true);
+    clear();
+}
+
+void GlyphAtlas::setFont(TTF_Font* newFont) {
+    disableAsync();
+    clear();
+    font = newFont;
+    generation++;
+
+    if (font) {
+        lineHeight = static_cast<float>(TTF_FontLineSkip(font));
+        fontHeight = static_cast<float>(TTF_FontHeight(font));
+        kerningEnabled = TTF_GetFontKerning(font) != 0;
+    } else {
+        lineHeight = 0;
+        fontHeight = 0;
+        kerningEnabled = false;
+    }
+}
+
+void GlyphAtlas::clear() {
+    for (SDL_Texture* page : pages) {
+        SDL_DestroyTexture(page);
+    }
+    pages.clear();
+    packer.reset();
+    placeholderPage = -1;
+    placeholderRect = SDL_Rect{0, 0, 0, 0};
+
+    for (GlyphInfo& info : ascii) {
+        info = GlyphInfo();
+    }
+    extended.clear();
+    kerningPairs.clear();
+    pendingCount = 0;
+}
+
+bool GlyphAtlas::enableAsync(WorkerPool* pool, const std::string& path, int pointSize) {
+    disableAsync();
+
+    // Without worker threads there is nothing to gain
+    if (!pool || pool->getThreadCount() == 0) {
+        return false;
+    }
+
+    auto source = std::make_unique<AsyncFontSource>(path, pointSize);
+    if (!source->font) {
+        return false;
+    }
+    workers = pool;
+    asyncSource = std::move(source);
+    return true;
+}
+
+void GlyphAtlas::disableAsync() {
+    if (!asyncSource) {
+        return;
+    }
+    retireFontSource(std::move(asyncSource), retiredSources);
+    workers = nullptr;
+    asyncEpoch++;
+
+    // Whatever was still pending gets rasterized synchronously on next use
+    if (pendingCount > 0) {
+        auto reset = [](GlyphInfo& info) {
+            if (info.pending) {
+                info.pending = false;
+                info.rasterized = false;
+                info.page = -1;
+            }
+        };
+        for (GlyphInfo& info : ascii) {
+            reset(info);
+        }
+        for (auto& [codepoint, info] : extended) {
+            reset(info);
+        }
+        pendingCount = 0;
+        revision++;
+    }
+}
+
+GlyphInfo& GlyphAtlas::lookup(Uint32 codepoint) {
+    GlyphInfo& info = codepoint < 128 ? ascii[codepoint] : extended[codepoint];
+    if (!info.loaded) {
+        info.loaded = true;
+        int minx, maxx, miny, maxy, advance;
+        if (font && TTF_GlyphMetrics32(font, codepoint, &minx, &maxx, &miny, &maxy, &advance) == 0) {
+            info.advance = static_cast<float>(advance);
+        }
+    }
+    return info;
+}
+
+float GlyphAtlas::getAdvance(Uint32 codepoint) {
+    return lookup(codepoint).advance;
+}
+
+float GlyphAtlas::getKerning(Uint32 left, Uint32 right) {
+    if (!kerningEnabled || !font) {
+        return 0.0f;
+    }
+
+    Uint64 key = (static_cast<Uint64>(left) << 32) | right;
+    auto it = kerningPairs.find(key);
+    if (it != kerningPairs.end()) {
+        return it->second;
+    }
+
+    // Baked caches only store the pairs that are not zero
+    if (lookup(left).baked && lookup(right).baked) {
+        return 0.0f;
+    }
+
+    float kerning = static_cast<float>(TTF_GetFontKerningSizeGlyphs32(font, left, right));
+    kerningPairs.emplace(key, kerning);
+    return kerning;
+}
+
+bool GlyphAtlas::loadCache(const FontCache& cache) {
+    const FontCacheHeader& header = cache.getHeader();
+    if (header.pageSize != PAGE_SIZE) {
+        return false;
+    }
+
+    // Start from an empty atlas; anything in flight for the old glyphs is stale
+    asyncEpoch++;
+    pendingCount = 0;
+    clear();
+    generation++;
+
+    for (Uint32 i = 0; i < header.pageCount; i++) {
+        SDL_Texture* texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888,
+                                                 SDL_TEXTUREACCESS_STATIC, PAGE_SIZE, PAGE_SIZE);
+        if (!texture) {
+            SDL_Log("Failed to create glyph atlas page! SDL Error: %s\n", SDL_GetError());
+            clear();
+            return false;
+        }
+        SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+        SDL_UpdateTexture(texture, nullptr, cache.getPagePixels(static_cast<int>(i)), PAGE_SIZE * sizeof(Uint32));
+        pages.push_back(texture);
+    }
+    packer.skipPages(static_cast<int>(header.pageCount));
+
+    const FontCacheGlyph* glyphs = cache.getGlyphs();
+    for (Uint32 i = 0; i < header.glyphCount; i++) {
+        const FontCacheGlyph& glyph = glyphs[i];
+        GlyphInfo& info = glyph.codepoint < 128 ? ascii[glyph.codepoint] : extended[glyph.codepoint];
+        info.advance = glyph.advance;
+        info.loaded = true;
+        info.rasterized = true;
+        info.baked = true;
+        if (glyph.page >= 0 && glyph.page < static_cast<int>(header.pageCount)) {
+            info.page = glyph.page;
+            info.src = SDL_Rect{glyph.x, glyph.y, glyph.w, glyph.h};
+        }
+    }
+
+    const FontCacheKerning* kerning = cache.getKerning();
+    for (Uint32 i = 0; i < header.kerningCount; i++) {
+        kerningPairs.emplace((static_cast<Uint64>(kerning[i].left) << 32) | kerning[i].right, kerning[i].kerning);
+    }
+
+    return true;
+}
+
+const GlyphInfo& GlyphAtlas::getGlyph(Uint32 codepoint) {
+    GlyphInfo& info = lookup(codepoint);
+    if (!info.rasterized) {
+        if (asyncSource && !isBlank(codepoint)) {
+            queueRasterize(codepoint, info);
+        } else {
+            rasterize(codepoint, info);
+        }
+    }
+    return info;
+}
+
+SDL_Texture* GlyphAtlas::getPageTexture(int page) const {
+    if (page < 0 || page >= static_cast<int>(pages.size())) {
+        return nullptr;
+    }
+    return pages[page];
+}
+
+void GlyphAtlas::rasterize(Uint32 codepoint, GlyphInfo& info) {
+    info.rasterized = true;
+
+    // Whitespace has nothing to draw
+    if (!font || isBlank(codepoint)) {
+        return;
+    }
+
+    GlyphBitmap bitmap;
+    if (rasterizeGlyph(font, codepoint, bitmap)) {
+        store(bitmap, info);
+    }
+}
+
+void GlyphAtlas::queueRasterize(Uint32 codepoint, GlyphInfo& info) {
+    info.rasterized = true;
+    info.pending = true;
+    pendingCount++;
+    if (placeholders) {
+        usePlaceholder(info);
+    }
+
+    std::shared_ptr<AsyncFontSource> source = asyncSource->acquire();
+    CompletionQueue<GlyphBitmap>* queue = &finished;
+    Uint32 epoch = asyncEpoch;
+    workers->submit([source, queue, codepoint, epoch] {
+        if (source->cancelled) {
+            return;
+        }
+
+        GlyphBitmap bitmap;
+        {
+            std::lock_guard<std::mutex> lock(source->fontMutex);
+            rasterizeGlyph(source->font, codepoint, bitmap);
+        }
+        bitmap.epoch = epoch;
+        queue->push(std::move(bitmap));
+    });
+}
+
+size_t GlyphAtlas::processUploads(size_t budgetBytes) {
+    releaseFontSources(retiredSources, false);
+
+    size_t uploaded = 0;
+    bool landed = false;
+    GlyphBitmap bitmap;
+    while ((uploaded == 0 || uploaded < budgetBytes) && finished.pop(bitmap)) {
+        if (bitmap.epoch != asyncEpoch) {
+            continue;
+        }
+
+        GlyphInfo& info = lookup(bitmap.codepoint);
+        if (!info.pending) {
+            continue;
+        }
+        info.pending = false;
+        info.page = -1;
+        pendingCount--;
+
+        store(bitmap, info);
+        uploaded += bitmap.pixels.size() * sizeof(Uint32);
+        landed = true;
+    }
+
+    if (landed) {
+        revision++;
+    }
+    return uploaded;
+}
+
+void GlyphAtlas::store(const GlyphBitmap& bitmap, GlyphInfo& info) {
+    if (bitmap.width <= 0 || bitmap.height <= 0) {
+        return;
+    }
+
+    int page;
+    SDL_Rect rect;
+    if (allocate(bitmap.width, bitmap.height, page, rect)) {
+        SDL_UpdateTexture(pages[page], &rect, bitmap.pixels.data(), bitmap.width * sizeof(Uint32));
+        info.page = page;
+        info.src = rect;
+    }
+}
+
+void GlyphAtlas::usePlaceholder(GlyphInfo& info) {
+    int side = std::max(1, static_cast<int>(std::ceil(fontHeight)));
+
+    // A faint bar across the x-height, reserved once per atlas
+    if (placeholderRect.w == 0) {
+        if (!allocate(side, side, placeholderPage, placeholderRect)) {
+            placeholderRect = SDL_Rect{0, 0, 0, 0};
+            return;
+        }
+        std::vector<Uint32> pixels(static_cast<size_t>(side) * side, 0);
+        for (int y = side * 3 / 10; y < side * 17 / 20; y++) {
+            std::fill(pixels.begin() + static_cast<size_t>(y) * side, pixels.begin() + static_cast<size_t>(y + 1) * side, 0x30FFFFFF);
+        }
+        SDL_UpdateTexture(pages[placeholderPage], &placeholderRect, pixels.data(), side * sizeof(Uint32));
+    }
+
+    // The region is uniform across, so any width up to the side maps 1:1
+    int width = std::max(1, std::min(side, static_cast<int>(info.advance) - 1));
+    info.page = placeholderPage;
+    info.src = SDL_Rect{placeholderRect.x, placeholderRect.y, width, side};
+}
+
+bool GlyphAtlas::allocate(int width, int height, int& page, SDL_Rect& rect) {
+    if (!packer.pack(width, height, page, rect)) {
+        SDL_Log("Glyph of %dx%d does not fit in a %d atlas page!", width, height, PAGE_SIZE);
+        return false;
+    }
+
+    if (page >= static_cast<int>(pages.size())) {
+        SDL_Texture* texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888,
+                                                 SDL_TEXTUREACCESS_STATIC, PAGE_SIZE, PAGE_SIZE);
+        if (!texture) {
+            SDL_Log("Failed to create glyph atlas page! SDL Error: %s\n", SDL_GetError());
+            // The packer already opened the page; open it again next time
+            packer.skipPages(static_cast<int>(pages.size()));
+            return false;
+        }
+        SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+
+        // Start from fully transparent pixels so padding never bleeds into glyphs
+        std::vector<Uint32> blank(PAGE_SIZE * PAGE_SIZE, 0);
+        SDL_UpdateTexture(texture, nullptr, blank.data(), PAGE_SIZE * sizeof(Uint32));
+
+        pages.push_back(texture);
+    }
+    return true;
+}
+
+void appendGlyphQuad(std::vector<SDL_Vertex>& vertices, const GlyphInfo& info, float x, float y, SDL_Color color) {
+    const float invPage = 1.0f / GlyphAtlas::PAGE_SIZE;
+    float x1 = x + info.src.w;
+    float y1 = y + info.src.h;
+    float u0 = info.src.x * invPage;
+    float v0 = info.src.y * invPage;
+    float u1 = (info.src.x + info.src.w) * invPage;
+    float v1 = (info.src.y + info.src.h) * invPage;
+
+    vertices.push_back({SDL_FPoint{x, y}, color, SDL_FPoint{u0, v0}});
+    vertices.push_back({SDL_FPoint{x1, y}, color, SDL_FPoint{u1, v0}});
+    vertices.push_back({SDL_FPoint{x, y1}, color, SDL_FPoint{u0, v1}});
+    vertices.push_back({SDL_FPoint{x1, y1}, color, SDL_FPoint{u1, v1}});
+}
+
+Vector2 measureText(GlyphAtlas& atlas, const std::string& text) {
+    if (text.empty()) {
+        return Vector2(0, 0);
+    }
+
+    float width = 0;
+    float lineWidth = 0;
+    int lineCount = 1;
+    Uint32 previous = 0;
+    size_t offset = 0;
+    while (offset < text.size()) {
+        Uint32 codepoint = decodeUtf8(text, offset);
+        if (codepoint == '\n') {
+            width = std::max(width, lineWidth);
+            lineWidth = 0;
+            lineCount++;
+            previous = 0;
+            continue;
+        }
+        if (previous) {
+            lineWidth += atlas.getKerning(previous, codepoint);
+        }
+        lineWidth += atlas.getAdvance(codepoint);
+        previous = codepoint;
+    }
+    width = std::max(width, lineWidth);
+
+    return Vector2(width, lineCount * atlas.getLineHeight());
+}
+
+// TextLayout implementation
+TextLayout::TextLayout()
+    : atlas(nullptr)
+    , maxWidth(0)
+    , dirty(true)
+    , atlasGeneration(0)
+    , layoutCount(0)
+{
+}
+
+TextLayout::TextLayout(GlyphAtlas* atlas, const std::string& text, float maxWidth)
+    : atlas(atlas)
+    , text(text)
+    , maxWidth(maxWidth)
+    , dirty(true)
+    , atlasGeneration(0)
+    , layoutCount(0)
+{
+}
+
+void TextLayout::setText(const std::string& newText) {
+    if (text != newText) {
+        text = newText;
+        dirty = true;
+    }
+}
+
+void TextLayout::setFont(GlyphAtlas* newAtlas) {
+    if (atlas != newAtlas) {
+        atlas = newAtlas;
+        dirty = true;
+    }
+}
+
+void TextLayout::setMaxWidth(float width) {
+    if (maxWidth != width) {
+        maxWidth = width;
+        dirty = true;
+    }
+}
+
+const std::vector<PositionedGlyph>& TextLayout::getGlyphs() const {
+    ensureLayout();
+    return glyphs;
+}
+
+const std::vector<TextLine>& TextLayout::getLines() const {
+    ensureLayout();
+    return lines;
+}
+
+Vector2 TextLayout::getSize() const {
+    ensureLayout();
+    return size;
+}
+
+float TextLayout::getLineHeight() const {
+    return atlas ? atlas->getLineHeight() : 0.0f;
+}
+
+void TextLayout::ensureLayout() const {
+    if (atlas && atlas->getGeneration() != atlasGeneration) {
+        dirty = true;
+    }
+    if (dirty) {
+        layout();
+        dirty = false;
+    }
+}
+
+void TextLayout::layout() const {
+    glyphs.clear();
+    lines.clear();
+    size = Vector2(0, 0);
+    layoutCount++;
+
+    if (!atlas) {
+        return;
+    }
+    atlasGeneration = atlas->getGeneration();
+
+    const float lineHeight = atlas->getLineHeight();
+    const size_t noBreak = static_cast<size_t>(-1);
+
+    // Close the line [first, end), measuring it without trailing spaces
+    auto finishLine = [&](size_t first, size_t end, float y) {
+        float width = 0;
+        for (size_t i = end; i > first; i--) {
+            const PositionedGlyph& glyph = glyphs[i - 1];
+            if (glyph.codepoint != ' ') {
+                width = glyph.x + glyph.advance;
+                break;
+            }
+        }
+        lines.push_back({first, end - first, y, width});
+        size.x = std::max(size.x, width);
+    };
+
+    size_t lineStart = 0;
+    size_t breakGlyph = noBreak; // First glyph after the last space on this line
+    float penX = 0;
+    float y = 0;
+    Uint32 previous = 0;
+    size_t offset = 0;
+
+    while (offset < text.size()) {
+        size_t glyphOffset = offset;
+        Uint32 codepoint = decodeUtf8(text, offset);
+
+        if (codepoint == '\n') {
+            finishLine(lineStart, glyphs.size(), y);
+            y += lineHeight;
+            lineStart = glyphs.size();
+            breakGlyph = noBreak;
+            penX = 0;
+            previous = 0;
+            continue;
+        }
+
+        float advance = atlas->getAdvance(codepoint);
+        if (previous) {
+            penX += atlas->getKerning(previous, codepoint);
+        }
+
+        // Wrap before this glyph if it would overflow the line
+        if (maxWidth > 0 && codepoint != ' ' && penX + advance > maxWidth && glyphs.size() > lineStart) {
+            size_t wrapAt = (breakGlyph != noBreak && breakGlyph > lineStart) ? breakGlyph : glyphs.size();
+            finishLine(lineStart, wrapAt, y);
+            y += lineHeight;
+
+            // Carry the partial word over to the new line
+            float shift = wrapAt < glyphs.size() ? glyphs[wrapAt].x : penX;
+            for (size_t i = wrapAt; i < glyphs.size(); i++) {
+                glyphs[i].x -= shift;
+                glyphs[i].y = y;
+            }
+            penX -= shift;
+            lineStart = wrapAt;
+            breakGlyph = noBreak;
+        }
+
+        glyphs.push_back({codepoint, penX, y, advance, glyphOffset});
+        penX += advance;
+        previous = codepoint;
+
+        if (codepoint == ' ') {
+            breakGlyph = glyphs.size();
+        }
+    }
+
+    finishLine(lineStart, glyphs.size(), y);
+    size.y = lines.size() * lineHeight;
+}
+
+// EditableText implementation
+EditableText::EditableText()
+    : atlas(nullptr)
+    , maxWidth(0)
+    , cursor(0)
+    , dirty(true)
+    , atlasGeneration(0)
+    , atlasRevision(0)
+    , lastRelayoutLines(0)
+{
+}
+
+EditableText::EditableText(GlyphAtlas* atlas, float maxWidth)
+    : atlas(atlas)
+    , maxWidth(maxWidth)
+    , cursor(0)
+    , dirty(true)
+    , atlasGeneration(0)
+    , atlasRevision(0)
+    , lastRelayoutLines(0)
+{
+}
+
+void EditableText::setFont(GlyphAtlas* newAtlas) {
+    if (atlas != newAtlas) {
+        atlas = newAtlas;
+        dirty = true;
+    }
+}
+
+void EditableText::setMaxWidth(float width) {
+    if (maxWidth != width) {
+        maxWidth = width;
+        dirty = true;
+    }
+}
+
+void EditableText::setText(const std::string& newText, const Color& color) {
+    clear();
+    insert(0, newText, color);
+}
+
+void EditableText::clear() {
+    text.clear();
+    glyphs.clear();
+    lines.clear();
+    cursor = 0;
+    dirty = true;
+}
+
+void EditableText::insert(size_t index, const std::string& str, const Color& color) {
+    if (str.empty()) {
+        return;
+    }
+    index = std::min(index, glyphs.size());
+    size_t byteOffset = index < glyphs.size() ? glyphs[index].byteOffset : text.size();
+
+    pending.clear();
+    size_t offset = 0;
+    while (offset < str.size()) {
+        size_t start = offset;
+        Uint32 codepoint = decodeUtf8(str, offset);
+        float advance = atlas ? atlas->getAdvance(codepoint) : 0.0f;
+        pending.push_back({codepoint, byteOffset + start, 0.0f, advance, color.toSDLColor()});
+    }
+
+    text.insert(byteOffset, str);
+    for (size_t i = index; i < glyphs.size(); i++) {
+        glyphs[i].byteOffset += str.size();
+    }
+    glyphs.insert(glyphs.begin() + index, pending.begin(), pending.end());
+
+    if (cursor >= index) {
+        cursor += pending.size();
+    }
+    relayout(index, index, static_cast<long>(pending.size()));
+}
+
+void EditableText::erase(size_t index, size_t count) {
+    if (index >= glyphs.size() || count == 0) {
+        return;
+    }
+    count = std::min(count, glyphs.size() - index);
+
+    size_t byteStart = glyphs[index].byteOffset;
+    size_t byteEnd = index + count < glyphs.size() ? glyphs[index + count].byteOffset : text.size();
+    size_t byteCount = byteEnd - byteStart;
+
+    text.erase(byteStart, byteCount);
+    glyphs.erase(glyphs.begin() + index, glyphs.begin() + index + count);
+    for (size_t i = index; i < glyphs.size(); i++) {
+        glyphs[i].byteOffset -= byteCount;
+    }
+
+    if (cursor >= index + count) {
+        cursor -= count;
+    } else if (cursor > index) {
+        cursor = index;
+    }
+    relayout(index, index + count, -static_cast<long>(count));
+}
+
+void EditableText::insertAtCursor(const std::string& str, const Color& color) {
+    insert(cursor, str, color);
+}
+
+void EditableText::backspace() {
+    if (cursor > 0) {
+        erase(cursor - 1, 1);
+    }
+}
+
+void EditableText::setCursor(size_t index) {
+    cursor = std::min(index, glyphs.size());
+    if (!dirty) {
+        updateCursor();
+    }
+}
+
+void EditableText::moveCursor(int delta) {
+    if (delta < 0 && static_cast<size_t>(-delta) > cursor) {
+        setCursor(0);
+    } else {
+        setCursor(cursor + delta);
+    }
+}
+
+Vector2 EditableText::getCursorPosition() const {
+    ensureLayout();
+    return cursorPosition;
+}
+
+const std::vector<EditableLine>& EditableText::getLines() const {
+    ensureLayout();
+    return lines;
+}
+
+float EditableText::getLineHeight() const {
+    return atlas ? atlas->getLineHeight() : 0.0f;
+}
+
+Vector2 EditableText::getSize() const {
+    ensureLayout();
+    float width = 0;
+    for (const EditableLine& line : lines) {
+        width = std::max(width, line.width);
+    }
+    return Vector2(width, lines.size() * getLineHeight());
+}
+
+const EditableLine& EditableText::getLineQuads(size_t line) {
+    ensureLayout();
+
+    // Glyphs that finished rasterizing in the background replace their placeholders
+    if (atlas && atlas->getRevision() != atlasRevision) {
+        atlasRevision = atlas->getRevision();
+        for (EditableLine& cached : lines) {
+            cached.quadsValid = false;
+        }
+    }
+
+    EditableLine& entry = lines[line];
+    if (!entry.quadsValid) {
+        buildQuads(entry);
+    }
+    return entry;
+}
+
+void EditableText::ensureLayout() const {
+    if (atlas && atlas->getGeneration() != atlasGeneration) {
+        dirty = true;
+    }
+    if (!dirty) {
+        return;
+    }
+
+    // Full rebuild: refresh metrics and drop every cached line
+    lines.clear();
+    if (atlas) {
+        atlasGeneration = atlas->getGeneration();
+        for (EditableGlyph& glyph : glyphs) {
+            glyph.advance = atlas->getAdvance(glyph.codepoint);
+        }
+    }
+    dirty = false;
+    relayout(0, glyphs.size(), 0);
+}
+
+size_t EditableText::findLine(size_t glyph) const {
+    // Last line starting at or before the glyph
+    size_t low = 0;
+    size_t high = lines.size();
+    while (high - low > 1) {
+        size_t mid = (low + high) / 2;
+        if (lines[mid].firstGlyph <= glyph) {
+            low = mid;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+size_t EditableText::findFirstAffectedLine(size_t glyph) const {
+    // lastMeasured never decreases from one line to the next
+    size_t low = 0;
+    size_t high = lines.size() - 1;
+    while (low < high) {
+        size_t mid = (low + high) / 2;
+        if (lines[mid].lastMeasured < glyph) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+size_t EditableText::layoutLine(size_t first, size_t& lastMeasured, float& width) const {
+    const size_t noBreak = static_cast<size_t>(-1);
+    size_t breakGlyph = noBreak;
+    size_t end = glyphs.size();
+    lastMeasured = glyphs.size();
+    float penX = 0;
+    Uint32 previous = 0;
+
+    for (size_t i = first; i < glyphs.size(); i++) {
+        EditableGlyph& glyph = glyphs[i];
+        if (glyph.codepoint == '\n') {
+            glyph.x = penX;
+            end = i + 1;
+            lastMeasured = i;
+            break;
+        }
+
+        if (previous && atlas) {
+            penX += atlas->getKerning(previous, glyph.codepoint);
+        }
+        if (maxWidth > 0 && glyph.codepoint != ' ' && penX + glyph.advance > maxWidth && i > first) {
+            end = breakGlyph != noBreak ? breakGlyph : i;
+            lastMeasured = i;
+            break;
+        }
+
+        glyph.x = penX;
+        penX += glyph.advance;
+        previous = glyph.codepoint;
+        if (glyph.codepoint == ' ') {
+            breakGlyph = i + 1;
+        }
+    }
+
+    // Trailing spaces and the newline do not count towards the width
+    width = 0;
+    for (size_t i = end; i > first; i--) {
+        const EditableGlyph& glyph = glyphs[i - 1];
+        if (glyph.codepoint != ' ' && glyph.codepoint != '\n') {
+            width = glyph.x + glyph.advance;
+            break;
+        }
+    }
+    return end;
+}
+
+void EditableText::relayout(size_t editStart, size_t oldEditEnd, long delta) const {
+    if (dirty) {
+        // A full rebuild is pending anyway
+        return;
+    }
+
+    // Earlier lines can move their break too when they measured past the edit,
+    // e.g. a short line followed by a long word wrapped across several lines
+    size_t startLine = lines.empty() ? 0 : findFirstAffectedLine(editStart);
+
+    newLines.clear();
+    size_t first = lines.empty() ? 0 : lines[startLine].firstGlyph;
+    size_t oldLine = startLine + 1;
+    size_t replaceEnd = lines.size();
+
+    while (true) {
+        float width;
+        size_t lastMeasured;
+        size_t next = layoutLine(first, lastMeasured, width);
+
+        // Keep the quads of lines that end before the edit and did not move
+        size_t previousIndex = startLine + newLines.size();
+        if (previousIndex < lines.size() && lines[previousIndex].firstGlyph == first &&
+            lines[previousIndex].glyphCount == next - first && next <= editStart) {
+            newLines.push_back(std::move(lines[previousIndex]));
+            newLines.back().lastMeasured = lastMeasured;
+        } else {
+            newLines.push_back({first, next - first, lastMeasured, width, false, {}, {}});
+        }
+
+        if (next >= glyphs.size()) {
+            // A final newline leaves an empty line for the cursor
+            if (next > first && glyphs[next - 1].codepoint == '\n') {
+                newLines.push_back({next, 0, next, 0.0f, false, {}, {}});
+            }
+            break;
+        }
+
+        // Converged once a break lands where an unchanged old line started
+        while (oldLine < lines.size() &&
+               (lines[oldLine].firstGlyph < oldEditEnd || lines[oldLine].firstGlyph + delta < next)) {
+            oldLine++;
+        }
+        if (oldLine < lines.size() && lines[oldLine].firstGlyph + delta == next) {
+            replaceEnd = oldLine;
+            break;
+        }
+        first = next;
+    }
+
+    lastRelayoutLines = newLines.size();
+
+    // Splice the rebuilt lines in and shift the untouched tail
+    if (lines.empty()) {
+        lines.swap(newLines);
+    } else {
+        for (size_t i = replaceEnd; i < lines.size(); i++) {
+            lines[i].firstGlyph += delta;
+            lines[i].lastMeasured += delta;
+        }
+        lines.erase(lines.begin() + startLine, lines.begin() + replaceEnd);
+        lines.insert(lines.begin() + startLine,
+                     std::make_move_iterator(newLines.begin()), std::make_move_iterator(newLines.end()));
+    }
+    newLines.clear();
+
+    updateCursor();
+}
+
+void EditableText::updateCursor() const {
+    if (lines.empty()) {
+        cursorPosition = Vector2(0, 0);
+        return;
+    }
+
+    size_t line = findLine(cursor);
+    const EditableLine& entry = lines[line];
+    float x = 0;
+    if (cursor < entry.firstGlyph + entry.glyphCount) {
+        x = glyphs[cursor].x;
+    } else if (entry.glyphCount > 0) {
+        const EditableGlyph& last = glyphs[entry.firstGlyph + entry.glyphCount - 1];
+        x = last.codepoint == '\n' ? last.x : last.x + last.advance;
+    }
+    cursorPosition = Vector2(x, line * getLineHeight());
+}
+
+void EditableText::buildQuads(EditableLine& line) {
+    line.quads.clear();
+    line.quadPages.clear();
+    line.quadsValid = true;
+    if (!atlas) {
+        return;
+    }
+
+    for (size_t i = line.firstGlyph; i < line.firstGlyph + line.glyphCount; i++) {
+        const EditableGlyph& glyph = glyphs[i];
+        const GlyphInfo& info = atlas->getGlyph(glyph.codepoint);
+        if (info.page < 0) {
+            continue;
+        }
+
+        appendGlyphQuad(line.quads, info, glyph.x, 0.0f, glyph.color);
+        line.quadPages.push_back(info.page);
+    }
+}
+
+} // namespace ContextEngine
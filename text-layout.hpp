@@ -0,0 +1,334 @@
+#pragma once
+
+#include "context-types.hpp"
+#include "worker-pool.hpp"
+#include "font-cache.hpp"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+namespace ContextEngine {
+
+// Metrics and atlas location of a single glyph
+struct GlyphInfo {
+    float advance = 0.0f;          // Horizontal pen advance in pixels
+    int page = -1;                 // Atlas page holding the bitmap, -1 for blank glyphs
+    SDL_Rect src = {0, 0, 0, 0};   // Bitmap region inside the atlas page
+    bool loaded = false;           // Metrics have been queried
+    bool rasterized = false;       // Bitmap has been packed into the atlas
+    bool pending = false;          // Bitmap is still being rasterized by a worker
+    bool baked = false;            // Loaded from a font cache, with its kerning pairs
+};
+
+// A glyph rasterized into CPU memory, ready to be uploaded
+struct GlyphBitmap {
+    Uint32 codepoint = 0;
+    Uint32 epoch = 0;           // Which batch of requests it answers, stale ones are dropped
+    int width = 0;
+    int height = 0;
+    std::vector<Uint32> pixels; // ARGB8888, white with coverage in alpha
+};
+
+// Rasterize one glyph in white; safe to call from any thread that owns the font
+bool rasterizeGlyph(TTF_Font* font, Uint32 codepoint, GlyphBitmap& bitmap);
+
+// A private copy of a font for worker jobs, so rasterization never shares a
+// face with the main thread. Jobs hold it through acquire(), and the owner only
+// destroys it (on the main thread) once no job holds it any more.
+struct AsyncFontSource {
+    TTF_Font* font = nullptr;
+    std::mutex fontMutex;             // One job at a time per face
+    std::atomic<int> inFlight{0};
+    std::atomic<bool> cancelled{false};
+
+    AsyncFontSource(const std::string& path, int pointSize);
+    ~AsyncFontSource();
+
+    // Prevent copying
+    AsyncFontSource(const AsyncFontSource&) = delete;
+    AsyncFontSource& operator=(const AsyncFontSource&) = delete;
+
+    // Handle for one job; released when the job finishes or is dropped
+    std::shared_ptr<AsyncFontSource> acquire();
+    bool isIdle() const { return inFlight.load() == 0; }
+};
+
+// Cancel a source and keep it alive until its jobs have finished
+void retireFontSource(std::unique_ptr<AsyncFontSource> source, std::vector<std::unique_ptr<AsyncFontSource>>& retired);
+// Destroy the retired sources no job references any more; wait for all of them if asked
+void releaseFontSources(std::vector<std::unique_ptr<AsyncFontSource>>& retired, bool wait);
+
+// A glyph placed by TextLayout, relative to the layout origin
+struct PositionedGlyph {
+    Uint32 codepoint;
+    float x, y;
+    float advance;
+    size_t byteOffset; // Offset of the glyph in the source UTF-8 string
+};
+
+// A line produced by TextLayout
+struct TextLine {
+    size_t firstGlyph;
+    size_t glyphCount; // Includes trailing spaces
+    float y;
+    float width;       // Excludes trailing spaces
+};
+
+// Packs rectangles into square pages one shelf (row) at a time
+class ShelfPacker {
+public:
+    explicit ShelfPacker(int pageSize, int padding = 1);
+
+    // Find room for a rectangle; page == getPageCount() - 1 may be a page just opened
+    bool pack(int width, int height, int& page, SDL_Rect& rect);
+    void reset();
+
+    // Continue on a fresh page after count pages that were filled elsewhere
+    void skipPages(int count);
+
+    int getPageSize() const { return pageSize; }
+    int getPageCount() const { return pageCount; }
+
+private:
+    int pageSize;
+    int padding;
+    int pageCount;
+    int shelfX;
+    int shelfY;
+    int shelfHeight;
+};
+
+// Decode one UTF-8 code point starting at offset and advance offset past it.
+// Malformed bytes decode to U+FFFD so layout never stalls.
+Uint32 decodeUtf8(const std::string& text, size_t& offset);
+
+// Caches glyph advances, kerning pairs and rasterized glyphs for one font.
+// Bitmaps are packed into atlas pages so laid out text draws in one batch per page.
+class GlyphAtlas {
+public:
+    static const int PAGE_SIZE = 512;
+
+    GlyphAtlas(SDL_Renderer* renderer, TTF_Font* font);
+    ~GlyphAtlas();
+
+    // Prevent copying
+    GlyphAtlas(const GlyphAtlas&) = delete;
+    GlyphAtlas& operator=(const GlyphAtlas&) = delete;
+
+    // Replace the font (e.g. when it is reloaded), dropping every cached glyph.
+    // Background rasterization is switched off and has to be enabled again.
+    void setFont(TTF_Font* font);
+    TTF_Font* getFont() const { return font; }
+
+    // Bumped whenever cached metrics are invalidated, so layouts know to rebuild
+    Uint32 getGeneration() const { return generation; }
+
+    float getLineHeight() const { return lineHeight; }
+    float getFontHeight() const { return fontHeight; }
+
+    // Metrics only, never rasterizes
+    float getAdvance(Uint32 codepoint);
+    float getKerning(Uint32 left, Uint32 right);
+
+    // Metrics plus atlas region, rasterizing the glyph on first use. With
+    // background rasterization the glyph comes back pending and draws as the
+    // placeholder (or not at all) until processUploads has packed it.
+    const GlyphInfo& getGlyph(Uint32 codepoint);
+
+    // Rasterize new glyphs on a worker pool from a second copy of the font file
+    bool enableAsync(WorkerPool* pool, const std::string& path, int pointSize);
+    void disableAsync();
+    bool isAsync() const { return asyncSource != nullptr; }
+
+    // Replace the cached glyphs with a baked cache for this font; its pages are
+    // uploaded as they are and its glyphs never touch FreeType
+    bool loadCache(const FontCache& cache);
+
+    // Draw a faint box for glyphs still being rasterized (on by default)
+    void setPlaceholders(bool enable) { placeholders = enable; }
+
+    // Upload finished glyphs until about budgetBytes of pixels have been sent,
+    // always at least one. Returns the bytes uploaded.
+    size_t processUploads(size_t budgetBytes);
+    int getPendingCount() const { return pendingCount; }
+
+    // Bumped whenever pending glyphs land, so cached quads know to rebuild
+    Uint32 getRevision() const { return revision; }
+
+    SDL_Texture* getPageTexture(int page) const;
+    int getPageCount() const { return static_cast<int>(pages.size()); }
+
+private:
+    GlyphInfo& lookup(Uint32 codepoint);
+    void rasterize(Uint32 codepoint, GlyphInfo& info);
+    void queueRasterize(Uint32 codepoint, GlyphInfo& info);
+    void store(const GlyphBitmap& bitmap, GlyphInfo& info);
+    void usePlaceholder(GlyphInfo& info);
+    bool allocate(int width, int height, int& page, SDL_Rect& rect);
+    void clear();
+
+    SDL_Renderer* renderer;
+    TTF_Font* font;
+    Uint32 generation;
+    float lineHeight;
+    float fontHeight;
+    bool kerningEnabled;
+
+    // ASCII lives in a flat table, everything else in a map
+    GlyphInfo ascii[128];
+    std::unordered_map<Uint32, GlyphInfo> extended;
+    std::unordered_map<Uint64, float> kerningPairs;
+
+    std::vector<SDL_Texture*> pages;
+    ShelfPacker packer;
+
+    // Background rasterization
+    WorkerPool* workers;
+    std::unique_ptr<AsyncFontSource> asyncSource;
+    std::vector<std::unique_ptr<AsyncFontSource>> retiredSources;
+    CompletionQueue<GlyphBitmap> finished;
+    int pendingCount;
+    Uint32 asyncEpoch;
+    Uint32 revision;
+    bool placeholders;
+    int placeholderPage;
+    SDL_Rect placeholderRect; // Skeleton box, empty until first needed
+};
+
+// Append the four corners of a glyph quad with its top-left at (x, y)
+void appendGlyphQuad(std::vector<SDL_Vertex>& vertices, const GlyphInfo& info, float x, float y, SDL_Color color);
+
+// Measure unwrapped text (newlines start new lines) using cached metrics
+Vector2 measureText(GlyphAtlas& atlas, const std::string& text);
+
+// Wraps a string to a pixel width using the cached metrics of a GlyphAtlas.
+// Line breaks and glyph positions are stored and only recomputed when the
+// text, the font or the width changes.
+class TextLayout {
+public:
+    TextLayout();
+    TextLayout(GlyphAtlas* atlas, const std::string& text, float maxWidth = 0.0f);
+
+    void setText(const std::string& text);
+    void setFont(GlyphAtlas* atlas);
+    void setMaxWidth(float width); // 0 disables wrapping
+
+    const std::string& getText() const { return text; }
+    GlyphAtlas* getFont() const { return atlas; }
+    float getMaxWidth() const { return maxWidth; }
+
+    const std::vector<PositionedGlyph>& getGlyphs() const;
+    const std::vector<TextLine>& getLines() const;
+    Vector2 getSize() const;
+    float getLineHeight() const;
+
+    // Number of times the layout has been rebuilt
+    Uint32 getLayoutCount() const { return layoutCount; }
+
+private:
+    void ensureLayout() const;
+    void layout() const;
+
+    GlyphAtlas* atlas;
+    std::string text;
+    float maxWidth;
+
+    mutable bool dirty;
+    mutable Uint32 atlasGeneration;
+    mutable Uint32 layoutCount;
+    mutable std::vector<PositionedGlyph> glyphs;
+    mutable std::vector<TextLine> lines;
+    mutable Vector2 size;
+};
+
+// A glyph owned by EditableText, positioned relative to its line
+struct EditableGlyph {
+    Uint32 codepoint;
+    size_t byteOffset;
+    float x;
+    float advance;
+    SDL_Color color;
+};
+
+// A line of EditableText with its cached glyph quads
+struct EditableLine {
+    size_t firstGlyph;
+    size_t glyphCount;
+    size_t lastMeasured; // Last glyph looked at to place the break, edits up to it can move the break
+    float width;
+    bool quadsValid;
+    std::vector<SDL_Vertex> quads; // Four vertices per drawn glyph, relative to the line origin
+    std::vector<int> quadPages;    // Atlas page of each quad
+};
+
+// Text buffer for input fields with incremental layout. An edit re-wraps from
+// the line holding the change and stops as soon as a line break lines up with
+// the previous layout again; untouched lines keep their glyph quads.
+class EditableText {
+public:
+    EditableText();
+    EditableText(GlyphAtlas* atlas, float maxWidth = 0.0f);
+
+    void setFont(GlyphAtlas* atlas);
+    void setMaxWidth(float width); // 0 disables wrapping
+    GlyphAtlas* getFont() const { return atlas; }
+    float getMaxWidth() const { return maxWidth; }
+
+    // Editing, indices are in glyphs (code points) rather than bytes
+    void setText(const std::string& text, const Color& color = Color());
+    void insert(size_t index, const std::string& text, const Color& color = Color());
+    void erase(size_t index, size_t count);
+    void clear();
+
+    // Editing at the cursor
+    void insertAtCursor(const std::string& text, const Color& color = Color());
+    void backspace();
+    void setCursor(size_t index);
+    void moveCursor(int delta);
+    size_t getCursor() const { return cursor; }
+
+    // Cursor position relative to the text origin, cached after each edit
+    Vector2 getCursorPosition() const;
+
+    const std::string& getText() const { return text; }
+    size_t getGlyphCount() const { return glyphs.size(); }
+    const std::vector<EditableLine>& getLines() const;
+    float getLineHeight() const;
+    Vector2 getSize() const;
+
+    // Glyph quads of a line relative to its origin, rebuilt only if the line changed
+    const EditableLine& getLineQuads(size_t line);
+
+    // Lines re-wrapped by the most recent edit
+    size_t getLastRelayoutLines() const { return lastRelayoutLines; }
+
+private:
+    void ensureLayout() const;
+    void relayout(size_t editStart, size_t oldEditEnd, long delta) const;
+    size_t layoutLine(size_t first, size_t& lastMeasured, float& width) const;
+    size_t findLine(size_t glyph) const;
+    size_t findFirstAffectedLine(size_t glyph) const;
+    void updateCursor() const;
+    void buildQuads(EditableLine& line);
+
+    GlyphAtlas* atlas;
+    float maxWidth;
+    std::string text;
+    size_t cursor;
+
+    mutable std::vector<EditableGlyph> glyphs;
+    mutable std::vector<EditableLine> lines;
+    mutable std::vector<EditableLine> newLines; // Scratch for relayout
+    std::vector<EditableGlyph> pending;         // Scratch for decoding inserts
+    mutable bool dirty;
+    mutable Uint32 atlasGeneration;
+    Uint32 atlasRevision;
+    mutable size_t lastRelayoutLines;
+    mutable Vector2 cursorPosition;
+};
+
+} // namespace ContextEngine
@@ -0,0 +1,383 @@
+#include "text-view.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+
+namespace ContextEngine {
+
+// PieceTable implementation
+PieceTable::PieceTable()
+    : length(0)
+{
+}
+
+PieceTable::PieceTable(const std::string& text)
+    : length(0)
+{
+    reset(text);
+}
+
+void PieceTable::reset(const std::string& text) {
+    original = text;
+    added.clear();
+    pieces.clear();
+    if (!original.empty()) {
+        pieces.push_back({false, 0, original.size()});
+    }
+    rebuildOffsets();
+}
+
+void PieceTable::rebuildOffsets() {
+    offsets.resize(pieces.size());
+    length = 0;
+    for (size_t i = 0; i < pieces.size(); i++) {
+        offsets[i] = length;
+        length += pieces[i].length;
+    }
+}
+
+size_t PieceTable::findPiece(size_t position) const {
+    // Last piece starting at or before position
+    auto it = std::upper_bound(offsets.begin(), offsets.end(), position);
+    return static_cast<size_t>(it - offsets.begin()) - 1;
+}
+
+void PieceTable::insert(size_t position, const std::string& text) {
+    if (text.empty()) {
+        return;
+    }
+    position = std::min(position, length);
+
+    size_t start = added.size();
+    added += text;
+    Piece piece = {true, start, text.size()};
+
+    if (position == length) {
+        // Typing at the end usually extends the last added piece
+        if (!pieces.empty() && pieces.back().added &&
+            pieces.back().start + pieces.back().length == start) {
+            pieces.back().length += text.size();
+        } else {
+            pieces.push_back(piece);
+        }
+    } else {
+        size_t index = findPiece(position);
+        size_t split = position - offsets[index];
+        if (split == 0) {
+            pieces.insert(pieces.begin() + index, piece);
+        } else {
+            Piece tail = pieces[index];
+            tail.start += split;
+            tail.length -= split;
+            pieces[index].length = split;
+            pieces.insert(pieces.begin() + index + 1, {piece, tail});
+        }
+    }
+    rebuildOffsets();
+}
+
+void PieceTable::erase(size_t position, size_t count) {
+    if (position >= length || count == 0) {
+        return;
+    }
+    size_t end = std::min(position + count, length);
+
+    std::vector<Piece> remaining;
+    remaining.reserve(pieces.size() + 1);
+    for (size_t i = 0; i < pieces.size(); i++) {
+        const Piece& piece = pieces[i];
+        size_t pieceStart = offsets[i];
+        size_t pieceEnd = pieceStart + piece.length;
+
+        if (pieceEnd <= position || pieceStart >= end) {
+            remaining.push_back(piece);
+            continue;
+        }
+
+        // Keep whatever sticks out on either side of the erased range
+        if (pieceStart < position) {
+            remaining.push_back({piece.added, piece.start, position - pieceStart});
+        }
+        if (pieceEnd > end) {
+            remaining.push_back({piece.added, piece.start + (end - pieceStart), pieceEnd - end});
+        }
+    }
+    pieces.swap(remaining);
+    rebuildOffsets();
+}
+
+char PieceTable::at(size_t position) const {
+    if (position >= length) {
+        return '\0';
+    }
+    size_t index = findPiece(position);
+    const Piece& piece = pieces[index];
+    const std::string& buffer = piece.added ? added : original;
+    return buffer[piece.start + (position - offsets[index])];
+}
+
+void PieceTable::read(size_t position, size_t count, std::string& out) const {
+    out.clear();
+    if (position >= length || count == 0) {
+        return;
+    }
+    count = std::min(count, length - position);
+
+    for (size_t index = findPiece(position); index < pieces.size() && out.size() < count; index++) {
+        const Piece& piece = pieces[index];
+        const std::string& buffer = piece.added ? added : original;
+        size_t skip = position > offsets[index] ? position - offsets[index] : 0;
+        size_t take = std::min(piece.length - skip, count - out.size());
+        out.append(buffer, piece.start + skip, take);
+    }
+}
+
+std::string PieceTable::toString() const {
+    std::string text;
+    read(0, length, text);
+    return text;
+}
+
+// TextView implementation
+TextView::TextView()
+    : lineStarts(1, 0)
+    , atlas(nullptr)
+    , atlasGeneration(0)
+    , atlasRevision(0)
+    , scroll(0)
+    , margin(2)
+    , layoutCount(0)
+{
+}
+
+void TextView::setText(const std::string& text) {
+    content.reset(text);
+
+    lineStarts.assign(1, 0);
+    for (size_t i = 0; i < text.size(); i++) {
+        if (text[i] == '\n') {
+            lineStarts.push_back(i + 1);
+        }
+    }
+
+    invalidateFrom(0, true);
+    setScroll(scroll);
+}
+
+bool TextView::loadFile(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        SDL_Log("Failed to open text file %s!", path.c_str());
+        return false;
+    }
+
+    std::ostringstream buffer;
+    buffer << file.rdbuf();
+    setText(buffer.str());
+    return true;
+}
+
+void TextView::insert(size_t position, const std::string& text) {
+    if (text.empty()) {
+        return;
+    }
+    position = std::min(position, content.size());
+    size_t line = static_cast<size_t>(std::upper_bound(lineStarts.begin(), lineStarts.end(), position) - lineStarts.begin()) - 1;
+
+    content.insert(position, text);
+
+    // Shift the following lines, then add one start per inserted newline
+    for (size_t i = line + 1; i < lineStarts.size(); i++) {
+        lineStarts[i] += text.size();
+    }
+    std::vector<size_t> added;
+    for (size_t i = 0; i < text.size(); i++) {
+        if (text[i] == '\n') {
+            added.push_back(position + i + 1);
+        }
+    }
+    lineStarts.insert(lineStarts.begin() + line + 1, added.begin(), added.end());
+
+    invalidateFrom(line, !added.empty());
+}
+
+void TextView::erase(size_t position, size_t count) {
+    if (position >= content.size() || count == 0) {
+        return;
+    }
+    count = std::min(count, content.size() - position);
+    size_t end = position + count;
+    size_t line = static_cast<size_t>(std::upper_bound(lineStarts.begin(), lineStarts.end(), position) - lineStarts.begin()) - 1;
+
+    content.erase(position, count);
+
+    // Drop the starts of lines whose newline was erased and shift the rest
+    auto first = std::upper_bound(lineStarts.begin(), lineStarts.end(), position);
+    auto last = std::upper_bound(first, lineStarts.end(), end);
+    bool joined = first != last;
+    for (auto it = last; it != lineStarts.end(); ++it) {
+        *it -= count;
+    }
+    lineStarts.erase(first, last);
+
+    invalidateFrom(line, joined);
+    setScroll(scroll);
+}
+
+size_t TextView::getLineStart(size_t line) const {
+    return line < lineStarts.size() ? lineStarts[line] : content.size();
+}
+
+void TextView::getLine(size_t line, std::string& out) const {
+    if (line >= lineStarts.size()) {
+        out.clear();
+        return;
+    }
+
+    size_t start = lineStarts[line];
+    size_t end = line + 1 < lineStarts.size() ? lineStarts[line + 1] - 1 : content.size();
+    content.read(start, end - start, out);
+    if (!out.empty() && out.back() == '\r') {
+        out.pop_back();
+    }
+}
+
+void TextView::setFont(GlyphAtlas* newAtlas) {
+    if (atlas != newAtlas) {
+        atlas = newAtlas;
+        invalidateFrom(0, true);
+        resizeCache();
+        setScroll(scroll);
+    }
+}
+
+void TextView::setBounds(const Rect& newBounds) {
+    bounds = newBounds;
+    resizeCache();
+    setScroll(scroll);
+}
+
+void TextView::setMargin(int lines) {
+    margin = std::max(0, lines);
+    resizeCache();
+}
+
+float TextView::getLineHeight() const {
+    return atlas ? atlas->getLineHeight() : 0.0f;
+}
+
+void TextView::setScroll(float offset) {
+    scroll = std::max(0.0f, std::min(offset, getMaxScroll()));
+}
+
+void TextView::scrollToLine(size_t line) {
+    setScroll(line * getLineHeight());
+}
+
+float TextView::getMaxScroll() const {
+    return std::max(0.0f, lineStarts.size() * getLineHeight() - bounds.h);
+}
+
+size_t TextView::getFirstVisibleLine() const {
+    float lineHeight = getLineHeight();
+    if (lineHeight <= 0) {
+        return 0;
+    }
+    size_t first = static_cast<size_t>(scroll / lineHeight);
+    return first > static_cast<size_t>(margin) ? first - margin : 0;
+}
+
+size_t TextView::getVisibleLineCount() const {
+    float lineHeight = getLineHeight();
+    if (lineHeight <= 0) {
+        return 0;
+    }
+    size_t first = getFirstVisibleLine();
+    size_t last = static_cast<size_t>((scroll + bounds.h) / lineHeight) + margin;
+    last = std::min(last, lineStarts.size() - 1);
+    return last >= first ? last - first + 1 : 0;
+}
+
+const TextViewLine& TextView::getLineQuads(size_t line) {
+    if (atlas && (atlas->getGeneration() != atlasGeneration || atlas->getRevision() != atlasRevision)) {
+        // A new generation can come with a new line height (e.g. the atlas
+        // got a font of another size), which changes how many lines are visible
+        bool resized = atlas->getGeneration() != atlasGeneration;
+        atlasGeneration = atlas->getGeneration();
+        atlasRevision = atlas->getRevision();
+        invalidateFrom(0, true);
+        if (resized) {
+            resizeCache();
+            setScroll(scroll);
+        }
+    }
+    if (cache.empty()) {
+        resizeCache();
+    }
+
+    TextViewLine& slot = cache[line % cache.size()];
+    if (!slot.valid || slot.line != line) {
+        layoutLine(line, slot);
+    }
+    return slot;
+}
+
+void TextView::invalidateFrom(size_t line, bool following) {
+    for (TextViewLine& slot : cache) {
+        if (slot.line == line || (following && slot.line > line)) {
+            slot.valid = false;
+        }
+    }
+}
+
+void TextView::resizeCache() {
+    // Enough slots that every line in the visible range maps to its own slot
+    float lineHeight = getLineHeight();
+    size_t rows = lineHeight > 0 ? static_cast<size_t>(std::ceil(bounds.h / lineHeight)) + 1 : 1;
+    size_t size = rows + 2 * margin + 1;
+    if (cache.size() != size) {
+        cache.assign(size, TextViewLine{0, false, {}, {}});
+    }
+}
+
+void TextView::layoutLine(size_t line, TextViewLine& slot) {
+    slot.line = line;
+    slot.valid = true;
+    slot.quads.clear();
+    slot.quadPages.clear();
+    layoutCount++;
+    if (!atlas) {
+        return;
+    }
+
+    getLine(line, lineText);
+
+    const SDL_Color white = {255, 255, 255, 255};
+    float penX = 0;
+    Uint32 previous = 0;
+    size_t offset = 0;
+    while (offset < lineText.size()) {
+        Uint32 codepoint = decodeUtf8(lineText, offset);
+        float advance = codepoint == '\t' ? atlas->getAdvance(' ') * 4 : atlas->getAdvance(codepoint);
+        if (previous) {
+            penX += atlas->getKerning(previous, codepoint);
+        }
+
+        // Anything past the right edge is clipped anyway
+        if (bounds.w > 0 && penX > bounds.w) {
+            break;
+        }
+
+        const GlyphInfo& info = atlas->getGlyph(codepoint);
+        if (info.page >= 0) {
+            appendGlyphQuad(slot.quads, info, penX, 0.0f, white);
+            slot.quadPages.push_back(info.page);
+        }
+        penX += advance;
+        previous = codepoint;
+    }
+}
+
+} // namespace ContextEngine
@@ -0,0 +1,118 @@
+#pragma once
+
+#include "context-types.hpp"
+#include "text-layout.hpp"
+
+#include <string>
+#include <vector>
+
+namespace ContextEngine {
+
+// Text storage for large documents. Edits append to an add buffer and split
+// pieces, so the original text is never copied or moved.
+class PieceTable {
+public:
+    PieceTable();
+    explicit PieceTable(const std::string& text);
+
+    void reset(const std::string& text);
+    void insert(size_t position, const std::string& text);
+    void erase(size_t position, size_t count);
+
+    size_t size() const { return length; }
+    char at(size_t position) const;
+
+    // Copy count bytes starting at position into out (replacing its contents)
+    void read(size_t position, size_t count, std::string& out) const;
+    std::string toString() const;
+
+private:
+    struct Piece {
+        bool added;    // Which buffer the piece points into
+        size_t start;
+        size_t length;
+    };
+
+    size_t findPiece(size_t position) const;
+    void rebuildOffsets();
+
+    std::string original;
+    std::string added;
+    std::vector<Piece> pieces;
+    std::vector<size_t> offsets; // Document offset of each piece
+    size_t length;
+};
+
+// A document line laid out by TextView
+struct TextViewLine {
+    size_t line;                   // Document line held by this cache slot
+    bool valid;
+    std::vector<SDL_Vertex> quads; // Four vertices per drawn glyph, relative to the line origin
+    std::vector<int> quadPages;    // Atlas page of each quad
+};
+
+// Scrollable view over a long document. Content lives in a piece table with a
+// line start index; only the visible lines plus a small margin are laid out,
+// so scrolling costs the same no matter how long the document is.
+class TextView {
+public:
+    TextView();
+
+    // Document
+    void setText(const std::string& text);
+    bool loadFile(const std::string& path);
+    void insert(size_t position, const std::string& text);
+    void erase(size_t position, size_t count);
+    std::string getText() const { return content.toString(); }
+
+    size_t getLineCount() const { return lineStarts.size(); }
+    size_t getLineStart(size_t line) const;
+    void getLine(size_t line, std::string& out) const;
+
+    // Presentation
+    void setFont(GlyphAtlas* atlas);
+    GlyphAtlas* getFont() const { return atlas; }
+    void setBounds(const Rect& bounds);
+    const Rect& getBounds() const { return bounds; }
+    void setMargin(int lines);
+    float getLineHeight() const;
+
+    // Scrolling, in pixels from the top of the document
+    void setScroll(float offset);
+    void scrollBy(float delta) { setScroll(scroll + delta); }
+    void scrollToLine(size_t line);
+    float getScroll() const { return scroll; }
+    float getMaxScroll() const;
+
+    // Range of lines to draw, including the margin
+    size_t getFirstVisibleLine() const;
+    size_t getVisibleLineCount() const;
+
+    // Glyph quads for a document line, laid out on a cache miss
+    const TextViewLine& getLineQuads(size_t line);
+
+    // Total lines laid out so far
+    Uint32 getLayoutCount() const { return layoutCount; }
+
+private:
+    void rebuildLineIndex();
+    void invalidateFrom(size_t line, bool following);
+    void resizeCache();
+    void layoutLine(size_t line, TextViewLine& slot);
+
+    PieceTable content;
+    std::vector<size_t> lineStarts;
+
+    GlyphAtlas* atlas;
+    Uint32 atlasGeneration;
+    Uint32 atlasRevision;
+    Rect bounds;
+    float scroll;
+    int margin;
+
+    std::vector<TextViewLine> cache; // Direct mapped by line index
+    std::string lineText;            // Scratch for layout
+    Uint32 layoutCount;
+};
+
+} // namespace ContextEngine
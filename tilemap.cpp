@@ -0,0 +1,209 @@
+#include "tilemap.hpp"
+#include "context-engine.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace ContextEngine {
+
+Tilemap::Tilemap(int width, int height, float tileSize)
+    : width(std::max(width, 0))
+    , height(std::max(height, 0))
+    , tileSize(tileSize)
+    , chunksX((this->width + CHUNK_SIZE - 1) / CHUNK_SIZE)
+    , chunksY((this->height + CHUNK_SIZE - 1) / CHUNK_SIZE)
+    , chunks(static_cast<size_t>(chunksX) * chunksY)
+    , tileset(nullptr)
+    , tilesetTileWidth(0)
+    , tilesetTileHeight(0)
+    , tilesetColumns(1)
+    , tilesetWidth(0)
+    , tilesetHeight(0)
+    , frame(0)
+    , maxCachedChunks(512)
+    , cachedChunks(0)
+    , drawnChunks(0)
+    , rebuiltChunks(0)
+{
+}
+
+Tilemap::Chunk* Tilemap::chunkAt(int x, int y, int& localIndex) {
+    if (x < 0 || y < 0 || x >= width || y >= height) {
+        return nullptr;
+    }
+    localIndex = (y % CHUNK_SIZE) * CHUNK_SIZE + (x % CHUNK_SIZE);
+    return &chunks[(y / CHUNK_SIZE) * chunksX + (x / CHUNK_SIZE)];
+}
+
+Uint16 Tilemap::getTile(int x, int y) const {
+    if (x < 0 || y < 0 || x >= width || y >= height) {
+        return 0;
+    }
+    const Chunk& chunk = chunks[(y / CHUNK_SIZE) * chunksX + (x / CHUNK_SIZE)];
+    if (chunk.tiles.empty()) {
+        return 0;
+    }
+    return chunk.tiles[(y % CHUNK_SIZE) * CHUNK_SIZE + (x % CHUNK_SIZE)];
+}
+
+void Tilemap::setTile(int x, int y, Uint16 tile) {
+    int local = 0;
+    Chunk* chunk = chunkAt(x, y, local);
+    if (!chunk) {
+        return;
+    }
+    if (chunk->tiles.empty()) {
+        if (tile == 0) {
+            return;
+        }
+        chunk->tiles.assign(CHUNK_SIZE * CHUNK_SIZE, 0);
+    }
+    if (chunk->tiles[local] != tile) {
+        chunk->tiles[local] = tile;
+        chunk->dirty = true;
+    }
+}
+
+void Tilemap::fillRect(int x, int y, int w, int h, Uint16 tile) {
+    int endX = std::min(x + w, width);
+    int endY = std::min(y + h, height);
+    for (int row = std::max(y, 0); row < endY; row++) {
+        for (int column = std::max(x, 0); column < endX; column++) {
+            setTile(column, row, tile);
+        }
+    }
+}
+
+void Tilemap::worldToTile(const Vector2& position, int& x, int& y) const {
+    x = static_cast<int>(std::floor(position.x / tileSize));
+    y = static_cast<int>(std::floor(position.y / tileSize));
+}
+
+void Tilemap::setTileset(SDL_Texture* texture, int tileWidth, int tileHeight, int columns) {
+    tileset = texture;
+    tilesetTileWidth = tileWidth;
+    tilesetTileHeight = tileHeight;
+    tilesetColumns = std::max(columns, 1);
+    tilesetWidth = 0;
+    tilesetHeight = 0;
+    if (texture) {
+        SDL_QueryTexture(texture, nullptr, nullptr, &tilesetWidth, &tilesetHeight);
+    }
+    invalidateAll();
+}
+
+void Tilemap::setTileColor(Uint16 tile, const Color& color) {
+    if (tileColors.size() <= tile) {
+        tileColors.resize(tile + 1, Color(255, 255, 255));
+    }
+    tileColors[tile] = color;
+    invalidateAll();
+}
+
+void Tilemap::invalidateAll() {
+    for (Chunk& chunk : chunks) {
+        chunk.dirty = true;
+    }
+}
+
+void Tilemap::rebuild(Chunk& chunk) {
+    chunk.mesh.clear();
+    const bool textured = tileset && tilesetWidth > 0 && tilesetHeight > 0;
+    const float invWidth = textured ? 1.0f / tilesetWidth : 0.0f;
+    const float invHeight = textured ? 1.0f / tilesetHeight : 0.0f;
+
+    for (int y = 0; y < CHUNK_SIZE && !chunk.tiles.empty(); y++) {
+        for (int x = 0; x < CHUNK_SIZE; x++) {
+            Uint16 tile = chunk.tiles[y * CHUNK_SIZE + x];
+            if (tile == 0) {
+                continue;
+            }
+
+            SDL_Color color = tile < tileColors.size() ? tileColors[tile].toSDLColor() : SDL_Color{255, 255, 255, 255};
+            float u0 = 0, v0 = 0, u1 = 0, v1 = 0;
+            if (textured) {
+                int cell = tile - 1;
+                u0 = (cell % tilesetColumns) * tilesetTileWidth * invWidth;
+                v0 = (cell / tilesetColumns) * tilesetTileHeight * invHeight;
+                u1 = u0 + tilesetTileWidth * invWidth;
+                v1 = v0 + tilesetTileHeight * invHeight;
+            }
+
+            float left = x * tileSize;
+            float top = y * tileSize;
+            chunk.mesh.push_back({SDL_FPoint{left, top}, color, SDL_FPoint{u0, v0}});
+            chunk.mesh.push_back({SDL_FPoint{left + tileSize, top}, color, SDL_FPoint{u1, v0}});
+            chunk.mesh.push_back({SDL_FPoint{left + tileSize, top + tileSize}, color, SDL_FPoint{u1, v1}});
+            chunk.mesh.push_back({SDL_FPoint{left, top + tileSize}, color, SDL_FPoint{u0, v1}});
+        }
+    }
+
+    if (!chunk.cached) {
+        chunk.cached = true;
+        cachedChunks++;
+    }
+    chunk.dirty = false;
+}
+
+void Tilemap::evict() {
+    // Rare, so a scan for the oldest meshes is fine
+    while (cachedChunks > maxCachedChunks) {
+        Chunk* oldest = nullptr;
+        for (Chunk& chunk : chunks) {
+            if (chunk.cached && chunk.lastDrawn != frame && (!oldest || chunk.lastDrawn < oldest->lastDrawn)) {
+                oldest = &chunk;
+            }
+        }
+        if (!oldest) {
+            return; // Everything cached is on screen
+        }
+        std::vector<SDL_Vertex>().swap(oldest->mesh);
+        oldest->cached = false;
+        oldest->dirty = true;
+        cachedChunks--;
+    }
+}
+
+void Tilemap::render(OtherCtx& ctx) {
+    frame++;
+    drawnChunks = 0;
+    rebuiltChunks = 0;
+    batch.clear();
+    if (chunks.empty()) {
+        return;
+    }
+
+    // Chunk range overlapping the view
+    const float chunkExtent = CHUNK_SIZE * tileSize;
+    Rect view = ctx.getViewRect();
+    int firstX = std::max(0, static_cast<int>(std::floor(view.x / chunkExtent)));
+    int firstY = std::max(0, static_cast<int>(std::floor(view.y / chunkExtent)));
+    int lastX = std::min(chunksX - 1, static_cast<int>(std::floor((view.x + view.w) / chunkExtent)));
+    int lastY = std::min(chunksY - 1, static_cast<int>(std::floor((view.y + view.h) / chunkExtent)));
+
+    const float zoom = ctx.isCameraEnabled() ? ctx.getCameraZoom() : 1.0f;
+    for (int chunkY = firstY; chunkY <= lastY; chunkY++) {
+        for (int chunkX = firstX; chunkX <= lastX; chunkX++) {
+            Chunk& chunk = chunks[chunkY * chunksX + chunkX];
+            if (chunk.tiles.empty()) {
+                continue;
+            }
+            if (chunk.dirty) {
+                rebuild(chunk);
+                rebuiltChunks++;
+            }
+            chunk.lastDrawn = frame;
+            if (chunk.mesh.empty()) {
+                continue;
+            }
+            Vector2 corner = ctx.transformPoint(chunkX * chunkExtent, chunkY * chunkExtent);
+            batch.addQuads(chunk.mesh.data(), chunk.mesh.size() / 4, corner, zoom);
+            drawnChunks++;
+        }
+    }
+
+    evict();
+    ctx.drawBatch(batch, tileset);
+}
+
+} // namespace ContextEngine
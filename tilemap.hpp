@@ -0,0 +1,92 @@
+#pragma once
+
+#include "context-types.hpp"
+#include "geometry-batch.hpp"
+
+#include <vector>
+
+namespace ContextEngine {
+
+class OtherCtx;
+
+// Grid of tile ids split into fixed size chunks. Each chunk keeps a mesh of
+// its non-empty tiles that is only rebuilt after one of them changes, and
+// render() only touches chunks that overlap the view, so the cost of a frame
+// follows what is on screen rather than the size of the map. Tile 0 is empty.
+class Tilemap {
+public:
+    static constexpr int CHUNK_SIZE = 32; // Tiles along each side of a chunk
+
+    Tilemap(int width, int height, float tileSize);
+
+    // Prevent copying
+    Tilemap(const Tilemap&) = delete;
+    Tilemap& operator=(const Tilemap&) = delete;
+
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    float getTileSize() const { return tileSize; }
+
+    Uint16 getTile(int x, int y) const; // 0 outside the map
+    void setTile(int x, int y, Uint16 tile);
+    void fillRect(int x, int y, int w, int h, Uint16 tile);
+
+    // Tile coordinates under a world position (may be outside the map)
+    void worldToTile(const Vector2& position, int& x, int& y) const;
+
+    // Atlas laid out in rows of columns tiles of tileWidth x tileHeight
+    // pixels; tile id n draws atlas cell n - 1. Without a tileset tiles are
+    // plain colored squares.
+    void setTileset(SDL_Texture* texture, int tileWidth, int tileHeight, int columns);
+
+    // Color of a tile id, multiplied with the tileset (white by default)
+    void setTileColor(Uint16 tile, const Color& color);
+
+    // Meshes of chunks that were drawn least recently are dropped past this many
+    void setMaxCachedChunks(size_t count) { maxCachedChunks = count; }
+
+    void render(OtherCtx& ctx);
+
+    // Stats from the last render
+    int getDrawnChunkCount() const { return drawnChunks; }
+    int getRebuiltChunkCount() const { return rebuiltChunks; }
+    size_t getCachedChunkCount() const { return cachedChunks; }
+
+private:
+    struct Chunk {
+        std::vector<Uint16> tiles;     // Empty until a tile is set
+        std::vector<SDL_Vertex> mesh;  // Four corners per tile, relative to the chunk corner
+        bool dirty = true;
+        bool cached = false;
+        Uint64 lastDrawn = 0;
+    };
+
+    Chunk* chunkAt(int x, int y, int& localIndex);
+    void rebuild(Chunk& chunk);
+    void evict();
+    void invalidateAll();
+
+    int width;
+    int height;
+    float tileSize;
+    int chunksX;
+    int chunksY;
+    std::vector<Chunk> chunks;
+
+    SDL_Texture* tileset;
+    int tilesetTileWidth;
+    int tilesetTileHeight;
+    int tilesetColumns;
+    int tilesetWidth;
+    int tilesetHeight;
+    std::vector<Color> tileColors;
+
+    GeometryBatch batch;
+    Uint64 frame;
+    size_t maxCachedChunks;
+    size_t cachedChunks;
+    int drawnChunks;
+    int rebuiltChunks;
+};
+
+} // namespace ContextEngine
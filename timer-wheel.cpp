@@ -0,0 +1,275 @@
+#include "timer-wheel.hpp"
+
+#include <algorithm>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+#include <intrin.h>
+#endif
+
+namespace ContextEngine {
+
+static const int SLOT_BITS = 6;
+static const Uint64 SLOT_MASK = TimerWheel::SLOTS - 1;
+
+// Farthest a timer can be placed ahead; later ones are placed again on the way
+static const Uint64 MAX_DELTA = (1ull << (SLOT_BITS * TimerWheel::LEVELS)) - 1;
+
+// Index of the lowest set bit; bits must not be 0
+static int lowestBit(Uint64 bits) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(bits);
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+    unsigned long index;
+    _BitScanForward64(&index, bits);
+    return static_cast<int>(index);
+#else
+    int index = 0;
+    while ((bits & 1) == 0) {
+        bits >>= 1;
+        index++;
+    }
+    return index;
+#endif
+}
+
+TimerWheel::TimerWheel(Uint64 idTag)
+    : now(0)
+    , tag(idTag & TAG_MASK)
+    , count(0)
+{
+    std::fill(std::begin(heads), std::end(heads), NONE);
+    std::fill(std::begin(occupied), std::end(occupied), 0);
+}
+
+TimerId TimerWheel::schedule(Uint64 delay, Uint64 interval, std::function<void()> callback) {
+    Uint32 index;
+    if (!freeNodes.empty()) {
+        index = freeNodes.back();
+        freeNodes.pop_back();
+    } else {
+        index = static_cast<Uint32>(nodes.size());
+        nodes.emplace_back();
+    }
+
+    Node& node = nodes[index];
+    node.callback = std::move(callback);
+    node.when = now + std::max<Uint64>(delay, 1);
+    node.interval = interval;
+    node.live = true;
+    node.cancelled = false;
+    insert(index);
+    count++;
+
+    // Index + 1 so no live timer has id 0
+    return tag | (static_cast<Uint64>(node.generation) << 32) | (index + 1);
+}
+
+Uint32 TimerWheel::indexOf(TimerId id) const {
+    if (!owns(id)) {
+        return NONE;
+    }
+    Uint32 index = static_cast<Uint32>(id & 0xFFFFFFFF) - 1;
+    Uint32 generation = static_cast<Uint32>((id & ~TAG_MASK) >> 32);
+    if (index >= nodes.size() || !nodes[index].live || nodes[index].generation != generation) {
+        return NONE;
+    }
+    return index;
+}
+
+bool TimerWheel::cancel(TimerId id) {
+    Uint32 index = indexOf(id);
+    if (index == NONE || nodes[index].cancelled) {
+        return false;
+    }
+
+    Node& node = nodes[index];
+    if (node.list >= 0) {
+        unlink(index);
+        release(index);
+    } else {
+        // Its callback is running; fire() drops it once that returns
+        node.cancelled = true;
+    }
+    count--;
+    return true;
+}
+
+bool TimerWheel::isScheduled(TimerId id) const {
+    Uint32 index = indexOf(id);
+    if (index == NONE || nodes[index].cancelled) {
+        return false;
+    }
+    // A one-shot timer whose callback is running has already fired
+    return nodes[index].list >= 0 || nodes[index].interval != 0;
+}
+
+void TimerWheel::insert(Uint32 index) {
+    Uint64 target = std::min(nodes[index].when, now + MAX_DELTA);
+    Uint64 delta = target > now ? target - now : 0;
+
+    // The lowest level whose slots span the delay
+    int level = 0;
+    while (level < LEVELS - 1 && delta >= (1ull << (SLOT_BITS * (level + 1)))) {
+        level++;
+    }
+    int slot = static_cast<int>((target >> (SLOT_BITS * level)) & SLOT_MASK);
+    link(index, level * SLOTS + slot);
+}
+
+void TimerWheel::link(Uint32 index, int list) {
+    Node& node = nodes[index];
+    node.list = list;
+    node.prev = NONE;
+    node.next = heads[list];
+    if (node.next != NONE) {
+        nodes[node.next].prev = index;
+    }
+    heads[list] = index;
+    if (list < FIRING) {
+        occupied[list / SLOTS] |= 1ull << (list % SLOTS);
+    }
+}
+
+void TimerWheel::unlink(Uint32 index) {
+    Node& node = nodes[index];
+    if (node.prev != NONE) {
+        nodes[node.prev].next = node.next;
+    } else {
+        heads[node.list] = node.next;
+    }
+    if (node.next != NONE) {
+        nodes[node.next].prev = node.prev;
+    }
+    if (node.list < FIRING && heads[node.list] == NONE) {
+        occupied[node.list / SLOTS] &= ~(1ull << (node.list % SLOTS));
+    }
+    node.list = -1;
+    node.prev = NONE;
+    node.next = NONE;
+}
+
+void TimerWheel::release(Uint32 index) {
+    Node& node = nodes[index];
+    node.callback = nullptr;
+    node.live = false;
+    node.cancelled = false;
+    node.generation = (node.generation + 1) & 0x7FFFFFFF;
+    freeNodes.push_back(index);
+}
+
+int TimerWheel::nextSlot(int level, Uint64& tick) const {
+    if (occupied[level] == 0) {
+        return -1;
+    }
+    // Slots of a level are visited once every 64^level ticks, in order
+    int shift = SLOT_BITS * level;
+    Uint64 base = (now >> shift) + 1;
+    int rotation = static_cast<int>(base & SLOT_MASK);
+    Uint64 mask = occupied[level];
+    if (rotation != 0) {
+        mask = (mask >> rotation) | (mask << (SLOTS - rotation));
+    }
+    Uint64 visit = base + lowestBit(mask);
+    tick = visit << shift;
+    return static_cast<int>(visit & SLOT_MASK);
+}
+
+Uint64 TimerWheel::getNextExpiry() const {
+    Uint64 next = NO_TICK;
+    for (int level = 0; level < LEVELS; level++) {
+        int shift = SLOT_BITS * level;
+        Uint64 base = (now >> shift) + 1;
+        for (int step = 0; step < SLOTS; step++) {
+            // A slot only holds timers due at or after its visit, so the
+            // first one usually settles it; far timers parked in the top
+            // level can be later than the slots after theirs
+            Uint64 visit = base + step;
+            if ((visit << shift) >= next) {
+                break;
+            }
+            for (Uint32 index = heads[level * SLOTS + (visit & SLOT_MASK)]; index != NONE; index = nodes[index].next) {
+                next = std::min(next, nodes[index].when);
+            }
+        }
+    }
+    return next;
+}
+
+void TimerWheel::cascade(int level) {
+    int list = level * SLOTS + static_cast<int>((now >> (SLOT_BITS * level)) & SLOT_MASK);
+
+    // Detach the slot first: far timers can land back in it
+    Uint32 index = heads[list];
+    heads[list] = NONE;
+    occupied[level] &= ~(1ull << (list % SLOTS));
+    while (index != NONE) {
+        Uint32 next = nodes[index].next;
+        nodes[index].list = -1;
+        insert(index);
+        index = next;
+    }
+}
+
+void TimerWheel::fire() {
+    int list = static_cast<int>(now & SLOT_MASK);
+
+    // Move the due slot to the firing list, where callbacks can still cancel them
+    Uint32 index = heads[list];
+    heads[list] = NONE;
+    occupied[0] &= ~(1ull << list);
+    while (index != NONE) {
+        Uint32 next = nodes[index].next;
+        link(index, FIRING);
+        index = next;
+    }
+
+    while (heads[FIRING] != NONE) {
+        index = heads[FIRING];
+        unlink(index);
+
+        // The callback may schedule timers and grow nodes, so it runs from a local
+        std::function<void()> callback = std::move(nodes[index].callback);
+        callback();
+
+        Node& node = nodes[index];
+        if (node.interval != 0 && !node.cancelled) {
+            node.callback = std::move(callback);
+            node.when += node.interval;
+            insert(index);
+        } else {
+            if (!node.cancelled) {
+                count--;
+            }
+            release(index);
+        }
+    }
+}
+
+void TimerWheel::advance(Uint64 tick) {
+    while (now < tick) {
+        // The next tick where a slot has work to run or move down
+        Uint64 next = NO_TICK;
+        for (int level = 0; level < LEVELS; level++) {
+            Uint64 visit;
+            if (nextSlot(level, visit) >= 0) {
+                next = std::min(next, visit);
+            }
+        }
+        if (next > tick) {
+            // Nothing is due or moves down a level before then
+            now = tick;
+            return;
+        }
+        now = next;
+
+        // Move farther timers down before running the ones due now
+        for (int level = LEVELS - 1; level > 0; level--) {
+            if ((now & ((1ull << (SLOT_BITS * level)) - 1)) == 0) {
+                cascade(level);
+            }
+        }
+        fire();
+    }
+}
+
+} // namespace ContextEngine
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "context-types.hpp"
+
+#include <functional>
+#include <vector>
+
+namespace ContextEngine {
+
+// Handle to a scheduled callback, 0 for none
+using TimerId = Uint64;
+
+// What a timer's delay is measured in
+enum class TimerClock {
+    Sim, // Sum of update deltaTimes: pauses with the game and replays exactly
+    Wall // Real time, keeps going through slow frames
+};
+
+// Hierarchical timer wheel counting in millisecond ticks. Four levels of 64
+// slots cover about 4.6 hours; farther timers wait in the top level and are
+// placed again as it turns. Scheduling and cancelling are O(1), and advance()
+// skips stretches where no slot has work instead of stepping every tick.
+// Callbacks run inside advance() and may schedule or cancel timers, including
+// their own.
+class TimerWheel {
+public:
+    static constexpr int LEVELS = 4;
+    static constexpr int SLOTS = 64;
+    static constexpr Uint64 NO_TICK = ~0ull;
+
+    // Tag is ORed into every id so ids from different wheels never collide
+    explicit TimerWheel(Uint64 idTag = 0);
+
+    // Prevent copying
+    TimerWheel(const TimerWheel&) = delete;
+    TimerWheel& operator=(const TimerWheel&) = delete;
+
+    // Run once delay ticks have passed (at least one), then every interval
+    // ticks if interval is not 0
+    TimerId schedule(Uint64 delay, Uint64 interval, std::function<void()> callback);
+
+    // False if the timer already fired or was cancelled
+    bool cancel(TimerId id);
+    bool isScheduled(TimerId id) const;
+    bool owns(TimerId id) const { return id != 0 && (id & TAG_MASK) == tag; }
+
+    // Move time forward, running every timer that is due in order
+    void advance(Uint64 tick);
+    Uint64 getTick() const { return now; }
+
+    // Tick the earliest timer is due, NO_TICK when empty. Walks each level's
+    // slots in visit order until one is visited after the best time found,
+    // which is usually the first occupied slot.
+    Uint64 getNextExpiry() const;
+
+    size_t getCount() const { return count; }
+
+private:
+    static constexpr Uint64 TAG_MASK = 1ull << 63;
+    static constexpr Uint32 NONE = ~0u;
+    static constexpr int FIRING = LEVELS * SLOTS; // List of timers being run
+
+    struct Node {
+        std::function<void()> callback;
+        Uint64 when = 0;
+        Uint64 interval = 0;
+        Uint32 generation = 0;
+        Uint32 prev = NONE;
+        Uint32 next = NONE;
+        int list = -1;          // Slot the timer is linked into, -1 when not linked
+        bool live = false;      // Scheduled or running
+        bool cancelled = false; // Cancelled while its callback was running
+    };
+
+    Uint32 indexOf(TimerId id) const; // NONE unless id names a live timer
+    int nextSlot(int level, Uint64& tick) const; // First occupied slot and when it is visited, -1 if none
+    void insert(Uint32 index);
+    void link(Uint32 index, int list);
+    void unlink(Uint32 index);
+    void release(Uint32 index);
+    void cascade(int level);
+    void fire();
+
+    std::vector<Node> nodes;
+    std::vector<Uint32> freeNodes;
+    Uint32 heads[LEVELS * SLOTS + 1];
+    Uint64 occupied[LEVELS]; // Bit per non-empty slot
+    Uint64 now;
+    Uint64 tag;
+    size_t count;
+};
+
+} // namespace ContextEngine
@@ -66,9 +66,15 @@ private:
     float shakeIntensity = 0.0f;
     Vector2 shakeOffset = Vector2(0, 0);
     
-    // Text wrapping variables
-    int maxCharsPerLine = 78;  // Increased character count for wider box
-    float charWidth = 12.0f;   // Approximate width of each character
+    // Cursor blink, toggled by a repeating engine timer
+    bool cursorVisible = true;
+    TimerId blinkTimer = 0;
+    Engine* timerEngine = nullptr; // Engine the blink timer runs on
+    
+    // Text layout, rebuilt only when the text changes
+    TextLayout sentenceLayout;
+    TextLayout inputLayout;
+    EditableText inputText; // Colored per character as it is typed
     
     // Generate a random number
     std::mt19937 rng;
@@ -78,10 +84,13 @@ private:
     std::string fontPath = "/usr/share/fonts/TTF/JetBrainsMono-Regular.ttf";
 
 public:
-    TypingTestGame() {
+    // The engine's seed, so a replayed session picks the same sentences
+    explicit TypingTestGame(Uint32 seed) {
         // Seed the random number generator
-        auto seed = std::chrono::high_resolution_clock::now().time_since_epoch().count();
-        rng.seed(static_cast<unsigned int>(seed));
+        rng.seed(seed);
+        
+        // Typing is read from key presses alone, the engine drops the rest
+        subscribeEvent(SDL_KEYDOWN);
         
         // Start with a random sentence
         selectRandomSentence();
@@ -92,12 +101,14 @@ public:
         currentSentence = sentences[dist(rng)];
         currentPosition = 0;
         userInput = "";
+        inputText.clear();
     }
     
     void startTest() {
         state = GameState::TYPING;
         startTime = std::chrono::high_resolution_clock::now();
         userInput = "";
+        inputText.clear();
         currentPosition = 0;
         errors = 0;
         wpm = 0.0f;
@@ -154,6 +165,7 @@ public:
         // Handle backspace
         if (event.key.keysym.sym == SDLK_BACKSPACE && !userInput.empty()) {
             userInput.pop_back();
+            inputText.backspace();
             if (currentPosition > 0) currentPosition--;
             return;
         }
@@ -208,6 +220,7 @@ public:
             // Check if the typed character matches the expected character
             if (inputChar == currentSentence[currentPosition]) {
                 userInput += inputChar;
+                inputText.insertAtCursor(std::string(1, inputChar), correctColor);
                 currentPosition++;
                 
                 // Check if the sentence is complete
@@ -217,6 +230,7 @@ public:
             } else {
                 // Wrong character typed
                 userInput += inputChar;
+                inputText.insertAtCursor(std::string(1, inputChar), errorColor);
                 wpm -= 5.0f * static_cast<float>(errors);
                 currentPosition++;
                 errors++;
@@ -261,17 +275,44 @@ public:
         if (engine->isKeyPressed(SDL_SCANCODE_ESCAPE)) {
             engine->quit();
         }
+        
+        // Blink every 0.5 seconds of real time; the timer also wakes the idle loop
+        if (!blinkTimer) {
+            blinkTimer = engine->scheduleRepeating(0.5f, [this] { cursorVisible = !cursorVisible; }, TimerClock::Wall);
+            timerEngine = engine;
+        }
+    }
+    
+    // The blink timer points at this scene, so it can't outlive its turn
+    void onExit() override {
+        if (blinkTimer) {
+            timerEngine->cancelTimer(blinkTimer);
+            blinkTimer = 0;
+        }
+    }
+    
+    // Between keystrokes only the cursor blink changes the screen
+    bool isAnimating() const override {
+        return !initialized || shakeDuration > 0.0f;
     }
     
     void render(OtherCtx* ctx) override {
         // Check if we need initialization
         if (!initialized) {
+            // Baked atlases skip rasterizing on every launch after the first
+            ctx->setFontCache("assets/font-cache");
+            
             // Load the monospace font
             if (ctx->loadFont("monospace", fontPath, 16)) {
                 std::cout << "Monospace font loaded successfully" << std::endl;
             } else {
                 std::cout << "Failed to load monospace font, falling back to default" << std::endl;
             }
+            // Wrapped text is laid out at a fixed size instead of scaling per draw
+            ctx->loadFont("monospace-body", fontPath, 20);
+            
+            // New glyphs are rasterized off the render thread
+            ctx->setAsyncText(true);
             initialized = true;
         }
         
@@ -288,7 +329,7 @@ public:
         switch (state) {
             case GameState::START:
                 ctx->drawText("Press ENTER to start typing", 300, 100, textColor, "monospace", 1.2f);
-                drawWrappedText(ctx, currentSentence, textBackground.x + 20, textBackground.y + 30, Color(150, 150, 150), "monospace");
+                drawWrappedText(ctx, sentenceLayout, currentSentence, textBackground.x + 20, textBackground.y + 30, Color(150, 150, 150), "monospace-body");
                 break;
                 
             case GameState::TYPING:
@@ -304,83 +345,44 @@ public:
         ctx->setCameraPosition(Vector2(0, 0));
     }
     
-    // Draw text with word wrapping
-    void drawWrappedText(OtherCtx* ctx, const std::string& text, float x, float y, const Color& color, const std::string& fontName) {
-        // Create wrapped lines
-        std::vector<std::string> lines;
-        std::string currentLine;
-        int currentLineChars = 0;
-        
-        std::istringstream stream(text);
-        std::string word;
-        
-        while (stream >> word) {
-            // Check if adding this word would exceed the max chars per line
-            if (currentLineChars + word.length() + 1 > maxCharsPerLine && !currentLine.empty()) {
-                // Start a new line
-                lines.push_back(currentLine);
-                currentLine = word;
-                currentLineChars = word.length();
-            } else {
-                // Add word to current line
-                if (!currentLine.empty()) {
-                    currentLine += " " + word;
-                    currentLineChars += word.length() + 1;
-                } else {
-                    currentLine = word;
-                    currentLineChars = word.length();
-                }
-            }
+    // Draw text with word wrapping, the layout only rebuilds when the text changes
+    void drawWrappedText(OtherCtx* ctx, TextLayout& layout, const std::string& text, float x, float y, const Color& color, const std::string& fontName) {
+        GlyphAtlas* font = ctx->getGlyphAtlas(fontName);
+        if (!font) {
+            font = ctx->getGlyphAtlas("default");
         }
         
-        // Add the last line
-        if (!currentLine.empty()) {
-            lines.push_back(currentLine);
-        }
-        
-        // Draw each line
-        float lineHeight = 30.0f; // Increased line height for better readability
-        for (size_t i = 0; i < lines.size(); i++) {
-            ctx->drawText(lines[i], x, y + i * lineHeight, color, fontName, 1.2f); // Increased text size
-        }
+        layout.setFont(font);
+        layout.setText(text);
+        layout.setMaxWidth(textBackground.w - 40);
+        ctx->drawTextLayout(layout, x, y, color);
     }
     
     void drawTypingUI(OtherCtx* ctx) {
         // Show what to type
         ctx->drawRoundedRect(textBackground.x, textBackground.y, textBackground.w, textBackground.h, 15, Color(30, 34, 42));
-        drawWrappedText(ctx, currentSentence, textBackground.x + 20, textBackground.y + 30, textColor, "monospace");
+        drawWrappedText(ctx, sentenceLayout, currentSentence, textBackground.x + 20, textBackground.y + 30, textColor, "monospace-body");
         
         // Draw user's input with character highlighting
         ctx->drawRoundedRect(inputBackground.x, inputBackground.y, inputBackground.w, inputBackground.h, 15, Color(30, 34, 42));
         
         float xOffset = inputBackground.x + 20;
         float yOffset = inputBackground.y + 30;
-        float xPos = xOffset;
         
-        for (size_t i = 0; i < userInput.length(); i++) {
-            Color charColor;
-            if (i < currentSentence.length() && userInput[i] == currentSentence[i]) {
-                charColor = correctColor;
-            } else {
-                charColor = errorColor;
-            }
-            
-            std::string charStr(1, userInput[i]);
-            ctx->drawText(charStr, xPos, yOffset, charColor, "monospace", 1.2f);
-            xPos += charWidth;
-            
-            // Wrap to next line if needed (simplified wrapping for input field)
-            if (xPos > inputBackground.x + inputBackground.w - 30) {
-                xPos = xOffset;
-                yOffset += 30.0f; // Line height
-            }
+        // Only the lines touched by the last keystroke were re-wrapped
+        GlyphAtlas* font = ctx->getGlyphAtlas("monospace-body");
+        if (!font) {
+            font = ctx->getGlyphAtlas("default");
         }
+        inputText.setFont(font);
+        inputText.setMaxWidth(inputBackground.w - 50);
+        ctx->drawEditableText(inputText, xOffset, yOffset);
         
         // Draw current cursor position (blinking cursor at current position)
-        int cursorBlinkRate = (SDL_GetTicks() / 500) % 2; // Blink every 0.5 seconds
-        if (cursorBlinkRate == 0) {
-            float cursorX = xOffset + (userInput.length() % (maxCharsPerLine - 2)) * charWidth;
-            float cursorY = yOffset;
+        if (cursorVisible) {
+            Vector2 cursor = inputText.getCursorPosition();
+            float cursorX = xOffset + cursor.x;
+            float cursorY = yOffset + cursor.y;
             ctx->drawRectOutline(cursorX, cursorY - 2, 2, 24, highlightColor);
         }
         
@@ -393,11 +395,11 @@ public:
     void drawFinishedUI(OtherCtx* ctx) {
         // Show completed text
         ctx->drawRoundedRect(textBackground.x, textBackground.y, textBackground.w, textBackground.h, 15, Color(30, 34, 42));
-        drawWrappedText(ctx, currentSentence, textBackground.x + 20, textBackground.y + 30, textColor, "monospace");
+        drawWrappedText(ctx, sentenceLayout, currentSentence, textBackground.x + 20, textBackground.y + 30, textColor, "monospace-body");
         
         // Show user's input
         ctx->drawRoundedRect(inputBackground.x, inputBackground.y, inputBackground.w, inputBackground.h, 15, Color(30, 34, 42));
-        drawWrappedText(ctx, userInput, inputBackground.x + 20, inputBackground.y + 30, highlightColor, "monospace");
+        drawWrappedText(ctx, inputLayout, userInput, inputBackground.x + 20, inputBackground.y + 30, highlightColor, "monospace-body");
         
         // Show results
         ctx->drawText("Typing test completed!", 300, 100, textColor, "monospace", 1.2f);
@@ -415,8 +417,24 @@ public:
 };
 
 int main(int argc, char* argv[]) {
+    // --record <file> logs this session's input, --replay <file> plays one
+    // back (add --headless to run it without a window)
+    std::string recordPath;
+    std::string replayPath;
+    bool headless = false;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--record" && i + 1 < argc) {
+            recordPath = argv[++i];
+        } else if (arg == "--replay" && i + 1 < argc) {
+            replayPath = argv[++i];
+        } else if (arg == "--headless") {
+            headless = true;
+        }
+    }
+    
     // Create engine with a nice window size for the typing test
-    Engine engine("Typing Speed Test", 1200, 700); // Increased window size to fit larger boxes
+    Engine engine("Typing Speed Test", 1200, 700, headless); // Increased window size to fit larger boxes
     
     // Initialize the engine
     if (!engine.init()) {
@@ -424,10 +442,20 @@ int main(int argc, char* argv[]) {
         return 1;
     }
     
+    if (!replayPath.empty() && !engine.startReplay(replayPath)) {
+        return 1;
+    }
+    if (!recordPath.empty() && !engine.startRecording(recordPath)) {
+        return 1;
+    }
+    
     // Create and add our typing test game scene
-    std::unique_ptr<Scene> gameScene = std::make_unique<TypingTestGame>();
+    std::unique_ptr<Scene> gameScene = std::make_unique<TypingTestGame>(engine.getRandomSeed());
     engine.addScene(std::move(gameScene));
     
+    // Sleep between keystrokes instead of redrawing at 60 FPS
+    engine.setIdleWaiting(true);
+    
     // Run the game
     engine.run();
     
@@ -0,0 +1,139 @@
+#include "worker-pool.hpp"
+
+#include <algorithm>
+
+namespace ContextEngine {
+
+WorkerPool::WorkerPool(int threadCount)
+    : stopping(false)
+{
+#ifndef CONTEXT_ENGINE_NO_THREADS
+    if (threadCount <= 0) {
+        threadCount = std::max(1, static_cast<int>(std::thread::hardware_concurrency()) - 1);
+    }
+    for (int i = 0; i < threadCount; i++) {
+        threads.emplace_back(&WorkerPool::run, this);
+    }
+#else
+    (void)threadCount;
+#endif
+}
+
+WorkerPool::~WorkerPool() {
+    std::deque<std::function<void()>> dropped;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        dropped.swap(jobs);
+    }
+    wake.notify_all();
+
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    // Dropped jobs release whatever they captured here, on the owning thread
+    dropped.clear();
+}
+
+void WorkerPool::submit(std::function<void()> job) {
+    if (threads.empty()) {
+        job();
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        jobs.push_back(std::move(job));
+    }
+    wake.notify_one();
+}
+
+void WorkerPool::parallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t)>& body) {
+    grain = std::max<size_t>(grain, 1);
+    size_t chunks = (count + grain - 1) / grain;
+    if (threads.empty() || chunks <= 1) {
+        if (count > 0) {
+            body(0, count);
+        }
+        return;
+    }
+
+    // Chunks are claimed from a shared counter, so the caller keeps working
+    // even when every worker is busy and can never deadlock waiting on them.
+    // Helpers that start late find nothing left, so the state is reference
+    // counted and goes back to the pool when the last one lets go of it.
+    ParallelFor* state;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        state = parallelStates.create();
+    }
+    size_t helpers = std::min(threads.size(), chunks - 1);
+    state->body = &body;
+    state->count = count;
+    state->grain = grain;
+    state->chunks = chunks;
+    state->references = static_cast<int>(helpers) + 1;
+
+    for (size_t i = 0; i < helpers; i++) {
+        // Two pointers fit std::function's inline storage, so this doesn't allocate
+        submit([this, state] {
+            runChunks(*state);
+            release(state);
+        });
+    }
+    runChunks(*state);
+
+    {
+        std::unique_lock<std::mutex> lock(state->mutex);
+        state->done.wait(lock, [state] { return state->finished.load() == state->chunks; });
+    }
+    release(state);
+}
+
+void WorkerPool::runChunks(ParallelFor& state) {
+    size_t ran = 0;
+    for (;;) {
+        size_t chunk = state.next.fetch_add(1);
+        if (chunk >= state.chunks) {
+            break;
+        }
+        size_t begin = chunk * state.grain;
+        (*state.body)(begin, std::min(begin + state.grain, state.count));
+        ran++;
+    }
+    if (ran > 0 && state.finished.fetch_add(ran) + ran == state.chunks) {
+        std::lock_guard<std::mutex> lock(state.mutex);
+        state.done.notify_all();
+    }
+}
+
+void WorkerPool::release(ParallelFor* state) {
+    if (state->references.fetch_sub(1) == 1) {
+        std::lock_guard<std::mutex> lock(mutex);
+        parallelStates.destroy(state);
+    }
+}
+
+size_t WorkerPool::getQueuedCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return jobs.size();
+}
+
+void WorkerPool::run() {
+    for (;;) {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [this] { return stopping || !jobs.empty(); });
+            if (stopping) {
+                return;
+            }
+            job = std::move(jobs.front());
+            jobs.pop_front();
+        }
+        job();
+    }
+}
+
+} // namespace ContextEngine
@@ -0,0 +1,97 @@
+#pragma once
+
+#include "allocators.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <vector>
+
+// Emscripten builds without pthreads run every job inline
+#if defined(__EMSCRIPTEN__) && !defined(__EMSCRIPTEN_PTHREADS__)
+#define CONTEXT_ENGINE_NO_THREADS 1
+#endif
+
+namespace ContextEngine {
+
+// Runs jobs on background threads. Jobs must not touch the renderer; they
+// hand their results back through a CompletionQueue that the main thread drains.
+class WorkerPool {
+public:
+    // 0 threads picks one less than the hardware concurrency, at least one
+    explicit WorkerPool(int threadCount = 0);
+    ~WorkerPool(); // Drops queued jobs and waits for running ones
+
+    // Prevent copying
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    void submit(std::function<void()> job);
+
+    // Split [0, count) into chunks of about grain items and run them on the
+    // workers and the calling thread, returning once every chunk is done
+    void parallelFor(size_t count, size_t grain, const std::function<void(size_t begin, size_t end)>& body);
+
+    int getThreadCount() const { return static_cast<int>(threads.size()); }
+    size_t getQueuedCount() const;
+
+private:
+    // Progress of one parallelFor, shared by the caller and its helper jobs
+    struct ParallelFor {
+        std::atomic<size_t> next{0};
+        std::atomic<size_t> finished{0};
+        std::atomic<int> references{0};
+        std::mutex mutex;
+        std::condition_variable done;
+        const std::function<void(size_t, size_t)>* body = nullptr;
+        size_t count = 0;
+        size_t grain = 0;
+        size_t chunks = 0;
+    };
+
+    void run();
+    static void runChunks(ParallelFor& state);
+    void release(ParallelFor* state);
+
+    std::vector<std::thread> threads;
+    std::deque<std::function<void()>> jobs;
+    mutable std::mutex mutex;
+    std::condition_variable wake;
+    bool stopping;
+    ObjectPool<ParallelFor> parallelStates; // Guarded by mutex
+};
+
+// Results produced by worker jobs, waiting for the main thread
+template <typename T>
+class CompletionQueue {
+public:
+    void push(T&& item) {
+        std::lock_guard<std::mutex> lock(mutex);
+        items.push_back(std::move(item));
+    }
+
+    bool pop(T& item) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (items.empty()) {
+            return false;
+        }
+        item = std::move(items.front());
+        items.pop_front();
+        return true;
+    }
+
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return items.size();
+    }
+
+private:
+    std::deque<T> items;
+    mutable std::mutex mutex;
+};
+
+} // namespace ContextEngine
@@ -0,0 +1,342 @@
+#include "world-stream.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <thread>
+
+namespace ContextEngine {
+
+WorldStream::WorldStream(const std::string& directory, const StreamingSettings& settings, int threadCount)
+    : directory(directory)
+    , settings(settings)
+    , residentBytes(0)
+    , pending(0)
+    , frame(0)
+    , workers(std::max(threadCount, 1))
+{
+}
+
+WorldStream::~WorldStream() {
+    // The pool is the last member, so it is destroyed first: queued loads are
+    // dropped and running ones finish into the queue before it goes away
+}
+
+std::string WorldStream::chunkFileName(int x, int y) {
+    char name[48];
+    std::snprintf(name, sizeof(name), "%d_%d.chunk", x, y);
+    return name;
+}
+
+bool WorldStream::writeChunk(const std::string& directory, int x, int y, const void* data, size_t size) {
+    WorldChunkHeader header = {};
+    header.magic = MAGIC;
+    header.version = VERSION;
+    header.x = x;
+    header.y = y;
+    header.dataSize = size;
+    header.dataOffset = (sizeof(header) + 15) & ~static_cast<Uint64>(15);
+
+    // Write next to the target and rename, so a crash never leaves half a chunk
+    std::string path = directory + "/" + chunkFileName(x, y);
+    std::string temporary = path + ".tmp";
+    {
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            SDL_Log("Failed to write world chunk %s!", temporary.c_str());
+            return false;
+        }
+        const char padding[16] = {};
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(padding, static_cast<std::streamsize>(header.dataOffset - sizeof(header)));
+        out.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+        if (!out) {
+            SDL_Log("Failed to write world chunk %s!", temporary.c_str());
+            std::remove(temporary.c_str());
+            return false;
+        }
+    }
+
+    // Rename only replaces an existing file on POSIX, remove it first elsewhere
+    if (std::rename(temporary.c_str(), path.c_str()) != 0 &&
+        (std::remove(path.c_str()), std::rename(temporary.c_str(), path.c_str()) != 0)) {
+        SDL_Log("Failed to move world chunk into place at %s!", path.c_str());
+        std::remove(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+Uint64 WorldStream::key(int x, int y) {
+    return (static_cast<Uint64>(static_cast<Uint32>(x)) << 32) | static_cast<Uint32>(y);
+}
+
+void WorldStream::worldToChunk(const Vector2& position, int& x, int& y) const {
+    x = static_cast<int>(std::floor(position.x / settings.chunkSize));
+    y = static_cast<int>(std::floor(position.y / settings.chunkSize));
+}
+
+// Runs on a worker: map the file, check it, and page all of it in
+WorldStream::LoadResult WorldStream::load(const std::string& path, int x, int y) {
+    LoadResult result = {x, y, std::make_unique<MappedFile>(), nullptr, 0};
+    if (!result.file->open(path)) {
+        result.file.reset(); // No file, nothing in this part of the world
+        return result;
+    }
+
+    const MappedFile& file = *result.file;
+    WorldChunkHeader header;
+    if (file.size() < sizeof(header)) {
+        SDL_Log("World chunk %s is truncated!", path.c_str());
+        result.file.reset();
+        return result;
+    }
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (header.magic != MAGIC || header.version != VERSION || header.x != x || header.y != y ||
+        header.dataOffset > file.size() || header.dataSize > file.size() - header.dataOffset) {
+        SDL_Log("World chunk %s is invalid!", path.c_str());
+        result.file.reset();
+        return result;
+    }
+
+    result.data = file.data() + header.dataOffset;
+    result.size = static_cast<size_t>(header.dataSize);
+
+    // Touch every page so the main thread never waits on a page fault
+    volatile Uint8 sink = 0;
+    for (size_t offset = 0; offset < result.size; offset += 4096) {
+        sink = sink + result.data[offset];
+    }
+    (void)sink;
+    return result;
+}
+
+void WorldStream::finish(LoadResult& result) {
+    Slot& slot = slots[key(result.x, result.y)];
+    slot.chunk = {result.x, result.y, result.data, result.size};
+    slot.file = std::move(result.file);
+    slot.state = slot.file ? ChunkState::Resident : ChunkState::Missing;
+    if (slot.state == ChunkState::Resident) {
+        residentBytes += slot.chunk.size;
+        if (onLoad) {
+            onLoad(slot.chunk);
+        }
+    }
+}
+
+void WorldStream::unload(Slot& slot) {
+    if (slot.state == ChunkState::Resident) {
+        if (onUnload) {
+            onUnload(slot.chunk);
+        }
+        residentBytes -= slot.chunk.size;
+    }
+    slot.file.reset();
+    slot.chunk.data = nullptr;
+    slot.chunk.size = 0;
+    slot.state = ChunkState::Unloaded;
+}
+
+void WorldStream::update(const Vector2& cameraPosition, const Vector2& cameraVelocity) {
+    frame++;
+
+    // Hand over whatever finished since the last frame
+    LoadResult result;
+    while (results.pop(result)) {
+        pending--;
+        finish(result);
+    }
+
+    int cameraX = 0;
+    int cameraY = 0;
+    worldToChunk(cameraPosition, cameraX, cameraY);
+    Vector2 predicted = cameraPosition + cameraVelocity * settings.lookahead;
+    int predictedX = 0;
+    int predictedY = 0;
+    worldToChunk(predicted, predictedX, predictedY);
+
+    // Everything near the camera is required, prefetch the area it is heading to
+    for (auto& entry : slots) {
+        entry.second.required = false;
+    }
+    wanted.clear();
+    auto want = [&](int x, int y, bool required) {
+        Slot& slot = slots[key(x, y)];
+        slot.chunk.x = x;
+        slot.chunk.y = y;
+        slot.lastWanted = frame;
+        slot.required = slot.required || required;
+        float dx = (x + 0.5f) * settings.chunkSize - (required ? cameraPosition.x : predicted.x);
+        float dy = (y + 0.5f) * settings.chunkSize - (required ? cameraPosition.y : predicted.y);
+        // Required chunks load before any prefetch
+        wanted.push_back({std::sqrt(dx * dx + dy * dy) + (required ? 0.0f : 1e30f), key(x, y)});
+    };
+    for (int y = cameraY - settings.loadRadius; y <= cameraY + settings.loadRadius; y++) {
+        for (int x = cameraX - settings.loadRadius; x <= cameraX + settings.loadRadius; x++) {
+            want(x, y, true);
+        }
+    }
+    for (int y = predictedY - settings.prefetchRadius; y <= predictedY + settings.prefetchRadius; y++) {
+        for (int x = predictedX - settings.prefetchRadius; x <= predictedX + settings.prefetchRadius; x++) {
+            want(x, y, false);
+        }
+    }
+
+    // Bytes the chunks wanted this frame hold or are about to. Loads in
+    // flight are guessed at the average size of the resident chunks.
+    size_t residentCount = 0;
+    size_t wantedBytes = 0;
+    for (const auto& entry : slots) {
+        const Slot& slot = entry.second;
+        if (slot.state == ChunkState::Resident) {
+            residentCount++;
+            if (slot.lastWanted == frame) {
+                wantedBytes += slot.chunk.size;
+            }
+        }
+    }
+    size_t estimate = residentCount > 0 ? residentBytes / residentCount : 0;
+    wantedBytes += static_cast<size_t>(pending) * estimate;
+
+    // Start loads, nearest first
+    std::sort(wanted.begin(), wanted.end());
+    for (const auto& entry : wanted) {
+        if (pending >= settings.maxPendingLoads) {
+            break;
+        }
+        Slot& slot = slots[entry.second];
+        if (slot.state != ChunkState::Unloaded) {
+            continue;
+        }
+        // Wanted chunks are never evicted, so prefetching stops where the
+        // budget would be exceeded instead of pushing out what it just loaded
+        if (!slot.required && wantedBytes + estimate > settings.memoryBudget) {
+            continue;
+        }
+        slot.state = ChunkState::Loading;
+        pending++;
+        wantedBytes += estimate;
+        std::string path = directory + "/" + chunkFileName(slot.chunk.x, slot.chunk.y);
+        int x = slot.chunk.x;
+        int y = slot.chunk.y;
+        workers.submit([this, path, x, y] {
+            results.push(load(path, x, y));
+        });
+    }
+
+    evict(cameraX, cameraY);
+}
+
+void WorldStream::evict(int cameraX, int cameraY) {
+    // Forget chunks nobody wants that hold no memory
+    for (auto it = slots.begin(); it != slots.end();) {
+        const Slot& slot = it->second;
+        bool empty = slot.state == ChunkState::Unloaded || slot.state == ChunkState::Missing;
+        it = empty && slot.lastWanted != frame ? slots.erase(it) : std::next(it);
+    }
+    if (residentBytes <= settings.memoryBudget) {
+        return;
+    }
+
+    // Over budget: drop chunks the camera no longer wants in policy order.
+    // Chunks wanted this frame stay even if that keeps the budget exceeded.
+    std::vector<std::pair<Sint64, Slot*>> candidates;
+    for (auto& entry : slots) {
+        Slot& slot = entry.second;
+        if (slot.state != ChunkState::Resident || slot.required || slot.lastWanted == frame) {
+            continue;
+        }
+        Sint64 order = 0;
+        if (settings.eviction == EvictionPolicy::LeastRecentlyUsed) {
+            order = static_cast<Sint64>(slot.lastWanted);
+        } else {
+            Sint64 dx = static_cast<Sint64>(slot.chunk.x) - cameraX;
+            Sint64 dy = static_cast<Sint64>(slot.chunk.y) - cameraY;
+            order = -(dx * dx + dy * dy);
+        }
+        candidates.push_back({order, &slot});
+    }
+    std::sort(candidates.begin(), candidates.end(),
+        [](const std::pair<Sint64, Slot*>& a, const std::pair<Sint64, Slot*>& b) { return a.first < b.first; });
+
+    for (const auto& candidate : candidates) {
+        if (residentBytes <= settings.memoryBudget) {
+            break;
+        }
+        unload(*candidate.second);
+    }
+}
+
+void WorldStream::requireArea(const Rect& area) {
+    int firstX = 0, firstY = 0, lastX = 0, lastY = 0;
+    worldToChunk(Vector2(area.x, area.y), firstX, firstY);
+    worldToChunk(Vector2(area.x + area.w, area.y + area.h), lastX, lastY);
+
+    for (int y = firstY; y <= lastY; y++) {
+        for (int x = firstX; x <= lastX; x++) {
+            Slot& slot = slots[key(x, y)];
+            slot.chunk.x = x;
+            slot.chunk.y = y;
+            slot.lastWanted = frame;
+            slot.required = true;
+            if (slot.state == ChunkState::Unloaded) {
+                slot.state = ChunkState::Loading;
+                LoadResult result = load(directory + "/" + chunkFileName(x, y), x, y);
+                finish(result);
+            }
+            // Already on a worker: take results until this one is back
+            while (slot.state == ChunkState::Loading) {
+                LoadResult result;
+                if (results.pop(result)) {
+                    pending--;
+                    finish(result);
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        }
+    }
+}
+
+bool WorldStream::isAreaReady(const Rect& area) const {
+    int firstX = 0, firstY = 0, lastX = 0, lastY = 0;
+    worldToChunk(Vector2(area.x, area.y), firstX, firstY);
+    worldToChunk(Vector2(area.x + area.w, area.y + area.h), lastX, lastY);
+
+    for (int y = firstY; y <= lastY; y++) {
+        for (int x = firstX; x <= lastX; x++) {
+            ChunkState state = getState(x, y);
+            if (state != ChunkState::Resident && state != ChunkState::Missing) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+ChunkState WorldStream::getState(int x, int y) const {
+    auto it = slots.find(key(x, y));
+    return it == slots.end() ? ChunkState::Unloaded : it->second.state;
+}
+
+const StreamedChunk* WorldStream::getChunk(int x, int y) const {
+    auto it = slots.find(key(x, y));
+    if (it == slots.end() || it->second.state != ChunkState::Resident) {
+        return nullptr;
+    }
+    return &it->second.chunk;
+}
+
+size_t WorldStream::getResidentCount() const {
+    size_t count = 0;
+    for (const auto& entry : slots) {
+        if (entry.second.state == ChunkState::Resident) {
+            count++;
+        }
+    }
+    return count;
+}
+
+} // namespace ContextEngine
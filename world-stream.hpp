@@ -0,0 +1,145 @@
+#pragma once
+
+#include "context-types.hpp"
+#include "font-cache.hpp"
+#include "worker-pool.hpp"
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ContextEngine {
+
+// Which resident chunks go first when the memory budget is exceeded
+enum class EvictionPolicy {
+    LeastRecentlyUsed, // Longest since the camera last wanted it
+    Farthest           // Farthest from the camera
+};
+
+struct StreamingSettings {
+    float chunkSize = 1024.0f;       // World units along each side of a chunk
+    int loadRadius = 1;              // Chunks around the camera that must be resident
+    int prefetchRadius = 2;          // Chunks around the predicted camera position
+    float lookahead = 1.0f;          // Seconds of camera velocity to predict ahead
+    size_t memoryBudget = 64 << 20;  // Bytes of chunk data kept resident
+    EvictionPolicy eviction = EvictionPolicy::LeastRecentlyUsed;
+    int maxPendingLoads = 4;         // Loads in flight at once
+};
+
+enum class ChunkState {
+    Unloaded,
+    Loading,
+    Resident, // Data is mapped and paged in
+    Missing   // No file: an empty part of the world
+};
+
+// A chunk whose data is fully in memory
+struct StreamedChunk {
+    int x;
+    int y;
+    const Uint8* data;
+    size_t size;
+};
+
+// On-disk chunk layout, in host byte order
+struct WorldChunkHeader {
+    Uint32 magic;
+    Uint32 version;
+    Sint32 x;
+    Sint32 y;
+    Uint64 dataSize;
+    Uint64 dataOffset; // 16 byte aligned
+};
+
+// Streams a world that is split into one file per chunk in a directory.
+// Chunks near the camera, and near where its velocity says it will be, are
+// memory mapped on worker threads and paged in there before they are handed
+// to the main thread, so touching their data never stalls on the disk.
+// Prefetching stops at the memory budget and only chunks the camera no longer
+// wants are evicted, so a load radius bigger than the budget still loads.
+// Chunks are only ever loaded or dropped inside update(); pointers from
+// getChunk stay valid until the next call.
+class WorldStream {
+public:
+    static const Uint32 MAGIC = 0x43574543; // "CEWC"
+    static const Uint32 VERSION = 1;
+
+    explicit WorldStream(const std::string& directory, const StreamingSettings& settings = StreamingSettings(),
+                         int threadCount = 1);
+    ~WorldStream(); // Waits for loads in flight
+
+    // Prevent copying
+    WorldStream(const WorldStream&) = delete;
+    WorldStream& operator=(const WorldStream&) = delete;
+
+    // Write one chunk file, e.g. from an editor or build step
+    static bool writeChunk(const std::string& directory, int x, int y, const void* data, size_t size);
+    static std::string chunkFileName(int x, int y);
+
+    StreamingSettings& getSettings() { return settings; }
+
+    // Call once per frame with the camera center and velocity in world units
+    void update(const Vector2& cameraPosition, const Vector2& cameraVelocity);
+
+    // Load every chunk overlapping an area on the calling thread, e.g. before
+    // the first frame or after a teleport
+    void requireArea(const Rect& area);
+
+    // Whether simulation or drawing in an area can go ahead
+    bool isAreaReady(const Rect& area) const;
+
+    ChunkState getState(int x, int y) const;
+    const StreamedChunk* getChunk(int x, int y) const; // Null unless resident
+    void worldToChunk(const Vector2& position, int& x, int& y) const;
+
+    // Called on the main thread inside update() or requireArea()
+    void setOnLoad(std::function<void(const StreamedChunk&)> callback) { onLoad = std::move(callback); }
+    void setOnUnload(std::function<void(const StreamedChunk&)> callback) { onUnload = std::move(callback); }
+
+    size_t getResidentBytes() const { return residentBytes; }
+    size_t getResidentCount() const;
+    int getPendingCount() const { return pending; }
+
+private:
+    struct Slot {
+        ChunkState state = ChunkState::Unloaded;
+        std::unique_ptr<MappedFile> file;
+        StreamedChunk chunk = {0, 0, nullptr, 0};
+        Uint64 lastWanted = 0;
+        bool required = false; // Inside the load radius this update
+    };
+
+    // A finished load travelling back from a worker
+    struct LoadResult {
+        int x;
+        int y;
+        std::unique_ptr<MappedFile> file;
+        const Uint8* data;
+        size_t size;
+    };
+
+    static Uint64 key(int x, int y);
+    static LoadResult load(const std::string& path, int x, int y);
+    void finish(LoadResult& result);
+    void unload(Slot& slot);
+    void evict(int cameraX, int cameraY);
+
+    std::string directory;
+    StreamingSettings settings;
+    std::unordered_map<Uint64, Slot> slots;
+    std::vector<std::pair<float, Uint64>> wanted; // Distance, chunk key
+    size_t residentBytes;
+    int pending;
+    Uint64 frame;
+
+    std::function<void(const StreamedChunk&)> onLoad;
+    std::function<void(const StreamedChunk&)> onUnload;
+
+    // Declared last so the workers stop before the queue they write to goes away
+    CompletionQueue<LoadResult> results;
+    WorkerPool workers;
+};
+
+} // namespace ContextEngine